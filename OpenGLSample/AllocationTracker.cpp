@@ -0,0 +1,92 @@
+/**
+ * @file AllocationTracker.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the AllocationTracker class and the replacements of
+ * the global operator new and delete that feed it.
+ */
+
+#include "AllocationTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Unnamed namespace
+namespace
+{
+    // Constant initialized, so allocations made before main are counted too
+    std::atomic<size_t> allocationCount(0);
+    std::atomic<size_t> allocatedBytes(0);
+
+    /**
+     * @brief Allocates from malloc and counts the allocation; returns nullptr on failure.
+     */
+    void* allocate(size_t size) {
+        AllocationTracker::record(size);
+        return std::malloc(size > 0 ? size : 1);
+    }
+}
+
+/**
+ * @brief Returns the allocations made so far.
+ */
+AllocationTracker::Totals AllocationTracker::getTotals() {
+    Totals totals;
+    totals.allocations = allocationCount.load(std::memory_order_relaxed);
+    totals.bytes = allocatedBytes.load(std::memory_order_relaxed);
+    return totals;
+}
+
+/**
+ * @brief Counts one allocation. Called by operator new.
+ * @param size The bytes requested.
+ */
+void AllocationTracker::record(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) {
+    void* pointer = allocate(size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
@@ -0,0 +1,43 @@
+/**
+ * @file AllocationTracker.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the AllocationTracker class, which counts every heap
+ * allocation made through operator new, so the frame loop can report what it allocates.
+ */
+
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <cstddef>
+
+/**
+ * @class AllocationTracker
+ * @brief Totals of the global operator new, which AllocationTracker.cpp replaces.
+ *
+ * Every thread's allocations are counted, the workers' included, with relaxed atomic increments.
+ * A frame's allocations are the difference between the totals at its start and at its end.
+ */
+class AllocationTracker
+{
+public:
+    // Allocations since the program started
+    struct Totals
+    {
+        size_t allocations = 0;
+        size_t bytes = 0;
+    };
+
+    /**
+     * @brief Returns the allocations made so far.
+     */
+    static Totals getTotals();
+
+    /**
+     * @brief Counts one allocation. Called by operator new.
+     * @param size The bytes requested.
+     */
+    static void record(size_t size);
+};
+#endif // ALLOCATIONTRACKER_H
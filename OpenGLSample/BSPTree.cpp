@@ -10,191 +10,538 @@
  */
 
 #include "BSPTree.h"
- /**
-  * @brief Inserts an item into the BSP tree.
-  *
-  * This method inserts a given item into the appropriate position in the BSP tree based on its
-  * position relative to the partition item. It uses the dot product to determine whether the item
-  * should be placed in the front or back sub-tree.
-  *
-  * @param item A pointer to the item to be inserted into the BSP tree.
-  */
-void BSPTree::insert(Item* item) {
-    glm::vec3 relativePosition = { item->position.x - partitionItem->position.x, item->position.y - partitionItem->position.y, item->position.z - partitionItem->position.z };
-    float dotProduct = relativePosition.x * normal.x + relativePosition.y * normal.y + relativePosition.z * normal.z;
+#include <algorithm>
+#include <map>
 
-    if (dotProduct < 0) {
-        if (back) {
-            back->insert(item);
-        }
-        else {
-            back = new BSPTree(item);
-        }
-    }
-    else {
-        if (front) {
-            front->insert(item);
-        }
-        else {
-            front = new BSPTree(item);
-        }
+const unsigned char BSPTree::NODE_SKIPPED;
+const unsigned char BSPTree::NODE_CULLED;
+const unsigned char BSPTree::NODE_VISIBLE;
+
+namespace
+{
+    /**
+     * @brief Returns the point used to sort an item during a build.
+     */
+    glm::vec3 getItemCenter(const Item* item) {
+        return item->hasBounds() ? item->getBounds().getCenter() : item->position;
     }
 }
 
 /**
- * @brief Merges two subtrees into a single subtree.
+ * @brief Inserts an item into the BSP tree.
  *
- * This method merges the front and back subtrees by attaching the back subtree
- * to the rightmost node of the front subtree. It ensures that the resulting
- * subtree maintains the correct structure of a BSP tree.
+ * The item is placed when the tree is next built, which happens before the next query.
  *
- * @param front A pointer to the front subtree.
- * @param back A pointer to the back subtree.
- * @return A pointer to the merged subtree.
+ * @param item A pointer to the item to be inserted into the BSP tree.
  */
-BSPTree* BSPTree::mergeSubtrees(BSPTree* front, BSPTree* back) {
-    if (!front) return back;
-    if (!back) return front;
-
-    // Find the rightmost node of the front subtree
-    BSPTree* rightmost = front;
-    while (rightmost->front) {
-        rightmost = rightmost->front;
-    }
-    rightmost->front = back;
-    return front;
+void BSPTree::insert(Item* item) {
+    items.push_back(item);
+    needsBuild = true;
 }
 
 /**
  * @brief Removes an item from the BSP tree.
  *
- * This method traverses the BSP tree to find and remove the specified item.
- * It ensures that the tree structure remains valid after the removal.
+ * The item is not deleted. The nodes are rebuilt before the next query.
  *
  * @param item The item to be removed from the tree.
  */
 void BSPTree::remove(Item* item) {
-    glm::vec3 relativePosition = { item->position.x - partitionItem->position.x, item->position.y - partitionItem->position.y, item->position.z - partitionItem->position.z };
-    float dotProduct = relativePosition.x * normal.x + relativePosition.y * normal.y + relativePosition.z * normal.z;
-
-    if (dotProduct < 0) {
-        if (back) {
-            if (back->partitionItem == item) {
-                // Found the item in the back subtree
-                BSPTree* temp = back;
-                back = mergeSubtrees(back->front, back->back);
-                delete temp->partitionItem;
-                delete temp;
-            }
-            else {
-                back->remove(item);
-            }
-        }
-    }
-    else {
-        if (front) {
-            if (front->partitionItem == item) {
-                // Found the item in the front subtree
-                BSPTree* temp = front;
-                front = mergeSubtrees(front->front, front->back);
-                delete temp->partitionItem;
-                delete temp;
-            }
-            else {
-                front->remove(item);
-            }
-        }
+    std::vector<Item*>::iterator found = std::find(items.begin(), items.end(), item);
+    if (found != items.end()) {
+        items.erase(found);
+        needsBuild = true;
     }
 }
 
 /**
- * @brief Checks if a point is within the camera's view frustum.
+ * @brief Builds a balanced subtree from a range of items and appends its nodes.
  *
- * This method calculates the frustum planes based on the camera's position, direction, and field of view.
- * It then checks if the given point lies within these planes, determining if the point is visible within the camera's view frustum.
+ * The range is split at the median item center along the longest axis of the centers' bounds.
+ * The median item partitions the node, and the two halves become the back and front subtrees.
  *
- * @param point A reference to the glm::vec3 representing the point to be checked.
- * @param camera A reference to the Camera object used to determine the view frustum.
- * @return A boolean indicating whether the point is within the frustum (true) or not (false).
+ * @param begin The first item of the range in buildOrder.
+ * @param end One past the last item of the range.
+ * @param nodeDepth The depth of the node being built, 1 for the root.
+ * @return The index of the subtree's root node.
  */
-bool BSPTree::isPointInFrustum(const glm::vec3& point, const Camera& camera) {
-    // Calculate the frustum planes
-    glm::vec3 right = glm::normalize(glm::cross(camera.Front, camera.Up));
-    glm::vec3 up = glm::normalize(glm::cross(right, camera.Front));
+int32_t BSPTree::buildRange(size_t begin, size_t end, int nodeDepth) {
+    AABB centers;
+    for (size_t i = begin; i < end; i++) {
+        centers.expand(getItemCenter(buildOrder[i]));
+    }
+    glm::vec3 size = centers.max - centers.min;
+    int axis = 0;
+    if (size.y > size[axis]) axis = 1;
+    if (size.z > size[axis]) axis = 2;
 
-    float nearPlane = 0.1f; // Near clipping plane distance
-    float farPlane = 100.0f; // Far clipping plane distance
-    float aspectRatio = 16.0f / 9.0f; // Aspect ratio of the screen
-    float halfVSide = nearPlane * tanf(glm::radians(camera.Fov) / 2.0f);
-    float halfHSide = halfVSide * aspectRatio;
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(buildOrder.begin() + begin, buildOrder.begin() + mid, buildOrder.begin() + end,
+        [axis](const Item* a, const Item* b) { return getItemCenter(a)[axis] < getItemCenter(b)[axis]; });
 
-    glm::vec3 nearCenter = camera.Position + camera.Front * nearPlane;
-    glm::vec3 farCenter = camera.Position + camera.Front * farPlane;
+    // Children are appended after the parent, so keep an index rather than a reference
+    const int32_t index = static_cast<int32_t>(nodes.size());
+    nodes.push_back(Node());
+    nodes[index].item = buildOrder[mid];
+    nodes[index].normal = glm::vec3(0.0f);
+    nodes[index].normal[axis] = 1.0f;
+    nodes[index].split = getItemCenter(buildOrder[mid])[axis];
+    depth = std::max(depth, nodeDepth);
 
-    // Define the frustum planes
-    glm::vec3 planes[6];
-    planes[0] = nearCenter + up * halfVSide; // Top plane
-    planes[1] = nearCenter - up * halfVSide; // Bottom plane
-    planes[2] = nearCenter + right * halfHSide; // Right plane
-    planes[3] = nearCenter - right * halfHSide; // Left plane
-    planes[4] = nearCenter; // Near plane
-    planes[5] = farCenter; // Far plane
+    if (begin < mid) {
+        int32_t back = buildRange(begin, mid, nodeDepth + 1);
+        nodes[index].back = back;
+    }
+    if (mid + 1 < end) {
+        int32_t front = buildRange(mid + 1, end, nodeDepth + 1);
+        nodes[index].front = front;
+    }
+    nodes[index].subtreeEnd = static_cast<uint32_t>(nodes.size());
+    return index;
+}
 
-    // Check if the point is within the frustum
-    for (int i = 0; i < 6; ++i) {
-        if (glm::dot(point - camera.Position, planes[i] - camera.Position) < 0) {
+/**
+ * @brief Rebuilds the tree as a balanced tree over its current items.
+ *
+ * Every node splits at the median item center along the longest axis, which keeps the depth
+ * logarithmic in the number of items. The node array keeps its capacity, so a rebuild clears
+ * and refills the same memory. The subtree bounds are refit and the query buffers reserved
+ * when the build finishes.
+ */
+void BSPTree::build() {
+    nodes.clear();
+    nodes.reserve(items.size());
+    buildOrder.assign(items.begin(), items.end());
+    depth = 0;
+    if (!buildOrder.empty()) {
+        buildRange(0, buildOrder.size(), 1);
+    }
+    needsBuild = false;
+    indexNodes();
+    refit();
+    reserveQueryBuffers(items.size());
+}
+
+/**
+ * @brief Returns the nodes of the tree, building it first if its items changed.
+ * @param nodeData Receives one entry per node, in depth-first order.
+ */
+void BSPTree::getNodeData(std::vector<NodeData>& nodeData) {
+    if (needsBuild) {
+        build();
+    }
+    // Item pointers become their index in the insertion order
+    std::map<const Item*, uint32_t> itemIndices;
+    for (size_t i = 0; i < items.size(); i++) {
+        itemIndices[items[i]] = static_cast<uint32_t>(i);
+    }
+
+    nodeData.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const Node& node = nodes[i];
+        NodeData& data = nodeData[i];
+        data.item = itemIndices[node.item];
+        data.back = node.back;
+        data.front = node.front;
+        data.subtreeEnd = node.subtreeEnd;
+        data.axis = node.normal.y != 0.0f ? 1 : (node.normal.z != 0.0f ? 2 : 0);
+        data.split = node.split;
+    }
+}
+
+/**
+ * @brief Replaces the nodes with a tree built earlier over the same items, instead of building it.
+ *
+ * The nodes are checked to be a depth-first tree that holds every item once. The subtree bounds
+ * are refit from the items, which should be recorded first, and the query buffers reserved.
+ *
+ * @param nodeData The nodes, as returned by getNodeData.
+ * @param count The number of nodes.
+ * @return False, leaving the tree to be built, when the nodes do not match the items.
+ */
+bool BSPTree::setNodeData(const NodeData* nodeData, size_t count) {
+    if (count != items.size()) {
+        return false;
+    }
+    // As buildRange lays them out: the back subtree follows its parent, then the front subtree
+    std::vector<unsigned char> itemUsed(items.size(), 0);
+    std::vector<int> nodeDepths(count, 1);
+    for (size_t i = 0; i < count; i++) {
+        const NodeData& data = nodeData[i];
+        if (data.item >= items.size() || itemUsed[data.item] || data.axis > 2 || data.subtreeEnd <= i || data.subtreeEnd > count) {
             return false;
         }
+        itemUsed[data.item] = 1;
+        uint32_t next = static_cast<uint32_t>(i + 1);
+        const int32_t children[2] = { data.back, data.front };
+        for (int32_t child : children) {
+            if (child == -1) {
+                continue;
+            }
+            if (static_cast<uint32_t>(child) != next || next >= count || nodeData[child].subtreeEnd > data.subtreeEnd) {
+                return false;
+            }
+            nodeDepths[child] = nodeDepths[i] + 1;
+            next = nodeData[child].subtreeEnd;
+        }
+        if (next != data.subtreeEnd) {
+            return false;
+        }
+    }
+    if (count > 0 && nodeData[0].subtreeEnd != count) {
+        return false;
     }
+
+    nodes.resize(count);
+    depth = 0;
+    for (size_t i = 0; i < count; i++) {
+        const NodeData& data = nodeData[i];
+        Node& node = nodes[i];
+        node = Node();
+        node.item = items[data.item];
+        node.back = data.back;
+        node.front = data.front;
+        node.subtreeEnd = data.subtreeEnd;
+        node.normal = glm::vec3(0.0f);
+        node.normal[data.axis] = 1.0f;
+        node.split = data.split;
+        depth = std::max(depth, nodeDepths[i]);
+    }
+    needsBuild = false;
+    indexNodes();
+    refit();
+    reserveQueryBuffers(items.size());
     return true;
 }
 
+/**
+ * @brief Recomputes every subtree bound from the current item bounds, in O(n).
+ *
+ * Children are stored after their parent, so one backward pass over the node array visits
+ * every child before its parent. The tree structure does not change.
+ */
+void BSPTree::refit() {
+    for (size_t i = nodes.size(); i-- > 0;) {
+        refitNode(static_cast<uint32_t>(i));
+    }
+    for (uint32_t index : refitNodes) {
+        refitMarks[index] = 0;
+    }
+    refitNodes.clear();
+}
 
 /**
- * @brief Collects items that are in front of the camera and optionally within the view frustum.
+ * @brief Marks the subtree bounds above an item as out of date after its bounds changed.
+ *
+ * Ignored while a build is pending, since the build refits every node.
  *
- * This method checks if items are in front of the camera and, if specified, within the camera's view frustum.
- * It recursively traverses the scene graph to collect all such items into the provided result vector.
+ * @param item An item in the tree.
+ */
+void BSPTree::markBoundsChanged(const Item* item) {
+    if (needsBuild) {
+        return;
+    }
+    std::unordered_map<const Item*, uint32_t>::const_iterator found = itemNodes.find(item);
+    if (found == itemNodes.end()) {
+        return;
+    }
+    // An ancestor already marked has all of its own ancestors marked too
+    for (int32_t index = static_cast<int32_t>(found->second); index >= 0 && !refitMarks[index]; index = nodes[index].parent) {
+        refitMarks[index] = 1;
+        refitNodes.push_back(static_cast<uint32_t>(index));
+    }
+}
+
+/**
+ * @brief Recomputes the subtree bounds marked by markBoundsChanged.
  *
- * @param camera A reference to the Camera object used to determine the view frustum and direction.
+ * Only the changed items' nodes and their ancestors are visited, children before parents, so
+ * k moved items in a balanced tree cost O(k log n).
+ */
+void BSPTree::refitChanged() {
+    // Children are stored after their parent, so descending indices visit every child first
+    std::sort(refitNodes.begin(), refitNodes.end(), std::greater<uint32_t>());
+    for (uint32_t index : refitNodes) {
+        refitNode(index);
+        refitMarks[index] = 0;
+    }
+    refitNodes.clear();
+}
+
+/**
+ * @brief Recomputes one node's subtree bounds from its item and its children's subtree bounds.
+ */
+void BSPTree::refitNode(uint32_t index) {
+    Node& node = nodes[index];
+    node.subtreeBounds = node.item->getBounds();
+    node.boundsKnown = node.item->hasBounds();
+    if (node.back >= 0) {
+        node.subtreeBounds.merge(nodes[node.back].subtreeBounds);
+        node.boundsKnown = node.boundsKnown && nodes[node.back].boundsKnown;
+    }
+    if (node.front >= 0) {
+        node.subtreeBounds.merge(nodes[node.front].subtreeBounds);
+        node.boundsKnown = node.boundsKnown && nodes[node.front].boundsKnown;
+    }
+}
+
+/**
+ * @brief Sets the parent of every node and the node of every item, and clears the pending refits.
+ */
+void BSPTree::indexNodes() {
+    itemNodes.clear();
+    itemNodes.reserve(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+        Node& node = nodes[i];
+        itemNodes[node.item] = static_cast<uint32_t>(i);
+        if (node.back >= 0) {
+            nodes[node.back].parent = static_cast<int32_t>(i);
+        }
+        if (node.front >= 0) {
+            nodes[node.front].parent = static_cast<int32_t>(i);
+        }
+    }
+    refitNodes.clear();
+    refitMarks.assign(nodes.size(), 0);
+}
+
+/**
+ * @brief Collects the items of the subtrees whose bounds intersect the frustum.
+ *
+ * Subtrees with known bounds outside the frustum are skipped without visiting their nodes.
+ *
+ * @param frustum The view frustum.
+ * @param planeCount The number of frustum planes to test, starting with the near plane.
  * @param result A reference to a vector of Item pointers where the collected items will be stored.
- * @param checkFrustum A boolean flag indicating whether to perform the frustum check (true) or not (false).
+ * @param resultNodes Receives the node of each collected item.
  */
-void BSPTree::getAllFrontItems(Camera& camera, std::vector<Item*>& result, bool checkFrustum) {
-    if (!partitionItem) return;
+void BSPTree::collectCandidates(const Frustum& frustum, int planeCount, std::vector<Item*>& result, std::vector<uint32_t>& resultNodes) const {
+    size_t i = 0;
+    while (i < nodes.size()) {
+        const Node& node = nodes[i];
+        if (node.boundsKnown && !frustum.intersects(node.subtreeBounds, planeCount)) {
+            i = node.subtreeEnd;
+        }
+        else {
+            result.push_back(node.item);
+            resultNodes.push_back(static_cast<uint32_t>(i));
+            i++;
+        }
+    }
+}
 
-    // Calculate the vector from the camera to the item
-    glm::vec3 toItem = partitionItem->position - camera.Position;
+/**
+ * @brief Appends the visible items of a subtree, nearest partition side first.
+ *
+ * At each node the child on the viewer's side of the partition comes first, then the node's
+ * own item, then the far child, so every item is listed before the items it could hide.
+ *
+ * @param index The subtree's root node, or -1.
+ * @param viewPosition The point the order is taken from.
+ * @param visibleItems Receives the items.
+ */
+void BSPTree::appendFrontToBack(int32_t index, const glm::vec3& viewPosition, std::vector<Item*>& visibleItems) const {
+    // A skipped node heads a subtree culled as a whole
+    if (index < 0 || nodeStates[index] == NODE_SKIPPED) {
+        return;
+    }
+    const Node& node = nodes[index];
+    const bool viewerInFront = glm::dot(node.normal, viewPosition) >= node.split;
+    appendFrontToBack(viewerInFront ? node.front : node.back, viewPosition, visibleItems);
+    if (nodeStates[index] == NODE_VISIBLE) {
+        visibleItems.push_back(node.item);
+    }
+    appendFrontToBack(viewerInFront ? node.back : node.front, viewPosition, visibleItems);
+}
+
+/**
+ * @brief Writes the items whose bounds intersect a box into a caller-provided vector.
+ *
+ * Subtrees with known bounds outside the box are skipped. Items that have not been recorded
+ * yet have no bounds and are always returned. The output vector is cleared but keeps its capacity.
+ * The tree is built first when its items changed.
+ *
+ * @param region The world-space box.
+ * @param regionItems Receives the items in node order.
+ */
+void BSPTree::queryItemsInRegion(const AABB& region, std::vector<Item*>& regionItems) {
+    if (needsBuild) {
+        build();
+    }
 
-    // Check if the item is in front of the camera
-    bool isInFront = glm::dot(toItem, camera.Front) > 0;
+    regionItems.clear();
+    size_t i = 0;
+    while (i < nodes.size()) {
+        const Node& node = nodes[i];
+        if (node.boundsKnown && !node.subtreeBounds.overlaps(region)) {
+            i = node.subtreeEnd;
+            continue;
+        }
+        if (!node.item->hasBounds() || node.item->getBounds().overlaps(region)) {
+            regionItems.push_back(node.item);
+        }
+        i++;
+    }
+}
 
-    // Check if the item is within the frustum if the checkFrustum flag is true
-    bool isInFrustum = !checkFrustum || isPointInFrustum(partitionItem->position, camera);
+/**
+ * @brief Finds the first item a ray meets, or a sphere swept along it when radius is positive.
+ *
+ * Subtrees whose bounds, grown by the radius, the ray misses or enters beyond the closest hit so
+ * far are skipped. Items that start out overlapping the ray's origin are ignored, so whatever is
+ * moved can always leave them. Items without bounds are ignored. Reads the nodes and items only,
+ * so it may run while another thread culls the tree, but not while it is built or refit.
+ *
+ * @param origin The start of the ray, or the center of the sphere.
+ * @param direction The direction of the ray; distances are in multiples of its length.
+ * @param maxDistance The end of the ray.
+ * @param radius The radius of the swept sphere, 0 for a ray.
+ * @param hit Receives the closest item met.
+ * @param itemTest Tests an item's own geometry once its bounds are met; empty to use its bounds.
+ * @return True when an item is met before maxDistance.
+ */
+bool BSPTree::castRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float radius, RayHit& hit,
+    const ItemRayTest& itemTest) const {
+    float nearest = maxDistance;
+    bool found = false;
+    size_t i = 0;
+    while (i < nodes.size()) {
+        const Node& node = nodes[i];
+        float distance = 0.0f;
+        glm::vec3 normal;
+        if (node.boundsKnown && !node.subtreeBounds.inflated(radius).intersectRay(origin, direction, nearest, distance, normal)) {
+            i = node.subtreeEnd;
+            continue;
+        }
+        i++;
 
-    if (isInFront && isInFrustum) {
-        if (back) back->getAllFrontItems(camera, result, checkFrustum);
-        result.push_back(partitionItem);
-        // Recursively check the front node
-        if (front) front->getAllFrontItems(camera, result, checkFrustum);
+        const Item& item = *node.item;
+        if (!item.hasBounds() || !item.getBounds().inflated(radius).intersectRay(origin, direction, nearest, distance, normal)) {
+            continue;
+        }
+        if (itemTest ? !itemTest(item, origin, direction, nearest, radius, distance, normal) : distance < 0.0f) {
+            continue;
+        }
+        nearest = distance;
+        hit.item = node.item;
+        hit.distance = distance;
+        hit.normal = normal;
+        found = true;
     }
-    else {
-        if (front) front->getAllFrontItems(camera, result, checkFrustum);
+    return found;
+}
+
+/**
+ * @brief Returns true when an item overlaps a box, stopping at the first one.
+ *
+ * Subtrees outside the box are skipped. Items without bounds are ignored. Reads the nodes and
+ * items only, like castRay.
+ *
+ * @param region The world-space box.
+ * @param itemTest Tests an item's own geometry once its bounds overlap; empty to use its bounds.
+ */
+bool BSPTree::overlapsAnyItem(const AABB& region, const ItemBoxTest& itemTest) const {
+    size_t i = 0;
+    while (i < nodes.size()) {
+        const Node& node = nodes[i];
+        if (node.boundsKnown && !node.subtreeBounds.overlaps(region)) {
+            i = node.subtreeEnd;
+            continue;
+        }
+        i++;
+        const Item& item = *node.item;
+        if (item.hasBounds() && item.getBounds().overlaps(region) && (!itemTest || itemTest(item, region))) {
+            return true;
+        }
     }
+    return false;
 }
 
 /**
- * @brief Retrieves items in front of the camera and optionally within the view frustum.
+ * @brief Reserves the query buffers for a number of items.
  *
- * This method clears the result vector and then calls the getItemsInFront method to populate the
- * result vector with items that are in front of the camera and, if specified, within the view frustum.
+ * Called by build(); with the buffers reserved, queries in a tree of at most itemCount items
+ * do not allocate.
  *
- * @param camera A reference to the Camera object used to determine the view direction and frustum.
- * @param checkFrustum A boolean flag indicating whether to perform the frustum check (true) or not (false).
- * @return A vector of Item pointers containing the items in front of the camera.
+ * @param itemCount The number of items the queries must hold without growing.
  */
-std::vector<Item*> BSPTree::getCurrentFrontItems(Camera& camera, bool checkFrustum) {
-    result.clear(); // Clear the result vector
-    getAllFrontItems(camera, result, checkFrustum);
-    return result;
+void BSPTree::reserveQueryBuffers(size_t itemCount) {
+    candidates.reserve(itemCount);
+    candidateNodes.reserve(itemCount);
+    boxes.reserve(itemCount);
+    visibility.reserve(itemCount);
+    nodeStates.reserve(itemCount);
+}
+
+/**
+ * @brief Writes the items whose bounds intersect the view frustum into a caller-provided vector.
+ *
+ * This method walks the node array, skipping every subtree whose bounds lie outside the frustum.
+ * The item bounds of the remaining nodes are then tested in one batch. Items that have not been
+ * recorded yet have no bounds and are always returned, so they get recorded on their first frame.
+ * The output vector is cleared but keeps its capacity, so a reserved vector is reused every frame.
+ * With a job system, large batches are split across its workers.
+ *
+ * @param frustum The view frustum extracted from the projection * view matrix.
+ * @param checkFrustum A boolean flag indicating whether to test all six planes (true) or only
+ * the near plane, which drops items behind the camera (false).
+ * @param visibleItems Receives the visible items in node order, or front to back.
+ * @param jobs The workers that share the batch test, or nullptr to test on the calling thread.
+ * @param frontToBackFrom Orders the visible items front to back from this point through the
+ * partitions, or nullptr to keep node order.
+ */
+void BSPTree::queryVisibleItems(const Frustum& frustum, bool checkFrustum, std::vector<Item*>& visibleItems, JobSystem* jobs,
+    const glm::vec3* frontToBackFrom) {
+    if (needsBuild) {
+        build();
+    }
+
+    const int planeCount = Frustum::getPlaneCount(checkFrustum);
+    const size_t capacities[] = { visibleItems.capacity(), candidates.capacity(), boxes.centerX.capacity(), visibility.capacity() };
+
+    visibleItems.clear();
+    candidates.clear();
+    candidateNodes.clear();
+    collectCandidates(frustum, planeCount, candidates, candidateNodes);
+
+    boxes.clear();
+    for (Item* item : candidates) {
+        boxes.push(item->getBounds());
+    }
+    if (jobs != nullptr && boxes.size() > CULL_GRAIN_SIZE) {
+        visibility.assign(boxes.size(), 1);
+        jobs->parallelFor(boxes.size(), CULL_GRAIN_SIZE, [this, &frustum, planeCount](size_t begin, size_t end) {
+            frustum.cullRange(boxes, visibility, planeCount, begin, end);
+        });
+    }
+    else {
+        frustum.cull(boxes, visibility, planeCount);
+    }
+
+    if (frontToBackFrom == nullptr) {
+        for (size_t i = 0; i < candidates.size(); i++) {
+            if (visibility[i] || !candidates[i]->hasBounds()) {
+                visibleItems.push_back(candidates[i]);
+            }
+        }
+    }
+    else {
+        nodeStates.assign(nodes.size(), NODE_SKIPPED);
+        for (size_t i = 0; i < candidates.size(); i++) {
+            nodeStates[candidateNodes[i]] = (visibility[i] || !candidates[i]->hasBounds()) ? NODE_VISIBLE : NODE_CULLED;
+        }
+        if (!nodes.empty()) {
+            appendFrontToBack(0, *frontToBackFrom, visibleItems);
+        }
+    }
+
+    // Every buffer whose capacity changed had to allocate; BoxList grows its six arrays together
+    const size_t grownCapacities[] = { visibleItems.capacity(), candidates.capacity(), boxes.centerX.capacity(), visibility.capacity() };
+    const size_t allocationsPerBuffer[] = { 1, 1, 6, 1 };
+    queryAllocations = 0;
+    for (size_t i = 0; i < sizeof(capacities) / sizeof(capacities[0]); i++) {
+        if (grownCapacities[i] != capacities[i]) {
+            queryAllocations += allocationsPerBuffer[i];
+        }
+    }
 }
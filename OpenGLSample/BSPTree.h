@@ -12,7 +12,13 @@
 #ifndef BSPTREE_H
 #define BSPTREE_H
 
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
 #include "Item.h"
+#include "Frustum.h"
+#include "JobSystem.h"
 
  /**
   * @class BSPtree
@@ -20,43 +26,141 @@
   *
   * The BSPtree class is used for efficient rendering of 3D scenes by recursively subdividing a space into convex
   * sets using hyperplanes. It includes methods for creating, inserting, and retrieving items in the BSP tree.
+  *
+  * The nodes live in one contiguous array in depth-first order: every node is followed by its back
+  * subtree and then its front subtree, and stores the index one past its subtree. A query walks the
+  * array front to back and skips a culled subtree by jumping to that index. The tree does not own
+  * its items; the scene that inserts them deletes them.
   */
 class BSPTree {
 private:
-    Item* partitionItem;
-    BSPTree* front;
-    BSPTree* back;
-    glm::vec3 normal = glm::vec3(0.0f, 0.0f, 1.0f);
-    std::vector<Item*> result;
+    // One node of the tree, linked to its children by index
+    struct Node
+    {
+        Item* item = nullptr;
+        int32_t back = -1;                  // Index of the back child, or -1
+        int32_t front = -1;                 // Index of the front child, or -1
+        int32_t parent = -1;                // Index of the parent, or -1 for the root
+        uint32_t subtreeEnd = 0;            // One past the last node of this subtree
+        glm::vec3 normal = glm::vec3(0.0f, 0.0f, 1.0f);
+        float split = 0.0f;                 // Position of the partition along normal; the front subtree lies above it
+        AABB subtreeBounds;                 // Bounds of this node's item and both subtrees
+        bool boundsKnown = false;           // False while an item below this node has no bounds
+    };
+
+    std::vector<Item*> items;               // Items in the tree, in the order they were inserted
+    std::vector<Item*> buildOrder;          // Scratch copy of items reordered by the build
+    std::vector<Node> nodes;                // Depth-first node array
+    bool needsBuild = false;                // True when items changed since the last build
+    int depth = 0;                          // Depth of the deepest node after the last build
+    std::vector<Item*> candidates;          // Items of the subtrees that intersect the frustum
+    BoxList boxes;                          // Bounds of the candidates, one entry per item
+    std::vector<unsigned char> visibility;  // Cull result per candidate
+    std::vector<uint32_t> candidateNodes;   // Node of each candidate
+    std::vector<unsigned char> nodeStates;  // Per node, for a front-to-back query: NODE_SKIPPED, NODE_CULLED or NODE_VISIBLE
+    size_t queryAllocations = 0;            // Buffers that had to grow during the last query
+    std::unordered_map<const Item*, uint32_t> itemNodes; // Node of each item after the last build
+    std::vector<uint32_t> refitNodes;       // Nodes whose subtree bounds are out of date
+    std::vector<unsigned char> refitMarks;  // Per node, 1 while listed in refitNodes
+
+    static const size_t CULL_GRAIN_SIZE = 1024; // Boxes tested per job when the batch is split
+
+    // What a query found for a node
+    static const unsigned char NODE_SKIPPED = 0;    // In a subtree outside the frustum
+    static const unsigned char NODE_CULLED = 1;     // Reached, but the item is outside the frustum
+    static const unsigned char NODE_VISIBLE = 2;
+
+    /**
+     * @brief Builds a balanced subtree from a range of items and appends its nodes.
+     *
+     * The range is split at the median item center along the longest axis of the centers' bounds.
+     * The median item partitions the node, and the two halves become the back and front subtrees.
+     *
+     * @param begin The first item of the range in buildOrder.
+     * @param end One past the last item of the range.
+     * @param nodeDepth The depth of the node being built, 1 for the root.
+     * @return The index of the subtree's root node.
+     */
+    int32_t buildRange(size_t begin, size_t end, int nodeDepth);
+
+    /**
+     * @brief Collects the items of the subtrees whose bounds intersect the frustum.
+     *
+     * Subtrees with known bounds outside the frustum are skipped without visiting their nodes.
+     *
+     * @param frustum The view frustum.
+     * @param planeCount The number of frustum planes to test, starting with the near plane.
+     * @param result A reference to a vector of Item pointers where the collected items will be stored.
+     * @param resultNodes Receives the node of each collected item.
+     */
+    void collectCandidates(const Frustum& frustum, int planeCount, std::vector<Item*>& result, std::vector<uint32_t>& resultNodes) const;
+
+    /**
+     * @brief Appends the visible items of a subtree, nearest partition side first.
+     *
+     * At each node the child on the viewer's side of the partition comes first, then the node's
+     * own item, then the far child, so every item is listed before the items it could hide.
+     *
+     * @param index The subtree's root node, or -1.
+     * @param viewPosition The point the order is taken from.
+     * @param visibleItems Receives the items.
+     */
+    void appendFrontToBack(int32_t index, const glm::vec3& viewPosition, std::vector<Item*>& visibleItems) const;
+
+    /**
+     * @brief Recomputes one node's subtree bounds from its item and its children's subtree bounds.
+     */
+    void refitNode(uint32_t index);
+
+    /**
+     * @brief Sets the parent of every node and the node of every item, and clears the pending refits.
+     */
+    void indexNodes();
 
 public:
+    // A node without its bounds, with the item as an index into getItems(), as stored in a scene file
+    struct NodeData
+    {
+        uint32_t item = 0;
+        int32_t back = -1;
+        int32_t front = -1;
+        uint32_t subtreeEnd = 0;
+        uint32_t axis = 0;                  // Axis of the partition normal, 0 to 2
+        float split = 0.0f;
+    };
+
+    // The closest item a ray or swept sphere meets
+    struct RayHit
+    {
+        Item* item = nullptr;
+        float distance = 0.0f;              // Along the ray, in multiples of its direction's length
+        glm::vec3 normal = glm::vec3(0.0f); // Of the face that was met
+    };
+
+    // Finds where a ray, against boxes grown by a radius, enters the geometry of one item from outside.
+    // Arguments: item, origin, direction, maxDistance, radius, distance (out), normal (out).
+    typedef std::function<bool(const Item&, const glm::vec3&, const glm::vec3&, float, float, float&, glm::vec3&)> ItemRayTest;
+
+    // Returns true when the geometry of one item overlaps a box
+    typedef std::function<bool(const Item&, const AABB&)> ItemBoxTest;
+
     /**
      * @brief Constructor for the BSPtree class.
-     * 
-     * This constructor initializes the BSPtree with a given partition item. It sets the partition item,
-     * and initializes the front and back sub-trees to nullptr.
-     * 
-     * @param partitionItem A pointer to the item used for partitioning the space.
-     */
-    BSPTree(Item* partitionItem) : partitionItem(partitionItem), front(nullptr), back(nullptr) {}
-
-    ~BSPTree() {
-        if (front != nullptr) {
-            delete front->partitionItem;
-            delete front;
-        }
-        if (back != nullptr) {
-            delete back->partitionItem;
-            delete back;
+     *
+     * This constructor initializes the BSPtree with a given partition item.
+     *
+     * @param partitionItem A pointer to the first item in the tree, or nullptr for an empty tree.
+     */
+    BSPTree(Item* partitionItem) {
+        if (partitionItem != nullptr) {
+            insert(partitionItem);
         }
     }
 
     /**
      * @brief Inserts an item into the BSP tree.
      *
-     * This method inserts a given item into the appropriate position in the BSP tree based on its
-     * position relative to the partition item. It uses the dot product to determine whether the item
-     * should be placed in the front or back sub-tree.
+     * The item is placed when the tree is next built, which happens before the next query.
      *
      * @param item A pointer to the item to be inserted into the BSP tree.
      */
@@ -65,49 +169,160 @@ public:
     /**
      * @brief Removes an item from the BSP tree.
      *
-     * This method traverses the BSP tree to find and remove the specified item.
-     * It ensures that the tree structure remains valid after the removal.
+     * The item is not deleted. The nodes are rebuilt before the next query.
      *
      * @param item The item to be removed from the tree.
      */
     void remove(Item* item);
 
-    BSPTree* mergeSubtrees(BSPTree* front, BSPTree* back);
+    /**
+     * @brief Rebuilds the tree as a balanced tree over its current items.
+     *
+     * Every node splits at the median item center along the longest axis, which keeps the depth
+     * logarithmic in the number of items. The node array keeps its capacity, so a rebuild clears
+     * and refills the same memory. The subtree bounds are refit and the query buffers reserved
+     * when the build finishes.
+     */
+    void build();
+
+    /**
+     * @brief Returns the nodes of the tree, building it first if its items changed.
+     * @param nodeData Receives one entry per node, in depth-first order.
+     */
+    void getNodeData(std::vector<NodeData>& nodeData);
 
     /**
-     * @brief Collects items that are in front of the camera and optionally within the view frustum.
+     * @brief Replaces the nodes with a tree built earlier over the same items, instead of building it.
      *
-     * This method checks if items are in front of the camera and, if specified, within the camera's view frustum.
-     * It recursively traverses the scene graph to collect all such items into the provided result vector.
+     * The nodes are checked to be a depth-first tree that holds every item once. The subtree bounds
+     * are refit from the items, which should be recorded first, and the query buffers reserved.
      *
-     * @param camera A reference to the Camera object used to determine the view frustum and direction.
-     * @param result A reference to a vector of Item pointers where the collected items will be stored.
-     * @param checkFrustum A boolean flag indicating whether to perform the frustum check (true) or not (false).
+     * @param nodeData The nodes, as returned by getNodeData.
+     * @param count The number of nodes.
+     * @return False, leaving the tree to be built, when the nodes do not match the items.
+     */
+    bool setNodeData(const NodeData* nodeData, size_t count);
+
+    /**
+     * @brief Recomputes every subtree bound from the current item bounds, in O(n).
+     *
+     * Children are stored after their parent, so one backward pass over the node array visits
+     * every child before its parent. The tree structure does not change.
+     */
+    void refit();
+
+    /**
+     * @brief Marks the subtree bounds above an item as out of date after its bounds changed.
+     *
+     * Ignored while a build is pending, since the build refits every node.
+     *
+     * @param item An item in the tree.
+     */
+    void markBoundsChanged(const Item* item);
+
+    /**
+     * @brief Recomputes the subtree bounds marked by markBoundsChanged.
+     *
+     * Only the changed items' nodes and their ancestors are visited, children before parents, so
+     * k moved items in a balanced tree cost O(k log n).
+     */
+    void refitChanged();
+
+    /**
+     * @brief Returns true when subtree bounds were marked since the last refit.
+     */
+    bool isRefitPending() const { return !refitNodes.empty(); }
+
+    /**
+     * @brief Returns the depth of the deepest node after the last build, 1 for a single node.
+     */
+    int getDepth() const { return depth; }
+
+    /**
+     * @brief Returns the items in the tree.
      */
-    void getAllFrontItems(Camera& camera, std::vector<Item*>& result, bool checkFrustum);
+    const std::vector<Item*>& getItems() const { return items; }
 
     /**
-     * @brief Retrieves items in front of the camera and optionally within the view frustum.
+     * @brief Reserves the query buffers for a number of items.
      *
-     * This method clears the result vector and then calls the getItemsInFront method to populate the
-     * result vector with items that are in front of the camera and, if specified, within the view frustum.
+     * Called by build(); with the buffers reserved, queries in a tree of at most itemCount items
+     * do not allocate.
      *
-     * @param camera A reference to the Camera object used to determine the view direction and frustum.
-     * @param checkFrustum A boolean flag indicating whether to perform the frustum check (true) or not (false).
-     * @return A vector of Item pointers containing the items in front of the camera.
+     * @param itemCount The number of items the queries must hold without growing.
      */
-    std::vector<Item*> getCurrentFrontItems(Camera& camera, bool checkFrustum);
+    void reserveQueryBuffers(size_t itemCount);
 
     /**
-     * @brief Checks if a point is within the camera's view frustum.
+     * @brief Writes the items whose bounds intersect the view frustum into a caller-provided vector.
      *
-     * This method calculates the frustum planes based on the camera's position, direction, and field of view.
-     * It then checks if the given point lies within these planes, determining if the point is visible within the camera's view frustum.
+     * This method walks the node array, skipping every subtree whose bounds lie outside the frustum.
+     * The item bounds of the remaining nodes are then tested in one batch. Items that have not been
+     * recorded yet have no bounds and are always returned, so they get recorded on their first frame.
+     * The output vector is cleared but keeps its capacity, so a reserved vector is reused every frame.
+     * With a job system, large batches are split across its workers.
      *
-     * @param point A reference to the glm::vec3 representing the point to be checked.
-     * @param camera A reference to the Camera object used to determine the view frustum.
-     * @return A boolean indicating whether the point is within the frustum (true) or not (false).
+     * @param frustum The view frustum extracted from the projection * view matrix.
+     * @param checkFrustum A boolean flag indicating whether to test all six planes (true) or only
+     * the near plane, which drops items behind the camera (false).
+     * @param visibleItems Receives the visible items in node order, or front to back.
+     * @param jobs The workers that share the batch test, or nullptr to test on the calling thread.
+     * @param frontToBackFrom Orders the visible items front to back from this point through the
+     * partitions, or nullptr to keep node order.
+     */
+    void queryVisibleItems(const Frustum& frustum, bool checkFrustum, std::vector<Item*>& visibleItems, JobSystem* jobs = nullptr,
+        const glm::vec3* frontToBackFrom = nullptr);
+
+    /**
+     * @brief Writes the items whose bounds intersect a box into a caller-provided vector.
+     *
+     * Subtrees with known bounds outside the box are skipped. Items that have not been recorded
+     * yet have no bounds and are always returned. The output vector is cleared but keeps its capacity.
+     * The tree is built first when its items changed.
+     *
+     * @param region The world-space box.
+     * @param regionItems Receives the items in node order.
+     */
+    void queryItemsInRegion(const AABB& region, std::vector<Item*>& regionItems);
+
+    /**
+     * @brief Finds the first item a ray meets, or a sphere swept along it when radius is positive.
+     *
+     * Subtrees whose bounds, grown by the radius, the ray misses or enters beyond the closest hit so
+     * far are skipped. Items that start out overlapping the ray's origin are ignored, so whatever is
+     * moved can always leave them. Items without bounds are ignored. Reads the nodes and items only,
+     * so it may run while another thread culls the tree, but not while it is built or refit.
+     *
+     * @param origin The start of the ray, or the center of the sphere.
+     * @param direction The direction of the ray; distances are in multiples of its length.
+     * @param maxDistance The end of the ray.
+     * @param radius The radius of the swept sphere, 0 for a ray.
+     * @param hit Receives the closest item met.
+     * @param itemTest Tests an item's own geometry once its bounds are met; empty to use its bounds.
+     * @return True when an item is met before maxDistance.
+     */
+    bool castRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float radius, RayHit& hit,
+        const ItemRayTest& itemTest = ItemRayTest()) const;
+
+    /**
+     * @brief Returns true when an item overlaps a box, stopping at the first one.
+     *
+     * Subtrees outside the box are skipped. Items without bounds are ignored. Reads the nodes and
+     * items only, like castRay.
+     *
+     * @param region The world-space box.
+     * @param itemTest Tests an item's own geometry once its bounds overlap; empty to use its bounds.
+     */
+    bool overlapsAnyItem(const AABB& region, const ItemBoxTest& itemTest = ItemBoxTest()) const;
+
+    /**
+     * @brief Returns true when items were inserted or removed since the last build.
+     */
+    bool isBuildPending() const { return needsBuild; }
+
+    /**
+     * @brief Returns the number of heap allocations made by the last query, 0 in steady state.
      */
-    bool isPointInFrustum(const glm::vec3& point, const Camera& camera);
+    size_t getQueryAllocations() const { return queryAllocations; }
 };
-#endif // BSPTREE_H
\ No newline at end of file
+#endif // BSPTREE_H
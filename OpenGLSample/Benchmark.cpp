@@ -0,0 +1,177 @@
+/**
+ * @file Benchmark.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the Benchmark class.
+ */
+
+#include "Benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+const float Benchmark::TIME_STEP = 1.0f / 60.0f;
+const int Benchmark::WARMUP_FRAMES;
+const int Benchmark::MAX_WARMUP_FRAMES;
+
+// Unnamed namespace
+namespace
+{
+    /**
+     * @brief Writes the mean, percentiles and maximum of a series as a JSON object member.
+     */
+    void writeSeries(std::ofstream& file, const char* name, const std::vector<double>& samples, double p50, double p95, double p99) {
+        double sum = 0.0;
+        double maximum = 0.0;
+        for (double sample : samples) {
+            sum += sample;
+            maximum = std::max(maximum, sample);
+        }
+        char line[256];
+        std::snprintf(line, sizeof(line), "  \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+            name, samples.empty() ? 0.0 : sum / samples.size(), p50, p95, p99, maximum);
+        file << line;
+    }
+
+    /**
+     * @brief Returns a string as the contents of a JSON string literal, with quotes, backslashes and control characters escaped.
+     */
+    std::string escapeJson(const std::string& text) {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (char c : text) {
+            const unsigned char code = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            }
+            else if (code < 0x20) {
+                // Written as a four digit code point, which covers every control character
+                char sequence[8];
+                std::snprintf(sequence, sizeof(sequence), "\\u%04x", code);
+                escaped += sequence;
+            }
+            else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+}
+
+/**
+ * @brief Creates a run from its settings.
+ * @param settings The camera path, scene size and output file.
+ */
+Benchmark::Benchmark(const Settings& settings) : settings(settings) {
+}
+
+/**
+ * @brief Reads the camera path.
+ * @return True when the path has keys.
+ */
+bool Benchmark::load() {
+    return path.load(settings.pathFile.c_str());
+}
+
+/**
+ * @brief Places the camera for the next frame. The frame is drawn with TIME_STEP as its delta time.
+ * @param camera The camera to place.
+ * @param profiler The profiler timing the frames; measurement starts on it after the warm-up.
+ * @param pendingTextures The texture files still loading, which extend the warm-up.
+ * @return False once the path has been replayed, with no frame to draw.
+ */
+bool Benchmark::beginFrame(Camera& camera, Profiler& profiler, size_t pendingTextures) {
+    if (!measuring) {
+        path.apply(0.0f, camera);
+        warmupFrame++;
+        if (warmupFrame >= MAX_WARMUP_FRAMES || (warmupFrame >= WARMUP_FRAMES && pendingTextures == 0)) {
+            // The warm-up frames still in flight are resolved before the log starts
+            profiler.flush();
+            profiler.setFrameLog(&timings);
+            measuring = true;
+        }
+        return true;
+    }
+
+    const float time = measuredFrame * TIME_STEP;
+    if (time > path.getDuration()) {
+        return false;
+    }
+    path.apply(time, camera);
+    measuredFrame++;
+    return true;
+}
+
+/**
+ * @brief Collects the last frames from the profiler and writes the results.
+ * @param profiler The profiler passed to beginFrame.
+ * @param renderer The GL renderer string, to tell runs on different hardware apart.
+ * @return True when the results file was written.
+ */
+bool Benchmark::finish(Profiler& profiler, const char* renderer) {
+    profiler.flush();
+    profiler.setFrameLog(nullptr);
+
+    std::vector<double> cpuMs;
+    std::vector<double> gpuMs;
+    std::vector<double> drawCalls;
+    std::vector<double> triangles;
+    std::vector<double> stateChanges;
+    std::vector<double> allocations;
+    for (const Profiler::FrameTiming& timing : timings) {
+        cpuMs.push_back(timing.cpuMs);
+        gpuMs.push_back(timing.gpuMs);
+        drawCalls.push_back(static_cast<double>(timing.counters.drawCalls));
+        triangles.push_back(static_cast<double>(timing.counters.triangles));
+        stateChanges.push_back(static_cast<double>(timing.counters.stateChanges));
+        allocations.push_back(static_cast<double>(timing.counters.allocations));
+    }
+
+    std::ofstream file(settings.outputFile.c_str(), std::ios::trunc);
+    if (!file) {
+        std::cout << "ERROR::BENCHMARK::RESULTS_NOT_WRITTEN " << settings.outputFile << std::endl;
+        return false;
+    }
+    file << "{\n";
+    file << "  \"path\": \"" << escapeJson(settings.pathFile) << "\",\n";
+    file << "  \"renderer\": \"" << escapeJson(renderer != nullptr ? renderer : "") << "\",\n";
+    file << "  \"tableCopies\": " << settings.tableCopies << ",\n";
+    file << "  \"fireflies\": " << settings.fireflyCount << ",\n";
+    file << "  \"seed\": " << settings.seed << ",\n";
+    file << "  \"frames\": " << timings.size() << ",\n";
+    file << "  \"warmupFrames\": " << warmupFrame << ",\n";
+    writeSeries(file, "cpuFrameMs", cpuMs, percentile(cpuMs, 0.5), percentile(cpuMs, 0.95), percentile(cpuMs, 0.99));
+    file << ",\n";
+    writeSeries(file, "gpuFrameMs", gpuMs, percentile(gpuMs, 0.5), percentile(gpuMs, 0.95), percentile(gpuMs, 0.99));
+    file << ",\n";
+    writeSeries(file, "drawCalls", drawCalls, percentile(drawCalls, 0.5), percentile(drawCalls, 0.95), percentile(drawCalls, 0.99));
+    file << ",\n";
+    writeSeries(file, "triangles", triangles, percentile(triangles, 0.5), percentile(triangles, 0.95), percentile(triangles, 0.99));
+    file << ",\n";
+    writeSeries(file, "stateChanges", stateChanges, percentile(stateChanges, 0.5), percentile(stateChanges, 0.95), percentile(stateChanges, 0.99));
+    file << ",\n";
+    writeSeries(file, "allocations", allocations, percentile(allocations, 0.5), percentile(allocations, 0.95), percentile(allocations, 0.99));
+    file << "\n}\n";
+
+    std::cout << "Benchmark: " << timings.size() << " frames, CPU p50 " << percentile(cpuMs, 0.5) << " p95 " << percentile(cpuMs, 0.95)
+        << " p99 " << percentile(cpuMs, 0.99) << " ms, GPU p50 " << percentile(gpuMs, 0.5) << " p95 " << percentile(gpuMs, 0.95)
+        << " p99 " << percentile(gpuMs, 0.99) << " ms, written to " << settings.outputFile << std::endl;
+    return true;
+}
+
+/**
+ * @brief Returns the value below which a fraction of the samples fall, by nearest rank.
+ */
+double Benchmark::percentile(std::vector<double> samples, double fraction) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(fraction * samples.size()));
+    rank = std::min(std::max<size_t>(rank, 1), samples.size()) - 1;
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
@@ -0,0 +1,97 @@
+/**
+ * @file Benchmark.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the Benchmark class, which replays a camera path with a
+ * fixed time step and reports frame time percentiles as JSON.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CameraPath.h"
+#include "Profiler.h"
+
+/**
+ * @class Benchmark
+ * @brief A repeatable run of the scene along a recorded camera path.
+ *
+ * Every frame advances the same fixed time step, so the camera poses, level of detail and firefly
+ * movement are the same from run to run. The run starts with warm-up frames at the first pose, held
+ * until the texture files have loaded, whose times are not counted. The frame times of the measured
+ * frames come from the profiler, GPU time included, and are written with their percentiles and the
+ * draw counters as one JSON object, for regression tracking.
+ */
+class Benchmark
+{
+public:
+    // Time step of every frame
+    static const float TIME_STEP;
+    // Frames drawn before the measurement, at least
+    static const int WARMUP_FRAMES = 60;
+    // Longest warm-up waiting for textures
+    static const int MAX_WARMUP_FRAMES = 600;
+
+    // What the run replays and where the results go
+    struct Settings
+    {
+        std::string pathFile;                               // Camera path to replay
+        std::string outputFile = "benchmark_results.json";
+        int tableCopies = 1;
+        int fireflyCount = 10;
+        uint32_t seed = 0;
+    };
+
+    /**
+     * @brief Creates a run from its settings.
+     * @param settings The camera path, scene size and output file.
+     */
+    explicit Benchmark(const Settings& settings);
+
+    /**
+     * @brief Reads the camera path.
+     * @return True when the path has keys.
+     */
+    bool load();
+
+    /**
+     * @brief Places the camera for the next frame. The frame is drawn with TIME_STEP as its delta time.
+     * @param camera The camera to place.
+     * @param profiler The profiler timing the frames; measurement starts on it after the warm-up.
+     * @param pendingTextures The texture files still loading, which extend the warm-up.
+     * @return False once the path has been replayed, with no frame to draw.
+     */
+    bool beginFrame(Camera& camera, Profiler& profiler, size_t pendingTextures);
+
+    /**
+     * @brief Collects the last frames from the profiler and writes the results.
+     * @param profiler The profiler passed to beginFrame.
+     * @param renderer The GL renderer string, to tell runs on different hardware apart.
+     * @return True when the results file was written.
+     */
+    bool finish(Profiler& profiler, const char* renderer);
+
+    /**
+     * @brief Returns the settings of the run.
+     */
+    const Settings& getSettings() const { return settings; }
+
+private:
+    Settings settings;
+    CameraPath path;
+    int warmupFrame = 0;
+    int measuredFrame = 0;
+    bool measuring = false;
+    std::vector<Profiler::FrameTiming> timings;
+
+    /**
+     * @brief Returns the value below which a fraction of the samples fall, by nearest rank.
+     */
+    static double percentile(std::vector<double> samples, double fraction);
+};
+#endif // BENCHMARK_H
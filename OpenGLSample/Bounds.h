@@ -0,0 +1,153 @@
+/**
+ * @file Bounds.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the AABB structure, an axis-aligned bounding box.
+ */
+
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <cfloat>
+#include <glm/glm.hpp>
+
+/**
+ * @struct AABB
+ * @brief An axis-aligned bounding box stored as its minimum and maximum corners.
+ *
+ * A default constructed box is empty: its minimum is larger than its maximum, so the first
+ * expand() or merge() makes it the bounds of that point or box.
+ */
+struct AABB
+{
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    /**
+     * @brief Returns true when the box contains at least one point.
+     */
+    bool isValid() const {
+        return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+    }
+
+    glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+    glm::vec3 getExtents() const { return (max - min) * 0.5f; }
+
+    /**
+     * @brief Grows the box to contain a point.
+     */
+    void expand(const glm::vec3& point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    /**
+     * @brief Grows the box to contain another box. Empty boxes are ignored.
+     */
+    void merge(const AABB& other) {
+        if (other.isValid()) {
+            expand(other.min);
+            expand(other.max);
+        }
+    }
+
+    /**
+     * @brief Returns true when two boxes share at least one point.
+     */
+    bool overlaps(const AABB& other) const {
+        return min.x <= other.max.x && max.x >= other.min.x
+            && min.y <= other.max.y && max.y >= other.min.y
+            && min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    /**
+     * @brief Returns the box grown by a margin on every side.
+     *
+     * Growing a box by a sphere's radius turns a sphere sweep into a ray cast. The grown box is
+     * slightly larger than the true sweep volume at its edges and corners, which errs on the side
+     * of a collision.
+     */
+    AABB inflated(float margin) const {
+        AABB result;
+        result.min = min - glm::vec3(margin);
+        result.max = max + glm::vec3(margin);
+        return result;
+    }
+
+    /**
+     * @brief Finds where a ray enters the box, with the slab method.
+     *
+     * @param origin The start of the ray.
+     * @param direction The direction of the ray; distances are in multiples of its length.
+     * @param maxDistance The end of the ray.
+     * @param entry Receives the distance at which the ray enters, negative when the origin is inside.
+     * @param normal Receives the normal of the face the ray enters through, or zero when the origin is inside.
+     * @return True when the ray meets the box between its origin and maxDistance.
+     */
+    bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& entry, glm::vec3& normal) const {
+        if (!isValid()) {
+            return false;
+        }
+        float entryDistance = -FLT_MAX;
+        float exitDistance = FLT_MAX;
+        int entryAxis = -1;
+        for (int axis = 0; axis < 3; axis++) {
+            if (glm::abs(direction[axis]) < 1e-8f) {
+                // Parallel to the slab: inside it all along, or never
+                if (origin[axis] < min[axis] || origin[axis] > max[axis]) {
+                    return false;
+                }
+                continue;
+            }
+            const float inverse = 1.0f / direction[axis];
+            const float t0 = (min[axis] - origin[axis]) * inverse;
+            const float t1 = (max[axis] - origin[axis]) * inverse;
+            if (glm::min(t0, t1) > entryDistance) {
+                entryDistance = glm::min(t0, t1);
+                entryAxis = axis;
+            }
+            exitDistance = glm::min(exitDistance, glm::max(t0, t1));
+            if (entryDistance > exitDistance) {
+                return false;
+            }
+        }
+        if (exitDistance < 0.0f || entryDistance > maxDistance) {
+            return false;
+        }
+        entry = entryDistance;
+        normal = glm::vec3(0.0f);
+        if (entryDistance >= 0.0f && entryAxis >= 0) {
+            normal[entryAxis] = direction[entryAxis] > 0.0f ? -1.0f : 1.0f;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Returns the bounds of this box after a transformation.
+     *
+     * The extents are projected onto each world axis with the absolute value of the matrix
+     * (Arvo's method), which is exact for the box's eight corners without transforming them.
+     *
+     * @param model The transformation applied to the box.
+     * @return The world-space bounds, or an empty box if this box is empty.
+     */
+    AABB transformed(const glm::mat4& model) const {
+        if (!isValid()) {
+            return AABB();
+        }
+        glm::vec3 center = glm::vec3(model * glm::vec4(getCenter(), 1.0f));
+        glm::vec3 extents = getExtents();
+        glm::vec3 newExtents;
+        for (int row = 0; row < 3; row++) {
+            newExtents[row] = glm::abs(model[0][row]) * extents.x
+                + glm::abs(model[1][row]) * extents.y
+                + glm::abs(model[2][row]) * extents.z;
+        }
+        AABB result;
+        result.min = center - newExtents;
+        result.max = center + newExtents;
+        return result;
+    }
+};
+#endif // BOUNDS_H
@@ -0,0 +1,98 @@
+/**
+ * @file CameraPath.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the CameraPath class.
+ */
+
+#include "CameraPath.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/**
+ * @brief Reads a path from a file, replacing the current keys.
+ * @param path The file path of the camera path.
+ * @return True when the file held at least one key.
+ */
+bool CameraPath::load(const char* path) {
+    keys.clear();
+    std::ifstream file(path);
+    if (!file) {
+        std::cout << "ERROR::CAMERAPATH::FILE_NOT_FOUND " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream values(line);
+        Key key;
+        if (!(values >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch)) {
+            std::cout << "ERROR::CAMERAPATH::BAD_KEY " << line << std::endl;
+            continue;
+        }
+        keys.push_back(key);
+    }
+    return !keys.empty();
+}
+
+/**
+ * @brief Writes the keys to a file.
+ * @param path The file path of the camera path.
+ * @return True when the file was written.
+ */
+bool CameraPath::save(const char* path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cout << "ERROR::CAMERAPATH::FILE_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+    file << "# time x y z yaw pitch" << std::endl;
+    for (const Key& key : keys) {
+        file << key.time << ' ' << key.position.x << ' ' << key.position.y << ' ' << key.position.z << ' '
+            << key.yaw << ' ' << key.pitch << std::endl;
+    }
+    return true;
+}
+
+/**
+ * @brief Appends the camera's current pose as a key.
+ * @param time The time of the key, after the last key's.
+ * @param camera The camera whose pose is recorded.
+ */
+void CameraPath::addKey(float time, const Camera& camera) {
+    Key key = { time, camera.Position, camera.Yaw, camera.Pitch };
+    keys.push_back(key);
+}
+
+/**
+ * @brief Places the camera at the pose of the path at a time, clamped to the path's ends.
+ * @param time The time along the path in seconds.
+ * @param camera The camera to place.
+ */
+void CameraPath::apply(float time, Camera& camera) const {
+    if (keys.empty()) {
+        return;
+    }
+    // Keys are few and visited in order, so a linear search is enough
+    size_t next = 0;
+    while (next < keys.size() && keys[next].time <= time) {
+        next++;
+    }
+    if (next == 0 || next == keys.size()) {
+        const Key& key = keys[next == 0 ? 0 : keys.size() - 1];
+        camera.SetPose(key.position, key.yaw, key.pitch);
+        return;
+    }
+
+    const Key& a = keys[next - 1];
+    const Key& b = keys[next];
+    const float span = b.time - a.time;
+    const float t = span > 0.0f ? (time - a.time) / span : 1.0f;
+    camera.SetPose(glm::mix(a.position, b.position, t), a.yaw + (b.yaw - a.yaw) * t, a.pitch + (b.pitch - a.pitch) * t);
+}
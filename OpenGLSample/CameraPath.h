@@ -0,0 +1,78 @@
+/**
+ * @file CameraPath.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the CameraPath class, which records camera poses over
+ * time and replays them.
+ */
+
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "camera.h"
+
+/**
+ * @class CameraPath
+ * @brief Timed camera poses, saved as text and replayed with linear interpolation.
+ *
+ * Each line of the file holds one key: the time in seconds, the position and the yaw and pitch in
+ * degrees. Lines starting with '#' are comments. Keys must be in time order.
+ */
+class CameraPath
+{
+public:
+    /**
+     * @brief Reads a path from a file, replacing the current keys.
+     * @param path The file path of the camera path.
+     * @return True when the file held at least one key.
+     */
+    bool load(const char* path);
+
+    /**
+     * @brief Writes the keys to a file.
+     * @param path The file path of the camera path.
+     * @return True when the file was written.
+     */
+    bool save(const char* path) const;
+
+    /**
+     * @brief Appends the camera's current pose as a key.
+     * @param time The time of the key, after the last key's.
+     * @param camera The camera whose pose is recorded.
+     */
+    void addKey(float time, const Camera& camera);
+
+    /**
+     * @brief Places the camera at the pose of the path at a time, clamped to the path's ends.
+     * @param time The time along the path in seconds.
+     * @param camera The camera to place.
+     */
+    void apply(float time, Camera& camera) const;
+
+    /**
+     * @brief Returns the time of the last key.
+     */
+    float getDuration() const { return keys.empty() ? 0.0f : keys.back().time; }
+
+    /**
+     * @brief Returns true when the path has no keys.
+     */
+    bool empty() const { return keys.empty(); }
+
+private:
+    // A recorded pose
+    struct Key
+    {
+        float time;
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+    };
+
+    std::vector<Key> keys;
+};
+#endif // CAMERAPATH_H
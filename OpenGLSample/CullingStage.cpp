@@ -0,0 +1,50 @@
+/**
+ * @file CullingStage.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the CullingStage class.
+ */
+
+#include "CullingStage.h"
+#include <algorithm>
+
+/**
+ * @brief Writes the visible draws of a set of command ranges.
+ *
+ * @param commandList The recorded commands the ranges refer to.
+ * @param ranges The command ranges of the items that passed item culling.
+ * @param frustum The view frustum.
+ * @param planeCount The number of frustum planes to test, starting with the near plane.
+ * @param lodPolicy The thresholds the levels of detail are selected with.
+ * @param lodView The camera values of the frame.
+ * @param jobs The workers that share the chunks.
+ * @param draws Receives the visible draws; cleared first, keeps its capacity.
+ */
+void CullingStage::run(RenderCommandList& commandList, const std::vector<CommandRange>& ranges, const Frustum& frustum,
+    int planeCount, const LodPolicy& lodPolicy, const LodView& lodView, JobSystem& jobs, std::vector<VisibleDraw>& draws) {
+    draws.clear();
+    const size_t chunkCount = JobSystem::getChunkCount(ranges.size(), RANGE_GRAIN_SIZE);
+    if (chunkCount <= 1) {
+        commandList.cullCommands(ranges, 0, ranges.size(), frustum, planeCount, lodPolicy, lodView, draws);
+        return;
+    }
+
+    if (chunkDraws.size() < chunkCount) {
+        chunkDraws.resize(chunkCount);
+    }
+    jobs.parallelFor(ranges.size(), RANGE_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        std::vector<VisibleDraw>& chunk = chunkDraws[begin / RANGE_GRAIN_SIZE];
+        chunk.clear();
+        commandList.cullCommands(ranges, begin, end, frustum, planeCount, lodPolicy, lodView, chunk);
+    });
+
+    size_t total = 0;
+    for (size_t i = 0; i < chunkCount; i++) {
+        total += chunkDraws[i].size();
+    }
+    draws.reserve(total);
+    for (size_t i = 0; i < chunkCount; i++) {
+        draws.insert(draws.end(), chunkDraws[i].begin(), chunkDraws[i].end());
+    }
+}
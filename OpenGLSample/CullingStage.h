@@ -0,0 +1,52 @@
+/**
+ * @file CullingStage.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the CullingStage class, which turns the command ranges
+ * of the visible items into a compact list of draws, split across the worker threads.
+ */
+
+#ifndef CULLINGSTAGE_H
+#define CULLINGSTAGE_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "RenderCommand.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+
+/**
+ * @class CullingStage
+ * @brief Culls every submesh of the visible items and selects its level of detail in parallel.
+ *
+ * The ranges are split into chunks of RANGE_GRAIN_SIZE items. Each chunk tests its commands'
+ * bounds against the frustum and selects their mesh by screen size, writing into its own list, so
+ * the chunks share nothing while they run. The lists are then joined in chunk order, which keeps
+ * the output identical to a serial pass.
+ */
+class CullingStage
+{
+public:
+    static const size_t RANGE_GRAIN_SIZE = 64; // Items per job
+
+    /**
+     * @brief Writes the visible draws of a set of command ranges.
+     *
+     * @param commandList The recorded commands the ranges refer to.
+     * @param ranges The command ranges of the items that passed item culling.
+     * @param frustum The view frustum.
+     * @param planeCount The number of frustum planes to test, starting with the near plane.
+     * @param lodPolicy The thresholds the levels of detail are selected with.
+     * @param lodView The camera values of the frame.
+     * @param jobs The workers that share the chunks.
+     * @param draws Receives the visible draws; cleared first, keeps its capacity.
+     */
+    void run(RenderCommandList& commandList, const std::vector<CommandRange>& ranges, const Frustum& frustum,
+        int planeCount, const LodPolicy& lodPolicy, const LodView& lodView, JobSystem& jobs, std::vector<VisibleDraw>& draws);
+
+private:
+    std::vector<std::vector<VisibleDraw>> chunkDraws; // Output of each chunk, reused every run
+};
+#endif // CULLINGSTAGE_H
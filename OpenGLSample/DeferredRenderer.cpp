@@ -0,0 +1,283 @@
+/**
+ * @file DeferredRenderer.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the DeferredRenderer class.
+ */
+
+#include "DeferredRenderer.h"
+#include "LightGrid.h"
+#include "ShadowMaps.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <iostream>
+
+const GLuint DeferredRenderer::ALBEDO_UNIT;
+const GLuint DeferredRenderer::SPECULAR_UNIT;
+const GLuint DeferredRenderer::NORMAL_UNIT;
+const GLuint DeferredRenderer::OVERLAY_UNIT;
+const GLuint DeferredRenderer::DEPTH_UNIT;
+
+namespace
+{
+    // The faces of the 16 by 8 unit sphere lie inside the sphere; scaling by this keeps the whole range covered
+    const float VOLUME_SCALE = 1.05f;
+}
+
+/**
+ * @brief Compiles the lighting shaders and creates a G-buffer of the given size.
+ * @param width The width of the framebuffer in pixels.
+ * @param height The height of the framebuffer in pixels.
+ * @param stateCache The cache that filters redundant binds.
+ */
+DeferredRenderer::DeferredRenderer(int width, int height, GLStateCache& stateCache)
+    : directionalShader("../OpenGLSample/shaderfiles/deferred_fullscreen.vs", "../OpenGLSample/shaderfiles/deferred_directional.fs"),
+    pointVolumeShader("../OpenGLSample/shaderfiles/deferred_volume.vs", "../OpenGLSample/shaderfiles/deferred_point.fs"),
+    pointFullscreenShader("../OpenGLSample/shaderfiles/deferred_fullscreen.vs", "../OpenGLSample/shaderfiles/deferred_point.fs"),
+    compositeShader("../OpenGLSample/shaderfiles/deferred_fullscreen.vs", "../OpenGLSample/shaderfiles/deferred_composite.fs"),
+    width(width),
+    height(height) {
+    const Shader* lightingShaders[] = { &directionalShader, &pointVolumeShader, &pointFullscreenShader };
+    for (const Shader* shader : lightingShaders) {
+        shader->bindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+        shader->bindUniformBlock("Lights", LIGHTS_BLOCK_BINDING);
+        glUseProgram(shader->ID);
+        shader->setInt("gAlbedo", ALBEDO_UNIT);
+        shader->setInt("gSpecular", SPECULAR_UNIT);
+        shader->setInt("gNormal", NORMAL_UNIT);
+        shader->setInt("gDepth", DEPTH_UNIT);
+    }
+    directionalShader.bindUniformBlock("Shadows", SHADOWS_BLOCK_BINDING);
+    glUseProgram(directionalShader.ID);
+    directionalShader.setInt("cascadeShadowMap", ShadowMaps::CASCADE_UNIT);
+    directionalShader.setInt("spotShadowMap", ShadowMaps::SPOT_UNIT);
+    glUseProgram(compositeShader.ID);
+    compositeShader.setInt("gOverlay", OVERLAY_UNIT);
+    glUseProgram(0);
+
+    glGenVertexArrays(1, &emptyVao);
+    createTargets(stateCache);
+}
+
+/**
+ * @brief Creates the G-buffer textures and framebuffer for the current size.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void DeferredRenderer::createTargets(GLStateCache& stateCache) {
+    // Albedo and specular colors only need 8 bits; normals and shininess keep half float precision
+    const GLenum internalFormats[TARGET_COUNT] = { GL_RGBA8, GL_RGBA8, GL_RGBA16F, GL_RGBA8 };
+    const GLenum types[TARGET_COUNT] = { GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE, GL_FLOAT, GL_UNSIGNED_BYTE };
+    const GLuint units[TARGET_COUNT] = { ALBEDO_UNIT, SPECULAR_UNIT, NORMAL_UNIT, OVERLAY_UNIT };
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    glGenTextures(TARGET_COUNT, targets);
+    GLenum drawBuffers[TARGET_COUNT];
+    // Each target is specified on the unit it is sampled from, so the lighting pass finds it bound
+    for (int i = 0; i < TARGET_COUNT; i++) {
+        stateCache.bindTexture(units[i], GL_TEXTURE_2D, targets[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], width, height, 0, GL_RGBA, types[i], NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, targets[i], 0);
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    glDrawBuffers(TARGET_COUNT, drawBuffers);
+
+    // Same format as the default framebuffer's depth, so it can be blitted there
+    glGenTextures(1, &depthTexture);
+    stateCache.bindTexture(DEPTH_UNIT, GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "ERROR::DEFERREDRENDERER::GBUFFER_INCOMPLETE" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/**
+ * @brief Deletes the G-buffer textures and framebuffer.
+ */
+void DeferredRenderer::destroyTargets() {
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(TARGET_COUNT, targets);
+    glDeleteTextures(1, &depthTexture);
+    framebuffer = 0;
+    depthTexture = 0;
+    for (int i = 0; i < TARGET_COUNT; i++) {
+        targets[i] = 0;
+    }
+}
+
+/**
+ * @brief Recreates the G-buffer when the framebuffer size changed.
+ * @param width The width of the framebuffer in pixels.
+ * @param height The height of the framebuffer in pixels.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void DeferredRenderer::resize(int width, int height, GLStateCache& stateCache) {
+    // A minimized window has a zero-sized framebuffer; keep the old targets until it comes back
+    if ((width == this->width && height == this->height) || width <= 0 || height <= 0) {
+        return;
+    }
+    this->width = width;
+    this->height = height;
+    // The new textures may get the deleted names back, which the cache would take as still bound
+    for (GLuint texture : targets) {
+        stateCache.forgetTexture(texture);
+    }
+    stateCache.forgetTexture(depthTexture);
+    destroyTargets();
+    createTargets(stateCache);
+}
+
+/**
+ * @brief Binds and clears the G-buffer; the scene is drawn next with the gbuffer.fs shaders.
+ *
+ * A frame rendered below the window's resolution covers the lower left part of the G-buffer.
+ *
+ * @param renderWidth The width of the frame in pixels, at most the G-buffer's.
+ * @param renderHeight The height of the frame in pixels, at most the G-buffer's.
+ */
+void DeferredRenderer::beginGeometryPass(int renderWidth, int renderHeight) {
+    this->renderWidth = std::min(renderWidth, width);
+    this->renderHeight = std::min(renderHeight, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, this->renderWidth, this->renderHeight);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+/**
+ * @brief Binds the G-buffer textures to their units and sets the uniforms every lighting shader shares.
+ */
+void DeferredRenderer::setGBufferUniforms(const Shader& shader, const glm::mat4& inverseViewProjection) const {
+    shader.setMat4("inverseViewProjection", inverseViewProjection);
+    shader.setVec2("screenSize", glm::vec2(static_cast<float>(renderWidth), static_cast<float>(renderHeight)));
+}
+
+/**
+ * @brief Lights the G-buffer into the output framebuffer.
+ *
+ * Copies the G-buffer depth into the output framebuffer first, so that what is drawn afterwards
+ * (the lamps and the skybox) is depth tested against the scene.
+ *
+ * @param pointLights The point lights of the frame.
+ * @param lightVolume A unit sphere mesh, scaled to each point light's range.
+ * @param viewProjection The projection * view matrix of the frame.
+ * @param viewPosition The camera position.
+ * @param zNear The distance of the near plane.
+ * @param stateCache The cache that filters redundant binds.
+ * @param outputFramebuffer The framebuffer to light, left bound; its depth format must be the G-buffer's.
+ */
+void DeferredRenderer::renderLighting(const std::vector<PointLightBlock>& pointLights, const MeshCreator::GLMesh& lightVolume,
+    const glm::mat4& viewProjection, const glm::vec3& viewPosition, float zNear, GLStateCache& stateCache, GLuint outputFramebuffer) {
+    const glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+    glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, renderWidth, renderHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+
+    stateCache.bindTexture(ALBEDO_UNIT, GL_TEXTURE_2D, targets[ALBEDO]);
+    stateCache.bindTexture(SPECULAR_UNIT, GL_TEXTURE_2D, targets[SPECULAR]);
+    stateCache.bindTexture(NORMAL_UNIT, GL_TEXTURE_2D, targets[NORMAL]);
+    stateCache.bindTexture(OVERLAY_UNIT, GL_TEXTURE_2D, targets[OVERLAY]);
+    stateCache.bindTexture(DEPTH_UNIT, GL_TEXTURE_2D, depthTexture);
+
+    // No pass tests or writes depth. The directional pass replaces the output's clear color wherever
+    // the scene was drawn, and leaves it where it was not; the point lights are added on top
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_BLEND);
+
+    stateCache.useProgram(directionalShader.ID);
+    setGBufferUniforms(directionalShader, inverseViewProjection);
+    stateCache.bindVertexArray(emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    // Back faces cover every pixel inside a sphere whether the camera is in front of it or not, and
+    // depth clamping keeps the far side of large spheres from being clipped
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glEnable(GL_DEPTH_CLAMP);
+
+    stateCache.useProgram(pointVolumeShader.ID);
+    setGBufferUniforms(pointVolumeShader, inverseViewProjection);
+    stateCache.useProgram(pointFullscreenShader.ID);
+    setGBufferUniforms(pointFullscreenShader, inverseViewProjection);
+
+    volumeCount = 0;
+    for (const PointLightBlock& light : pointLights) {
+        float range = LightGrid::computeRange(light);
+        if (range == 0.0f) {
+            continue;
+        }
+
+        // A light that never dims below the cutoff, or whose sphere holds the camera, is drawn fullscreen
+        const Shader* shader = &pointVolumeShader;
+        if (range < 0.0f || glm::length(viewPosition - light.position) < range * VOLUME_SCALE + zNear) {
+            shader = &pointFullscreenShader;
+        }
+        stateCache.useProgram(shader->ID);
+        shader->setVec3("light.position", light.position);
+        shader->setVec3("light.ambient", light.ambient);
+        shader->setVec3("light.diffuse", light.diffuse);
+        shader->setVec3("light.specular", light.specular);
+        shader->setFloat("light.constant", light.constant);
+        shader->setFloat("light.linear", light.linear);
+        shader->setFloat("light.quadratic", light.quadratic);
+        shader->setFloat("light.intensity", light.intensity);
+
+        if (shader == &pointFullscreenShader) {
+            // The fullscreen triangle faces the camera, so it is drawn without the front face culling
+            glDisable(GL_CULL_FACE);
+            stateCache.bindVertexArray(emptyVao);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glEnable(GL_CULL_FACE);
+            continue;
+        }
+
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), light.position);
+        model = glm::scale(model, glm::vec3(range * VOLUME_SCALE));
+        shader->setMat4("model", model);
+        stateCache.bindVertexArray(lightVolume.vao);
+        glDrawElementsBaseVertex(GL_TRIANGLES, lightVolume.nIndices, GL_UNSIGNED_SHORT, lightVolume.getIndexOffset(), lightVolume.baseVertex);
+        volumeCount++;
+    }
+
+    glDisable(GL_DEPTH_CLAMP);
+    glCullFace(GL_BACK);
+    glDisable(GL_CULL_FACE);
+
+    // The overlay is premultiplied, so it replaces the lit color by its alpha
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    stateCache.useProgram(compositeShader.ID);
+    stateCache.bindVertexArray(emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+}
+
+/**
+ * @brief Releases the G-buffer and the lighting shaders.
+ */
+void DeferredRenderer::destroy() {
+    destroyTargets();
+    glDeleteVertexArrays(1, &emptyVao);
+    emptyVao = 0;
+    glDeleteProgram(directionalShader.ID);
+    glDeleteProgram(pointVolumeShader.ID);
+    glDeleteProgram(pointFullscreenShader.ID);
+    glDeleteProgram(compositeShader.ID);
+}
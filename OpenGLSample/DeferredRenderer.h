@@ -0,0 +1,130 @@
+/**
+ * @file DeferredRenderer.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the DeferredRenderer class, which lights the scene from a G-buffer
+ * instead of in the forward pass.
+ */
+
+#ifndef DEFERREDRENDERER_H
+#define DEFERREDRENDERER_H
+
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "MeshCreator.h"
+#include "GLStateCache.h"
+#include "UniformBuffer.h"
+
+/**
+ * @class DeferredRenderer
+ * @brief Renders the scene's material properties once, then adds each light in screen space.
+ *
+ * The scene shaders are built with gbuffer.fs, which writes the diffuse albedo, the specular color,
+ * the normal and shininess, and the overlay texture into four targets. The lighting pass then
+ * reconstructs each pixel's position from the depth buffer: the directional and spot lights are written
+ * by one fullscreen pass, and each point light is added on top in a sphere that covers its range, so
+ * a point light only costs the pixels it reaches. The overlay is blended in last,
+ * the same way 6.multiple_lights.fs does.
+ */
+class DeferredRenderer
+{
+public:
+    // Texture units of the G-buffer targets, after the material textures and the light grid
+    static const GLuint ALBEDO_UNIT = 6;
+    static const GLuint SPECULAR_UNIT = 7;
+    static const GLuint NORMAL_UNIT = 8;
+    static const GLuint OVERLAY_UNIT = 9;
+    static const GLuint DEPTH_UNIT = 10;
+
+    /**
+     * @brief Compiles the lighting shaders and creates a G-buffer of the given size.
+     * @param width The width of the framebuffer in pixels.
+     * @param height The height of the framebuffer in pixels.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    DeferredRenderer(int width, int height, GLStateCache& stateCache);
+
+    /**
+     * @brief Recreates the G-buffer when the framebuffer size changed.
+     * @param width The width of the framebuffer in pixels.
+     * @param height The height of the framebuffer in pixels.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void resize(int width, int height, GLStateCache& stateCache);
+
+    /**
+     * @brief Binds and clears the G-buffer; the scene is drawn next with the gbuffer.fs shaders.
+     *
+     * A frame rendered below the window's resolution covers the lower left part of the G-buffer.
+     *
+     * @param renderWidth The width of the frame in pixels, at most the G-buffer's.
+     * @param renderHeight The height of the frame in pixels, at most the G-buffer's.
+     */
+    void beginGeometryPass(int renderWidth, int renderHeight);
+
+    /**
+     * @brief Lights the G-buffer into the output framebuffer.
+     *
+     * Copies the G-buffer depth into the output framebuffer first, so that what is drawn afterwards
+     * (the lamps and the skybox) is depth tested against the scene.
+     *
+     * @param pointLights The point lights of the frame.
+     * @param lightVolume A unit sphere mesh, scaled to each point light's range.
+     * @param viewProjection The projection * view matrix of the frame.
+     * @param viewPosition The camera position.
+     * @param zNear The distance of the near plane.
+     * @param stateCache The cache that filters redundant binds.
+     * @param outputFramebuffer The framebuffer to light, left bound; its depth format must be the G-buffer's.
+     */
+    void renderLighting(const std::vector<PointLightBlock>& pointLights, const MeshCreator::GLMesh& lightVolume,
+        const glm::mat4& viewProjection, const glm::vec3& viewPosition, float zNear, GLStateCache& stateCache, GLuint outputFramebuffer = 0);
+
+    /**
+     * @brief Returns the number of point lights drawn as spheres by the last renderLighting.
+     */
+    size_t getVolumeCount() const { return volumeCount; }
+
+    /**
+     * @brief Releases the G-buffer and the lighting shaders.
+     */
+    void destroy();
+
+private:
+    enum Target { ALBEDO = 0, SPECULAR, NORMAL, OVERLAY, TARGET_COUNT };
+
+    Shader directionalShader;    // Directional and spot light, fullscreen
+    Shader pointVolumeShader;    // One point light, drawn as a sphere
+    Shader pointFullscreenShader; // One point light whose sphere contains the camera
+    Shader compositeShader;      // Overlay textures
+
+    GLuint framebuffer = 0;
+    GLuint targets[TARGET_COUNT] = { 0, 0, 0, 0 };
+    GLuint depthTexture = 0;
+    GLuint emptyVao = 0;         // Fullscreen triangles are generated from gl_VertexID
+    int width = 0;
+    int height = 0;
+    int renderWidth = 0;         // Part of the G-buffer the frame covers
+    int renderHeight = 0;
+    size_t volumeCount = 0;
+
+    /**
+     * @brief Creates the G-buffer textures and framebuffer for the current size.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void createTargets(GLStateCache& stateCache);
+
+    /**
+     * @brief Deletes the G-buffer textures and framebuffer.
+     */
+    void destroyTargets();
+
+    /**
+     * @brief Binds the G-buffer textures to their units and sets the uniforms every lighting shader shares.
+     */
+    void setGBufferUniforms(const Shader& shader, const glm::mat4& inverseViewProjection) const;
+};
+#endif // DEFERREDRENDERER_H
@@ -11,41 +11,24 @@
 /**
  * @brief Constructor for the DirectLight class.
  *
- * This constructor initializes the DirectLight object using a configuration file.
- * The configuration file should contain the directional light properties under the
- * "DirectLight" section.
+ * This constructor initializes the DirectLight object from the descriptor of its section
+ * of the configuration file, usually "DirectLight".
  *
- * @param configFilePath The path to the configuration file.
+ * @param descriptor The light's section of the configuration file.
  */
-DirectLight::DirectLight(const std::string& configFilePath) : LightSource(configFilePath) {
-    std::ifstream configFile(configFilePath);
-    std::string line;
-    std::map<std::string, glm::vec3> config;
-    std::string currentSection;
-
-    while (std::getline(configFile, line)) {
-        if (line[0] == '[') {
-            currentSection = line.substr(1, line.size() - 2);
-        }
-        else if (currentSection == "DirectLight") {
-            std::istringstream is_line(line);
-            std::string key;
-            if (std::getline(is_line, key, '=')) {
-                std::string value_str;
-                if (std::getline(is_line, value_str)) {
-                    std::istringstream is_value(value_str);
-                    float x, y, z;
-                    is_value >> x >> y >> z;
-                    config[key] = glm::vec3(x, y, z);
-                }
-            }
-        }
-    }
+DirectLight::DirectLight(const LightDescriptor& descriptor)
+    : LightSource(descriptor),
+    direction(descriptor.direction) {
+}
 
-    direction = config["direction"];
-    ambient = config["ambient"];
-    diffuse = config["diffuse"];
-    specular = config["specular"];
+/**
+ * @brief Takes the direction and colors of a descriptor, after the configuration file was reloaded.
+ *
+ * @param descriptor The light's section of the reloaded configuration file.
+ */
+void DirectLight::configure(const LightDescriptor& descriptor) {
+    direction = descriptor.direction;
+    LightSource::configure(descriptor);
 }
 
 
@@ -64,5 +47,17 @@ void DirectLight::setToShader(Shader& shader, const std::string& name) const {
     shader.setVec3("dirLight.direction", direction);
     shader.setVec3("dirLight.ambient", ambient);
     shader.setVec3("dirLight.diffuse", diffuse);
-    shader.setVec3(".specular", specular);
+    shader.setVec3("dirLight.specular", specular);
+}
+
+/**
+ * @brief Writes the directional light properties into the Lights uniform block.
+ *
+ * @param block The Lights block that will be uploaded to the uniform buffer.
+ */
+void DirectLight::writeToBlock(LightsBlock& block) const {
+    block.dirLight.direction = direction;
+    block.dirLight.ambient = ambient;
+    block.dirLight.diffuse = diffuse;
+    block.dirLight.specular = specular;
 }
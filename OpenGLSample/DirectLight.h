@@ -9,7 +9,6 @@
 #ifndef DIRECTLIGHT_H
 #define DIRECTLIGHT_H
 
-#include <map>
 #include <string>
 #include <glm/glm.hpp>
 #include "LightSource.h"
@@ -22,26 +21,22 @@
  * The DirectLight class extends the LightSource class and adds additional properties
  * specific to a directional light source. These properties include direction, ambient,
  * diffuse, and specular components. The direction represents the direction of the light,
- * while the ambient, diffuse, and specular components represent the color of the light
- * in different lighting conditions.
+ * while the ambient, diffuse, and specular components, inherited from LightSource, represent
+ * the color of the light in different lighting conditions.
  */
 class DirectLight : public LightSource {
 public:
     glm::vec3 direction;
-    glm::vec3 ambient;
-    glm::vec3 diffuse;
-    glm::vec3 specular;
 
     /**
      * @brief Constructor for the DirectLight class.
      *
-     * This constructor initializes the DirectLight object using a configuration file.
-     * The configuration file should contain the directional light properties under the
-     * "DirectLight" section.
+     * This constructor initializes the DirectLight object from the descriptor of its section
+     * of the configuration file, usually "DirectLight".
      *
-     * @param configFilePath The path to the configuration file.
+     * @param descriptor The light's section of the configuration file.
      */
-    DirectLight(const std::string& configFilePath);
+    DirectLight(const LightDescriptor& descriptor);
 
     /**
      * @brief Sets the directional light properties to a shader.
@@ -54,6 +49,20 @@ public:
      * @param name The base name of the light properties in the shader.
      */
     void setToShader(Shader& shader, const std::string& name) const override;
+
+    /**
+     * @brief Writes the directional light properties into the Lights uniform block.
+     *
+     * @param block The Lights block that will be uploaded to the uniform buffer.
+     */
+    void writeToBlock(LightsBlock& block) const override;
+
+    /**
+     * @brief Takes the direction and colors of a descriptor, after the configuration file was reloaded.
+     *
+     * @param descriptor The light's section of the reloaded configuration file.
+     */
+    void configure(const LightDescriptor& descriptor) override;
 };
 
 #endif // DIRECTLIGHT_H
\ No newline at end of file
@@ -16,10 +16,8 @@
  */
 void DrinkBox::render() {
     // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureDrinkFront);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    bindTexture(GL_TEXTURE0, gTexture.gTextureDrinkFront);
+    bindTexture(GL_TEXTURE1, 0);
 
 
     // First frustum pyramid, drink box
@@ -29,14 +27,10 @@ void DrinkBox::render() {
     glm::vec3 translationVec = drawObject(objectScale, rotationMatrix, objectPosition, transformData);
 
     // Draws the triangles
-    drawMeshBasedOnDistance(gMesh.gFrustumPyramidMesh, gMesh.gFrustumPyramidMesh, translationVec, true);
-
-    // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    drawMeshBasedOnDistance(gMesh.gFrustumPyramidMesh, gMesh.gFrustumPyramidMesh, translationVec);
 
     // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureDrinkTop);
+    bindTexture(GL_TEXTURE0, gTexture.gTextureDrinkTop);
 
     // First plane, drink box lid
     objectScale = glm::vec3(0.535f, 1.0f, 0.535f);
@@ -44,8 +38,5 @@ void DrinkBox::render() {
         * glm::rotate(glm::radians(-2.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     objectPosition = glm::vec3(-1.88f, 1.7f, -1.0f);
     translationVec = drawObject(objectScale, rotationMatrix, objectPosition, transformData);
-    drawMeshBasedOnDistance(gMesh.gPlaneMesh, gMesh.gPlaneMesh, translationVec, false);
-
-    // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    drawMeshBasedOnDistance(gMesh.gPlaneMesh, gMesh.gPlaneMesh, translationVec);
 }
\ No newline at end of file
@@ -32,13 +32,11 @@ public:
      *
      * @param initialPos The initial position of the DrinkBox as a glm::vec3.
      * @param transformData The transformation data for the DrinkBox.
-     * @param mesh The mesh data for the DrinkBox.
-     * @param texture The texture data for the DrinkBox.
-     * @param shader The shader program used for rendering the DrinkBox.
+     * @param resources The shared mesh, texture and shader tables.
      * @param inputCamera A reference to the camera used for rendering.
      */
-    DrinkBox(glm::vec3 initialPos, Transform transformData, MeshCreator mesh, Textures texture, Shader shader, Camera& inputCamera)
-        : Item(initialPos, mesh, texture, shader, inputCamera), transformData(transformData) {}
+    DrinkBox(glm::vec3 initialPos, Transform transformData, const ResourceRegistry& resources, Camera& inputCamera)
+        : Item(initialPos, resources, inputCamera), transformData(transformData) {}
 
     /**
      * @brief Renders the DrinkBox object.
@@ -0,0 +1,195 @@
+/**
+ * @file DynamicResolution.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the DynamicResolution and ScaledRenderTarget classes.
+ */
+
+#include "DynamicResolution.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    const float MIN_SCALE = 0.5f;         // A quarter of the pixels at most
+    const float TARGET_FRACTION = 0.85f;  // Aim under the budget, so the frame-to-frame spread still fits
+    const float MAX_DROP = 0.8f;          // Largest step down, as a factor of the scale
+    const float MAX_RISE = 1.05f;         // Largest step up
+    const float DEADBAND = 0.02f;         // Smaller changes are ignored, so the resolution does not flicker
+    const float SHARPNESS = 0.5f;         // Strength of the upscale's sharpen, from 0 to 1
+    const GLuint COLOR_UNIT = 0;          // The upscale is the last draw of the frame
+}
+
+/**
+ * @brief Feeds the GPU time of one resolved frame and adjusts the scale.
+ * @param gpuMs The GPU time of the frame, in milliseconds.
+ */
+void DynamicResolution::update(double gpuMs) {
+    if (!enabled || gpuMs <= 0.0) {
+        return;
+    }
+    // The frames issued before the last step are still being resolved
+    if (skippedSamples > 0) {
+        skippedSamples--;
+        return;
+    }
+    float wanted = scale * std::sqrt(budgetMs * TARGET_FRACTION / static_cast<float>(gpuMs));
+    wanted = std::min(std::max(wanted, scale * MAX_DROP), scale * MAX_RISE);
+    wanted = std::min(std::max(wanted, MIN_SCALE), 1.0f);
+    if (std::fabs(wanted - scale) < DEADBAND && wanted != 1.0f && wanted != MIN_SCALE) {
+        return;
+    }
+    if (wanted != scale) {
+        scale = wanted;
+        skippedSamples = Profiler::FRAME_LATENCY;
+    }
+}
+
+/**
+ * @brief Enables or disables the scaling; a disabled governor returns to the full resolution.
+ */
+void DynamicResolution::setEnabled(bool enable) {
+    enabled = enable;
+    if (!enabled) {
+        scale = 1.0f;
+        skippedSamples = 0;
+    }
+}
+
+/**
+ * @brief Returns the LOD bias that matches the scale, 0 at the full resolution.
+ */
+float DynamicResolution::getLodBias() const {
+    return -std::log2(scale);
+}
+
+/**
+ * @brief Compiles the upscale shader and creates the target for a window size.
+ * @param width The width of the window's framebuffer in pixels.
+ * @param height The height of the window's framebuffer in pixels.
+ * @param stateCache The cache that filters redundant binds.
+ */
+ScaledRenderTarget::ScaledRenderTarget(int width, int height, GLStateCache& stateCache)
+    : upscaleShader("../OpenGLSample/shaderfiles/deferred_fullscreen.vs", "../OpenGLSample/shaderfiles/upscale_sharpen.fs"),
+    width(std::max(width, 1)),
+    height(std::max(height, 1)),
+    renderWidth(this->width),
+    renderHeight(this->height) {
+    glUseProgram(upscaleShader.ID);
+    upscaleShader.setInt("sceneColor", COLOR_UNIT);
+    upscaleShader.setFloat("sharpness", SHARPNESS);
+    glUseProgram(0);
+
+    glGenVertexArrays(1, &emptyVao);
+    createTargets(stateCache);
+}
+
+/**
+ * @brief Creates the textures and framebuffer for the current size.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void ScaledRenderTarget::createTargets(GLStateCache& stateCache) {
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    // Bilinear filtering does the upscale
+    glGenTextures(1, &colorTexture);
+    stateCache.bindTexture(COLOR_UNIT, GL_TEXTURE_2D, colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+
+    // Same format as the default framebuffer's and the G-buffer's depth, so either can be blitted here
+    glGenTextures(1, &depthTexture);
+    stateCache.bindTexture(COLOR_UNIT, GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "ERROR::SCALEDRENDERTARGET::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/**
+ * @brief Deletes the textures and framebuffer.
+ */
+void ScaledRenderTarget::destroyTargets() {
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &colorTexture);
+    glDeleteTextures(1, &depthTexture);
+    framebuffer = 0;
+    colorTexture = 0;
+    depthTexture = 0;
+}
+
+/**
+ * @brief Recreates the textures when the window size changed and sets the render size of a scale.
+ * @param width The width of the window's framebuffer in pixels.
+ * @param height The height of the window's framebuffer in pixels.
+ * @param scale The fraction of the window's width and height to render at.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void ScaledRenderTarget::update(int width, int height, float scale, GLStateCache& stateCache) {
+    // A minimized window has a zero-sized framebuffer; keep the old textures until it comes back
+    if ((width != this->width || height != this->height) && width > 0 && height > 0) {
+        this->width = width;
+        this->height = height;
+        // The new textures may get the deleted names back, which the cache would take as still bound
+        stateCache.forgetTexture(colorTexture);
+        stateCache.forgetTexture(depthTexture);
+        destroyTargets();
+        createTargets(stateCache);
+    }
+    scale = std::min(std::max(scale, 0.0f), 1.0f);
+    renderWidth = std::max(static_cast<int>(this->width * scale + 0.5f), 1);
+    renderHeight = std::max(static_cast<int>(this->height * scale + 0.5f), 1);
+}
+
+/**
+ * @brief Binds and clears the target, with the viewport set to the render size.
+ */
+void ScaledRenderTarget::bind() {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, renderWidth, renderHeight);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+/**
+ * @brief Upscales the rendered part into the default framebuffer and restores the window's viewport.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void ScaledRenderTarget::resolve(GLStateCache& stateCache) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+
+    // The triangle covers every pixel of the window, so nothing needs depth
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+    stateCache.useProgram(upscaleShader.ID);
+    upscaleShader.setVec2("outputSize", glm::vec2(static_cast<float>(width), static_cast<float>(height)));
+    upscaleShader.setVec2("renderScale", glm::vec2(static_cast<float>(renderWidth) / width, static_cast<float>(renderHeight) / height));
+    stateCache.bindTexture(COLOR_UNIT, GL_TEXTURE_2D, colorTexture);
+    stateCache.bindVertexArray(emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+}
+
+/**
+ * @brief Releases the textures and the upscale shader.
+ */
+void ScaledRenderTarget::destroy() {
+    destroyTargets();
+    glDeleteVertexArrays(1, &emptyVao);
+    emptyVao = 0;
+    glDeleteProgram(upscaleShader.ID);
+}
@@ -0,0 +1,141 @@
+/**
+ * @file DynamicResolution.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the DynamicResolution class, which scales the render
+ * resolution to hold a GPU frame time, and of the ScaledRenderTarget class, which the scene is drawn
+ * into at that resolution before it is upscaled to the window.
+ */
+
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+
+#include <glad/glad.h>
+
+#include "shader.h"
+#include "GLStateCache.h"
+
+/**
+ * @class DynamicResolution
+ * @brief Lowers the render scale while the GPU misses the frame budget and raises it again when there is headroom.
+ *
+ * The GPU cost of a frame mostly follows its pixel count, so each step moves the scale by the square
+ * root of the ratio between the target time and the measured one, dropping quickly and rising slowly.
+ * The GPU times arrive a few frames late, so after a step the samples of the frames still rendered at
+ * the old scale are skipped. Fewer pixels also mean each mesh covers fewer of them, so the LOD bias
+ * goes with the scale: a mesh at half resolution is drawn at the level it would get at half its size.
+ */
+class DynamicResolution
+{
+public:
+    /**
+     * @brief Constructor for the DynamicResolution class.
+     * @param frameBudget The GPU frame time to stay under, in seconds.
+     */
+    explicit DynamicResolution(float frameBudget) : budgetMs(frameBudget * 1000.0f) {}
+
+    /**
+     * @brief Feeds the GPU time of one resolved frame and adjusts the scale.
+     * @param gpuMs The GPU time of the frame, in milliseconds.
+     */
+    void update(double gpuMs);
+
+    /**
+     * @brief Enables or disables the scaling; a disabled governor returns to the full resolution.
+     */
+    void setEnabled(bool enable);
+
+    bool isEnabled() const { return enabled; }
+
+    /**
+     * @brief Returns the fraction of the window's width and height to render at, up to 1.
+     */
+    float getScale() const { return scale; }
+
+    /**
+     * @brief Returns the LOD bias that matches the scale, 0 at the full resolution.
+     */
+    float getLodBias() const;
+
+private:
+    float budgetMs;         // Target GPU frame time, in milliseconds
+    float scale = 1.0f;
+    int skippedSamples = 0; // Samples still to skip after a step
+    bool enabled = true;
+};
+
+/**
+ * @class ScaledRenderTarget
+ * @brief An offscreen color and depth target of the window's size, rendered into at a lower resolution.
+ *
+ * The textures keep the window's size and a frame only covers their lower left part, so a change of
+ * scale is a new viewport rather than new textures. The depth format is the default framebuffer's, so
+ * the G-buffer depth can be blitted into it the same way. resolve draws the rendered part over the
+ * window with a sharpening upscale.
+ */
+class ScaledRenderTarget
+{
+public:
+    /**
+     * @brief Compiles the upscale shader and creates the target for a window size.
+     * @param width The width of the window's framebuffer in pixels.
+     * @param height The height of the window's framebuffer in pixels.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    ScaledRenderTarget(int width, int height, GLStateCache& stateCache);
+
+    /**
+     * @brief Recreates the textures when the window size changed and sets the render size of a scale.
+     * @param width The width of the window's framebuffer in pixels.
+     * @param height The height of the window's framebuffer in pixels.
+     * @param scale The fraction of the window's width and height to render at.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void update(int width, int height, float scale, GLStateCache& stateCache);
+
+    /**
+     * @brief Binds and clears the target, with the viewport set to the render size.
+     */
+    void bind();
+
+    /**
+     * @brief Upscales the rendered part into the default framebuffer and restores the window's viewport.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void resolve(GLStateCache& stateCache);
+
+    GLuint getFramebuffer() const { return framebuffer; }
+
+    int getRenderWidth() const { return renderWidth; }
+
+    int getRenderHeight() const { return renderHeight; }
+
+    /**
+     * @brief Releases the textures and the upscale shader.
+     */
+    void destroy();
+
+private:
+    Shader upscaleShader;
+    GLuint framebuffer = 0;
+    GLuint colorTexture = 0;
+    GLuint depthTexture = 0;
+    GLuint emptyVao = 0;     // Fullscreen triangles are generated from gl_VertexID
+    int width = 0;           // Texture size, the window's
+    int height = 0;
+    int renderWidth = 0;     // Part of the textures a frame covers
+    int renderHeight = 0;
+
+    /**
+     * @brief Creates the textures and framebuffer for the current size.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void createTargets(GLStateCache& stateCache);
+
+    /**
+     * @brief Deletes the textures and framebuffer.
+     */
+    void destroyTargets();
+};
+#endif // DYNAMICRESOLUTION_H
@@ -27,13 +27,11 @@ public:
      * @brief Constructor for the FireFlower class.
      * @param initialPos A glm::vec3 representing the initial position of the FireFlower.
      * @param transformData A Transform object containing transformation data for the FireFlower.
-     * @param mesh A MeshCreator object for creating the mesh of the FireFlower.
-     * @param texture A Textures object for the texture of the FireFlower.
-     * @param shader A Shader object for the shader program used by the FireFlower.
+     * @param resources The shared mesh, texture and shader tables.
      * @param inputCamera A reference to the Camera object used for rendering.
      */
-    FireFlower(glm::vec3 initialPos, Transform transformData, MeshCreator mesh, Textures texture, Shader shader, Camera& inputCamera)
-        : Item(initialPos, mesh, texture, shader, inputCamera), transformData(transformData) {}
+    FireFlower(glm::vec3 initialPos, Transform transformData, const ResourceRegistry& resources, Camera& inputCamera)
+        : Item(initialPos, resources, inputCamera), transformData(transformData) {}
    
     /**
      * @brief Renders the FireFlower object.
@@ -0,0 +1,548 @@
+/**
+ * @file FireFlySystem.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the FireFlySystem class.
+ */
+
+#include "FireFlySystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIREFLY_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    const float PI = 3.14159265f;
+    const float TWO_PI = 6.28318531f;
+    const float LEASH_RADIUS = 3.0f;    // Distance from the spawn point before a firefly turns back
+    const float PARTICLE_SCALE = 0.05f;
+
+    uint32_t nextRandom(uint32_t& state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Uniform float in [0, 1) from the top 23 bits
+    float toUnitFloat(uint32_t bits) {
+        uint32_t mantissa = (bits >> 9) | 0x3f800000u;
+        float value;
+        std::memcpy(&value, &mantissa, sizeof(value));
+        return value - 1.0f;
+    }
+
+    float wrapAngle(float x) {
+        return x - TWO_PI * static_cast<float>(static_cast<int>(x / TWO_PI + (x < 0.0f ? -0.5f : 0.5f)));
+    }
+
+    // Parabolic sine for x in [-pi, pi], max error about 0.001
+    float fastSin(float x) {
+        float y = (4.0f / PI) * x - (4.0f / (PI * PI)) * x * std::fabs(x);
+        return 0.225f * (y * std::fabs(y) - y) + y;
+    }
+
+    float fastCos(float x) {
+        x += PI * 0.5f;
+        if (x > PI) x -= TWO_PI;
+        return fastSin(x);
+    }
+
+#ifdef FIREFLY_USE_SSE2
+    __m128i nextRandom4(__m128i& state) {
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+        state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+        state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+        return state;
+    }
+
+    __m128 toUnitFloat4(__m128i bits) {
+        __m128i mantissa = _mm_or_si128(_mm_srli_epi32(bits, 9), _mm_set1_epi32(0x3f800000));
+        return _mm_sub_ps(_mm_castsi128_ps(mantissa), _mm_set1_ps(1.0f));
+    }
+
+    __m128 abs4(__m128 x) {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+    }
+
+    __m128 wrapAngle4(__m128 x) {
+        __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.0f / TWO_PI))));
+        return _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(TWO_PI)));
+    }
+
+    __m128 fastSin4(__m128 x) {
+        __m128 y = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(4.0f / PI), x),
+            _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(4.0f / (PI * PI)), x), abs4(x)));
+        __m128 refine = _mm_sub_ps(_mm_mul_ps(y, abs4(y)), y);
+        return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.225f), refine), y);
+    }
+
+    __m128 fastCos4(__m128 x) {
+        x = _mm_add_ps(x, _mm_set1_ps(PI * 0.5f));
+        __m128 over = _mm_cmpgt_ps(x, _mm_set1_ps(PI));
+        x = _mm_sub_ps(x, _mm_and_ps(over, _mm_set1_ps(TWO_PI)));
+        return fastSin4(x);
+    }
+
+    // r * scale - scale / 2, a random offset centered on zero
+    __m128 jitter4(__m128i& state, float scale) {
+        return _mm_sub_ps(_mm_mul_ps(toUnitFloat4(nextRandom4(state)), _mm_set1_ps(scale)), _mm_set1_ps(scale * 0.5f));
+    }
+#endif
+}
+
+/**
+ * @brief Adds a firefly. While simulated on the GPU, the state is read back first.
+ * @param position The spawn point of the firefly.
+ * @param initialSpeed The initial speed of the firefly.
+ */
+void FireFlySystem::add(const glm::vec3& position, float initialSpeed) {
+    if (gpuSimulated && !gpuUploadPending) {
+        readBackGpuState();
+        gpuUploadPending = true;
+    }
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    positionZ.push_back(position.z);
+    spawnX.push_back(position.x);
+    spawnY.push_back(position.y);
+    spawnZ.push_back(position.z);
+    speed.push_back(initialSpeed);
+    angle.push_back(0.0f);
+    // xorshift needs a non-zero seed; spread the seeds with a Weyl sequence
+    rngState.push_back(0x9E3779B9u * static_cast<uint32_t>(rngState.size() + 1));
+}
+
+/**
+ * @brief Restarts the random sequence of every firefly from a seed, for repeatable runs.
+ *
+ * Seed 0 gives the sequences the fireflies start with. While simulated on the GPU, the state is
+ * read back first.
+ *
+ * @param seed The seed shared by all fireflies; each still gets its own sequence.
+ */
+void FireFlySystem::reseed(uint32_t seed) {
+    if (gpuSimulated && !gpuUploadPending) {
+        readBackGpuState();
+        gpuUploadPending = true;
+    }
+    for (size_t i = 0; i < rngState.size(); i++) {
+        uint32_t state = seed ^ (0x9E3779B9u * static_cast<uint32_t>(i + 1));
+        rngState[i] = state != 0 ? state : 1u;
+    }
+}
+
+/**
+ * @brief Updates fireflies one at a time.
+ * @param begin The first firefly to update.
+ * @param deltaTime The time elapsed since the last update.
+ */
+void FireFlySystem::updateScalar(size_t begin, float deltaTime) {
+    for (size_t i = begin; i < size(); i++) {
+        // Add some randomness to the speed
+        float s = speed[i] + toUnitFloat(nextRandom(rngState[i])) * 0.01f - 0.005f;
+
+        // Reverse the direction of movement once the firefly strays from its spawn point
+        float dx = spawnX[i] - positionX[i];
+        float dy = spawnY[i] - positionY[i];
+        float dz = spawnZ[i] - positionZ[i];
+        if (dx * dx + dy * dy + dz * dz > LEASH_RADIUS * LEASH_RADIUS) {
+            s = -s;
+        }
+
+        // Update the angle, with some randomness
+        float a = angle[i] + s * deltaTime;
+        a += toUnitFloat(nextRandom(rngState[i])) * 0.1f - 0.05f;
+        a = wrapAngle(a);
+
+        // Calculate the new position
+        float step = s * deltaTime;
+        positionX[i] += step * (fastSin(a) + toUnitFloat(nextRandom(rngState[i])) * 0.2f - 0.1f);
+        positionY[i] += step * (fastCos(a) + toUnitFloat(nextRandom(rngState[i])) * 0.2f - 0.1f);
+
+        speed[i] = s;
+        angle[i] = a;
+    }
+}
+
+/**
+ * @brief Moves every firefly.
+ * @param deltaTime The time elapsed since the last update.
+ */
+void FireFlySystem::update(float deltaTime) {
+    size_t i = 0;
+#ifdef FIREFLY_USE_SSE2
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 leash = _mm_set1_ps(LEASH_RADIUS * LEASH_RADIUS);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= size(); i += 4) {
+        __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rngState[i]));
+        __m128 px = _mm_loadu_ps(&positionX[i]);
+        __m128 py = _mm_loadu_ps(&positionY[i]);
+        __m128 pz = _mm_loadu_ps(&positionZ[i]);
+
+        __m128 s = _mm_add_ps(_mm_loadu_ps(&speed[i]), jitter4(state, 0.01f));
+
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&spawnX[i]), px);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&spawnY[i]), py);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(&spawnZ[i]), pz);
+        __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        s = _mm_xor_ps(s, _mm_and_ps(_mm_cmpgt_ps(distance2, leash), signBit));
+
+        __m128 a = _mm_add_ps(_mm_loadu_ps(&angle[i]), _mm_mul_ps(s, dt));
+        a = wrapAngle4(_mm_add_ps(a, jitter4(state, 0.1f)));
+
+        __m128 step = _mm_mul_ps(s, dt);
+        px = _mm_add_ps(px, _mm_mul_ps(step, _mm_add_ps(fastSin4(a), jitter4(state, 0.2f))));
+        py = _mm_add_ps(py, _mm_mul_ps(step, _mm_add_ps(fastCos4(a), jitter4(state, 0.2f))));
+
+        _mm_storeu_ps(&positionX[i], px);
+        _mm_storeu_ps(&positionY[i], py);
+        _mm_storeu_ps(&speed[i], s);
+        _mm_storeu_ps(&angle[i], a);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&rngState[i]), state);
+    }
+#endif
+    updateScalar(i, deltaTime);
+}
+
+/**
+ * @brief Moves every firefly, turning back the ones that fly into an obstacle.
+ *
+ * A firefly that moves from open space to a blocked position goes back to where it was and
+ * reverses, as it does at the end of its leash. One already inside an obstacle, such as one
+ * spawned there, moves freely until it is out.
+ *
+ * @param deltaTime The time elapsed since the last update.
+ * @param isBlocked Returns true when a position is inside an obstacle; called once per firefly.
+ */
+void FireFlySystem::update(float deltaTime, const std::function<bool(const glm::vec3&)>& isBlocked) {
+    // Fireflies added since the last update start out wherever they are
+    for (size_t i = insideObstacle.size(); i < size(); i++) {
+        insideObstacle.push_back(isBlocked(getPosition(i)) ? 1 : 0);
+    }
+    // Only x and y move
+    previousX = positionX;
+    previousY = positionY;
+    update(deltaTime);
+
+    for (size_t i = 0; i < size(); i++) {
+        const bool blocked = isBlocked(getPosition(i));
+        if (blocked && insideObstacle[i] == 0) {
+            positionX[i] = previousX[i];
+            positionY[i] = previousY[i];
+            speed[i] = -speed[i];
+            continue;
+        }
+        insideObstacle[i] = blocked ? 1 : 0;
+    }
+}
+
+/**
+ * @brief Creates the vertex array that draws the mesh once per firefly.
+ * @param particleMesh The indexed mesh drawn for each firefly.
+ */
+void FireFlySystem::createBuffers(const MeshCreator::GLMesh& particleMesh) {
+    mesh = &particleMesh;
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    // Same layout as the MeshCreator meshes
+    MeshCreator::setVertexAttributes(*mesh);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->vbos[1]);
+
+    glGenBuffers(1, &instanceVbo);
+    glBindVertexArray(0);
+
+    createGpuBuffers();
+}
+
+/**
+ * @brief Creates the state buffers and vertex arrays used by the GPU simulation.
+ */
+void FireFlySystem::createGpuBuffers() {
+    static_assert(sizeof(GpuParticle) == 36, "GpuParticle must match the interleaved feedback outputs");
+    const GLsizei stride = sizeof(GpuParticle);
+
+    glGenBuffers(2, stateVbos);
+    glGenVertexArrays(2, updateVaos);
+    glGenVertexArrays(2, gpuDrawVaos);
+
+    for (int i = 0; i < 2; i++) {
+        // Update input: the whole state of every firefly
+        glBindVertexArray(updateVaos[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, stateVbos[i]);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuParticle, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuParticle, spawn));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuParticle, speed));
+        glEnableVertexAttribArray(2);
+        glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, stride, (void*)offsetof(GpuParticle, seed));
+        glEnableVertexAttribArray(3);
+
+        // Draw: the mesh per vertex, the position of firefly i per instance
+        glBindVertexArray(gpuDrawVaos[i]);
+        MeshCreator::setVertexAttributes(*mesh);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->vbos[1]);
+
+        glBindBuffer(GL_ARRAY_BUFFER, stateVbos[i]);
+        for (GLuint axis = 0; axis < 3; axis++) {
+            glVertexAttribPointer(3 + axis, 1, GL_FLOAT, GL_FALSE, stride, (void*)(offsetof(GpuParticle, position) + axis * sizeof(float)));
+            glEnableVertexAttribArray(3 + axis);
+            glVertexAttribDivisor(3 + axis, 1);
+        }
+    }
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Copies the CPU arrays into the GPU state buffer.
+ */
+void FireFlySystem::uploadGpuState() {
+    std::vector<GpuParticle> particles(size());
+    for (size_t i = 0; i < size(); i++) {
+        GpuParticle& particle = particles[i];
+        particle.position[0] = positionX[i];
+        particle.position[1] = positionY[i];
+        particle.position[2] = positionZ[i];
+        particle.spawn[0] = spawnX[i];
+        particle.spawn[1] = spawnY[i];
+        particle.spawn[2] = spawnZ[i];
+        particle.speed = speed[i];
+        particle.angle = angle[i];
+        particle.seed = rngState[i];
+    }
+
+    const GLsizeiptr bytes = particles.size() * sizeof(GpuParticle);
+    currentState = 0;
+    glBindBuffer(GL_ARRAY_BUFFER, stateVbos[0]);
+    glBufferData(GL_ARRAY_BUFFER, bytes, particles.data(), GL_DYNAMIC_COPY);
+    glBindBuffer(GL_ARRAY_BUFFER, stateVbos[1]);
+    glBufferData(GL_ARRAY_BUFFER, bytes, NULL, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    gpuUploadPending = false;
+}
+
+/**
+ * @brief Copies the latest GPU state back into the CPU arrays.
+ */
+void FireFlySystem::readBackGpuState() {
+    std::vector<GpuParticle> particles(size());
+    glBindBuffer(GL_ARRAY_BUFFER, stateVbos[currentState]);
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0, particles.size() * sizeof(GpuParticle), particles.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    for (size_t i = 0; i < size(); i++) {
+        const GpuParticle& particle = particles[i];
+        positionX[i] = particle.position[0];
+        positionY[i] = particle.position[1];
+        positionZ[i] = particle.position[2];
+        speed[i] = particle.speed;
+        angle[i] = particle.angle;
+        rngState[i] = particle.seed;
+    }
+    // The GPU ignores obstacles, so each firefly starts over from where it ended up
+    insideObstacle.clear();
+}
+
+/**
+ * @brief Moves the simulation state between the CPU arrays and the GPU buffers.
+ * @param enabled True to simulate on the GPU, false to simulate on the CPU.
+ */
+void FireFlySystem::setGpuSimulation(bool enabled) {
+    if (enabled == gpuSimulated || stateVbos[0] == 0) {
+        return;
+    }
+    if (enabled) {
+        uploadGpuState();
+    }
+    else if (!gpuUploadPending) {
+        // Pending CPU changes already hold the latest state
+        readBackGpuState();
+    }
+    gpuSimulated = enabled;
+    gpuUploadPending = false;
+}
+
+/**
+ * @brief Moves every firefly with one transform feedback pass.
+ * @param deltaTime The time elapsed since the last update.
+ * @param updateShader The transform feedback program built from 6.firefly_update.vs.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void FireFlySystem::updateGpu(float deltaTime, const Shader& updateShader, GLStateCache& stateCache) {
+    if (!gpuSimulated || size() == 0) {
+        return;
+    }
+    if (gpuUploadPending) {
+        uploadGpuState();
+    }
+
+    const int nextState = 1 - currentState;
+    stateCache.useProgram(updateShader.ID);
+    updateShader.setFloat(updateShader.getUniformLocation("deltaTime"), deltaTime);
+    stateCache.bindVertexArray(updateVaos[currentState]);
+
+    // No fragments: the vertex outputs go straight into the other state buffer
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, stateVbos[nextState]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(size()));
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    currentState = nextState;
+}
+
+/**
+ * @brief Copies the current positions, so they can be drawn while the next update runs.
+ * @param positions Receives the positions; its arrays keep their capacity.
+ */
+void FireFlySystem::writeSnapshot(Snapshot& positions) const {
+    positions.positionX.assign(positionX.begin(), positionX.end());
+    positions.positionY.assign(positionY.begin(), positionY.end());
+    positions.positionZ.assign(positionZ.begin(), positionZ.end());
+}
+
+/**
+ * @brief Copies the positions into the instance buffer, growing it when needed.
+ * @param positions The positions to draw.
+ */
+void FireFlySystem::uploadPositions(const Snapshot& positions) {
+    const size_t count = positions.size();
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(count * sizeof(float));
+    const float* arrays[3] = { positions.positionX.data(), positions.positionY.data(), positions.positionZ.data() };
+
+    if (streamBuffer != nullptr) {
+        GLintptr offsets[3];
+        int axis = 0;
+        while (axis < 3 && (offsets[axis] = streamBuffer->write(arrays[axis], bytes, sizeof(glm::vec4))) != StreamBuffer::NO_SPACE) {
+            axis++;
+        }
+        if (axis == 3) {
+            positionSource = streamBuffer->getBuffer();
+            std::copy(offsets, offsets + 3, positionOffsets);
+            return;
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    if (count > instanceCapacity) {
+        // The x, y and z arrays sit one after another, so their offsets move with the capacity
+        instanceCapacity = count * 2;
+    }
+    // Orphan the old storage so the driver does not wait for the previous frame
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity * 3 * sizeof(float), NULL, GL_STREAM_DRAW);
+    for (int axis = 0; axis < 3; axis++) {
+        positionOffsets[axis] = axis * instanceCapacity * sizeof(float);
+        glBufferSubData(GL_ARRAY_BUFFER, positionOffsets[axis], bytes, arrays[axis]);
+    }
+    positionSource = instanceVbo;
+}
+
+/**
+ * @brief Points attribute locations 3 to 5 of the bound VAO at the last uploaded positions.
+ */
+void FireFlySystem::bindPositionAttributes() {
+    glBindBuffer(GL_ARRAY_BUFFER, positionSource);
+    for (GLuint axis = 0; axis < 3; axis++) {
+        glVertexAttribPointer(3 + axis, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)positionOffsets[axis]);
+        glEnableVertexAttribArray(3 + axis);
+        glVertexAttribDivisor(3 + axis, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * @brief Draws every firefly with one instanced draw call.
+ * @param shader The firefly shader, with per-instance offsets at locations 3 to 5.
+ * @param texture The diffuse texture of the fireflies.
+ * @param stateCache The cache that filters redundant binds.
+ * @param positions The positions to draw; ignored while simulated on the GPU.
+ */
+void FireFlySystem::draw(const Shader& shader, GLuint texture, GLStateCache& stateCache, const Snapshot& positions) {
+    const size_t instanceCount = gpuSimulated ? size() : positions.size();
+    if (getDrawCallCount() == 0 || instanceCount == 0) {
+        return;
+    }
+    if (!gpuSimulated) {
+        uploadPositions(positions);
+    }
+
+    stateCache.useProgram(shader.ID);
+    shader.setFloat(shader.getUniformLocation("particleScale"), PARTICLE_SCALE);
+    shader.setFloat(shader.getUniformLocation("material.shininess"), 2.0f);
+    shader.setVec2(shader.getUniformLocation("uvScale"), glm::vec2(1.0f, 1.0f));
+
+    // bind textures on corresponding texture units
+    stateCache.bindTexture(0, GL_TEXTURE_2D, texture);
+    stateCache.bindTexture(1, GL_TEXTURE_2D, 0);
+    stateCache.bindTexture(2, GL_TEXTURE_2D, 0);
+
+    stateCache.bindVertexArray(gpuSimulated ? gpuDrawVaos[currentState] : vao);
+    if (!gpuSimulated) {
+        bindPositionAttributes();
+    }
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh->nIndices, GL_UNSIGNED_SHORT, mesh->getIndexOffset(), static_cast<GLsizei>(instanceCount), mesh->baseVertex);
+}
+
+/**
+ * @brief Draws every firefly into a depth map with one instanced draw call.
+ *
+ * Binds no textures or material uniforms, for the shadow maps' dynamic casters.
+ *
+ * @param shader The depth-only firefly shader, with per-instance offsets at locations 3 to 5.
+ * @param stateCache The cache that filters redundant binds.
+ * @param positions The positions to draw; ignored while simulated on the GPU.
+ */
+void FireFlySystem::drawDepth(const Shader& shader, GLStateCache& stateCache, const Snapshot& positions) {
+    const size_t instanceCount = gpuSimulated ? size() : positions.size();
+    if (getDrawCallCount() == 0 || instanceCount == 0) {
+        return;
+    }
+    if (!gpuSimulated) {
+        uploadPositions(positions);
+    }
+
+    stateCache.useProgram(shader.ID);
+    shader.setFloat(shader.getUniformLocation("particleScale"), PARTICLE_SCALE);
+    stateCache.bindVertexArray(gpuSimulated ? gpuDrawVaos[currentState] : vao);
+    if (!gpuSimulated) {
+        bindPositionAttributes();
+    }
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh->nIndices, GL_UNSIGNED_SHORT, mesh->getIndexOffset(), static_cast<GLsizei>(instanceCount), mesh->baseVertex);
+}
+
+/**
+ * @brief Releases the GL buffers.
+ */
+void FireFlySystem::destroyBuffers() {
+    if (vao != 0) {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &instanceVbo);
+        vao = 0;
+        instanceVbo = 0;
+        instanceCapacity = 0;
+    }
+    if (stateVbos[0] != 0) {
+        glDeleteVertexArrays(2, updateVaos);
+        glDeleteVertexArrays(2, gpuDrawVaos);
+        glDeleteBuffers(2, stateVbos);
+        for (int i = 0; i < 2; i++) {
+            updateVaos[i] = 0;
+            gpuDrawVaos[i] = 0;
+            stateVbos[i] = 0;
+        }
+        gpuSimulated = false;
+    }
+}
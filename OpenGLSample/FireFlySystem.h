@@ -0,0 +1,249 @@
+/**
+ * @file FireFlySystem.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the FireFlySystem class, which simulates and draws every firefly in the scene.
+ */
+
+#ifndef FIREFLYSYSTEM_H
+#define FIREFLYSYSTEM_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "MeshCreator.h"
+#include "GLStateCache.h"
+#include "shader.h"
+#include "StreamBuffer.h"
+
+/**
+ * @class FireFlySystem
+ * @brief Fireflies stored as structure-of-arrays and updated in one pass.
+ *
+ * Each firefly wanders around its spawn point: its speed and angle drift randomly, and it turns
+ * back when it strays more than the leash radius away. All fireflies are updated every frame,
+ * four at a time with SSE2 where available, using a xorshift generator per firefly. The position
+ * arrays are uploaded as they are and drawn with one instanced call.
+ *
+ * The same motion can run on the GPU instead: the state is copied into two interleaved buffers,
+ * and each frame a transform feedback pass reads one and writes the other. The fireflies are then
+ * drawn straight from the buffer that was just written, so the CPU neither updates nor uploads them.
+ */
+class FireFlySystem
+{
+public:
+    // A copy of the positions, taken after an update and drawn later
+    struct Snapshot
+    {
+        std::vector<float> positionX, positionY, positionZ;
+
+        size_t size() const { return positionX.size(); }
+    };
+
+private:
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> spawnX, spawnY, spawnZ;
+    std::vector<float> speed;
+    std::vector<float> angle;
+    std::vector<uint32_t> rngState;
+    std::vector<float> previousX, previousY;        // Positions before the update, for fireflies turned back by an obstacle
+    std::vector<unsigned char> insideObstacle;      // 1 while a firefly is inside an obstacle and free to leave it
+
+    // Interleaved per-firefly state, as read and written by 6.firefly_update.vs
+    struct GpuParticle
+    {
+        float position[3];
+        float spawn[3];
+        float speed;
+        float angle;
+        uint32_t seed;
+    };
+
+    const MeshCreator::GLMesh* mesh = nullptr;
+    GLuint vao = 0;
+    GLuint instanceVbo = 0;
+    size_t instanceCapacity = 0;   // Fireflies the instance buffer can hold
+    StreamBuffer* streamBuffer = nullptr;   // Ring the positions are written into, when set
+    GLuint positionSource = 0;              // Buffer holding the last uploaded x, y and z arrays
+    GLintptr positionOffsets[3] = {};       // Offset of each array in positionSource
+
+    GLuint stateVbos[2] = { 0, 0 };     // Ping-pong state buffers for the GPU simulation
+    GLuint updateVaos[2] = { 0, 0 };    // Read the state of buffer i as update shader input
+    GLuint gpuDrawVaos[2] = { 0, 0 };   // Draw the mesh with the positions in buffer i
+    int currentState = 0;               // Buffer holding the latest GPU state
+    bool gpuSimulated = false;          // True while the GPU owns the simulation state
+    bool gpuUploadPending = false;      // True when the CPU arrays changed while simulated on the GPU
+
+    /**
+     * @brief Updates fireflies one at a time.
+     * @param begin The first firefly to update.
+     * @param deltaTime The time elapsed since the last update.
+     */
+    void updateScalar(size_t begin, float deltaTime);
+
+    /**
+     * @brief Copies the positions into the instance buffer, growing it when needed.
+     * @param positions The positions to draw.
+     */
+    void uploadPositions(const Snapshot& positions);
+
+    /**
+     * @brief Points attribute locations 3 to 5 of the bound VAO at the last uploaded positions.
+     */
+    void bindPositionAttributes();
+
+    /**
+     * @brief Creates the state buffers and vertex arrays used by the GPU simulation.
+     */
+    void createGpuBuffers();
+
+    /**
+     * @brief Copies the CPU arrays into the GPU state buffer.
+     */
+    void uploadGpuState();
+
+    /**
+     * @brief Copies the latest GPU state back into the CPU arrays.
+     */
+    void readBackGpuState();
+
+public:
+    /**
+     * @brief Adds a firefly. While simulated on the GPU, the state is read back first.
+     * @param position The spawn point of the firefly.
+     * @param initialSpeed The initial speed of the firefly.
+     */
+    void add(const glm::vec3& position, float initialSpeed);
+
+    /**
+     * @brief Restarts the random sequence of every firefly from a seed, for repeatable runs.
+     *
+     * Seed 0 gives the sequences the fireflies start with. While simulated on the GPU, the state is
+     * read back first.
+     *
+     * @param seed The seed shared by all fireflies; each still gets its own sequence.
+     */
+    void reseed(uint32_t seed);
+
+    /**
+     * @brief Returns the number of fireflies.
+     */
+    size_t size() const { return positionX.size(); }
+
+    /**
+     * @brief Returns the current position of a firefly.
+     * @param index The firefly index.
+     */
+    glm::vec3 getPosition(size_t index) const {
+        return glm::vec3(positionX[index], positionY[index], positionZ[index]);
+    }
+
+    /**
+     * @brief Returns the spawn point of a firefly.
+     * @param index The firefly index.
+     */
+    glm::vec3 getSpawnPosition(size_t index) const {
+        return glm::vec3(spawnX[index], spawnY[index], spawnZ[index]);
+    }
+
+    /**
+     * @brief Returns the current speed of a firefly.
+     * @param index The firefly index.
+     */
+    float getSpeed(size_t index) const { return speed[index]; }
+
+    /**
+     * @brief Moves every firefly.
+     * @param deltaTime The time elapsed since the last update.
+     */
+    void update(float deltaTime);
+
+    /**
+     * @brief Moves every firefly, turning back the ones that fly into an obstacle.
+     *
+     * A firefly that moves from open space to a blocked position goes back to where it was and
+     * reverses, as it does at the end of its leash. One already inside an obstacle, such as one
+     * spawned there, moves freely until it is out.
+     *
+     * @param deltaTime The time elapsed since the last update.
+     * @param isBlocked Returns true when a position is inside an obstacle; called once per firefly.
+     */
+    void update(float deltaTime, const std::function<bool(const glm::vec3&)>& isBlocked);
+
+    /**
+     * @brief Copies the current positions, so they can be drawn while the next update runs.
+     * @param positions Receives the positions; its arrays keep their capacity.
+     */
+    void writeSnapshot(Snapshot& positions) const;
+
+    /**
+     * @brief Moves every firefly with one transform feedback pass.
+     * @param deltaTime The time elapsed since the last update.
+     * @param updateShader The transform feedback program built from 6.firefly_update.vs.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void updateGpu(float deltaTime, const Shader& updateShader, GLStateCache& stateCache);
+
+    /**
+     * @brief Moves the simulation state between the CPU arrays and the GPU buffers.
+     * @param enabled True to simulate on the GPU, false to simulate on the CPU.
+     */
+    void setGpuSimulation(bool enabled);
+
+    /**
+     * @brief Returns true while the fireflies are simulated on the GPU.
+     */
+    bool isGpuSimulated() const { return gpuSimulated; }
+
+    /**
+     * @brief Writes the CPU-simulated positions into a ring instead of the orphaned instance buffer.
+     * @param buffer The ring, or nullptr to use the instance buffer.
+     */
+    void setStreamBuffer(StreamBuffer* buffer) { streamBuffer = buffer; }
+
+    /**
+     * @brief Creates the vertex array that draws the mesh once per firefly.
+     * @param particleMesh The indexed mesh drawn for each firefly.
+     */
+    void createBuffers(const MeshCreator::GLMesh& particleMesh);
+
+    /**
+     * @brief Draws every firefly with one instanced draw call.
+     * @param shader The firefly shader, with per-instance offsets at locations 3 to 5.
+     * @param texture The diffuse texture of the fireflies.
+     * @param stateCache The cache that filters redundant binds.
+     * @param positions The positions to draw; ignored while simulated on the GPU.
+     */
+    void draw(const Shader& shader, GLuint texture, GLStateCache& stateCache, const Snapshot& positions);
+
+    /**
+     * @brief Draws every firefly into a depth map with one instanced draw call.
+     *
+     * Binds no textures or material uniforms, for the shadow maps' dynamic casters.
+     *
+     * @param shader The depth-only firefly shader, with per-instance offsets at locations 3 to 5.
+     * @param stateCache The cache that filters redundant binds.
+     * @param positions The positions to draw; ignored while simulated on the GPU.
+     */
+    void drawDepth(const Shader& shader, GLStateCache& stateCache, const Snapshot& positions);
+
+    /**
+     * @brief Returns the number of draw calls issued by draw().
+     */
+    size_t getDrawCallCount() const { return (vao != 0 && size() > 0) ? 1 : 0; }
+
+    /**
+     * @brief Returns the number of triangles drawn by draw().
+     */
+    size_t getTriangleCount() const { return mesh != nullptr ? mesh->nIndices / 3 * size() : 0; }
+
+    /**
+     * @brief Releases the GL buffers.
+     */
+    void destroyBuffers();
+};
+#endif // FIREFLYSYSTEM_H
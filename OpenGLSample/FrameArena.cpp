@@ -0,0 +1,57 @@
+/**
+ * @file FrameArena.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the FrameArena class.
+ */
+
+#include "FrameArena.h"
+
+const size_t FrameArena::DEFAULT_CAPACITY;
+
+/**
+ * @brief Creates the arena with a block of a given size.
+ * @param capacity The size of the block in bytes.
+ */
+FrameArena::FrameArena(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {
+    block.reset(new unsigned char[this->capacity]);
+}
+
+/**
+ * @brief Returns uninitialized memory that stays valid until the next reset.
+ * @param size The number of bytes.
+ * @param alignment What the address must be a multiple of, a power of two.
+ */
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    alignment = std::max<size_t>(alignment, 1);
+    const size_t base = reinterpret_cast<size_t>(block.get());
+    const size_t start = ((base + head + alignment - 1) & ~(alignment - 1)) - base;
+    frameBytes += size + (start - head);
+    if (start + size <= capacity) {
+        head = start + size;
+        return block.get() + start;
+    }
+
+    // Past the block: a heap block of its own, with room to align it
+    overflow.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[size + alignment]));
+    const size_t address = reinterpret_cast<size_t>(overflow.back().get());
+    return reinterpret_cast<void*>((address + alignment - 1) & ~(alignment - 1));
+}
+
+/**
+ * @brief Takes back everything allocated since the last reset, growing the block after an overflow.
+ */
+void FrameArena::reset() {
+    peakBytes = std::max(peakBytes, frameBytes);
+    if (!overflow.empty()) {
+        overflowCount++;
+        overflow.clear();
+        while (capacity < peakBytes) {
+            capacity *= 2;
+        }
+        block.reset(new unsigned char[capacity]);
+    }
+    head = 0;
+    frameBytes = 0;
+}
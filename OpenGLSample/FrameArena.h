@@ -0,0 +1,179 @@
+/**
+ * @file FrameArena.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the FrameArena class, a linear allocator for the data
+ * that lives for one frame, of the FrameAllocator template that puts standard containers in it, and
+ * of arenaStableSort, a stable sort whose merge buffer comes from it.
+ */
+
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class FrameArena
+ * @brief One block handed out front to back and taken back all at once at the end of the frame.
+ *
+ * An allocation is a pointer bump and freeing is a no-op, so transient containers cost no heap
+ * traffic. A frame that needs more than the block gets heap blocks for the rest, released at reset,
+ * and the block is grown to that frame's peak, so the heap is only touched until the arena has seen
+ * the largest frame. Used on the GL thread only.
+ */
+class FrameArena
+{
+public:
+    static const size_t DEFAULT_CAPACITY = 1024 * 1024; // Bytes of the block before it grows
+
+    /**
+     * @brief Creates the arena with a block of a given size.
+     * @param capacity The size of the block in bytes.
+     */
+    explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /**
+     * @brief Returns uninitialized memory that stays valid until the next reset.
+     * @param size The number of bytes.
+     * @param alignment What the address must be a multiple of, a power of two.
+     */
+    void* allocate(size_t size, size_t alignment);
+
+    /**
+     * @brief Returns uninitialized memory for a number of objects, valid until the next reset.
+     */
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * @brief Takes back everything allocated since the last reset, growing the block after an overflow.
+     */
+    void reset();
+
+    size_t getCapacity() const { return capacity; }
+
+    /**
+     * @brief Returns the bytes the largest frame so far allocated.
+     */
+    size_t getPeakBytes() const { return peakBytes; }
+
+    /**
+     * @brief Returns the number of frames that did not fit the block.
+     */
+    size_t getOverflowCount() const { return overflowCount; }
+
+private:
+    std::unique_ptr<unsigned char[]> block;
+    size_t capacity;
+    size_t head = 0;                                        // Next free byte of the block
+    size_t frameBytes = 0;                                  // Allocated since the last reset, overflow included
+    size_t peakBytes = 0;
+    size_t overflowCount = 0;
+    std::vector<std::unique_ptr<unsigned char[]>> overflow; // Heap blocks of the allocations past the block
+};
+
+/**
+ * @class FrameAllocator
+ * @brief A standard allocator that takes its memory from a frame arena, or from the heap without one.
+ *
+ * A container using it must be destroyed before the arena's next reset.
+ */
+template <typename T>
+class FrameAllocator
+{
+public:
+    typedef T value_type;
+
+    explicit FrameAllocator(FrameArena* arena) : arena(arena) {}
+
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        if (arena != nullptr) {
+            return arena->allocateArray<T>(count);
+        }
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t) {
+        if (arena == nullptr) {
+            ::operator delete(pointer);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U>& other) const { return arena == other.arena; }
+
+    template <typename U>
+    bool operator!=(const FrameAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+    template <typename U> friend class FrameAllocator;
+
+    FrameArena* arena;
+};
+
+/**
+ * @brief Sorts a vector like std::stable_sort, with the merge buffer taken from a frame arena.
+ *
+ * std::stable_sort allocates its buffer on the heap at every call. Here runs of INSERTION_RUN
+ * elements are sorted in place and then merged pairwise, back and forth between the vector and
+ * the buffer. Without an arena, std::stable_sort is used.
+ *
+ * @param values The elements, of a trivially copyable type.
+ * @param compare The strict weak ordering.
+ * @param arena The arena of the frame, or nullptr.
+ */
+template <typename T, typename Compare>
+void arenaStableSort(std::vector<T>& values, Compare compare, FrameArena* arena) {
+    static_assert(std::is_trivially_copyable<T>::value, "the merge buffer is uninitialized memory");
+    const size_t INSERTION_RUN = 32;
+    const size_t count = values.size();
+    if (arena == nullptr) {
+        std::stable_sort(values.begin(), values.end(), compare);
+        return;
+    }
+
+    T* source = values.data();
+    for (size_t begin = 0; begin < count; begin += INSERTION_RUN) {
+        const size_t end = std::min(begin + INSERTION_RUN, count);
+        for (size_t i = begin + 1; i < end; i++) {
+            const T value = source[i];
+            size_t j = i;
+            for (; j > begin && compare(value, source[j - 1]); j--) {
+                source[j] = source[j - 1];
+            }
+            source[j] = value;
+        }
+    }
+    if (count <= INSERTION_RUN) {
+        return;
+    }
+
+    // std::merge takes from the first range on ties, so equal elements keep their order
+    T* target = arena->allocateArray<T>(count);
+    for (size_t width = INSERTION_RUN; width < count; width *= 2) {
+        for (size_t begin = 0; begin < count; begin += 2 * width) {
+            const size_t middle = std::min(begin + width, count);
+            const size_t end = std::min(begin + 2 * width, count);
+            std::merge(source + begin, source + middle, source + middle, source + end, target + begin, compare);
+        }
+        std::swap(source, target);
+    }
+    if (source != values.data()) {
+        std::copy(source, source + count, values.data());
+    }
+}
+#endif // FRAMEARENA_H
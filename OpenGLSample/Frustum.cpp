@@ -0,0 +1,103 @@
+/**
+ * @file Frustum.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the Frustum class.
+ */
+
+#include "Frustum.h"
+#include <cmath>
+
+/**
+ * @brief Extracts the planes from a combined projection * view matrix.
+ * @param viewProjection The matrix that transforms world space to clip space.
+ */
+void Frustum::update(const glm::mat4& viewProjection) {
+    // glm is column-major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    glm::vec4 planes[PLANE_COUNT];
+    planes[PLANE_NEAR] = rows[3] + rows[2];
+    planes[PLANE_FAR] = rows[3] - rows[2];
+    planes[PLANE_LEFT] = rows[3] + rows[0];
+    planes[PLANE_RIGHT] = rows[3] - rows[0];
+    planes[PLANE_BOTTOM] = rows[3] + rows[1];
+    planes[PLANE_TOP] = rows[3] - rows[1];
+
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        // Normalize so the box radius and the plane distance use the same units
+        float length = glm::length(glm::vec3(planes[i]));
+        if (length > 0.0f) {
+            planes[i] /= length;
+        }
+        normalX[i] = planes[i].x;
+        normalY[i] = planes[i].y;
+        normalZ[i] = planes[i].z;
+        distance[i] = planes[i].w;
+    }
+}
+
+/**
+ * @brief Tests one box against the planes.
+ * @param box The world-space box.
+ * @param planeCount The number of planes to test, starting with the near plane.
+ * @return False when the box is fully outside one of the planes.
+ */
+bool Frustum::intersects(const AABB& box, int planeCount) const {
+    if (!box.isValid()) {
+        return false;
+    }
+    glm::vec3 center = box.getCenter();
+    glm::vec3 extents = box.getExtents();
+    for (int i = 0; i < planeCount; i++) {
+        float centerDistance = normalX[i] * center.x + normalY[i] * center.y + normalZ[i] * center.z + distance[i];
+        float radius = std::fabs(normalX[i]) * extents.x + std::fabs(normalY[i]) * extents.y + std::fabs(normalZ[i]) * extents.z;
+        if (centerDistance + radius < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Tests a batch of boxes against the planes.
+ * @param boxes The world-space boxes.
+ * @param visible Receives one flag per box, 1 when the box intersects the volume.
+ * @param planeCount The number of planes to test, starting with the near plane.
+ */
+void Frustum::cull(const BoxList& boxes, std::vector<unsigned char>& visible, int planeCount) const {
+    visible.assign(boxes.size(), 1);
+    cullRange(boxes, visible, planeCount, 0, boxes.size());
+}
+
+/**
+ * @brief Tests part of a batch of boxes against the planes, so a batch can be split across threads.
+ * @param boxes The world-space boxes.
+ * @param visible Holds one flag per box, preset to 1; the flags of boxes outside the volume are cleared.
+ * @param planeCount The number of planes to test, starting with the near plane.
+ * @param begin The first box to test.
+ * @param end One past the last box to test.
+ */
+void Frustum::cullRange(const BoxList& boxes, std::vector<unsigned char>& visible, int planeCount, size_t begin, size_t end) const {
+    const float* cx = boxes.centerX.data();
+    const float* cy = boxes.centerY.data();
+    const float* cz = boxes.centerZ.data();
+    const float* ex = boxes.extentX.data();
+    const float* ey = boxes.extentY.data();
+    const float* ez = boxes.extentZ.data();
+    unsigned char* out = visible.data();
+
+    // One plane at a time over every box; the inner loop has no branches
+    for (int plane = 0; plane < planeCount; plane++) {
+        const float nx = normalX[plane], ny = normalY[plane], nz = normalZ[plane], d = distance[plane];
+        const float ax = std::fabs(nx), ay = std::fabs(ny), az = std::fabs(nz);
+        for (size_t i = begin; i < end; i++) {
+            float reach = nx * cx[i] + ny * cy[i] + nz * cz[i] + d + ax * ex[i] + ay * ey[i] + az * ez[i];
+            out[i] &= static_cast<unsigned char>(reach >= 0.0f);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/**
+ * @file Frustum.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the Frustum class, which culls bounding boxes against the view volume.
+ */
+
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+/**
+ * @struct BoxList
+ * @brief Bounding boxes stored as separate center and extent arrays for batch culling.
+ */
+struct BoxList
+{
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+    size_t size() const { return centerX.size(); }
+
+    void reserve(size_t count) {
+        centerX.reserve(count); centerY.reserve(count); centerZ.reserve(count);
+        extentX.reserve(count); extentY.reserve(count); extentZ.reserve(count);
+    }
+
+    void clear() {
+        centerX.clear(); centerY.clear(); centerZ.clear();
+        extentX.clear(); extentY.clear(); extentZ.clear();
+    }
+
+    void push(const AABB& box) {
+        glm::vec3 center = box.getCenter();
+        glm::vec3 extents = box.getExtents();
+        centerX.push_back(center.x); centerY.push_back(center.y); centerZ.push_back(center.z);
+        extentX.push_back(extents.x); extentY.push_back(extents.y); extentZ.push_back(extents.z);
+    }
+};
+
+/**
+ * @class Frustum
+ * @brief The six planes of a view volume, extracted from a projection * view matrix.
+ *
+ * The planes are taken from the rows of the combined matrix (Gribb and Hartmann), so they are
+ * correct for both the perspective and the orthographic projection. Plane normals point into the
+ * volume and are stored one component per array, so a batch of boxes is tested with straight
+ * loops the compiler can vectorize.
+ */
+class Frustum
+{
+public:
+    // Plane order; the near plane comes first so it can be tested on its own
+    enum Plane { PLANE_NEAR = 0, PLANE_FAR, PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_COUNT };
+
+    /**
+     * @brief Extracts the planes from a combined projection * view matrix.
+     * @param viewProjection The matrix that transforms world space to clip space.
+     */
+    void update(const glm::mat4& viewProjection);
+
+    /**
+     * @brief Tests one box against the planes.
+     * @param box The world-space box.
+     * @param planeCount The number of planes to test, starting with the near plane.
+     * @return False when the box is fully outside one of the planes.
+     */
+    bool intersects(const AABB& box, int planeCount = PLANE_COUNT) const;
+
+    /**
+     * @brief Returns the number of planes a query tests.
+     * @param checkFrustum True for all six planes, false for only the near plane, which drops boxes behind the camera.
+     */
+    static int getPlaneCount(bool checkFrustum) { return checkFrustum ? PLANE_COUNT : PLANE_NEAR + 1; }
+
+    /**
+     * @brief Tests a batch of boxes against the planes.
+     * @param boxes The world-space boxes.
+     * @param visible Receives one flag per box, 1 when the box intersects the volume.
+     * @param planeCount The number of planes to test, starting with the near plane.
+     */
+    void cull(const BoxList& boxes, std::vector<unsigned char>& visible, int planeCount = PLANE_COUNT) const;
+
+    /**
+     * @brief Tests part of a batch of boxes against the planes, so a batch can be split across threads.
+     * @param boxes The world-space boxes.
+     * @param visible Holds one flag per box, preset to 1; the flags of boxes outside the volume are cleared.
+     * @param planeCount The number of planes to test, starting with the near plane.
+     * @param begin The first box to test.
+     * @param end One past the last box to test.
+     */
+    void cullRange(const BoxList& boxes, std::vector<unsigned char>& visible, int planeCount, size_t begin, size_t end) const;
+
+private:
+    float normalX[PLANE_COUNT] = {};
+    float normalY[PLANE_COUNT] = {};
+    float normalZ[PLANE_COUNT] = {};
+    float distance[PLANE_COUNT] = {};
+};
+#endif // FRUSTUM_H
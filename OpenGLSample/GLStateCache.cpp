@@ -0,0 +1,116 @@
+/**
+ * @file GLStateCache.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the GLStateCache class.
+ */
+
+#include "GLStateCache.h"
+#include <iostream>
+
+/**
+ * @brief Makes a program current.
+ * @param program The program handle.
+ */
+void GLStateCache::useProgram(GLuint program) {
+    if (currentProgram == program) {
+        stats.programBindsSkipped++;
+        return;
+    }
+    glUseProgram(program);
+    currentProgram = program;
+    stats.programBinds++;
+}
+
+/**
+ * @brief Binds a vertex array object.
+ * @param vao The vertex array handle, or 0 to unbind.
+ */
+void GLStateCache::bindVertexArray(GLuint vao) {
+    if (currentVertexArray == vao) {
+        stats.vertexArrayBindsSkipped++;
+        return;
+    }
+    glBindVertexArray(vao);
+    currentVertexArray = vao;
+    stats.vertexArrayBinds++;
+}
+
+/**
+ * @brief Binds a texture to a texture unit.
+ * @param unit The zero-based texture unit.
+ * @param target GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_BUFFER.
+ * @param texture The texture handle, or 0 to unbind.
+ */
+void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    if (unit >= MAX_TEXTURE_UNITS) {
+        std::cout << "ERROR::GLSTATECACHE::TEXTURE_UNIT_OUT_OF_RANGE" << std::endl;
+        return;
+    }
+
+    GLuint* bound = &textures2D[unit];
+    if (target == GL_TEXTURE_CUBE_MAP) {
+        bound = &texturesCube[unit];
+    }
+    else if (target == GL_TEXTURE_BUFFER) {
+        bound = &texturesBuffer[unit];
+    }
+    else if (target == GL_TEXTURE_2D_ARRAY) {
+        bound = &texturesArray[unit];
+    }
+    if (*bound == texture) {
+        stats.textureBindsSkipped++;
+        return;
+    }
+    if (activeUnit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+    }
+    glBindTexture(target, texture);
+    *bound = texture;
+    stats.textureBinds++;
+}
+
+/**
+ * @brief Forgets the shadowed state so that the next bind of each kind is always issued.
+ *
+ * Call this after code outside the cache has changed bindings.
+ */
+void GLStateCache::invalidate() {
+    currentProgram = UNKNOWN;
+    currentVertexArray = UNKNOWN;
+    activeUnit = UNKNOWN;
+    for (int i = 0; i < MAX_TEXTURE_UNITS; i++) {
+        textures2D[i] = UNKNOWN;
+        texturesCube[i] = UNKNOWN;
+        texturesBuffer[i] = UNKNOWN;
+        texturesArray[i] = UNKNOWN;
+    }
+}
+
+/**
+ * @brief Marks a texture as unbound on every unit it was bound to through the cache.
+ *
+ * Call this before deleting a texture, since glGenTextures may hand the same name out again.
+ * @param texture The texture handle.
+ */
+void GLStateCache::forgetTexture(GLuint texture) {
+    for (int i = 0; i < MAX_TEXTURE_UNITS; i++) {
+        GLuint* bound[] = { &textures2D[i], &texturesCube[i], &texturesBuffer[i], &texturesArray[i] };
+        for (GLuint* name : bound) {
+            if (*name == texture) {
+                *name = UNKNOWN;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Prints the bind counters to the console.
+ */
+void GLStateCache::printStats() const {
+    std::cout << "Programs: " << stats.programBinds << " bound, " << stats.programBindsSkipped << " skipped" << std::endl;
+    std::cout << "Vertex arrays: " << stats.vertexArrayBinds << " bound, " << stats.vertexArrayBindsSkipped << " skipped" << std::endl;
+    std::cout << "Textures: " << stats.textureBinds << " bound, " << stats.textureBindsSkipped << " skipped" << std::endl;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file GLStateCache.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the GLStateCache class, which filters out redundant
+ * program, vertex array and texture binds.
+ */
+
+#ifndef GLSTATECACHE_H
+#define GLSTATECACHE_H
+
+#include <glad/glad.h>
+
+/**
+ * @class GLStateCache
+ * @brief Shadows the GL binding state and skips binds that would not change it.
+ *
+ * Every glUseProgram, glBindVertexArray and glBindTexture issued by the renderer goes through this
+ * class. It counts how many binds were sent to the driver and how many were skipped.
+ */
+class GLStateCache
+{
+public:
+    static const int MAX_TEXTURE_UNITS = 16;
+
+    // Issued and skipped binds since the last resetStats
+    struct Stats
+    {
+        unsigned int programBinds = 0;
+        unsigned int programBindsSkipped = 0;
+        unsigned int vertexArrayBinds = 0;
+        unsigned int vertexArrayBindsSkipped = 0;
+        unsigned int textureBinds = 0;
+        unsigned int textureBindsSkipped = 0;
+    };
+
+    GLStateCache() { invalidate(); }
+
+    /**
+     * @brief Makes a program current.
+     * @param program The program handle.
+     */
+    void useProgram(GLuint program);
+
+    /**
+     * @brief Binds a vertex array object.
+     * @param vao The vertex array handle, or 0 to unbind.
+     */
+    void bindVertexArray(GLuint vao);
+
+    /**
+     * @brief Binds a texture to a texture unit.
+     * @param unit The zero-based texture unit.
+     * @param target GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_BUFFER.
+     * @param texture The texture handle, or 0 to unbind.
+     */
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    /**
+     * @brief Forgets the shadowed state so that the next bind of each kind is always issued.
+     *
+     * Call this after code outside the cache has changed bindings.
+     */
+    void invalidate();
+
+    /**
+     * @brief Marks a texture as unbound on every unit it was bound to through the cache.
+     *
+     * Call this before deleting a texture, since glGenTextures may hand the same name out again.
+     * @param texture The texture handle.
+     */
+    void forgetTexture(GLuint texture);
+
+    /**
+     * @brief Clears the bind counters.
+     */
+    void resetStats() { stats = Stats(); }
+
+    /**
+     * @brief Returns the bind counters.
+     */
+    const Stats& getStats() const { return stats; }
+
+    /**
+     * @brief Prints the bind counters to the console.
+     */
+    void printStats() const;
+
+private:
+    // Marks a binding as unknown
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+    GLuint currentProgram;
+    GLuint currentVertexArray;
+    GLuint activeUnit;
+    GLuint textures2D[MAX_TEXTURE_UNITS];
+    GLuint texturesCube[MAX_TEXTURE_UNITS];
+    GLuint texturesBuffer[MAX_TEXTURE_UNITS];
+    GLuint texturesArray[MAX_TEXTURE_UNITS];
+    Stats stats;
+};
+#endif // GLSTATECACHE_H
@@ -23,8 +23,8 @@ class Hammer :
     Transform transformData;
 
 public:
-    Hammer(glm::vec3 initialPos, Transform transformData, MeshCreator mesh, Textures texture, Shader shader, Camera& inputCamera)
-        : Item(initialPos, mesh, texture, shader, inputCamera), transformData(transformData) {}
+    Hammer(glm::vec3 initialPos, Transform transformData, const ResourceRegistry& resources, Camera& inputCamera)
+        : Item(initialPos, resources, inputCamera), transformData(transformData) {}
     /**
      * @brief Renders the FireFlower object.
      *
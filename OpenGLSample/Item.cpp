@@ -7,6 +7,7 @@
  */
 
 #include "Item.h"
+#include <iostream>
 
 /**
  * @brief Calculates the distance from the camera to the object.
@@ -22,63 +23,237 @@ float Item::calculateDistance(glm::vec3 objectPosition) const {
 }
 
 /**
- * @brief Draws the appropriate mesh based on the distance to the camera.
+ * @brief Draws the appropriate mesh based on its size on screen.
  *
- * This method selects and draws either a high-detail or low-detail mesh based on the distance
- * from the object to a given point. It uses either glDrawArrays or glDrawElements based on the
- * useDrawArrays flag.
+ * This method records a draw that selects either a high-detail or low-detail mesh from the projected
+ * size of its bounds, through the scene's LodPolicy. The mesh is chosen every time the command is culled.
  *
- * @param highMesh The high-detail mesh to draw when close.
- * @param lowMesh The low-detail mesh to draw when farther away.
- * @param translationVec The vector representing the position to calculate distance from.
- * @param useDrawArrays A flag indicating whether to use glDrawArrays (true) or glDrawElements (false).
+ * @param highMesh The high-detail mesh to draw when large on screen.
+ * @param lowMesh The low-detail mesh to draw when smaller.
+ * @param translationVec The position used to sort the draw front to back.
  */
-void Item::drawMeshBasedOnDistance(MeshCreator::GLMesh& highMesh, MeshCreator::GLMesh& lowMesh, glm::vec3& translationVec, bool useDrawArrays) const
+void Item::drawMeshBasedOnDistance(const MeshCreator::GLMesh& highMesh, const MeshCreator::GLMesh& lowMesh, const glm::vec3& translationVec)
 {
-    float distance = calculateDistance(translationVec);
+    pendingCommand.highMesh = &highMesh;
+    pendingCommand.lowMesh = &lowMesh;
+    pendingCommand.useDistanceLod = true;
+    pendingCommand.position = translationVec;
+    submitCommand();
+}
 
-    if (distance < 8) {
-        // Activate the VBOs contained within the mesh's VAO
-        glBindVertexArray(highMesh.vao);
-        if (useDrawArrays) {
-            glDrawArrays(GL_TRIANGLES, 0, highMesh.nVertices);
-        }
-        else {
-            glDrawElements(GL_TRIANGLES, highMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
-        }
+/**
+ * @brief Draws a mesh without distance-based level of detail.
+ * @param mesh The mesh to draw.
+ */
+void Item::drawMesh(const MeshCreator::GLMesh& mesh) {
+    pendingCommand.highMesh = &mesh;
+    pendingCommand.lowMesh = &mesh;
+    pendingCommand.useDistanceLod = false;
+    pendingCommand.position = glm::vec3(pendingCommand.model[3]);
+    submitCommand();
+}
+
+/**
+ * @brief Binds a texture to a texture unit for the following draws.
+ * @param unit The texture unit (GL_TEXTURE0 diffuse, GL_TEXTURE1 specular, GL_TEXTURE2 overlay).
+ * @param texture The texture handle, or 0 to unbind.
+ */
+void Item::bindTexture(GLenum unit, GLuint texture) {
+    switch (unit) {
+    case GL_TEXTURE0:
+        pendingCommand.diffuseTexture = texture;
+        break;
+    case GL_TEXTURE1:
+        pendingCommand.specularTexture = texture;
+        break;
+    case GL_TEXTURE2:
+        pendingCommand.overlayTexture = texture;
+        break;
+    default:
+        std::cout << "ERROR::ITEM::UNSUPPORTED_TEXTURE_UNIT" << std::endl;
+        break;
     }
-    else if (distance <= 19) {
-        glBindVertexArray(lowMesh.vao);
-        if (useDrawArrays) {
-            glDrawArrays(GL_TRIANGLES, 0, lowMesh.nVertices);
-        }
-        else {
-            glDrawElements(GL_TRIANGLES, lowMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+}
+
+/**
+ * @brief Sets the material shininess for the following draws.
+ * @param shininess The specular exponent.
+ */
+void Item::setShininess(float shininess) {
+    pendingCommand.shininess = shininess;
+}
+
+/**
+ * @brief Sets the texture coordinate scale for the following draws.
+ * @param uvScale The scale applied to the texture coordinates.
+ */
+void Item::setUVScale(glm::vec2 uvScale) {
+    pendingCommand.uvScale = uvScale;
+}
+
+/**
+ * @brief Records the pending command, or draws it immediately when no recording is active.
+ */
+void Item::submitCommand() {
+    if (recordTarget == nullptr) {
+        RenderCommandList::draw(pendingCommand, lightingShader);
+        return;
+    }
+
+    computeCommandBounds(pendingCommand);
+    bounds.merge(pendingCommand.bounds);
+
+    if (!recorded) {
+        size_t index = recordTarget->add(pendingCommand);
+        if (recordCursor == 0) {
+            firstCommand = index;
         }
     }
+    else if (recordCursor < commandCount) {
+        recordTarget->set(firstCommand + recordCursor, pendingCommand);
+    }
+    else {
+        std::cout << "ERROR::ITEM::COMMAND_COUNT_CHANGED" << std::endl;
+    }
+    recordCursor++;
+}
+
+/**
+ * @brief Records the item's draws into a command list.
+ *
+ * The first recording appends the item's commands to the end of the list. Later recordings
+ * overwrite the same range in place. The item's bounds are rebuilt from the recorded draws.
+ *
+ * @param commandList The list that receives the commands.
+ */
+void Item::record(RenderCommandList& commandList) {
+    recordTarget = &commandList;
+    recordCursor = 0;
+    transformCursor = 0;
+    bounds = AABB();
+    // default material, rough and untextured
+    pendingCommand = RenderCommand();
+
+    render();
+
+    if (!recorded) {
+        commandCount = recordCursor;
+        recorded = true;
+    }
+    recordTarget = nullptr;
+    dirty = false;
 }
 
 /**
  * @brief Draws the object with given transformations.
  *
  * This method applies scaling, rotation, and translation transformations to the object
- * and updates its position.
+ * and updates its position. The model matrix is used by the next draw.
+ *
+ * An item attached to a transform graph keeps the transformation as the local matrix of a
+ * submesh node, and takes the rest from the cached world matrix of its item node.
  *
  * @param scaleVec A vector representing the scaling factors.
  * @param rotation A matrix representing the rotation.
  * @param translateVec A vector representing the translation.
- * @param transformData A struct containing additional transformation data.
+ * @param transformData A struct containing additional transformation data, relative to the
+ * item's parent node when it is attached to a transform graph.
  * @return The new position of the object as a glm::vec3.
  */
 glm::vec3 Item::drawObject(glm::vec3 scaleVec, glm::mat4 rotation, glm::vec3 translateVec, Transform transformData) {
-    glm::mat4 scale = glm::scale(scaleVec);
-    glm::mat4 translation = glm::translate(translateVec);
-    glm::mat4 model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;
-    lightingShader.setMat4("model", model);
+    return setLocalTransform(glm::translate(translateVec) * rotation * glm::scale(scaleVec), transformData);
+}
+
+/**
+ * @brief Sets the model matrix of the next draw from a matrix relative to the item.
+ *
+ * The matrix is placed by the transformation data. An item attached to a transform graph keeps
+ * the result as the local matrix of the next submesh node, relative to the item's parent node.
+ *
+ * @param local The submesh's matrix relative to the item.
+ * @param transformData The item's placement, relative to its parent node when it is attached to a transform graph.
+ * @return The new position of the object as a glm::vec3.
+ */
+glm::vec3 Item::setLocalTransform(const glm::mat4& local, const Transform& transformData) {
+    const glm::mat4 placed = transformData.translation * transformData.rotation * transformData.scale * local;
+    glm::mat4 model;
+    if (transforms != nullptr && recordTarget != nullptr) {
+        if (transformCursor == submeshNodes.size()) {
+            submeshNodes.push_back(transforms->createNode(itemNode, placed));
+        }
+        else {
+            transforms->setLocal(submeshNodes[transformCursor], placed);
+        }
+        pendingCommand.transformNode = submeshNodes[transformCursor];
+        transformCursor++;
+        model = transforms->getWorld(itemNode) * placed;
+    }
+    else {
+        pendingCommand.transformNode = TransformGraph::NO_NODE;
+        model = placed;
+    }
+    pendingCommand.model = model;
     this->position = glm::vec3(model[3]);
     this->initialPosition = glm::vec3(model[3]);
 
     return glm::vec3(model[3]);
 }
 
+/**
+ * @brief Gives the item a node in a transform graph, under the node of its table set.
+ *
+ * The item's submesh nodes are created under it by the next recording. Must be called before
+ * the first recording, while the parent's world matrix is up to date.
+ *
+ * @param graph The graph that holds the scene's transforms.
+ * @param parentNode The node the item is placed relative to, or TransformGraph::NO_NODE.
+ */
+void Item::attachTransform(TransformGraph& graph, uint32_t parentNode) {
+    transforms = &graph;
+    itemNode = graph.createNode(parentNode, glm::mat4(1.0f));
+    submeshNodes.clear();
+}
 
+/**
+ * @brief Copies the world matrices the last graph update changed into the recorded commands.
+ *
+ * The commands' bounds and the item's bounds follow, without recording the item again.
+ *
+ * @param commandList The list the item was recorded into.
+ * @return True when a command changed.
+ */
+bool Item::refreshTransforms(RenderCommandList& commandList) {
+    if (transforms == nullptr || !recorded) {
+        return false;
+    }
+
+    bool changed = false;
+    AABB refreshed;
+    for (size_t i = firstCommand; i < firstCommand + commandCount; i++) {
+        const RenderCommand& recordedCommand = commandList[i];
+        if (recordedCommand.transformNode != TransformGraph::NO_NODE && transforms->isChanged(recordedCommand.transformNode)) {
+            RenderCommand command = recordedCommand;
+            command.model = transforms->getWorld(command.transformNode);
+            command.position = glm::vec3(command.model[3]);
+            computeCommandBounds(command);
+            commandList.set(i, command);
+            changed = true;
+        }
+        refreshed.merge(commandList[i].bounds);
+    }
+    if (changed) {
+        bounds = refreshed;
+        position = glm::vec3(commandList[firstCommand + commandCount - 1].model[3]);
+    }
+    return changed;
+}
+
+/**
+ * @brief Sets a command's bounds from its meshes and model matrix.
+ */
+void Item::computeCommandBounds(RenderCommand& command) {
+    command.bounds = command.highMesh->bounds.transformed(command.model);
+    if (command.lowMesh != command.highMesh) {
+        command.bounds.merge(command.lowMesh->bounds.transformed(command.model));
+    }
+}
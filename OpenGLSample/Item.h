@@ -15,6 +15,9 @@
 #include "Textures.h"
 #include "shader.h"
 #include "camera.h"
+#include "RenderCommand.h"
+#include "ResourceRegistry.h"
+#include "TransformGraph.h"
 
 struct Transform
 {
@@ -26,18 +29,79 @@ struct Transform
 /**
  * @brief Definition for the Item class.
  *
- * The Item class represents a 3D object in a scene, with a position, mesh, texture, shader, and camera reference.
+ * The Item class represents a 3D object in a scene, with a position, shared mesh, texture and shader tables, and a camera reference.
  *
  */
 class Item
 {
 protected:
 
-    MeshCreator gMesh;
-    Textures gTexture;
-    Shader lightingShader;
+    // Shared, read-only resource tables
+    const MeshCreator& gMesh;
+    const Textures& gTexture;
+    const Shader& lightingShader;
     Camera& camera;
 
+    RenderCommand pendingCommand;               // Material and transform state for the next recorded draw
+    RenderCommandList* recordTarget = nullptr;  // List being recorded into, or nullptr to draw immediately
+    size_t firstCommand = 0;                    // Index of this item's first command in the list
+    size_t commandCount = 0;                    // Number of commands this item owns
+    size_t recordCursor = 0;                    // Next command written during a recording
+    bool recorded = false;                      // True once the item owns a range in the list
+    bool dirty = true;                          // True when the recorded commands are out of date
+    AABB bounds;                                // World-space bounds of the recorded draws
+    TransformGraph* transforms = nullptr;       // Graph holding the item's node, or nullptr
+    uint32_t itemNode = TransformGraph::NO_NODE; // Node of the whole item, parent of its submesh nodes
+    std::vector<uint32_t> submeshNodes;         // One node per drawObject call of a recording
+    size_t transformCursor = 0;                 // Next submesh node used during a recording
+
+    /**
+     * @brief Binds a texture to a texture unit for the following draws.
+     * @param unit The texture unit (GL_TEXTURE0 diffuse, GL_TEXTURE1 specular, GL_TEXTURE2 overlay).
+     * @param texture The texture handle, or 0 to unbind.
+     */
+    void bindTexture(GLenum unit, GLuint texture);
+
+    /**
+     * @brief Sets the material shininess for the following draws.
+     * @param shininess The specular exponent.
+     */
+    void setShininess(float shininess);
+
+    /**
+     * @brief Sets the texture coordinate scale for the following draws.
+     * @param uvScale The scale applied to the texture coordinates.
+     */
+    void setUVScale(glm::vec2 uvScale);
+
+    /**
+     * @brief Draws a mesh without distance-based level of detail.
+     * @param mesh The mesh to draw.
+     */
+    void drawMesh(const MeshCreator::GLMesh& mesh);
+
+    /**
+     * @brief Sets the model matrix of the next draw from a matrix relative to the item.
+     *
+     * The matrix is placed by the transformation data. An item attached to a transform graph keeps
+     * the result as the local matrix of the next submesh node, relative to the item's parent node.
+     *
+     * @param local The submesh's matrix relative to the item.
+     * @param transformData The item's placement, relative to its parent node when it is attached to a transform graph.
+     * @return The new position of the object as a glm::vec3.
+     */
+    glm::vec3 setLocalTransform(const glm::mat4& local, const Transform& transformData);
+
+    /**
+     * @brief Records the pending command, or draws it immediately when no recording is active.
+     */
+    void submitCommand();
+
+    /**
+     * @brief Sets a command's bounds from its meshes and model matrix.
+     */
+    static void computeCommandBounds(RenderCommand& command);
+
 public:
     glm::vec3 position;
     glm::vec3 initialPosition;
@@ -45,16 +109,16 @@ public:
     /**
      * @brief Constructor for the Item class.
      *
-     * This constructor initializes the Item object with the given initial position, mesh, texture, shader, and camera.
+     * This constructor initializes the Item object with the given initial position, resources, and camera.
+     * The item references the shared resource tables; it does not copy them.
      *
      * @param initialPos The initial position of the item as a glm::vec3.
-     * @param mesh The mesh data for the item.
-     * @param texture The texture data for the item.
-     * @param shader The shader program used for rendering the item.
+     * @param resources The shared mesh, texture and shader tables.
      * @param inputCamera A reference to the camera object.
      */
-    Item(glm::vec3 initialPos, MeshCreator mesh, Textures texture, Shader shader, Camera& inputCamera)
-        : position(initialPos), initialPosition(initialPos), gMesh(mesh), gTexture(texture), lightingShader(shader), camera(inputCamera) {}
+    Item(glm::vec3 initialPos, const ResourceRegistry& resources, Camera& inputCamera)
+        : gMesh(resources.getMeshes()), gTexture(resources.getTextures()), lightingShader(resources.getLightingShader()), camera(inputCamera),
+        position(initialPos), initialPosition(initialPos) {}
     
     // Virtual destructor to ensure proper cleanup of derived classes
     virtual ~Item() = default;
@@ -70,29 +134,31 @@ public:
     float calculateDistance(glm::vec3 objectPosition) const;
 
     /**
-     * @brief Draws the appropriate mesh based on the distance to the camera.
+     * @brief Draws the appropriate mesh based on its size on screen.
      *
-     * This method selects and draws either a high-detail or low-detail mesh based on the distance
-     * from the object to a given point. It uses either glDrawArrays or glDrawElements based on the
-     * useDrawArrays flag.
+     * This method records a draw that selects either a high-detail or low-detail mesh from the projected
+     * size of its bounds, through the scene's LodPolicy. The mesh is chosen every time the command is culled.
      *
-     * @param highMesh The high-detail mesh to draw when close.
-     * @param lowMesh The low-detail mesh to draw when farther away.
-     * @param translationVec The vector representing the position to calculate distance from.
-     * @param useDrawArrays A flag indicating whether to use glDrawArrays (true) or glDrawElements (false).
+     * @param highMesh The high-detail mesh to draw when large on screen.
+     * @param lowMesh The low-detail mesh to draw when smaller.
+     * @param translationVec The position used to sort the draw front to back.
      */
-    void drawMeshBasedOnDistance(MeshCreator::GLMesh& highMesh, MeshCreator::GLMesh& lowMesh, glm::vec3& translationVec, bool useDrawArrays) const;
+    void drawMeshBasedOnDistance(const MeshCreator::GLMesh& highMesh, const MeshCreator::GLMesh& lowMesh, const glm::vec3& translationVec);
     
     /**
      * @brief Draws the object with given transformations.
      *
      * This method applies scaling, rotation, and translation transformations to the object
-     * and updates its position.
+     * and updates its position. The model matrix is used by the next draw.
+     *
+     * An item attached to a transform graph keeps the transformation as the local matrix of a
+     * submesh node, and takes the rest from the cached world matrix of its item node.
      *
      * @param scaleVec A vector representing the scaling factors.
      * @param rotation A matrix representing the rotation.
      * @param translateVec A vector representing the translation.
-     * @param transformData A struct containing additional transformation data.
+     * @param transformData A struct containing additional transformation data, relative to the
+     * item's parent node when it is attached to a transform graph.
      * @return The new position of the object as a glm::vec3.
      */
     glm::vec3 drawObject(glm::vec3 scaleVec, glm::mat4 rotation, glm::vec3 translateVec, Transform transformData);
@@ -101,8 +167,75 @@ public:
      * @brief Renders the item.
      *
      * This pure virtual function must be implemented by derived classes to render the item.
+     * When called from record() the draws are stored in the command list instead of being issued.
      */
     virtual void render() = 0; // Pure virtual function
 
+    /**
+     * @brief Records the item's draws into a command list.
+     *
+     * The first recording appends the item's commands to the end of the list. Later recordings
+     * overwrite the same range in place. The item's bounds are rebuilt from the recorded draws.
+     *
+     * @param commandList The list that receives the commands.
+     */
+    void record(RenderCommandList& commandList);
+
+    /**
+     * @brief Gives the item a node in a transform graph, under the node of its table set.
+     *
+     * The item's submesh nodes are created under it by the next recording. Must be called before
+     * the first recording, while the parent's world matrix is up to date.
+     *
+     * @param graph The graph that holds the scene's transforms.
+     * @param parentNode The node the item is placed relative to, or TransformGraph::NO_NODE.
+     */
+    void attachTransform(TransformGraph& graph, uint32_t parentNode);
+
+    /**
+     * @brief Returns the item's node, or TransformGraph::NO_NODE when it is not attached.
+     */
+    uint32_t getTransformNode() const { return itemNode; }
+
+    /**
+     * @brief Copies the world matrices the last graph update changed into the recorded commands.
+     *
+     * The commands' bounds and the item's bounds follow, without recording the item again.
+     *
+     * @param commandList The list the item was recorded into.
+     * @return True when a command changed.
+     */
+    bool refreshTransforms(RenderCommandList& commandList);
+
+    /**
+     * @brief Flags the recorded commands as out of date so they are recorded again before the next draw.
+     */
+    void markDirty() { dirty = true; }
+
+    /**
+     * @brief Returns true when the item must be recorded before it is drawn.
+     */
+    bool isDirty() const { return dirty; }
+
+    /**
+     * @brief Returns the world-space bounds of the draws from the last recording.
+     */
+    const AABB& getBounds() const { return bounds; }
+
+    /**
+     * @brief Returns true once the item has been recorded and its bounds are known.
+     */
+    bool hasBounds() const { return recorded; }
+
+    /**
+     * @brief Returns the range of commands this item owns in its command list.
+     */
+    CommandRange getCommandRange() const {
+        CommandRange range;
+        range.first = firstCommand;
+        range.count = commandCount;
+        return range;
+    }
+
 };
 #endif // ITEM_H
\ No newline at end of file
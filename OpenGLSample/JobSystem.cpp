@@ -0,0 +1,289 @@
+/**
+ * @file JobSystem.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the JobSystem class.
+ */
+
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace
+{
+    // Slots of a work queue's ring when it first fills
+    const size_t INITIAL_RING_SIZE = 64;
+
+    // The pool and queue of the worker running on this thread, if any
+    thread_local const JobSystem* currentPool = nullptr;
+    thread_local unsigned int currentQueue = 0;
+}
+
+/**
+ * @brief Starts the worker threads.
+ * @param workerCount The number of workers; 0 runs every job on the submitting thread.
+ */
+JobSystem::JobSystem(unsigned int workerCount)
+    : nextQueue(0), queuedTasks(0), queuedBackgroundTasks(0), stopping(false) {
+    for (unsigned int i = 0; i < workerCount; i++) {
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+    for (unsigned int i = 0; i < workerCount; i++) {
+        workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+    }
+}
+
+/**
+ * @brief Finishes the queued jobs and joins the worker threads.
+ */
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Returns one worker per hardware thread, leaving one for the GL thread.
+ */
+unsigned int JobSystem::getDefaultWorkerCount() {
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+/**
+ * @brief Queues a job and counts it on a counter.
+ * @param job The work to run.
+ * @param counter The counter that is decremented once the job has finished.
+ */
+void JobSystem::submit(Job job, JobCounter& counter) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    Task task;
+    task.job = std::move(job);
+    task.counter = &counter;
+    if (queues.empty()) {
+        runTask(task);
+        return;
+    }
+
+    // Workers keep their own jobs local; outside submissions are spread over the workers
+    unsigned int queueIndex = currentPool == this
+        ? currentQueue
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % static_cast<unsigned int>(queues.size());
+    {
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+        queues[queueIndex]->pushBack(std::move(task));
+    }
+    queuedTasks.fetch_add(1, std::memory_order_release);
+    wakeWorker();
+}
+
+/**
+ * @brief Queues a background job and counts it on a counter.
+ *
+ * The job only runs on a worker that has no other job, and never inside wait.
+ *
+ * @param job The work to run.
+ * @param counter The counter that is decremented once the job has finished.
+ */
+void JobSystem::submitBackground(Job job, JobCounter& counter) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    Task task;
+    task.job = std::move(job);
+    task.counter = &counter;
+    if (queues.empty()) {
+        runTask(task);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+        backgroundQueue.pushBack(std::move(task));
+    }
+    queuedBackgroundTasks.fetch_add(1, std::memory_order_release);
+    wakeWorker();
+}
+
+/**
+ * @brief Runs queued jobs until every job counted on the counter has finished.
+ * @param counter The counter to wait for.
+ */
+void JobSystem::wait(JobCounter& counter) {
+    const unsigned int queueIndex = currentPool == this ? currentQueue : 0;
+    while (!counter.isDone()) {
+        Task task;
+        if (!queues.empty() && takeTask(queueIndex, task)) {
+            runTask(task);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/**
+ * @brief Splits a range into chunks and runs them in parallel, returning once all have finished.
+ *
+ * Chunk i covers [i * grainSize, min(count, (i + 1) * grainSize)), so a body can store per-chunk
+ * results at begin / grainSize. The calling thread runs the first chunk and helps with the rest.
+ *
+ * @param count The number of elements.
+ * @param grainSize The number of elements per chunk.
+ * @param body Called once per chunk with the chunk's begin and end.
+ */
+void JobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    grainSize = std::max<size_t>(grainSize, 1);
+    const size_t chunkCount = getChunkCount(count, grainSize);
+
+    // Bounds are computed in the job, so each job captures two words and fits std::function's inline storage
+    const auto runChunk = [&body, count, grainSize](size_t chunk) {
+        const size_t begin = chunk * grainSize;
+        body(begin, std::min(count, begin + grainSize));
+    };
+    JobCounter counter;
+    for (size_t chunk = 1; chunk < chunkCount; chunk++) {
+        submit([&runChunk, chunk]() { runChunk(chunk); }, counter);
+    }
+    runChunk(0);
+    wait(counter);
+}
+
+/**
+ * @brief Takes a job, from the given worker's own queue first and then from the others.
+ * @param queueIndex The queue searched first.
+ * @param task Receives the job.
+ * @return True when a job was taken.
+ */
+bool JobSystem::takeTask(unsigned int queueIndex, Task& task) {
+    if (queuedTasks.load(std::memory_order_acquire) <= 0) {
+        return false;
+    }
+    const unsigned int queueCount = static_cast<unsigned int>(queues.size());
+    for (unsigned int offset = 0; offset < queueCount; offset++) {
+        WorkQueue& queue = *queues[(queueIndex + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        // The newest job of the own queue is still warm in cache; steal the oldest of the others
+        if (!(offset == 0 ? queue.popBack(task) : queue.popFront(task))) {
+            continue;
+        }
+        queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Takes the oldest background job.
+ * @param task Receives the job.
+ * @return True when a job was taken.
+ */
+bool JobSystem::takeBackgroundTask(Task& task) {
+    if (queuedBackgroundTasks.load(std::memory_order_acquire) <= 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+    if (!backgroundQueue.popFront(task)) {
+        return false;
+    }
+    queuedBackgroundTasks.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Wakes one sleeping worker after a job was queued.
+ */
+void JobSystem::wakeWorker() {
+    {
+        // Taking the lock orders the notify after a worker that is about to sleep has checked the counts
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+/**
+ * @brief Adds a job after the newest, doubling the ring when it is full.
+ */
+void JobSystem::WorkQueue::pushBack(Task&& task) {
+    if (count == ring.size()) {
+        std::vector<Task> grown(std::max(ring.size() * 2, INITIAL_RING_SIZE));
+        for (size_t i = 0; i < count; i++) {
+            grown[i] = std::move(ring[(first + i) % ring.size()]);
+        }
+        ring.swap(grown);
+        first = 0;
+    }
+    ring[(first + count) % ring.size()] = std::move(task);
+    count++;
+}
+
+/**
+ * @brief Removes the newest job into task; returns false when the queue is empty.
+ */
+bool JobSystem::WorkQueue::popBack(Task& task) {
+    if (count == 0) {
+        return false;
+    }
+    count--;
+    Task& slot = ring[(first + count) % ring.size()];
+    task = std::move(slot);
+    slot = Task();
+    return true;
+}
+
+/**
+ * @brief Removes the oldest job into task; returns false when the queue is empty.
+ */
+bool JobSystem::WorkQueue::popFront(Task& task) {
+    if (count == 0) {
+        return false;
+    }
+    Task& slot = ring[first];
+    task = std::move(slot);
+    slot = Task();
+    first = (first + 1) % ring.size();
+    count--;
+    return true;
+}
+
+/**
+ * @brief Runs a job and reports it to its counter.
+ * @param task The job to run.
+ */
+void JobSystem::runTask(Task& task) {
+    task.job();
+    task.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+/**
+ * @brief The loop of one worker thread.
+ * @param index The worker's queue index.
+ */
+void JobSystem::workerLoop(unsigned int index) {
+    currentPool = this;
+    currentQueue = index;
+    for (;;) {
+        Task task;
+        // Frame jobs go first; a background job only fills a worker that has nothing else to do
+        if (takeTask(index, task) || takeBackgroundTask(task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        const auto hasWork = [this]() {
+            return queuedTasks.load(std::memory_order_acquire) > 0
+                || queuedBackgroundTasks.load(std::memory_order_acquire) > 0;
+        };
+        wake.wait(lock, [this, &hasWork]() { return stopping || hasWork(); });
+        if (stopping && !hasWork()) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,198 @@
+/**
+ * @file JobSystem.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the JobSystem class, a pool of worker threads that run
+ * small jobs and steal work from each other when their own queue runs dry.
+ */
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @struct JobCounter
+ * @brief Counts the unfinished jobs of one submission, so a thread can wait for all of them.
+ */
+struct JobCounter
+{
+    std::atomic<int> pending;
+
+    JobCounter() : pending(0) {}
+
+    /**
+     * @brief Returns true when every job submitted with this counter has finished.
+     */
+    bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+/**
+ * @class JobSystem
+ * @brief Runs jobs on a fixed set of worker threads.
+ *
+ * Every worker owns a queue. A worker pops its newest job first and, when its queue is empty,
+ * steals the oldest job of another worker. Jobs submitted from outside the pool are dealt to the
+ * worker queues in turn. A thread that waits on a counter runs queued jobs until the counter
+ * drops to zero, so waiting never idles a core that could help. With no workers, jobs run
+ * immediately on the submitting thread.
+ *
+ * Background jobs, such as file decoding, wait in a separate queue that only idle workers take
+ * from. A waiting thread never runs them, so a wait for a frame's jobs is not held up behind them.
+ */
+class JobSystem
+{
+public:
+    typedef std::function<void()> Job;
+
+    /**
+     * @brief Starts the worker threads.
+     * @param workerCount The number of workers; 0 runs every job on the submitting thread.
+     */
+    explicit JobSystem(unsigned int workerCount);
+
+    /**
+     * @brief Finishes the queued jobs and joins the worker threads.
+     */
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /**
+     * @brief Returns one worker per hardware thread, leaving one for the GL thread.
+     */
+    static unsigned int getDefaultWorkerCount();
+
+    /**
+     * @brief Queues a job and counts it on a counter.
+     * @param job The work to run.
+     * @param counter The counter that is decremented once the job has finished.
+     */
+    void submit(Job job, JobCounter& counter);
+
+    /**
+     * @brief Queues a background job and counts it on a counter.
+     *
+     * The job only runs on a worker that has no other job, and never inside wait.
+     *
+     * @param job The work to run.
+     * @param counter The counter that is decremented once the job has finished.
+     */
+    void submitBackground(Job job, JobCounter& counter);
+
+    /**
+     * @brief Runs queued jobs until every job counted on the counter has finished.
+     * @param counter The counter to wait for.
+     */
+    void wait(JobCounter& counter);
+
+    /**
+     * @brief Splits a range into chunks and runs them in parallel, returning once all have finished.
+     *
+     * Chunk i covers [i * grainSize, min(count, (i + 1) * grainSize)), so a body can store per-chunk
+     * results at begin / grainSize. The calling thread runs the first chunk and helps with the rest.
+     *
+     * @param count The number of elements.
+     * @param grainSize The number of elements per chunk.
+     * @param body Called once per chunk with the chunk's begin and end.
+     */
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+    /**
+     * @brief Returns the number of chunks parallelFor splits a range into.
+     * @param count The number of elements.
+     * @param grainSize The number of elements per chunk.
+     */
+    static size_t getChunkCount(size_t count, size_t grainSize) {
+        return grainSize == 0 ? count : (count + grainSize - 1) / grainSize;
+    }
+
+    /**
+     * @brief Returns the number of worker threads.
+     */
+    unsigned int getWorkerCount() const { return static_cast<unsigned int>(workers.size()); }
+
+private:
+    // A queued job and the counter it reports to
+    struct Task
+    {
+        Job job;
+        JobCounter* counter = nullptr;
+    };
+
+    // One worker's jobs; the owner works at the back, thieves take from the front.
+    // A ring that only grows, so once it has held a frame's jobs queuing allocates nothing.
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::vector<Task> ring;
+        size_t first = 0;   // Slot of the oldest job
+        size_t count = 0;
+
+        /**
+         * @brief Adds a job after the newest, doubling the ring when it is full.
+         */
+        void pushBack(Task&& task);
+
+        /**
+         * @brief Removes the newest job into task; returns false when the queue is empty.
+         */
+        bool popBack(Task& task);
+
+        /**
+         * @brief Removes the oldest job into task; returns false when the queue is empty.
+         */
+        bool popFront(Task& task);
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;  // One queue per worker
+    WorkQueue backgroundQueue;                        // Background jobs, oldest first
+    std::vector<std::thread> workers;
+    std::atomic<unsigned int> nextQueue;              // Queue that receives the next outside submission
+    std::atomic<int> queuedTasks;                     // Jobs waiting in any worker queue
+    std::atomic<int> queuedBackgroundTasks;           // Jobs waiting in the background queue
+    std::atomic<bool> stopping;
+    std::mutex sleepMutex;                            // Guards the sleep of idle workers
+    std::condition_variable wake;
+
+    /**
+     * @brief Takes a job, from the given worker's own queue first and then from the others.
+     * @param queueIndex The queue searched first.
+     * @param task Receives the job.
+     * @return True when a job was taken.
+     */
+    bool takeTask(unsigned int queueIndex, Task& task);
+
+    /**
+     * @brief Takes the oldest background job.
+     * @param task Receives the job.
+     * @return True when a job was taken.
+     */
+    bool takeBackgroundTask(Task& task);
+
+    /**
+     * @brief Wakes one sleeping worker after a job was queued.
+     */
+    void wakeWorker();
+
+    /**
+     * @brief Runs a job and reports it to its counter.
+     * @param task The job to run.
+     */
+    static void runTask(Task& task);
+
+    /**
+     * @brief The loop of one worker thread.
+     * @param index The worker's queue index.
+     */
+    void workerLoop(unsigned int index);
+};
+#endif // JOBSYSTEM_H
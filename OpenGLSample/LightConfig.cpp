@@ -0,0 +1,252 @@
+/**
+ * @file LightConfig.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the LightConfig class.
+ */
+
+#include "LightConfig.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// Unnamed namespace
+namespace
+{
+    /**
+     * @brief Parses whitespace-separated floats; returns false unless all of them are present.
+     */
+    bool parseFloats(const char* text, float* values, int count) {
+        for (int i = 0; i < count; i++) {
+            char* end = nullptr;
+            values[i] = std::strtof(text, &end);
+            if (end == text) {
+                return false;
+            }
+            text = end;
+        }
+        return true;
+    }
+
+    bool parseVector(const char* text, glm::vec3& vector) {
+        float values[3];
+        if (!parseFloats(text, values, 3)) {
+            return false;
+        }
+        vector = glm::vec3(values[0], values[1], values[2]);
+        return true;
+    }
+
+    bool parseFloat(const char* text, float& value) {
+        return parseFloats(text, &value, 1);
+    }
+
+    /**
+     * @brief Returns a line without its leading and trailing whitespace and carriage return.
+     */
+    std::string trim(const std::string& line) {
+        const char* whitespace = " \t\r";
+        const size_t first = line.find_first_not_of(whitespace);
+        if (first == std::string::npos) {
+            return std::string();
+        }
+        return line.substr(first, line.find_last_not_of(whitespace) - first + 1);
+    }
+
+    /**
+     * @brief Returns true when a name starts with a prefix.
+     */
+    bool startsWith(const std::string& name, const char* prefix) {
+        return name.compare(0, std::char_traits<char>::length(prefix), prefix) == 0;
+    }
+}
+
+/**
+ * @brief Creates the configuration of a file; nothing is read until load.
+ * @param path The file path of the configuration file.
+ */
+LightConfig::LightConfig(const std::string& path) : path(path) {
+}
+
+/**
+ * @brief Parses the file, replacing the descriptors.
+ * @return False when the file cannot be read; the previous descriptors are kept.
+ */
+bool LightConfig::load() {
+    int64_t time = -1, size = -1;
+    std::ifstream file(path);
+    if (!file || !getFileStamp(time, size)) {
+        std::cout << "ERROR::LIGHTCONFIG::FILE_NOT_FOUND " << path << std::endl;
+        return false;
+    }
+    fileTime = time;
+    fileSize = size;
+
+    std::vector<LightDescriptor> parsed;
+    std::vector<bool> typed;    // True when the section gave its type, by key or by name
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        const std::string text = trim(line);
+        if (text.empty() || text[0] == ';' || text[0] == '#') {
+            continue;
+        }
+        if (text[0] == '[') {
+            LightDescriptor light;
+            light.name = text.substr(1, text.find(']') - 1);
+            typed.push_back(getTypeFromName(light.name, light.type));
+            parsed.push_back(light);
+            continue;
+        }
+        const size_t equals = text.find('=');
+        if (parsed.empty() || equals == std::string::npos) {
+            std::cout << "ERROR::LIGHTCONFIG::BAD_LINE " << path << ":" << lineNumber << std::endl;
+            continue;
+        }
+        const std::string key = trim(text.substr(0, equals));
+        const std::string value = text.substr(equals + 1);
+        if (key == "type") {
+            const std::string type = trim(value);
+            typed.back() = true;
+            if (type == "directional") {
+                parsed.back().type = LightDescriptor::DIRECTIONAL;
+            }
+            else if (type == "point") {
+                parsed.back().type = LightDescriptor::POINT;
+            }
+            else if (type == "spot") {
+                parsed.back().type = LightDescriptor::SPOT;
+            }
+            else {
+                typed.back() = false;
+            }
+        }
+        else if (!setField(parsed.back(), key, value.c_str())) {
+            std::cout << "ERROR::LIGHTCONFIG::BAD_KEY " << path << ":" << lineNumber << " " << key << std::endl;
+        }
+    }
+
+    // The Lights block has one directional and one spot slot
+    lights.clear();
+    lightIndices.clear();
+    bool hasDirectional = false;
+    bool hasSpot = false;
+    for (size_t i = 0; i < parsed.size(); i++) {
+        const LightDescriptor& light = parsed[i];
+        if (!typed[i]) {
+            std::cout << "ERROR::LIGHTCONFIG::UNKNOWN_TYPE " << light.name << std::endl;
+            continue;
+        }
+        bool& taken = light.type == LightDescriptor::DIRECTIONAL ? hasDirectional : hasSpot;
+        if (light.type != LightDescriptor::POINT && taken) {
+            std::cout << "ERROR::LIGHTCONFIG::EXTRA_LIGHT " << light.name << std::endl;
+            continue;
+        }
+        if (lightIndices.count(light.name) != 0) {
+            std::cout << "ERROR::LIGHTCONFIG::DUPLICATE_LIGHT " << light.name << std::endl;
+            continue;
+        }
+        if (light.type != LightDescriptor::POINT) {
+            taken = true;
+        }
+        lightIndices[light.name] = lights.size();
+        lights.push_back(light);
+    }
+    return true;
+}
+
+/**
+ * @brief Parses the file again when its modification time or size changed since the last load.
+ * @return True when the descriptors were replaced.
+ */
+bool LightConfig::reloadIfChanged() {
+    int64_t time = -1, size = -1;
+    if (!getFileStamp(time, size) || (time == fileTime && size == fileSize)) {
+        return false;
+    }
+    return load();
+}
+
+/**
+ * @brief Returns the descriptor of a section, or nullptr when the file has no such light.
+ */
+const LightDescriptor* LightConfig::find(const std::string& name) const {
+    std::map<std::string, size_t>::const_iterator found = lightIndices.find(name);
+    return found != lightIndices.end() ? &lights[found->second] : nullptr;
+}
+
+/**
+ * @brief Reads the modification time and size of the file; returns false when it does not exist.
+ */
+bool LightConfig::getFileStamp(int64_t& time, int64_t& size) const {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    time = static_cast<int64_t>(info.st_mtime);
+    size = static_cast<int64_t>(info.st_size);
+    return true;
+}
+
+/**
+ * @brief Applies one key of a section to its descriptor; returns false for an unknown key or a bad value.
+ */
+bool LightConfig::setField(LightDescriptor& light, const std::string& key, const char* value) {
+    if (key == "direction") {
+        return parseVector(value, light.direction);
+    }
+    if (key == "position") {
+        return parseVector(value, light.position);
+    }
+    if (key == "ambient") {
+        return parseVector(value, light.ambient);
+    }
+    if (key == "diffuse") {
+        return parseVector(value, light.diffuse);
+    }
+    if (key == "specular") {
+        return parseVector(value, light.specular);
+    }
+    if (key == "constant") {
+        return parseFloat(value, light.constant);
+    }
+    if (key == "linear") {
+        return parseFloat(value, light.linear);
+    }
+    if (key == "quadratic") {
+        return parseFloat(value, light.quadratic);
+    }
+    if (key == "intensity") {
+        return parseFloat(value, light.intensity);
+    }
+    if (key == "cutoff") {
+        return parseFloat(value, light.cutOff);
+    }
+    if (key == "outercutoff") {
+        return parseFloat(value, light.outerCutOff);
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the type a section name implies, false when it implies none.
+ */
+bool LightConfig::getTypeFromName(const std::string& name, LightDescriptor::Type& type) {
+    if (startsWith(name, "DirectLight")) {
+        type = LightDescriptor::DIRECTIONAL;
+        return true;
+    }
+    if (startsWith(name, "PointLight")) {
+        type = LightDescriptor::POINT;
+        return true;
+    }
+    if (startsWith(name, "SpotLight")) {
+        type = LightDescriptor::SPOT;
+        return true;
+    }
+    return false;
+}
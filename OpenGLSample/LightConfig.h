@@ -0,0 +1,115 @@
+/**
+ * @file LightConfig.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the LightDescriptor struct and the LightConfig class,
+ * which parses the light configuration file once into a table of light descriptors.
+ */
+
+#ifndef LIGHTCONFIG_H
+#define LIGHTCONFIG_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @struct LightDescriptor
+ * @brief The properties of one light, as read from its section of the configuration file.
+ *
+ * Each light type reads the fields it uses and ignores the others.
+ */
+struct LightDescriptor
+{
+    enum Type
+    {
+        DIRECTIONAL, POINT, SPOT
+    };
+
+    std::string name;                               // Section name, which identifies the light across reloads
+    Type type = POINT;
+    glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 ambient = glm::vec3(0.0f);
+    glm::vec3 diffuse = glm::vec3(0.0f);
+    glm::vec3 specular = glm::vec3(0.0f);
+    float constant = 1.0f;                          // Attenuation factors
+    float linear = 0.0f;
+    float quadratic = 0.0f;
+    float intensity = 0.0f;
+    float cutOff = 0.0f;                            // Cone angles in degrees
+    float outerCutOff = 0.0f;
+};
+
+/**
+ * @class LightConfig
+ * @brief The light configuration file, parsed in a single pass.
+ *
+ * Every [Section] of the file describes one light. Its type is given by a type= key (directional,
+ * point or spot) or, without one, by the section name starting with DirectLight, PointLight or
+ * SpotLight, so any number of point lights can be listed. The Lights block has room for one
+ * directional and one spot light; further ones are reported and skipped. The file's modification
+ * time and size are kept, so a changed file can be parsed again while the program runs.
+ */
+class LightConfig
+{
+public:
+    /**
+     * @brief Creates the configuration of a file; nothing is read until load.
+     * @param path The file path of the configuration file.
+     */
+    explicit LightConfig(const std::string& path);
+
+    /**
+     * @brief Parses the file, replacing the descriptors.
+     * @return False when the file cannot be read; the previous descriptors are kept.
+     */
+    bool load();
+
+    /**
+     * @brief Parses the file again when its modification time or size changed since the last load.
+     * @return True when the descriptors were replaced.
+     */
+    bool reloadIfChanged();
+
+    /**
+     * @brief Returns the descriptors, in file order.
+     */
+    const std::vector<LightDescriptor>& getLights() const { return lights; }
+
+    /**
+     * @brief Returns the descriptor of a section, or nullptr when the file has no such light.
+     */
+    const LightDescriptor* find(const std::string& name) const;
+
+    /**
+     * @brief Returns the file path of the configuration file.
+     */
+    const std::string& getPath() const { return path; }
+
+private:
+    std::string path;
+    std::vector<LightDescriptor> lights;
+    std::map<std::string, size_t> lightIndices;     // Section name to descriptor
+    int64_t fileTime = -1;                          // Modification time of the last load, -1 before it
+    int64_t fileSize = -1;
+
+    /**
+     * @brief Reads the modification time and size of the file; returns false when it does not exist.
+     */
+    bool getFileStamp(int64_t& time, int64_t& size) const;
+
+    /**
+     * @brief Applies one key of a section to its descriptor; returns false for an unknown key or a bad value.
+     */
+    static bool setField(LightDescriptor& light, const std::string& key, const char* value);
+
+    /**
+     * @brief Returns the type a section name implies, false when it implies none.
+     */
+    static bool getTypeFromName(const std::string& name, LightDescriptor::Type& type);
+};
+#endif // LIGHTCONFIG_H
@@ -0,0 +1,228 @@
+/**
+ * @file LightGrid.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the LightGrid class.
+ */
+
+#include "LightGrid.h"
+#include <algorithm>
+#include <cmath>
+
+const GLuint LightGrid::TILES_X;
+const GLuint LightGrid::TILES_Y;
+const GLuint LightGrid::SLICES;
+const GLuint LightGrid::CLUSTER_COUNT;
+const GLuint LightGrid::MAX_POINT_LIGHTS;
+const GLuint LightGrid::LIGHT_DATA_UNIT;
+const GLuint LightGrid::CLUSTER_UNIT;
+const GLuint LightGrid::LIGHT_INDEX_UNIT;
+const float LightGrid::LIGHT_CUTOFF = 1.0f / 256.0f;
+
+/**
+ * @brief Creates the buffers and their buffer textures.
+ */
+void LightGrid::create() {
+    const GLenum formats[BUFFER_COUNT] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+
+    glGenBuffers(BUFFER_COUNT, buffers);
+    glGenTextures(BUFFER_COUNT, textures);
+    for (int i = 0; i < BUFFER_COUNT; i++) {
+        // Buffer textures cannot be empty, so every buffer starts with room for one element
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(PointLightBlock), NULL, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+/**
+ * @brief Assigns the point lights to the clusters of a view.
+ *
+ * Makes no GL calls.
+ *
+ * @param pointLights The point lights; lights past MAX_POINT_LIGHTS are dropped.
+ * @param view The view matrix.
+ * @param projection The projection matrix, perspective or orthographic.
+ * @param zNear The distance of the near plane.
+ * @param zFar The distance of the far plane.
+ * @param viewportWidth The width of the viewport in pixels.
+ * @param viewportHeight The height of the viewport in pixels.
+ */
+void LightGrid::build(const std::vector<PointLightBlock>& pointLights, const glm::mat4& view, const glm::mat4& projection,
+    float zNear, float zFar, int viewportWidth, int viewportHeight) {
+    const size_t lightCount = std::min<size_t>(pointLights.size(), MAX_POINT_LIGHTS);
+    lights.assign(pointLights.begin(), pointLights.begin() + lightCount);
+
+    // Tiles are a whole number of pixels, the last row and column may reach past the viewport
+    const float tileWidth = std::ceil(std::max(viewportWidth, 1) / static_cast<float>(TILES_X));
+    const float tileHeight = std::ceil(std::max(viewportHeight, 1) / static_cast<float>(TILES_Y));
+    const float logDepthRange = std::log(zFar / zNear);
+
+    parameters.gridSize[0] = TILES_X;
+    parameters.gridSize[1] = TILES_Y;
+    parameters.gridSize[2] = SLICES;
+    parameters.pointLightCount = static_cast<GLuint>(lightCount);
+    parameters.tileSize = glm::vec2(tileWidth, tileHeight);
+    parameters.sliceScale = SLICES / logDepthRange;
+    parameters.sliceBias = -(SLICES * std::log(zNear)) / logDepthRange;
+
+    assignments.clear();
+    for (size_t i = 0; i < lightCount; i++) {
+        const PointLightBlock& light = lights[i];
+        const glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        const float depth = -center.z;
+
+        // A light that never dims below the cutoff reaches the whole frustum
+        float range = computeRange(light);
+        if (range == 0.0f) {
+            continue;
+        }
+        const float frustumReach = glm::length(center) + 2.0f * zFar;
+        if (range < 0.0f || range > frustumReach) {
+            range = frustumReach;
+        }
+        if (depth + range < zNear || depth - range > zFar) {
+            continue;
+        }
+
+        const float nearDepth = std::max(depth - range, zNear);
+        const float farDepth = std::min(depth + range, zFar);
+        const int firstSlice = glm::clamp(static_cast<int>(std::log(nearDepth) * parameters.sliceScale + parameters.sliceBias), 0, (int)SLICES - 1);
+        const int lastSlice = glm::clamp(static_cast<int>(std::log(farDepth) * parameters.sliceScale + parameters.sliceBias), 0, (int)SLICES - 1);
+
+        for (int slice = firstSlice; slice <= lastSlice; slice++) {
+            // Part of the light's depth range inside the slice
+            const float sliceNear = std::max(zNear * std::pow(zFar / zNear, slice / static_cast<float>(SLICES)), nearDepth);
+            const float sliceFar = std::min(zNear * std::pow(zFar / zNear, (slice + 1) / static_cast<float>(SLICES)), farDepth);
+
+            // Radius of the sphere's widest cross-section within the slice
+            const float offset = (depth < sliceNear) ? sliceNear - depth : ((depth > sliceFar) ? depth - sliceFar : 0.0f);
+            const float radius = std::sqrt(std::max(range * range - offset * offset, 0.0f));
+
+            // The corners of a box in front of the eye bound its projection
+            glm::vec2 ndcMin(1e30f);
+            glm::vec2 ndcMax(-1e30f);
+            for (int corner = 0; corner < 8; corner++) {
+                const glm::vec4 point(
+                    center.x + ((corner & 1) ? radius : -radius),
+                    center.y + ((corner & 2) ? radius : -radius),
+                    (corner & 4) ? -sliceFar : -sliceNear,
+                    1.0f);
+                const glm::vec4 clip = projection * point;
+                const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+            if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) {
+                continue;
+            }
+
+            const int firstX = glm::clamp(static_cast<int>((ndcMin.x * 0.5f + 0.5f) * viewportWidth / tileWidth), 0, (int)TILES_X - 1);
+            const int lastX = glm::clamp(static_cast<int>((ndcMax.x * 0.5f + 0.5f) * viewportWidth / tileWidth), 0, (int)TILES_X - 1);
+            const int firstY = glm::clamp(static_cast<int>((ndcMin.y * 0.5f + 0.5f) * viewportHeight / tileHeight), 0, (int)TILES_Y - 1);
+            const int lastY = glm::clamp(static_cast<int>((ndcMax.y * 0.5f + 0.5f) * viewportHeight / tileHeight), 0, (int)TILES_Y - 1);
+
+            for (int y = firstY; y <= lastY; y++) {
+                for (int x = firstX; x <= lastX; x++) {
+                    const uint32_t cluster = x + TILES_X * (y + TILES_Y * slice);
+                    assignments.push_back(std::make_pair(cluster, static_cast<GLushort>(i)));
+                }
+            }
+        }
+    }
+
+    // Counting sort of the assignments by cluster
+    clusters.assign(CLUSTER_COUNT * 2, 0);
+    for (const std::pair<uint32_t, GLushort>& assignment : assignments) {
+        clusters[assignment.first * 2 + 1]++;
+    }
+    GLuint offset = 0;
+    for (GLuint cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+        clusters[cluster * 2] = offset;
+        offset += clusters[cluster * 2 + 1];
+        clusters[cluster * 2 + 1] = 0;
+    }
+    indices.resize(assignments.size());
+    for (const std::pair<uint32_t, GLushort>& assignment : assignments) {
+        GLuint& count = clusters[assignment.first * 2 + 1];
+        indices[clusters[assignment.first * 2] + count] = assignment.second;
+        count++;
+    }
+}
+
+/**
+ * @brief Uploads the lights and clusters of the last build and binds the buffer textures.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void LightGrid::upload(GLStateCache& stateCache) {
+    const void* data[BUFFER_COUNT] = { lights.data(), clusters.data(), indices.data() };
+    const size_t sizes[BUFFER_COUNT] = {
+        lights.size() * sizeof(PointLightBlock),
+        clusters.size() * sizeof(GLuint),
+        indices.size() * sizeof(GLushort)
+    };
+
+    for (int i = 0; i < BUFFER_COUNT; i++) {
+        // Orphan the previous frame's contents instead of waiting for draws still reading them
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+        if (sizes[i] > 0) {
+            glBufferData(GL_TEXTURE_BUFFER, sizes[i], data[i], GL_STREAM_DRAW);
+        }
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    stateCache.bindTexture(LIGHT_DATA_UNIT, GL_TEXTURE_BUFFER, textures[LIGHT_DATA]);
+    stateCache.bindTexture(CLUSTER_UNIT, GL_TEXTURE_BUFFER, textures[CLUSTERS]);
+    stateCache.bindTexture(LIGHT_INDEX_UNIT, GL_TEXTURE_BUFFER, textures[LIGHT_INDICES]);
+}
+
+/**
+ * @brief Writes the grid parameters of the last build into the Lights uniform block.
+ * @param block The Lights block that will be uploaded to the uniform buffer.
+ */
+void LightGrid::writeToBlock(LightsBlock& block) const {
+    block.clusters = parameters;
+}
+
+/**
+ * @brief Returns the distance at which a point light falls below LIGHT_CUTOFF.
+ *
+ * Solves constant + linear * d + quadratic * d^2 = brightness / LIGHT_CUTOFF, where the brightness is the
+ * largest channel of the light's colors scaled by its intensity.
+ *
+ * @param light The point light.
+ * @return The range, 0 when the light never reaches the cutoff, or a negative value when it never falls below it.
+ */
+float LightGrid::computeRange(const PointLightBlock& light) {
+    const glm::vec3 brightest = glm::max(glm::max(light.ambient, light.diffuse), light.specular);
+    const float brightness = light.intensity * std::max(std::max(brightest.x, brightest.y), brightest.z);
+    const float attenuation = brightness / LIGHT_CUTOFF;
+    if (attenuation <= light.constant) {
+        return 0.0f;
+    }
+
+    if (light.quadratic > 0.0f) {
+        const float c = light.constant - attenuation;
+        return (-light.linear + std::sqrt(light.linear * light.linear - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic);
+    }
+    if (light.linear > 0.0f) {
+        return (attenuation - light.constant) / light.linear;
+    }
+    return -1.0f;
+}
+
+/**
+ * @brief Releases the buffers and textures.
+ */
+void LightGrid::destroy() {
+    glDeleteTextures(BUFFER_COUNT, textures);
+    glDeleteBuffers(BUFFER_COUNT, buffers);
+    for (int i = 0; i < BUFFER_COUNT; i++) {
+        textures[i] = 0;
+        buffers[i] = 0;
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ * @file LightGrid.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the LightGrid class, which assigns the point lights to the
+ * clusters of the view frustum for clustered forward shading.
+ */
+
+#ifndef LIGHTGRID_H
+#define LIGHTGRID_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "GLStateCache.h"
+#include "UniformBuffer.h"
+
+/**
+ * @class LightGrid
+ * @brief Point lights sorted into a grid of view-space clusters, rebuilt every frame.
+ *
+ * The view frustum is split into TILES_X by TILES_Y screen tiles and SLICES depth slices, spaced
+ * exponentially between the near and far planes. Each point light is given a range from its
+ * attenuation, beyond which it adds less than LIGHT_CUTOFF, and is listed in every cluster its
+ * range reaches. The lights, the (offset, count) pair of each cluster and the light index lists
+ * are stored in three buffer textures, so each fragment only shades the lights of its own cluster.
+ * Buffer textures are core in GL 3.3, unlike shader storage buffers.
+ */
+class LightGrid
+{
+public:
+    static const GLuint TILES_X = 16;
+    static const GLuint TILES_Y = 9;
+    static const GLuint SLICES = 24;
+    static const GLuint CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+
+    // Light indices are 16-bit
+    static const GLuint MAX_POINT_LIGHTS = 4096;
+
+    // Texture units of the buffer textures, after the three material textures
+    static const GLuint LIGHT_DATA_UNIT = 3;
+    static const GLuint CLUSTER_UNIT = 4;
+    static const GLuint LIGHT_INDEX_UNIT = 5;
+
+    // A light is ignored where it would add less than this to a color channel
+    static const float LIGHT_CUTOFF;
+
+    /**
+     * @brief Creates the buffers and their buffer textures.
+     */
+    void create();
+
+    /**
+     * @brief Assigns the point lights to the clusters of a view.
+     *
+     * Makes no GL calls.
+     *
+     * @param pointLights The point lights; lights past MAX_POINT_LIGHTS are dropped.
+     * @param view The view matrix.
+     * @param projection The projection matrix, perspective or orthographic.
+     * @param zNear The distance of the near plane.
+     * @param zFar The distance of the far plane.
+     * @param viewportWidth The width of the viewport in pixels.
+     * @param viewportHeight The height of the viewport in pixels.
+     */
+    void build(const std::vector<PointLightBlock>& pointLights, const glm::mat4& view, const glm::mat4& projection,
+        float zNear, float zFar, int viewportWidth, int viewportHeight);
+
+    /**
+     * @brief Uploads the lights and clusters of the last build and binds the buffer textures.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void upload(GLStateCache& stateCache);
+
+    /**
+     * @brief Writes the grid parameters of the last build into the Lights uniform block.
+     * @param block The Lights block that will be uploaded to the uniform buffer.
+     */
+    void writeToBlock(LightsBlock& block) const;
+
+    /**
+     * @brief Returns the distance at which a point light falls below LIGHT_CUTOFF.
+     * @param light The point light.
+     * @return The range, 0 when the light never reaches the cutoff, or a negative value when it never falls below it.
+     */
+    static float computeRange(const PointLightBlock& light);
+
+    /**
+     * @brief Returns the number of light indices written by the last build, summed over every cluster.
+     */
+    size_t getIndexCount() const { return indices.size(); }
+
+    /**
+     * @brief Releases the buffers and textures.
+     */
+    void destroy();
+
+private:
+    enum Buffer { LIGHT_DATA = 0, CLUSTERS, LIGHT_INDICES, BUFFER_COUNT };
+
+    GLuint buffers[BUFFER_COUNT] = { 0, 0, 0 };
+    GLuint textures[BUFFER_COUNT] = { 0, 0, 0 };
+
+    LightClustersBlock parameters = {};
+    std::vector<PointLightBlock> lights;                   // Lights of the last build, four RGBA32F texels each
+    std::vector<GLuint> clusters;                          // Offset and count of each cluster's light indices
+    std::vector<GLushort> indices;                         // Light indices of every cluster, cluster by cluster
+    std::vector<std::pair<uint32_t, GLushort>> assignments; // Scratch list of (cluster, light) pairs
+};
+#endif // LIGHTGRID_H
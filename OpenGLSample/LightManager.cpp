@@ -6,19 +6,72 @@
  */
 
 #include "LightManager.h"
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+#include "camera.h"
+#include "DirectLight.h"
+#include "PointLight.h"
+#include "SpotLight.h"
+
+namespace {
+    // The block is compared and uploaded in std140 rows
+    const size_t BLOCK_ROW_SIZE = 16;
+    const size_t BLOCK_ROW_COUNT = sizeof(LightsBlock) / BLOCK_ROW_SIZE;
+}
 
 /**
- * @brief Adds a light to the lights vector.
+ * @brief Creates the lights of a configuration, or brings them up to date after it was reloaded.
  *
- * This method adds the specified light to the LightManager's vector of lights.
- * It ensures that the light is included in the collection of lights managed by
- * the LightManager, allowing it to be used in subsequent operations such as
- * rendering or updating light properties.
+ * Lights are matched to the sections of the file by name. A light whose section is new is added,
+ * and one whose section is still there takes its new properties in place, so its handle stays
+ * valid. A point light whose section was removed is removed too; a directional or spot light is
+ * switched off instead, since the renderer keeps using their handles. A light whose section
+ * changed type is replaced.
  *
- * @param light A pointer to the LightSource object to be added.
+ * @param config The parsed configuration.
+ * @param camera The camera a new spot light starts at.
  */
-void LightManager::addLight(LightSource* light) {
-    lights.push_back(light);
+void LightManager::applyConfig(const LightConfig& config, const Camera& camera) {
+    std::set<std::string> sections;
+    int pointNumber = 0;
+    for (const LightDescriptor& descriptor : config.getLights()) {
+        sections.insert(descriptor.name);
+        const int number = descriptor.type == LightDescriptor::POINT ? pointNumber++ : -1;
+
+        std::map<std::string, int>::iterator found = configSlots.find(descriptor.name);
+        LightSource* light = found != configSlots.end() ? getSlot(found->second) : nullptr;
+        if (light != nullptr && hasType(light, descriptor.type)) {
+            light->configure(descriptor);
+            if (descriptor.type == LightDescriptor::POINT) {
+                static_cast<PointLight*>(light)->lightNumber = number;
+            }
+            continue;
+        }
+        if (light != nullptr) {
+            removeLight(light);
+        }
+        configSlots[descriptor.name] = addSlot(createLight(descriptor, number, camera));
+    }
+
+    // Sections no longer in the file
+    std::map<std::string, int>::iterator slot = configSlots.begin();
+    while (slot != configSlots.end()) {
+        LightSource* light = getSlot(slot->second);
+        if (sections.count(slot->first) != 0 || light == nullptr) {
+            ++slot;
+            continue;
+        }
+        if (hasType(light, LightDescriptor::POINT)) {
+            removeLight(light);
+            slot = configSlots.erase(slot);
+        }
+        else {
+            light->switchOff();
+            ++slot;
+        }
+    }
 }
 
 /**
@@ -26,18 +79,20 @@ void LightManager::addLight(LightSource* light) {
  *
  * This method removes the specified light from the LightManager's vector of lights.
  * It first finds the light in the vector, deletes the LightSource object to deallocate
- * the memory, and then removes the pointer from the vector.
+ * the memory, and then empties its slot, so the handles of the other lights stay valid.
  *
  * @param light A pointer to the LightSource object to be removed and deallocated.
  */
 void LightManager::removeLight(LightSource* light) {
     // Find the light in the vector
     auto target = std::find(lights.begin(), lights.end(), light);
-    if (target != lights.end()) {
+    if (target != lights.end() && light != nullptr) {
         // Delete the LightSource object
         delete* target;
-        // Remove the pointer from the vector
-        lights.erase(target);
+        // Empty its slot
+        *target = nullptr;
+        // Whatever the light wrote into the block must be cleared
+        resetBlock();
     }
 }
 
@@ -52,7 +107,64 @@ void LightManager::removeLight(LightSource* light) {
  */
 void LightManager::setLightsToShader(Shader& shader) const {
     for (int i = 0; i < lights.size(); ++i) {
-        lights[i]->setToShader(shader, "lights[" + std::to_string(i) + "]");
+        if (lights[i] != nullptr) {
+            lights[i]->setToShader(shader, "lights[" + std::to_string(i) + "]");
+        }
+    }
+}
+
+/**
+ * @brief Uploads the lights that changed to the Lights uniform buffer.
+ *
+ * This method lets every light whose revision changed write itself into the cached std140 Lights
+ * block, adds the parameters of the light grid, and uploads the range of the block that differs
+ * from the buffer's contents in a single buffer update. Nothing is uploaded when no light changed.
+ * Every shader that declares the Lights block reads from it.
+ *
+ * @param buffer The uniform buffer bound to LIGHTS_BLOCK_BINDING.
+ * @param grid The light grid built from this frame's point lights.
+ */
+void LightManager::setLightsToBuffer(UniformBuffer& buffer, const LightGrid& grid) {
+    for (size_t i = 0; i < lights.size(); ++i) {
+        if (lights[i] != nullptr && lights[i]->getRevision() != writtenRevisions[i]) {
+            lights[i]->writeToBlock(block);
+            writtenRevisions[i] = lights[i]->getRevision();
+        }
+    }
+    grid.writeToBlock(block);
+
+    // Find the first and last rows that differ from the buffer
+    const unsigned char* rows = reinterpret_cast<const unsigned char*>(&block);
+    const unsigned char* uploadedRows = reinterpret_cast<const unsigned char*>(&uploadedBlock);
+    size_t first = BLOCK_ROW_COUNT;
+    size_t last = 0;
+    for (size_t row = 0; row < BLOCK_ROW_COUNT; ++row) {
+        if (!blockUploaded || std::memcmp(rows + row * BLOCK_ROW_SIZE, uploadedRows + row * BLOCK_ROW_SIZE, BLOCK_ROW_SIZE) != 0) {
+            first = std::min(first, row);
+            last = row;
+        }
+    }
+
+    uploadedBytes = 0;
+    if (first == BLOCK_ROW_COUNT) {
+        return;
+    }
+    GLintptr offset = static_cast<GLintptr>(first * BLOCK_ROW_SIZE);
+    uploadedBytes = (last - first + 1) * BLOCK_ROW_SIZE;
+    buffer.update(offset, static_cast<GLsizeiptr>(uploadedBytes), rows + offset);
+    std::memcpy(&uploadedBlock, &block, sizeof(LightsBlock));
+    blockUploaded = true;
+}
+
+/**
+ * @brief Collects the point lights to be sorted into the light grid.
+ * @param pointLights Receives one entry per point light, appended in the order the lights were added.
+ */
+void LightManager::writePointLights(std::vector<PointLightBlock>& pointLights) const {
+    for (LightSource* light : lights) {
+        if (light != nullptr) {
+            light->writeToList(pointLights);
+        }
     }
 }
 
@@ -69,4 +181,63 @@ void LightManager::clearLights() {
         delete light;
     }
     lights.clear();
-}
\ No newline at end of file
+    writtenRevisions.clear();
+    configSlots.clear();
+    resetBlock();
+}
+
+/**
+ * @brief Stores a light in a new slot and returns the slot's index.
+ */
+int LightManager::addSlot(LightSource* light) {
+    lights.push_back(light);
+    writtenRevisions.push_back(0);
+    return static_cast<int>(lights.size()) - 1;
+}
+
+/**
+ * @brief Returns the light in a slot, or nullptr for an empty or invalid slot.
+ */
+LightSource* LightManager::getSlot(int index) const {
+    if (index < 0 || index >= static_cast<int>(lights.size())) {
+        return nullptr;
+    }
+    return lights[index];
+}
+
+/**
+ * @brief Clears the block so that every light writes itself again, after a light was removed.
+ */
+void LightManager::resetBlock() {
+    block = {};
+    std::fill(writtenRevisions.begin(), writtenRevisions.end(), 0u);
+}
+
+/**
+ * @brief Creates the light of a descriptor.
+ * @param pointNumber The index of the light among the point lights of the file.
+ */
+LightSource* LightManager::createLight(const LightDescriptor& descriptor, int pointNumber, const Camera& camera) {
+    switch (descriptor.type) {
+    case LightDescriptor::DIRECTIONAL:
+        return new DirectLight(descriptor);
+    case LightDescriptor::SPOT:
+        return new SpotLight(descriptor, camera);
+    default:
+        return new PointLight(descriptor, pointNumber);
+    }
+}
+
+/**
+ * @brief Returns true when a light was created from a descriptor of the same type.
+ */
+bool LightManager::hasType(const LightSource* light, LightDescriptor::Type type) {
+    switch (type) {
+    case LightDescriptor::DIRECTIONAL:
+        return dynamic_cast<const DirectLight*>(light) != nullptr;
+    case LightDescriptor::SPOT:
+        return dynamic_cast<const SpotLight*>(light) != nullptr;
+    default:
+        return dynamic_cast<const PointLight*>(light) != nullptr;
+    }
+}
@@ -9,10 +9,31 @@
 #ifndef LIGHTMANAGER_H
 #define LIGHTMANAGER_H
 
+#include <map>
+#include <string>
 #include <vector>
 #include <memory>
 #include "LightSource.h"
+#include "LightConfig.h"
 #include "Shader.h"
+#include "UniformBuffer.h"
+#include "LightGrid.h"
+
+class Camera;
+
+/**
+ * @struct LightHandle
+ * @brief Identifies a light added to a LightManager, together with its type.
+ *
+ * A handle keeps referring to the same light while other lights are added or removed.
+ */
+template <typename T>
+struct LightHandle
+{
+    int index = -1;
+
+    bool isValid() const { return index >= 0; }
+};
 
 /**
  * @class LightManager
@@ -20,15 +41,21 @@
  *
  * The LightManager class is responsible for maintaining a list of light sources
  * in a scene. It provides methods for adding, removing, and setting lights to a shader.
- * Each light source is represented as a pointer to a LightSource object.
+ * Each light source is represented as a pointer to a LightSource object, and is reached
+ * through the handle returned when it was added.
+ *
+ * The Lights block is kept between frames. Only the lights whose revision changed since the
+ * last upload are written into it again, and only the rows of the block that differ from the
+ * buffer's contents are uploaded.
+ *
+ * The lights of the configuration file are created from the descriptors of a LightConfig and keep
+ * the name of their section, so a reloaded file updates them in place.
  */
 class LightManager {
 
 
 public:
 
-    std::vector<LightSource*> lights;
-
     /**
      * @brief Adds a light to the lights vector.
      *
@@ -37,16 +64,60 @@ public:
      * the LightManager, allowing it to be used in subsequent operations such as
      * rendering or updating light properties.
      *
-     * @param light A pointer to the LightSource object to be added.
+     * @param light A pointer to the light to be added. The LightManager takes ownership of it.
+     * @return The handle of the light, valid until the light is removed.
+     */
+    template <typename T>
+    LightHandle<T> addLight(T* light) {
+        LightHandle<T> handle;
+        handle.index = addSlot(light);
+        return handle;
+    }
+
+    /**
+     * @brief Returns the light a handle refers to, or nullptr once it was removed.
+     * @param handle A handle returned by addLight.
+     */
+    template <typename T>
+    T* get(LightHandle<T> handle) const {
+        return static_cast<T*>(getSlot(handle.index));
+    }
+
+    /**
+     * @brief Returns the handle of the light created from a section of the configuration file.
+     * @param name The section name.
+     * @return The handle, invalid when no light of type T was created from that section.
+     */
+    template <typename T>
+    LightHandle<T> findLight(const std::string& name) const {
+        LightHandle<T> handle;
+        std::map<std::string, int>::const_iterator found = configSlots.find(name);
+        if (found != configSlots.end() && dynamic_cast<T*>(getSlot(found->second)) != nullptr) {
+            handle.index = found->second;
+        }
+        return handle;
+    }
+
+    /**
+     * @brief Creates the lights of a configuration, or brings them up to date after it was reloaded.
+     *
+     * Lights are matched to the sections of the file by name. A light whose section is new is added,
+     * and one whose section is still there takes its new properties in place, so its handle stays
+     * valid. A point light whose section was removed is removed too; a directional or spot light is
+     * switched off instead, since the renderer keeps using their handles. A light whose section
+     * changed type is replaced.
+     *
+     * @param config The parsed configuration.
+     * @param camera The camera a new spot light starts at.
      */
-    void addLight(LightSource* light);
+    void applyConfig(const LightConfig& config, const Camera& camera);
 
     /**
      * @brief Removes and deallocates a light from the lights vector.
      *
      * This method removes the specified light from the LightManager's vector of lights.
      * It first finds the light in the vector, deletes the LightSource object to deallocate
-     * the memory, and then removes the pointer from the vector.
+     * the memory, and then empties its slot, so the handles of the other lights stay valid.
      *
      * @param light A pointer to the LightSource object to be removed and deallocated.
      */
@@ -63,6 +134,30 @@ public:
      */
     void setLightsToShader(Shader& shader) const;
 
+    /**
+     * @brief Uploads the lights that changed to the Lights uniform buffer.
+     *
+     * This method lets every light whose revision changed write itself into the cached std140 Lights
+     * block, adds the parameters of the light grid, and uploads the range of the block that differs
+     * from the buffer's contents in a single buffer update. Nothing is uploaded when no light changed.
+     * Every shader that declares the Lights block reads from it.
+     *
+     * @param buffer The uniform buffer bound to LIGHTS_BLOCK_BINDING.
+     * @param grid The light grid built from this frame's point lights.
+     */
+    void setLightsToBuffer(UniformBuffer& buffer, const LightGrid& grid);
+
+    /**
+     * @brief Collects the point lights to be sorted into the light grid.
+     * @param pointLights Receives one entry per point light, appended in the order the lights were added.
+     */
+    void writePointLights(std::vector<PointLightBlock>& pointLights) const;
+
+    /**
+     * @brief Returns the number of bytes of the Lights block uploaded by the last setLightsToBuffer.
+     */
+    size_t getUploadedBytes() const { return uploadedBytes; }
+
     /**
      * @brief Clears all the lights managed by the LightManager.
      *
@@ -72,6 +167,45 @@ public:
      * the LightManager is being destroyed.
      */
     void clearLights();
+
+private:
+    // One slot per added light; removed lights leave an empty slot so handles stay valid
+    std::vector<LightSource*> lights;
+    // Revision of each light when it was last written into the block, 0 when it never was
+    std::vector<unsigned int> writtenRevisions;
+    // Slot of the light created from each section of the configuration file
+    std::map<std::string, int> configSlots;
+
+    LightsBlock block = {};         // Lights as they are written
+    LightsBlock uploadedBlock = {}; // Contents of the uniform buffer
+    bool blockUploaded = false;
+    size_t uploadedBytes = 0;
+
+    /**
+     * @brief Stores a light in a new slot and returns the slot's index.
+     */
+    int addSlot(LightSource* light);
+
+    /**
+     * @brief Returns the light in a slot, or nullptr for an empty or invalid slot.
+     */
+    LightSource* getSlot(int index) const;
+
+    /**
+     * @brief Clears the block so that every light writes itself again, after a light was removed.
+     */
+    void resetBlock();
+
+    /**
+     * @brief Creates the light of a descriptor.
+     * @param pointNumber The index of the light among the point lights of the file.
+     */
+    static LightSource* createLight(const LightDescriptor& descriptor, int pointNumber, const Camera& camera);
+
+    /**
+     * @brief Returns true when a light was created from a descriptor of the same type.
+     */
+    static bool hasType(const LightSource* light, LightDescriptor::Type type);
 };
 
 #endif // LIGHTMANAGER_H
\ No newline at end of file
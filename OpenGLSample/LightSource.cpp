@@ -12,15 +12,38 @@
  * @brief Constructor for the LightSource class.
  *
  * This constructor initializes the light source properties (ambient, diffuse, and specular)
- * using a configuration file path.
+ * from the descriptor parsed out of the configuration file.
  *
- * @param configFilePath A string representing the path to the configuration file.
+ * @param descriptor The light's section of the configuration file.
  */
-LightSource::LightSource(const std::string& configFilePath) {
+LightSource::LightSource(const LightDescriptor& descriptor) {
+    ambient = descriptor.ambient;
+    diffuse = descriptor.diffuse;
+    specular = descriptor.specular;
+}
+
+/**
+ * @brief Takes the properties of a descriptor, after the configuration file was reloaded.
+ *
+ * The base light copies its ambient, diffuse and specular colors; each light type also copies its own fields.
+ *
+ * @param descriptor The light's section of the reloaded configuration file.
+ */
+void LightSource::configure(const LightDescriptor& descriptor) {
+    ambient = descriptor.ambient;
+    diffuse = descriptor.diffuse;
+    specular = descriptor.specular;
+    markChanged();
+}
+
+/**
+ * @brief Turns the light off, after its section was removed from the configuration file.
+ */
+void LightSource::switchOff() {
     ambient = glm::vec3(0.0f);
     diffuse = glm::vec3(0.0f);
     specular = glm::vec3(0.0f);
-
+    markChanged();
 }
 
 /**
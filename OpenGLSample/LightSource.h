@@ -12,8 +12,11 @@
 #define LIGHTSOURCE_H
 
 #include <string>
+#include <vector>
 #include <glm/glm.hpp>
 #include "Shader.h"
+#include "UniformBuffer.h"
+#include "LightConfig.h"
 
 /**
  * @class LightSource
@@ -33,11 +36,16 @@ public:
      * @brief Constructor for the LightSource class.
      *
      * This constructor initializes the light source properties (ambient, diffuse, and specular)
-     * using a configuration file path.
+     * from the descriptor parsed out of the configuration file.
      *
-     * @param configFilePath A string representing the path to the configuration file.
+     * @param descriptor The light's section of the configuration file.
      */
-    LightSource(const std::string& configFilePath);
+    LightSource(const LightDescriptor& descriptor);
+
+    /**
+     * @brief Lights are deleted through LightSource pointers by the LightManager.
+     */
+    virtual ~LightSource() {}
 
     /**
      * @brief Sets the light properties to a shader.
@@ -49,6 +57,53 @@ public:
      * @param name The base name of the light properties in the shader.
      */
     virtual void setToShader(Shader& shader, const std::string& name) const;
+
+    /**
+     * @brief Writes the light properties into the Lights uniform block.
+     *
+     * This method copies the light's properties into its slot of the std140 Lights block.
+     * The base light has no slot of its own, so the default implementation does nothing.
+     *
+     * @param block The Lights block that will be uploaded to the uniform buffer.
+     */
+    virtual void writeToBlock(LightsBlock& /*block*/) const {}
+
+    /**
+     * @brief Appends the light to the point lights shaded through the light grid.
+     * Only point lights are added; the default implementation does nothing.
+     * @param pointLights The point lights that the light grid is built from.
+     */
+    virtual void writeToList(std::vector<PointLightBlock>& /*pointLights*/) const {}
+
+    /**
+     * @brief Takes the properties of a descriptor, after the configuration file was reloaded.
+     *
+     * The base light copies its ambient, diffuse and specular colors; each light type also copies its own fields.
+     *
+     * @param descriptor The light's section of the reloaded configuration file.
+     */
+    virtual void configure(const LightDescriptor& descriptor);
+
+    /**
+     * @brief Turns the light off, after its section was removed from the configuration file.
+     */
+    virtual void switchOff();
+
+    /**
+     * @brief Records that the light's properties changed.
+     *
+     * The LightManager only writes a light into the Lights block again when its revision moved on, so code
+     * that assigns the public properties directly calls this afterwards.
+     */
+    void markChanged() { ++revision; }
+
+    /**
+     * @brief Returns a counter that changes whenever the light's properties change.
+     */
+    unsigned int getRevision() const { return revision; }
+
+private:
+    unsigned int revision = 1;
 };
 
 #endif // LIGHTSOURCE_H
\ No newline at end of file
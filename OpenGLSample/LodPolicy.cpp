@@ -0,0 +1,111 @@
+/**
+ * @file LodPolicy.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the LodPolicy and LodBiasController classes.
+ */
+
+#include "LodPolicy.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+namespace
+{
+    const float MAX_BIAS = 3.0f;          // At most 8 times smaller screen sizes
+    const float BIAS_STEP = 0.02f;        // Bias change per frame over or under budget
+    const float OVER_BUDGET = 1.05f;      // Raise the bias above 105% of the budget
+    const float UNDER_BUDGET = 0.8f;      // Lower it below 80%
+    const float SMOOTHING = 0.1f;         // Weight of the newest frame in the average
+}
+
+LodPolicy::LodPolicy() : cullScreenSize(0.002f), hysteresis(0.1f) {
+    // Defaults keep the original switch at about 8 units for the scene's mid-sized submeshes
+    thresholds[0] = 0.065f;
+    thresholds[1] = 0.03f;
+    thresholds[2] = 0.015f;
+}
+
+/**
+ * @brief Sets the screen size below which a mesh switches from level i to level i + 1.
+ * @param level The finer of the two levels, 0 to MAX_LEVELS - 2.
+ * @param screenSize The threshold, as a fraction of half the viewport height.
+ */
+void LodPolicy::setThreshold(int level, float screenSize) {
+    if (level >= 0 && level < MAX_LEVELS - 1) {
+        thresholds[level] = screenSize;
+    }
+}
+
+/**
+ * @brief Returns the projected screen size of a box.
+ * @param bounds The world-space bounds; invalid bounds count as infinitely large.
+ * @param view The camera values of the frame.
+ * @return The projected radius as a fraction of half the viewport height.
+ */
+float LodPolicy::getScreenSize(const AABB& bounds, const LodView& view) {
+    if (!bounds.isValid()) {
+        return FLT_MAX;
+    }
+    const float radius = glm::length(bounds.getExtents());
+    if (!view.perspective) {
+        return radius * view.projectionScale;
+    }
+    const float distance = glm::length(bounds.getCenter() - view.viewPosition);
+    return radius * view.projectionScale / std::max(distance, 0.0001f);
+}
+
+/**
+ * @brief Selects the level of detail for a screen size.
+ * @param screenSize The projected size from getScreenSize.
+ * @param levelCount The number of levels the mesh has, 1 to MAX_LEVELS.
+ * @param previousLevel The level selected last frame, levelCount if culled, or LEVEL_UNKNOWN.
+ * @param bias The global LOD bias.
+ * @return The level to draw, or levelCount when the mesh is too small to draw.
+ */
+int LodPolicy::selectLevel(float screenSize, int levelCount, unsigned char previousLevel, float bias) const {
+    const float size = screenSize * std::exp2(-bias);
+
+    // Boundary i separates level i from level i + 1; the last one separates the coarsest level from nothing
+    int level = 0;
+    for (int boundary = 0; boundary < levelCount; boundary++) {
+        float threshold = boundary == levelCount - 1 ? cullScreenSize : thresholds[boundary];
+        if (previousLevel != LEVEL_UNKNOWN) {
+            // Stay on the side of the boundary the mesh was on unless it moved past the band
+            threshold *= previousLevel > boundary ? 1.0f + hysteresis : 1.0f - hysteresis;
+        }
+        if (size >= threshold) {
+            break;
+        }
+        level++;
+    }
+    return level;
+}
+
+/**
+ * @brief Feeds one frame time to the controller and adjusts the bias.
+ * @param frameTime The duration of the last frame, in seconds.
+ */
+void LodBiasController::update(float frameTime) {
+    smoothedFrameTime += (frameTime - smoothedFrameTime) * SMOOTHING;
+    if (!enabled) {
+        return;
+    }
+    if (smoothedFrameTime > budget * OVER_BUDGET) {
+        bias = std::min(bias + BIAS_STEP, MAX_BIAS);
+    }
+    else if (smoothedFrameTime < budget * UNDER_BUDGET) {
+        bias = std::max(bias - BIAS_STEP, 0.0f);
+    }
+}
+
+/**
+ * @brief Enables or disables the adjustment; a disabled controller returns to a bias of 0.
+ */
+void LodBiasController::setEnabled(bool enable) {
+    enabled = enable;
+    if (!enabled) {
+        bias = 0.0f;
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * @file LodPolicy.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the LodPolicy class, which selects a level of detail from the
+ * projected screen size of a mesh, and of the LodBiasController class, which tunes the global LOD bias
+ * to a frame-time budget.
+ */
+
+#ifndef LODPOLICY_H
+#define LODPOLICY_H
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+/**
+ * @struct LodView
+ * @brief The camera values a frame selects its levels of detail with.
+ */
+struct LodView
+{
+    glm::vec3 viewPosition = glm::vec3(0.0f); // Camera position
+    float projectionScale = 1.0f;             // projection[1][1]: cot(fov / 2) in perspective, 1 / half height in ortho
+    bool perspective = true;                  // Screen size shrinks with distance when true
+    float bias = 0.0f;                        // Positive values select coarser levels
+};
+
+/**
+ * @class LodPolicy
+ * @brief Selects one of up to MAX_LEVELS meshes by projected screen size, with hysteresis.
+ *
+ * The screen size of a mesh is the radius of its bounds projected to the screen, as a fraction of
+ * half the viewport height. Level i is drawn while the screen size is at least threshold i, and
+ * the mesh is not drawn at all once it is smaller than the cull size. To cross a threshold, the
+ * screen size must move past it by the hysteresis band, so a mesh sitting on a threshold keeps its
+ * level instead of switching every frame. The bias scales every screen size by 2^-bias.
+ */
+class LodPolicy
+{
+public:
+    static const int MAX_LEVELS = 4;                   // Most levels a mesh can have
+    static const unsigned char LEVEL_UNKNOWN = 0xFF;   // No level selected yet, so no hysteresis applies
+
+    LodPolicy();
+
+    /**
+     * @brief Sets the screen size below which a mesh switches from level i to level i + 1.
+     * @param level The finer of the two levels, 0 to MAX_LEVELS - 2.
+     * @param screenSize The threshold, as a fraction of half the viewport height.
+     */
+    void setThreshold(int level, float screenSize);
+
+    /**
+     * @brief Sets the screen size below which a mesh is not drawn.
+     * @param screenSize The cull size, as a fraction of half the viewport height.
+     */
+    void setCullScreenSize(float screenSize) { cullScreenSize = screenSize; }
+
+    /**
+     * @brief Sets the width of the hysteresis band around every threshold.
+     * @param band The band as a fraction of the threshold, for example 0.1 for 10%.
+     */
+    void setHysteresis(float band) { hysteresis = band; }
+
+    /**
+     * @brief Returns the projected screen size of a box.
+     * @param bounds The world-space bounds; invalid bounds count as infinitely large.
+     * @param view The camera values of the frame.
+     * @return The projected radius as a fraction of half the viewport height.
+     */
+    static float getScreenSize(const AABB& bounds, const LodView& view);
+
+    /**
+     * @brief Selects the level of detail for a screen size.
+     * @param screenSize The projected size from getScreenSize.
+     * @param levelCount The number of levels the mesh has, 1 to MAX_LEVELS.
+     * @param previousLevel The level selected last frame, levelCount if culled, or LEVEL_UNKNOWN.
+     * @param bias The global LOD bias.
+     * @return The level to draw, or levelCount when the mesh is too small to draw.
+     */
+    int selectLevel(float screenSize, int levelCount, unsigned char previousLevel, float bias) const;
+
+private:
+    float thresholds[MAX_LEVELS - 1];  // Screen size at which level i gives way to level i + 1
+    float cullScreenSize;              // Screen size at which the coarsest level gives way to nothing
+    float hysteresis;                  // Band around each threshold, as a fraction of it
+};
+
+/**
+ * @class LodBiasController
+ * @brief Raises the LOD bias while frames take longer than the budget and lowers it when they are well under.
+ */
+class LodBiasController
+{
+public:
+    /**
+     * @brief Constructor for the LodBiasController class.
+     * @param frameBudget The frame time to stay under, in seconds.
+     */
+    explicit LodBiasController(float frameBudget) : budget(frameBudget), smoothedFrameTime(frameBudget) {}
+
+    /**
+     * @brief Feeds one frame time to the controller and adjusts the bias.
+     * @param frameTime The duration of the last frame, in seconds.
+     */
+    void update(float frameTime);
+
+    /**
+     * @brief Enables or disables the adjustment; a disabled controller returns to a bias of 0.
+     */
+    void setEnabled(bool enable);
+
+    bool isEnabled() const { return enabled; }
+
+    /**
+     * @brief Returns the current bias.
+     */
+    float getBias() const { return bias; }
+
+private:
+    float budget;               // Target frame time, in seconds
+    float smoothedFrameTime;    // Exponential moving average of the frame time
+    float bias = 0.0f;
+    bool enabled = true;
+};
+#endif // LODPOLICY_H
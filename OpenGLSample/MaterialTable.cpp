@@ -0,0 +1,107 @@
+/**
+ * @file MaterialTable.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the MaterialTable class.
+ */
+
+#include "MaterialTable.h"
+#include <algorithm>
+#include <iostream>
+
+const int MaterialTable::NO_MATERIAL;
+
+/**
+ * @brief Returns the id of a material, adding it the first time it is seen.
+ * @param diffuseTexture The texture bound to GL_TEXTURE0, or 0.
+ * @param specularTexture The texture bound to GL_TEXTURE1, or 0.
+ * @param overlayTexture The texture bound to GL_TEXTURE2, or 0.
+ * @param shininess The specular exponent.
+ * @param uvScale The texture coordinate scale.
+ * @return The material id, or 0 when the table is full.
+ */
+unsigned short MaterialTable::getMaterialId(GLuint diffuseTexture, GLuint specularTexture, GLuint overlayTexture, float shininess, glm::vec2 uvScale) {
+    Key key(diffuseTexture, specularTexture, overlayTexture, shininess, uvScale.x, uvScale.y);
+    std::map<Key, unsigned short>::const_iterator found = ids.find(key);
+    if (found != ids.end()) {
+        return found->second;
+    }
+    if (entries.size() == MAX_MATERIALS) {
+        std::cout << "ERROR::MATERIALTABLE::FULL" << std::endl;
+        return 0;
+    }
+
+    unsigned short id = static_cast<unsigned short>(entries.size());
+    Entry entry = { diffuseTexture, specularTexture, overlayTexture, false };
+    entries.push_back(entry);
+    ids[key] = id;
+
+    MaterialBlock& material = block.materials[id];
+    material.uvScale = uvScale;
+    material.shininess = shininess;
+    material.layers = glm::ivec4(0);
+    markDirty(id);
+    return id;
+}
+
+/**
+ * @brief Resolves the texture layers of the new entries and uploads the entries that changed.
+ *
+ * Creates the uniform buffer on first use. The layers are resolved again when the array changes.
+ *
+ * @param textureArray The array the layers come from, or nullptr to leave the layers as they are.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void MaterialTable::upload(TextureArray* textureArray, GLStateCache& stateCache) {
+    if (!bufferCreated) {
+        buffer.create(sizeof(MaterialsBlock), MATERIALS_BLOCK_BINDING);
+        bufferCreated = true;
+    }
+
+    if (textureArray != nullptr) {
+        if (textureArray != layersArray) {
+            for (Entry& entry : entries) {
+                entry.layersResolved = false;
+            }
+            layersArray = textureArray;
+        }
+        for (size_t i = 0; i < entries.size(); i++) {
+            Entry& entry = entries[i];
+            if (entry.layersResolved) {
+                continue;
+            }
+            block.materials[i].layers = textureArray->getLayers(entry.diffuseTexture, entry.specularTexture, entry.overlayTexture, stateCache);
+            entry.layersResolved = true;
+            markDirty(i);
+        }
+    }
+
+    if (dirtyBegin < dirtyEnd) {
+        buffer.update(static_cast<GLintptr>(dirtyBegin * sizeof(MaterialBlock)),
+            static_cast<GLsizeiptr>((dirtyEnd - dirtyBegin) * sizeof(MaterialBlock)), &block.materials[dirtyBegin]);
+        dirtyBegin = 0;
+        dirtyEnd = 0;
+    }
+}
+
+/**
+ * @brief Releases the uniform buffer.
+ */
+void MaterialTable::destroy() {
+    buffer.destroy();
+    bufferCreated = false;
+}
+
+/**
+ * @brief Adds an entry to the range uploaded next.
+ */
+void MaterialTable::markDirty(size_t index) {
+    if (dirtyBegin == dirtyEnd) {
+        dirtyBegin = index;
+        dirtyEnd = index + 1;
+        return;
+    }
+    dirtyBegin = std::min(dirtyBegin, index);
+    dirtyEnd = std::max(dirtyEnd, index + 1);
+}
@@ -0,0 +1,95 @@
+/**
+ * @file MaterialTable.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the MaterialTable class, which keeps every material of the
+ * recorded draws in the Materials uniform block so that a draw selects its material with an index.
+ */
+
+#ifndef MATERIALTABLE_H
+#define MATERIALTABLE_H
+
+#include <map>
+#include <tuple>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "UniformBuffer.h"
+#include "TextureArray.h"
+#include "GLStateCache.h"
+
+/**
+ * @class MaterialTable
+ * @brief The distinct materials of the scene, mirrored into the Materials uniform block.
+ *
+ * A material is a texture set with its shininess and texture coordinate scale. Each distinct one gets
+ * an id the first time it is seen, and draws pass that id instead of setting material uniforms, so
+ * draws of different materials can share a batch. With a TextureArray the entries also hold the
+ * layers of their textures. Only the entries that changed since the last upload are sent.
+ */
+class MaterialTable
+{
+public:
+    // Material id of a draw that reads the material uniforms instead of the table
+    static const int NO_MATERIAL = -1;
+
+    /**
+     * @brief Returns the id of a material, adding it the first time it is seen.
+     * @param diffuseTexture The texture bound to GL_TEXTURE0, or 0.
+     * @param specularTexture The texture bound to GL_TEXTURE1, or 0.
+     * @param overlayTexture The texture bound to GL_TEXTURE2, or 0.
+     * @param shininess The specular exponent.
+     * @param uvScale The texture coordinate scale.
+     * @return The material id, or 0 when the table is full.
+     */
+    unsigned short getMaterialId(GLuint diffuseTexture, GLuint specularTexture, GLuint overlayTexture, float shininess, glm::vec2 uvScale);
+
+    /**
+     * @brief Resolves the texture layers of the new entries and uploads the entries that changed.
+     *
+     * Creates the uniform buffer on first use. The layers are resolved again when the array changes.
+     *
+     * @param textureArray The array the layers come from, or nullptr to leave the layers as they are.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void upload(TextureArray* textureArray, GLStateCache& stateCache);
+
+    /**
+     * @brief Returns the number of materials in the table.
+     */
+    size_t size() const { return entries.size(); }
+
+    /**
+     * @brief Releases the uniform buffer.
+     */
+    void destroy();
+
+private:
+    // The textures of an entry, kept to resolve its layers
+    struct Entry
+    {
+        GLuint diffuseTexture;
+        GLuint specularTexture;
+        GLuint overlayTexture;
+        bool layersResolved;
+    };
+
+    typedef std::tuple<GLuint, GLuint, GLuint, float, float, float> Key;
+
+    std::map<Key, unsigned short> ids;
+    std::vector<Entry> entries;
+    MaterialsBlock block = {};
+    UniformBuffer buffer;
+    bool bufferCreated = false;
+    TextureArray* layersArray = nullptr;    // Array the resolved layers belong to
+    size_t dirtyBegin = 0;                  // Range of entries changed since the last upload
+    size_t dirtyEnd = 0;
+
+    /**
+     * @brief Adds an entry to the range uploaded next.
+     */
+    void markDirty(size_t index);
+};
+#endif // MATERIALTABLE_H
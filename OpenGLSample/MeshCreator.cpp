@@ -7,16 +7,80 @@
  */
 
 #include "MeshCreator.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 #include <glm/gtx/transform.hpp> // pi
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <map>
 #include <vector>
 #include <iostream>
 
+const GLuint MeshCreator::FLOATS_PER_VERTEX_TOTAL;
+
+namespace
+{
+    // 16-byte vertex of VertexFormat::Compact
+    struct CompactVertex
+    {
+        GLushort position[4]; // Half floats, the fourth is padding
+        GLuint normal;        // Signed normalized 10:10:10:2, w unused
+        GLushort uv[2];       // Unsigned normalized
+    };
+
+    // Largest error a half float position may have before the compact format is rejected
+    const float POSITION_TOLERANCE = 1e-3f;
+
+    /**
+     * @brief Packs interleaved float vertices into the compact format.
+     * @param vertices The vertices, 8 floats each.
+     * @param packed Receives one compact vertex per vertex.
+     * @return False when a position does not fit a half float within POSITION_TOLERANCE or a texture
+     * coordinate lies outside [0, 1].
+     */
+    bool packCompactVertices(const std::vector<GLfloat>& vertices, std::vector<CompactVertex>& packed)
+    {
+        const size_t vertexCount = vertices.size() / MeshCreator::FLOATS_PER_VERTEX_TOTAL;
+        packed.resize(vertexCount);
+
+        for (size_t v = 0; v < vertexCount; v++) {
+            const GLfloat* p = &vertices[v * MeshCreator::FLOATS_PER_VERTEX_TOTAL];
+            CompactVertex& vertex = packed[v];
+
+            for (int axis = 0; axis < 3; axis++) {
+                vertex.position[axis] = glm::packHalf1x16(p[axis]);
+                if (std::abs(glm::unpackHalf1x16(vertex.position[axis]) - p[axis]) > POSITION_TOLERANCE)
+                    return false;
+            }
+            vertex.position[3] = 0;
+
+            if (p[6] < 0.0f || p[6] > 1.0f || p[7] < 0.0f || p[7] > 1.0f)
+                return false;
+            const GLuint uv = glm::packUnorm2x16(glm::vec2(p[6], p[7]));
+            vertex.uv[0] = static_cast<GLushort>(uv & 0xFFFF);
+            vertex.uv[1] = static_cast<GLushort>(uv >> 16);
+
+            // Zero normals, from padded vertices, stay zero
+            glm::vec3 normal(p[3], p[4], p[5]);
+            const float length = glm::length(normal);
+            if (length > 0.0f)
+                normal /= length;
+            vertex.normal = glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f));
+        }
+        return true;
+    }
+}
+
 /**
  * @brief Creates mesh data for various shapes.
  *
  * This method initializes mesh data for a variety of shapes by calling specific mesh creation functions.
- * Each function populates the corresponding GLMesh object with vertex data and other necessary information.
+ * Each function stages its vertices and indices and sets the corresponding GLMesh object's range; the
+ * staged data is then uploaded into the shared buffers at once.
  */
 void MeshCreator::createMeshes()
 {
@@ -32,39 +96,55 @@ void MeshCreator::createMeshes()
     makeTorusMesh(gLowTorusMesh, 15, 15);
     makeConeMesh(gConeMesh);
     makeSkyboxMesh(gSkyboxMesh);
+
+    // Generated levels continue below the hand-written low variants. The cube and pyramids are a
+    // dozen triangles each and the plane is two, so they have nothing to remove.
+    generateLods(gLowCylinderMesh);
+    generateLods(gLowSphereMesh);
+    generateLods(gLowTorusMesh);
+    generateLods(gConeMesh);
+
+    uploadSharedBuffers();
+    printCacheReport();
 }
 
 /**
  * @brief Releases all mesh data.
  *
- * This method calls the `destroyMesh` function for each mesh in the MeshCreator class, freeing the resources allocated for each mesh.
+ * This method deletes the shared vertex array and buffers and clears the handles of every mesh, including the generated levels of detail.
  *
  * @note This method should be called to ensure proper cleanup of all mesh resources.
  */
 void MeshCreator::destroyMeshes() 
 {
-    destroyMesh(gPlaneMesh);
-    destroyMesh(gPyramidMesh);
-    destroyMesh(gFrustumPyramidMesh);
-    destroyMesh(gCylinderMesh);
-    destroyMesh(gCubeMesh);
-    destroyMesh(gSphereMesh);
-    destroyMesh(gLowSphereMesh);
-    destroyMesh(gTorusMesh);
-    destroyMesh(gConeMesh);
-    destroyMesh(gSkyboxMesh);
+    glDeleteVertexArrays(1, &sharedVao);
+    glDeleteBuffers(2, sharedVbos);
+    sharedVao = 0;
+    sharedVbos[0] = 0;
+    sharedVbos[1] = 0;
+    sharedBufferBytes = 0;
+
+    for (GLMesh* mesh : sharedMeshes) {
+        mesh->vao = 0;
+        mesh->vbos[0] = 0;
+        mesh->vbos[1] = 0;
+        mesh->coarser = nullptr;
+    }
+    sharedMeshes.clear();
+    generatedLods.clear();
+    cacheStats.clear();
 }
 
 /**
- * @brief Creates a plane mesh with vertices along the x-axis.
+ * @brief Returns the vertex and index data of the unit plane.
  *
- * This method initializes a plane mesh with specified vertex positions, normals, and texture coordinates.
+ * This is the same data uploaded by makePlaneMesh, for code that bakes planes into its own buffers.
  *
- * @param mesh A reference to the GLMesh object that will be initialized with the plane mesh data.
+ * @return The plane's interleaved vertices and triangle indices.
  */
-void MeshCreator::makePlaneMesh(GLMesh& mesh) {
+MeshCreator::MeshData MeshCreator::getPlaneData() {
     // Specifies Normalized Device Coordinates (x,y,z) for plane vertices
-    GLfloat verts[] = {
+    const GLfloat verts[] = {
         // Vertex Positions   // Normals           // Texture
          0.5f, 0.0f, -0.5f,   0.0f, 1.0f,  0.0f,   1.0f, 1.0f, // Back Right,   index 0
          0.5f, 0.0f,  0.5f,   0.0f, 1.0f,  0.0f,   1.0f, 0.0f, // Front Right,  index 1
@@ -72,38 +152,69 @@ void MeshCreator::makePlaneMesh(GLMesh& mesh) {
         -0.5f, 0.0f, -0.5f,   0.0f, 1.0f,  0.0f,   0.0f, 1.0f, // Back Left,    index 3
     };
 
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerUV = 2;
-
-    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-    glBindVertexArray(mesh.vao);
-
-    // Create 2 buffers: first one for the vertex data; second one for the indices
-    glGenBuffers(2, mesh.vbos);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
     // Data for the indices
-    GLushort indices[] = { 0, 1, 3,  // Triangle 1
-                           1, 2, 3   // Triangle 2
+    const GLushort indices[] = { 0, 1, 3,  // Triangle 1
+                                 1, 2, 3   // Triangle 2
     };
-    mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-    // Strides between vertex coordinates
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
+    MeshData plane;
+    plane.vertices.assign(verts, verts + sizeof(verts) / sizeof(verts[0]));
+    plane.indices.assign(indices, indices + sizeof(indices) / sizeof(indices[0]));
+    return plane;
+}
 
-    // Create Vertex Attribute Pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
+/**
+ * @brief Generates a chain of coarser levels of detail for a staged mesh.
+ *
+ * The mesh's staged vertices and indices are simplified with MeshSimplifier, halving the
+ * triangle count per level while the surface moves by less than a fraction of the mesh size.
+ * Each level is staged, linked from the previous one through GLMesh::coarser and owned by the
+ * MeshCreator. The chain stops early when a level would save too little to be worth a draw.
+ * Must be called before the shared buffers are uploaded.
+ *
+ * @param mesh A mesh added to the shared buffers.
+ */
+void MeshCreator::generateLods(GLMesh& mesh) {
+    const int MAX_GENERATED_LEVELS = 2;
+    const size_t MIN_TRIANGLES = 8;          // Smaller meshes are not simplified further
+    const float MIN_REDUCTION = 0.75f;       // A level must keep at most this share of the previous level's triangles
+    const float LEVEL_ERROR[MAX_GENERATED_LEVELS] = { 0.02f, 0.05f }; // Allowed surface error, as a share of the mesh diagonal
+
+    MeshData data = getMeshData(mesh);
+    const float size = mesh.bounds.isValid() ? glm::length(mesh.bounds.max - mesh.bounds.min) : 0.0f;
+
+    GLMesh* previous = &mesh;
+    for (int level = 0; level < MAX_GENERATED_LEVELS; level++) {
+        const size_t triangleCount = data.indices.size() / 3;
+        if (triangleCount < MIN_TRIANGLES) {
+            break;
+        }
+        MeshData simplified = MeshSimplifier::simplify(data, triangleCount / 2, size * LEVEL_ERROR[level]);
+        const size_t simplifiedCount = simplified.indices.size() / 3;
+        if (simplifiedCount == 0 || simplifiedCount > triangleCount * MIN_REDUCTION) {
+            break;
+        }
 
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerNormal));
-    glEnableVertexAttribArray(1);
+        std::unique_ptr<GLMesh> lod(new GLMesh());
+        addMesh(*lod, simplified);
+        previous->coarser = lod.get();
+        previous = lod.get();
+        generatedLods.push_back(std::move(lod));
+        data = std::move(simplified);
+    }
+}
 
-    glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
+/**
+ * @brief Creates a plane mesh with vertices along the x-axis.
+ *
+ * This method initializes a plane mesh with specified vertex positions, normals, and texture coordinates.
+ *
+ * @param mesh A reference to the GLMesh object that will be initialized with the plane mesh data.
+ */
+void MeshCreator::makePlaneMesh(GLMesh& mesh) {
+    MeshData plane = getPlaneData();
+
+    addMesh(mesh, plane);
 }
 
 /**
@@ -147,33 +258,7 @@ void MeshCreator::makePyramidMesh(GLMesh& mesh)
 		0.0f,   0.5f,  0.0f,  -1.0f,  0.0f,  0.0f,  0.5f, 1.0f,  // Top Vertex
 	};
 
-	const GLuint floatsPerVertex = 3;
-	const GLuint floatsPerNormal = 3;
-	const GLuint floatsPerUV = 2;
-
-	mesh.nVertices = sizeof(vertices) / (sizeof(vertices[0]) * (floatsPerVertex + floatsPerNormal + floatsPerUV));
-
-	glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(mesh.vao);
-
-	// Create VBO
-	glGenBuffers(1, mesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	// Strides between vertex coordinates
-	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerNormal));
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-	glEnableVertexAttribArray(2);
-
+	addUnindexedMesh(mesh, vertices, sizeof(vertices) / sizeof(vertices[0]), 8);
 }
 
  /**
@@ -240,32 +325,7 @@ void MeshCreator::makeFrustumPyramidMesh(GLMesh& mesh)
 
     };
 
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerUV = 2;
-
-    mesh.nVertices = sizeof(vertices) / (sizeof(vertices[0]) * (floatsPerVertex + floatsPerNormal + floatsPerUV));
-
-    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-    glBindVertexArray(mesh.vao);
-
-    // Create VBO
-    glGenBuffers(1, mesh.vbos);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-    // Strides between vertex coordinates
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-    // Create Vertex Attribute Pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerNormal));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
+    addUnindexedMesh(mesh, vertices, sizeof(vertices) / sizeof(vertices[0]), 8);
 }
 
 /**
@@ -468,34 +528,7 @@ void MeshCreator::makeCylinderMesh(GLMesh& mesh)
     // Fill the verts and indices arrays with data
     makePrism(verts, indices, NUM_SIDES, 0.25f, 1.0f);
 
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerUV = 2;
-
-    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-    glBindVertexArray(mesh.vao);
-
-    // Create 2 buffers: first one for the vertex data; second one for the indices
-    glGenBuffers(2, mesh.vbos);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-    mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // Strides between vertex coordinates
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-    // Create Vertex Attribute Pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerNormal));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
+    addMesh(mesh, verts, sizeof(verts) / sizeof(verts[0]), indices, sizeof(indices) / sizeof(indices[0]));
 }
 
 /**
@@ -537,34 +570,7 @@ void MeshCreator::makeLowCylinderMesh(GLMesh& mesh)
     // Fill the verts and indices arrays with data
     makePrism(verts, indices, NUM_SIDES, 0.25f, 1.0f);
 
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerUV = 2;
-
-    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-    glBindVertexArray(mesh.vao);
-
-    // Create 2 buffers: first one for the vertex data; second one for the indices
-    glGenBuffers(2, mesh.vbos);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-    mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // Strides between vertex coordinates
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-    // Create Vertex Attribute Pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerNormal));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
+    addMesh(mesh, verts, sizeof(verts) / sizeof(verts[0]), indices, sizeof(indices) / sizeof(indices[0]));
 }
 
 /**
@@ -631,32 +637,7 @@ void MeshCreator::makeCubeMesh(GLMesh& mesh)
        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.2f, 0.1f
     };
 
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerUV = 2;
-
-    mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (floatsPerVertex + floatsPerNormal + floatsPerUV));
-
-    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-    glBindVertexArray(mesh.vao);
-
-    // Create 2 buffers: first one for the vertex data; second one for the indices
-    glGenBuffers(1, mesh.vbos);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-    // Strides between vertex coordinates is 8. A tightly packed stride is 0.
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);// The number of floats before each
-
-    // Create Vertex Attribute Pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerVertex));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
+    addUnindexedMesh(mesh, verts, sizeof(verts) / sizeof(verts[0]), 8);
 }
 
 /**
@@ -742,34 +723,7 @@ void MeshCreator::makeSphereMesh(GLMesh& mesh)
         }
     }
 
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerUV = 2;
-
-    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-    glBindVertexArray(mesh.vao);
-
-    // Create 2 buffers: first one for the vertex data; second one for the indices
-    glGenBuffers(2, mesh.vbos);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-    mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // Strides between vertex coordinates
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-    // Create Vertex Attribute Pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerNormal));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
+    addMesh(mesh, verts, sizeof(verts) / sizeof(verts[0]), indices, sizeof(indices) / sizeof(indices[0]));
 }
 
 
@@ -856,34 +810,7 @@ void MeshCreator::makeLowSphereMesh(GLMesh& mesh)
         }
     }
 
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerUV = 2;
-
-    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-    glBindVertexArray(mesh.vao);
-
-    // Create 2 buffers: first one for the vertex data; second one for the indices
-    glGenBuffers(2, mesh.vbos);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-    mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // Strides between vertex coordinates
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
-
-    // Create Vertex Attribute Pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerNormal));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
+    addMesh(mesh, verts, sizeof(verts) / sizeof(verts[0]), indices, sizeof(indices) / sizeof(indices[0]));
 }
 
 /**
@@ -1033,34 +960,18 @@ void MeshCreator::makeTorusMesh(GLMesh& mesh, int main, int tube)
             normals_list.push_back(-normal);
         }
     }
-    // Total float values per each type 
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-
-    // Store vertex and index count 
-    mesh.nVertices = vertex_list.size();
-    mesh.nIndices = 0;
-
-    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-    glBindVertexArray(mesh.vao);
-
-    // Create 2 buffers: first one for the vertex data;
-    glGenBuffers(2, mesh.vbos);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, vertex_list.size() * sizeof(glm::vec3), &vertex_list[0], GL_STATIC_DRAW);
-
-    // Strides between vertex coordinates is 3. A tightly packed stride is 0.
-    GLint stride = sizeof(float) * (floatsPerVertex);// The number of floats before each
-
-    // Create Vertex Attribute Pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[1]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, normals_list.size() * sizeof(glm::vec3), &normals_list[0], GL_STATIC_DRAW);
-
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(1);
+    // Interleave the positions and normals; the torus has no texture coordinates
+    std::vector<GLfloat> verts;
+    verts.reserve(vertex_list.size() * FLOATS_PER_VERTEX_TOTAL);
+    for (size_t i = 0; i < vertex_list.size(); i++) {
+        const GLfloat vertex[FLOATS_PER_VERTEX_TOTAL] = {
+            vertex_list[i].x, vertex_list[i].y, vertex_list[i].z,
+            normals_list[i].x, normals_list[i].y, normals_list[i].z,
+            0.0f, 0.0f
+        };
+        verts.insert(verts.end(), vertex, vertex + FLOATS_PER_VERTEX_TOTAL);
+    }
+    addUnindexedMesh(mesh, verts.data(), verts.size(), FLOATS_PER_VERTEX_TOTAL);
 }
 
 /**
@@ -1167,35 +1078,8 @@ void MeshCreator::makeConeMesh(GLMesh& mesh) {
     indices[(3 * currentTriangle) + 0] = 0;
     indices[(3 * currentTriangle) + 1] = 2;
     indices[(3 * currentTriangle) + 2] = currentVertex - 1;
-    
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerUV = 2;
-
-    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-    glBindVertexArray(mesh.vao);
-
-    // Create 2 buffers: first one for the vertex data; second one for the indices
-    glGenBuffers(2, mesh.vbos);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-    mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // Strides between vertex coordinates
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
 
-    // Create Vertex Attribute Pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerNormal));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
+    addMesh(mesh, verts, sizeof(verts) / sizeof(verts[0]), indices, sizeof(indices) / sizeof(indices[0]));
 }
 
 /**
@@ -1251,36 +1135,256 @@ void MeshCreator::makeSkyboxMesh(GLMesh& mesh) {
         -1.0f, -1.0f,  1.0f,
          1.0f, -1.0f,  1.0f
     };
-    const GLuint floatsPerVertex = 3;
 
-    mesh.nVertices = sizeof(vertices) / (sizeof(vertices[0]) * (floatsPerVertex));
+    addUnindexedMesh(mesh, vertices, sizeof(vertices) / sizeof(vertices[0]), 3);
+}
 
-    glGenVertexArrays(1, &mesh.vao); // we can also generate multiple VAOs or buffers at the same time
-    glBindVertexArray(mesh.vao);
+/**
+ * @brief Computes the object-space bounds of a mesh from its vertex data.
+ *
+ * @param mesh A reference to the GLMesh object that receives the bounds.
+ * @param verts The vertex data, with the position in the first three floats of each vertex.
+ * @param floatCount The number of floats in verts.
+ * @param floatsPerVertexTotal The number of floats between the start of two vertices.
+ */
+void MeshCreator::computeBounds(GLMesh& mesh, const GLfloat* verts, size_t floatCount, GLuint floatsPerVertexTotal)
+{
+    mesh.bounds = AABB();
+    for (size_t i = 0; i + 3 <= floatCount; i += floatsPerVertexTotal) {
+        mesh.bounds.expand(glm::vec3(verts[i], verts[i + 1], verts[i + 2]));
+    }
+}
 
-    // Create VBO
-    glGenBuffers(1, mesh.vbos);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+/**
+ * @brief Appends an indexed mesh to the staged shared buffers.
+ * @param mesh A reference to the GLMesh object that receives the mesh's range.
+ * @param data The interleaved vertices, 8 floats each, and the triangle indices.
+ */
+void MeshCreator::addMesh(GLMesh& mesh, const MeshData& data)
+{
+    addMesh(mesh, data.vertices.data(), data.vertices.size(), data.indices.data(), data.indices.size());
+}
+
+/**
+ * @brief Appends an indexed mesh, given as arrays, to the staged shared buffers.
+ *
+ * The triangles are reordered for the vertex cache and the vertices for vertex fetch with
+ * MeshOptimizer, and the cache miss ratio before and after is kept for printCacheReport.
+ *
+ * @param mesh A reference to the GLMesh object that receives the mesh's range.
+ * @param verts The interleaved vertices, 8 floats each.
+ * @param floatCount The number of floats in verts.
+ * @param indices The triangle indices.
+ * @param indexCount The number of indices.
+ */
+void MeshCreator::addMesh(GLMesh& mesh, const GLfloat* verts, size_t floatCount, const GLushort* indices, size_t indexCount)
+{
+    if (sharedVao != 0) {
+        std::cout << "ERROR::MESHCREATOR::SHARED_BUFFERS_ALREADY_UPLOADED" << std::endl;
+        return;
+    }
+    MeshData data;
+    data.vertices.assign(verts, verts + floatCount);
+    data.indices.assign(indices, indices + indexCount);
+
+    const size_t vertexCount = floatCount / FLOATS_PER_VERTEX_TOTAL;
+    CacheStats stats;
+    stats.mesh = &mesh;
+    stats.acmrBefore = MeshOptimizer::computeAcmr(data.indices, vertexCount);
+    MeshOptimizer::optimizeVertexCache(data.indices, vertexCount);
+    if (MeshOptimizer::computeAcmr(data.indices, vertexCount) > stats.acmrBefore) {
+        // Already well ordered, e.g. strips around a cylinder
+        data.indices.assign(indices, indices + indexCount);
+    }
+    MeshOptimizer::optimizeVertexFetch(data);
+    stats.acmrAfter = MeshOptimizer::computeAcmr(data.indices, vertexCount);
+    cacheStats.push_back(stats);
+
+    mesh.baseVertex = static_cast<GLint>(sharedData.vertices.size() / FLOATS_PER_VERTEX_TOTAL);
+    mesh.firstIndex = static_cast<GLuint>(sharedData.indices.size());
+    mesh.nVertices = static_cast<GLuint>(vertexCount);
+    mesh.nIndices = static_cast<GLuint>(indexCount);
+    computeBounds(mesh, verts, floatCount, FLOATS_PER_VERTEX_TOTAL);
+
+    sharedData.vertices.insert(sharedData.vertices.end(), data.vertices.begin(), data.vertices.end());
+    sharedData.indices.insert(sharedData.indices.end(), data.indices.begin(), data.indices.end());
+    sharedMeshes.push_back(&mesh);
+}
+
+/**
+ * @brief Indexes a triangle list and appends it to the staged shared buffers.
+ *
+ * Identical vertices are merged. Vertices with fewer than 8 floats are padded with a zero
+ * normal and texture coordinate.
+ *
+ * @param mesh A reference to the GLMesh object that receives the mesh's range.
+ * @param verts The vertices, three per triangle.
+ * @param floatCount The number of floats in verts.
+ * @param floatsPerVertexTotal The number of floats between the start of two vertices.
+ */
+void MeshCreator::addUnindexedMesh(GLMesh& mesh, const GLfloat* verts, size_t floatCount, GLuint floatsPerVertexTotal)
+{
+    typedef std::array<GLfloat, FLOATS_PER_VERTEX_TOTAL> Vertex;
+    std::map<Vertex, GLushort> vertexIds;
+    MeshData data;
+
+    // Whole triangles only, as glDrawArrays would draw them
+    const size_t vertexCount = (floatCount / floatsPerVertexTotal) / 3 * 3;
+    const GLuint copiedFloats = std::min<GLuint>(floatsPerVertexTotal, FLOATS_PER_VERTEX_TOTAL);
+    for (size_t i = 0; i < vertexCount; i++) {
+        Vertex vertex = {};
+        std::copy(verts + i * floatsPerVertexTotal, verts + i * floatsPerVertexTotal + copiedFloats, vertex.begin());
+
+        std::map<Vertex, GLushort>::const_iterator found = vertexIds.find(vertex);
+        if (found != vertexIds.end()) {
+            data.indices.push_back(found->second);
+            continue;
+        }
+        GLushort id = static_cast<GLushort>(vertexIds.size());
+        vertexIds[vertex] = id;
+        data.vertices.insert(data.vertices.end(), vertex.begin(), vertex.end());
+        data.indices.push_back(id);
+    }
+    addMesh(mesh, data);
+}
+
+/**
+ * @brief Returns a copy of a staged mesh's vertices and indices.
+ * @param mesh A mesh added to the shared buffers.
+ * @return The mesh's interleaved vertices and triangle indices, relative to its first vertex.
+ */
+MeshCreator::MeshData MeshCreator::getMeshData(const GLMesh& mesh) const
+{
+    MeshData data;
+    if (sharedData.vertices.size() < (mesh.baseVertex + mesh.nVertices) * FLOATS_PER_VERTEX_TOTAL
+        || sharedData.indices.size() < mesh.firstIndex + mesh.nIndices) {
+        std::cout << "ERROR::MESHCREATOR::MESH_NOT_STAGED" << std::endl;
+        return data;
+    }
+    std::vector<GLfloat>::const_iterator firstVertex = sharedData.vertices.begin() + mesh.baseVertex * FLOATS_PER_VERTEX_TOTAL;
+    data.vertices.assign(firstVertex, firstVertex + mesh.nVertices * FLOATS_PER_VERTEX_TOTAL);
+    std::vector<GLushort>::const_iterator firstIndex = sharedData.indices.begin() + mesh.firstIndex;
+    data.indices.assign(firstIndex, firstIndex + mesh.nIndices);
+    return data;
+}
+
+/**
+ * @brief Points attribute locations 0 to 2 of the bound VAO at a mesh's vertex buffer.
+ *
+ * Both layouts decode to the same vec3 position, vec3 normal and vec2 texture coordinate, so the
+ * shaders do not depend on the format.
+ *
+ * @param mesh The mesh whose vertex buffer and format are used.
+ */
+void MeshCreator::setVertexAttributes(const GLMesh& mesh)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]);
+
+    if (mesh.format == VertexFormat::Compact) {
+        const GLint stride = sizeof(CompactVertex);
+        glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(CompactVertex, position));
+        glEnableVertexAttribArray(0);
+
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(CompactVertex, normal));
+        glEnableVertexAttribArray(1);
+
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(CompactVertex, uv));
+        glEnableVertexAttribArray(2);
+        return;
+    }
+
+    const GLuint floatsPerVertex = 3;
+    const GLuint floatsPerNormal = 3;
+    const GLuint floatsPerUV = 2;
 
     // Strides between vertex coordinates
-    GLint stride = sizeof(float) * (floatsPerVertex);
+    GLint stride = sizeof(float) * FLOATS_PER_VERTEX_TOTAL;
 
     // Create Vertex Attribute Pointers
     glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
     glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * floatsPerVertex));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, floatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
+    glEnableVertexAttribArray(2);
 }
 
 /**
- * @brief Destroys a mesh by deleting its VAO and VBOs.
- *
- * This method frees the resources allocated for the mesh by deleting the Vertex Array Object (VAO) and Vertex Buffer Objects (VBOs).
- * It is important to call this method after the render loop exits to ensure proper cleanup of GPU resources.
+ * @brief Uploads the staged meshes into the shared buffers and points every mesh at them.
  *
- * @param mesh A reference to the GLMesh object whose resources will be freed.
+ * The vertices are packed into the requested format, falling back to floats when they do not fit it.
+ */
+void MeshCreator::uploadSharedBuffers()
+{
+    std::vector<CompactVertex> compactVertices;
+    uploadedFormat = requestedFormat;
+    if (uploadedFormat == VertexFormat::Compact && !packCompactVertices(sharedData.vertices, compactVertices)) {
+        std::cout << "ERROR::MESHCREATOR::COMPACT_VERTEX_RANGE a vertex does not fit the compact format, using float vertices" << std::endl;
+        uploadedFormat = VertexFormat::Float;
+    }
+
+    glGenVertexArrays(1, &sharedVao);
+    glBindVertexArray(sharedVao);
+
+    // Create 2 buffers: first one for the vertex data; second one for the indices
+    glGenBuffers(2, sharedVbos);
+    glBindBuffer(GL_ARRAY_BUFFER, sharedVbos[0]);
+    if (uploadedFormat == VertexFormat::Compact)
+        glBufferData(GL_ARRAY_BUFFER, compactVertices.size() * sizeof(CompactVertex), compactVertices.data(), GL_STATIC_DRAW);
+    else
+        glBufferData(GL_ARRAY_BUFFER, sharedData.vertices.size() * sizeof(GLfloat), sharedData.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedVbos[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sharedData.indices.size() * sizeof(GLushort), sharedData.indices.data(), GL_STATIC_DRAW);
+    sharedBufferBytes = sharedData.indices.size() * sizeof(GLushort)
+        + (uploadedFormat == VertexFormat::Compact ? compactVertices.size() * sizeof(CompactVertex) : sharedData.vertices.size() * sizeof(GLfloat));
+
+    for (GLMesh* mesh : sharedMeshes) {
+        mesh->vao = sharedVao;
+        mesh->vbos[0] = sharedVbos[0];
+        mesh->vbos[1] = sharedVbos[1];
+        mesh->format = uploadedFormat;
+    }
+
+    GLMesh layout;
+    layout.vbos[0] = sharedVbos[0];
+    layout.format = uploadedFormat;
+    setVertexAttributes(layout);
+
+    glBindVertexArray(0);
+
+    // The GPU holds the only copy from here on
+    sharedData = MeshData();
+}
+
+/**
+ * @brief Prints the cache miss ratio of every mesh before and after reordering.
  */
-void MeshCreator::destroyMesh(GLMesh& mesh)
+void MeshCreator::printCacheReport() const
 {
-    glDeleteVertexArrays(1, &mesh.vao);
-    glDeleteBuffers(2, mesh.vbos);
-}
\ No newline at end of file
+    const struct { const char* name; const GLMesh* mesh; } named[] = {
+        { "Plane", &gPlaneMesh }, { "Pyramid", &gPyramidMesh }, { "Frustum pyramid", &gFrustumPyramidMesh },
+        { "Cylinder", &gCylinderMesh }, { "Low cylinder", &gLowCylinderMesh }, { "Cube", &gCubeMesh },
+        { "Sphere", &gSphereMesh }, { "Low sphere", &gLowSphereMesh }, { "Torus", &gTorusMesh },
+        { "Low torus", &gLowTorusMesh }, { "Cone", &gConeMesh }, { "Skybox", &gSkyboxMesh }
+    };
+
+    std::cout << "Vertex cache ACMR (FIFO " << MeshOptimizer::ACMR_CACHE_SIZE << "), before -> after:" << std::endl;
+    for (const auto& entry : named) {
+        // Each mesh is followed by its generated levels of detail
+        int level = 0;
+        for (const GLMesh* mesh = entry.mesh; mesh != nullptr; mesh = mesh->coarser, level++) {
+            for (const CacheStats& stats : cacheStats) {
+                if (stats.mesh != mesh) {
+                    continue;
+                }
+                std::cout << "  " << entry.name;
+                if (level > 0) {
+                    std::cout << " LOD " << level;
+                }
+                std::cout << ": " << stats.acmrBefore << " -> " << stats.acmrAfter << " (" << mesh->nIndices / 3 << " triangles)" << std::endl;
+            }
+        }
+    }
+}
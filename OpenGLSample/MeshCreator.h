@@ -10,27 +10,61 @@
 #define MESHCREATOR_H
 
 #include <glad/glad.h>
+#include <memory>
+#include <vector>
+
+#include "Bounds.h"
 
 /**
  * @class MeshCreator
  * @brief This class is responsible for creating and managing mesh data for various 3D shapes.
  *
  * The MeshCreator class provides methods to create and destroy mesh data for different 3D shapes, including primitives and a frustum pyramid.
+ *
+ * Every mesh is stored in one interleaved vertex buffer and one index buffer, shared through a single
+ * VAO. A mesh is a range of that index buffer plus a base vertex, and is drawn with glDrawElementsBaseVertex.
  */
 class MeshCreator
 {
 
 public:
 
+    // Layout of the vertices in the shared vertex buffer
+    enum class VertexFormat
+    {
+        Float,   // 32 bytes: float position, normal and texture coordinate
+        Compact  // 16 bytes: half float position, 10:10:10:2 normal, 16-bit normalized texture coordinate
+    };
+
     // Stores the GL data relative to a given mesh
     struct GLMesh
     {
-        GLuint vao;         // Handle for the vertex array object
-        GLuint vbos[2];     // Handles for the vertex buffer objects
-        GLuint nVertices;	// Number of vertices for the mesh
-        GLuint nIndices;    // Number of indices of the mesh
+        GLuint vao = 0;                 // Handle for the shared vertex array object
+        GLuint vbos[2] = { 0, 0 };      // Handles for the shared vertex and index buffers
+        GLuint nVertices = 0;           // Number of vertices for the mesh
+        GLuint nIndices = 0;            // Number of indices of the mesh
+        GLuint firstIndex = 0;          // First index of the mesh in the shared index buffer
+        GLint baseVertex = 0;           // Added to every index of the mesh
+        AABB bounds;                    // Object-space bounds of the vertex positions
+        const GLMesh* coarser = nullptr; // Next generated level of detail, or nullptr
+        VertexFormat format = VertexFormat::Float; // Layout of the shared vertex buffer
 
+        /**
+         * @brief Returns the byte offset of the first index, for the indices argument of the draw calls.
+         */
+        const void* getIndexOffset() const { return (void*)(firstIndex * sizeof(GLushort)); }
+    };
+
+    // Floats per vertex of every mesh: position, normal, texture coordinate
+    static const GLuint FLOATS_PER_VERTEX_TOTAL = 8;
+
+    // CPU copy of an indexed mesh, 8 floats per vertex (position, normal, texture coordinate)
+    struct MeshData
+    {
+        std::vector<GLfloat> vertices;
+        std::vector<GLushort> indices;
     };
+
     GLMesh gPlaneMesh;
     GLMesh gPyramidMesh;
     GLMesh gFrustumPyramidMesh;
@@ -48,20 +82,100 @@ public:
      * @brief Creates mesh data for various shapes.
      *
      * This method initializes mesh data for a variety of shapes by calling specific mesh creation functions.
-     * Each function populates the corresponding GLMesh object with vertex data and other necessary information.
+     * Each function stages its vertices and indices and sets the corresponding GLMesh object's range; the
+     * staged data is then uploaded into the shared buffers at once.
      */
     void createMeshes();
 
     /**
      * @brief Releases all mesh data.
      *
-     * This method calls the `destroyMesh` function for each mesh in the MeshCreator class, freeing the resources allocated for each mesh.
+     * This method deletes the shared vertex array and buffers and clears the handles of every mesh, including the generated levels of detail.
      *
      * @note This method should be called to ensure proper cleanup of all mesh resources.
      */
     void destroyMeshes();
 
+    /**
+     * @brief Returns the vertex and index data of the unit plane.
+     *
+     * This is the same data uploaded by makePlaneMesh, for code that bakes planes into its own buffers.
+     *
+     * @return The plane's interleaved vertices and triangle indices.
+     */
+    static MeshData getPlaneData();
+
+    /**
+     * @brief Returns the vertex array object shared by every mesh.
+     */
+    GLuint getSharedVao() const { return sharedVao; }
+
+    /**
+     * @brief Returns the size of the shared vertex and index buffers in bytes.
+     */
+    size_t getBufferBytes() const { return sharedBufferBytes; }
+
+    /**
+     * @brief Selects the layout the meshes are uploaded with.
+     *
+     * Must be called before createMeshes. VertexFormat::Compact falls back to VertexFormat::Float
+     * when a position would lose too much precision as a half float or a texture coordinate lies
+     * outside [0, 1].
+     *
+     * @param format The requested layout.
+     */
+    void setVertexFormat(VertexFormat format) { requestedFormat = format; }
+
+    /**
+     * @brief Returns the layout the meshes were uploaded with.
+     */
+    VertexFormat getVertexFormat() const { return uploadedFormat; }
+
+    /**
+     * @brief Points attribute locations 0 to 2 of the bound VAO at a mesh's vertex buffer.
+     *
+     * Both layouts decode to the same vec3 position, vec3 normal and vec2 texture coordinate, so the
+     * shaders do not depend on the format.
+     *
+     * @param mesh The mesh whose vertex buffer and format are used.
+     */
+    static void setVertexAttributes(const GLMesh& mesh);
+
 private:
+    // Times the generators below without a GL context
+    friend class MicroBenchmarks;
+
+    std::vector<std::unique_ptr<GLMesh>> generatedLods; // Levels created by generateLods
+    std::vector<GLMesh*> sharedMeshes;                  // Every mesh placed in the shared buffers
+    MeshData sharedData;                                // Staged vertices and indices, released once uploaded
+
+    // Average cache miss ratio of a mesh before and after MeshOptimizer
+    struct CacheStats
+    {
+        const GLMesh* mesh;
+        float acmrBefore;
+        float acmrAfter;
+    };
+    std::vector<CacheStats> cacheStats;                 // One entry per mesh added
+    GLuint sharedVao = 0;
+    GLuint sharedVbos[2] = { 0, 0 };                    // Shared vertex and index buffers
+    size_t sharedBufferBytes = 0;                       // Size of both shared buffers
+    VertexFormat requestedFormat = VertexFormat::Compact;
+    VertexFormat uploadedFormat = VertexFormat::Float;
+
+    /**
+     * @brief Generates a chain of coarser levels of detail for a staged mesh.
+     *
+     * The mesh's staged vertices and indices are simplified with MeshSimplifier, halving the
+     * triangle count per level while the surface moves by less than a fraction of the mesh size.
+     * Each level is staged, linked from the previous one through GLMesh::coarser and owned by the
+     * MeshCreator. The chain stops early when a level would save too little to be worth a draw.
+     * Must be called before the shared buffers are uploaded.
+     *
+     * @param mesh A mesh added to the shared buffers.
+     */
+    void generateLods(GLMesh& mesh);
+
     /**
      * @brief Creates a plane mesh with vertices along the x-axis.
      *
@@ -199,13 +313,64 @@ private:
     void makeSkyboxMesh(GLMesh& mesh);
 
     /**
-     * @brief Destroys a mesh by deleting its VAO and VBOs.
+     * @brief Computes the object-space bounds of a mesh from its vertex data.
+     *
+     * @param mesh A reference to the GLMesh object that receives the bounds.
+     * @param verts The vertex data, with the position in the first three floats of each vertex.
+     * @param floatCount The number of floats in verts.
+     * @param floatsPerVertexTotal The number of floats between the start of two vertices.
+     */
+    static void computeBounds(GLMesh& mesh, const GLfloat* verts, size_t floatCount, GLuint floatsPerVertexTotal);
+
+    /**
+     * @brief Appends an indexed mesh to the staged shared buffers.
+     * @param mesh A reference to the GLMesh object that receives the mesh's range.
+     * @param data The interleaved vertices, 8 floats each, and the triangle indices.
+     */
+    void addMesh(GLMesh& mesh, const MeshData& data);
+
+    /**
+     * @brief Appends an indexed mesh, given as arrays, to the staged shared buffers.
+     *
+     * The triangles are reordered for the vertex cache and the vertices for vertex fetch with
+     * MeshOptimizer, and the cache miss ratio before and after is kept for printCacheReport.
+     *
+     * @param mesh A reference to the GLMesh object that receives the mesh's range.
+     * @param verts The interleaved vertices, 8 floats each.
+     * @param floatCount The number of floats in verts.
+     * @param indices The triangle indices.
+     * @param indexCount The number of indices.
+     */
+    void addMesh(GLMesh& mesh, const GLfloat* verts, size_t floatCount, const GLushort* indices, size_t indexCount);
+
+    /**
+     * @brief Indexes a triangle list and appends it to the staged shared buffers.
      *
-     * This method frees the resources allocated for the mesh by deleting the Vertex Array Object (VAO) and Vertex Buffer Objects (VBOs).
-     * It is important to call this method after the render loop exits to ensure proper cleanup of GPU resources.
+     * Identical vertices are merged. Vertices with fewer than 8 floats are padded with a zero
+     * normal and texture coordinate.
      *
-     * @param mesh A reference to the GLMesh object whose resources will be freed.
+     * @param mesh A reference to the GLMesh object that receives the mesh's range.
+     * @param verts The vertices, three per triangle.
+     * @param floatCount The number of floats in verts.
+     * @param floatsPerVertexTotal The number of floats between the start of two vertices.
+     */
+    void addUnindexedMesh(GLMesh& mesh, const GLfloat* verts, size_t floatCount, GLuint floatsPerVertexTotal);
+
+    /**
+     * @brief Returns a copy of a staged mesh's vertices and indices.
+     * @param mesh A mesh added to the shared buffers.
+     * @return The mesh's interleaved vertices and triangle indices, relative to its first vertex.
+     */
+    MeshData getMeshData(const GLMesh& mesh) const;
+
+    /**
+     * @brief Uploads the staged meshes into the shared buffers and points every mesh at them.
+     */
+    void uploadSharedBuffers();
+
+    /**
+     * @brief Prints the cache miss ratio of every mesh before and after reordering.
      */
-    void destroyMesh(GLMesh& mesh);
+    void printCacheReport() const;
 };
 #endif // MESHCREATOR_h
\ No newline at end of file
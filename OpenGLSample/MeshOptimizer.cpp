@@ -0,0 +1,238 @@
+/**
+ * @file MeshOptimizer.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the MeshOptimizer class.
+ */
+
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+const size_t MeshOptimizer::ACMR_CACHE_SIZE;
+
+namespace
+{
+    const GLuint FLOATS_PER_VERTEX = 8;      // Position, normal, texture coordinate
+    const int CACHE_SIZE = 32;               // Size of the LRU cache the triangle order is scored against
+    const float CACHE_DECAY_POWER = 1.5f;    // How quickly the score falls off further back in the cache
+    const float LAST_TRIANGLE_SCORE = 0.75f; // Score of the vertices of the last triangle added
+    const float VALENCE_BOOST_SCALE = 2.0f;  // Weight of the bonus for vertices with few triangles left
+    const float VALENCE_BOOST_POWER = 0.5f;
+    const uint32_t INVALID = 0xFFFFFFFFu;
+
+    /**
+     * @brief Returns how much adding a triangle that uses a vertex is worth.
+     * @param cachePosition The position of the vertex in the cache, or -1 when it is not cached.
+     * @param remainingTriangles The number of triangles that use the vertex and are not added yet.
+     */
+    float scoreVertex(int cachePosition, uint32_t remainingTriangles)
+    {
+        if (remainingTriangles == 0) {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                // The last triangle's vertices get a fixed score, so that strips do not always continue
+                // from the same edge
+                score = LAST_TRIANGLE_SCORE;
+            }
+            else {
+                const float scale = 1.0f / (CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+            }
+        }
+
+        // Finish off vertices with few triangles left, so that they leave the cache for good
+        score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+        return score;
+    }
+}
+
+/**
+ * @brief Reorders a mesh's triangles for the post-transform vertex cache.
+ * @param indices The triangle indices, reordered in place.
+ * @param vertexCount The number of vertices the indices refer to.
+ */
+void MeshOptimizer::optimizeVertexCache(std::vector<GLushort>& indices, size_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // Triangles of each vertex, as slices of one array. The first remainingTriangles[v] entries of a
+    // vertex's slice are the triangles not added yet.
+    std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        remainingTriangles[indices[i]]++;
+    }
+    std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) {
+        firstTriangle[v + 1] = firstTriangle[v] + remainingTriangles[v];
+    }
+    std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+    std::vector<uint32_t> filled(vertexCount, 0);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int corner = 0; corner < 3; corner++) {
+            const GLushort v = indices[t * 3 + corner];
+            vertexTriangles[firstTriangle[v] + filled[v]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        vertexScores[v] = scoreVertex(-1, remainingTriangles[v]);
+    }
+
+    std::vector<bool> added(triangleCount, false);
+    std::vector<float> triangleScores(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+    }
+
+    std::vector<GLushort> result;
+    result.reserve(triangleCount * 3);
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(CACHE_SIZE + 3);
+    newCache.reserve(CACHE_SIZE + 3);
+
+    uint32_t best = INVALID;
+    while (result.size() < triangleCount * 3) {
+        if (best == INVALID) {
+            // Nothing in the cache touches a remaining triangle; start again from the best one anywhere
+            float bestScore = -1.0f;
+            for (size_t t = 0; t < triangleCount; t++) {
+                if (!added[t] && triangleScores[t] > bestScore) {
+                    bestScore = triangleScores[t];
+                    best = static_cast<uint32_t>(t);
+                }
+            }
+        }
+
+        added[best] = true;
+        newCache.clear();
+        for (int corner = 0; corner < 3; corner++) {
+            const GLushort v = indices[best * 3 + corner];
+            result.push_back(v);
+            newCache.push_back(v);
+
+            // Swap the triangle out of the vertex's remaining slice
+            uint32_t* triangles = &vertexTriangles[firstTriangle[v]];
+            uint32_t& remaining = remainingTriangles[v];
+            for (uint32_t i = 0; i < remaining; i++) {
+                if (triangles[i] == best) {
+                    std::swap(triangles[i], triangles[remaining - 1]);
+                    break;
+                }
+            }
+            remaining--;
+        }
+
+        // The triangle's vertices move to the front; the rest keep their order
+        for (uint32_t v : cache) {
+            if (v != newCache[0] && v != newCache[1] && v != newCache[2]) {
+                newCache.push_back(v);
+            }
+        }
+        cache.swap(newCache);
+
+        best = INVALID;
+        float bestScore = -1.0f;
+        for (size_t position = 0; position < cache.size(); position++) {
+            const uint32_t v = cache[position];
+            cachePositions[v] = position < static_cast<size_t>(CACHE_SIZE) ? static_cast<int>(position) : -1;
+            vertexScores[v] = scoreVertex(cachePositions[v], remainingTriangles[v]);
+        }
+        for (size_t position = 0; position < cache.size(); position++) {
+            const uint32_t v = cache[position];
+            const uint32_t* triangles = &vertexTriangles[firstTriangle[v]];
+            for (uint32_t i = 0; i < remainingTriangles[v]; i++) {
+                const uint32_t t = triangles[i];
+                const float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+                if (position < static_cast<size_t>(CACHE_SIZE) && score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+        if (cache.size() > static_cast<size_t>(CACHE_SIZE)) {
+            cache.resize(CACHE_SIZE);
+        }
+    }
+
+    // Any trailing indices that do not form a triangle are kept as they were
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+/**
+ * @brief Reorders a mesh's vertices in the order its triangles first reference them.
+ *
+ * Vertices no triangle references are kept after the referenced ones.
+ *
+ * @param mesh The mesh to reorder, 8 floats per vertex. Its indices are remapped.
+ */
+void MeshOptimizer::optimizeVertexFetch(MeshCreator::MeshData& mesh)
+{
+    const size_t vertexCount = mesh.vertices.size() / FLOATS_PER_VERTEX;
+    std::vector<uint32_t> remap(vertexCount, INVALID);
+    std::vector<GLfloat> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    uint32_t next = 0;
+    for (GLushort& index : mesh.indices) {
+        if (remap[index] == INVALID) {
+            remap[index] = next++;
+            const GLfloat* vertex = &mesh.vertices[index * FLOATS_PER_VERTEX];
+            vertices.insert(vertices.end(), vertex, vertex + FLOATS_PER_VERTEX);
+        }
+        index = static_cast<GLushort>(remap[index]);
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (remap[v] == INVALID) {
+            const GLfloat* vertex = &mesh.vertices[v * FLOATS_PER_VERTEX];
+            vertices.insert(vertices.end(), vertex, vertex + FLOATS_PER_VERTEX);
+        }
+    }
+    mesh.vertices.swap(vertices);
+}
+
+/**
+ * @brief Returns the average cache miss ratio of a triangle list.
+ *
+ * Simulates a FIFO cache of ACMR_CACHE_SIZE vertices. The result is the number of vertices transformed
+ * per triangle: 3 when no vertex is reused, approaching 0.5 for a well ordered regular grid.
+ *
+ * @param indices The triangle indices.
+ * @param vertexCount The number of vertices the indices refer to.
+ * @return The number of cache misses divided by the number of triangles, or 0 for an empty mesh.
+ */
+float MeshOptimizer::computeAcmr(const std::vector<GLushort>& indices, size_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+
+    // A vertex is cached while fewer than ACMR_CACHE_SIZE misses happened since it was loaded
+    std::vector<size_t> loadedAt(vertexCount, 0);
+    std::vector<bool> loaded(vertexCount, false);
+    size_t misses = 0;
+    for (size_t i = 0; i < triangleCount * 3; i++) {
+        const GLushort v = indices[i];
+        if (!loaded[v] || misses - loadedAt[v] > ACMR_CACHE_SIZE) {
+            loaded[v] = true;
+            loadedAt[v] = misses;
+            misses++;
+        }
+    }
+    return static_cast<float>(misses) / triangleCount;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file MeshOptimizer.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the MeshOptimizer class, which reorders the triangles and vertices
+ * of an indexed mesh for the GPU's post-transform vertex cache and vertex fetch.
+ */
+
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "MeshCreator.h"
+
+/**
+ * @class MeshOptimizer
+ * @brief Reorders indexed meshes so that the GPU transforms and fetches each vertex as few times as possible.
+ *
+ * The triangle order favours vertices that were used recently, so that their transformed results are still
+ * in the post-transform cache (Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006). The vertices are
+ * then laid out in the order the triangles first reference them, so that vertex fetch reads the buffer
+ * front to back. Neither pass changes the rendered result.
+ */
+class MeshOptimizer
+{
+public:
+    // Number of entries of the FIFO cache used by computeAcmr, a typical post-transform cache size
+    static const size_t ACMR_CACHE_SIZE = 16;
+
+    /**
+     * @brief Reorders a mesh's triangles for the post-transform vertex cache.
+     * @param indices The triangle indices, reordered in place.
+     * @param vertexCount The number of vertices the indices refer to.
+     */
+    static void optimizeVertexCache(std::vector<GLushort>& indices, size_t vertexCount);
+
+    /**
+     * @brief Reorders a mesh's vertices in the order its triangles first reference them.
+     *
+     * Vertices no triangle references are kept after the referenced ones.
+     *
+     * @param mesh The mesh to reorder, 8 floats per vertex. Its indices are remapped.
+     */
+    static void optimizeVertexFetch(MeshCreator::MeshData& mesh);
+
+    /**
+     * @brief Returns the average cache miss ratio of a triangle list.
+     *
+     * Simulates a FIFO cache of ACMR_CACHE_SIZE vertices. The result is the number of vertices transformed
+     * per triangle: 3 when no vertex is reused, approaching 0.5 for a well ordered regular grid.
+     *
+     * @param indices The triangle indices.
+     * @param vertexCount The number of vertices the indices refer to.
+     * @return The number of cache misses divided by the number of triangles, or 0 for an empty mesh.
+     */
+    static float computeAcmr(const std::vector<GLushort>& indices, size_t vertexCount);
+};
+#endif // MESHOPTIMIZER_H
@@ -0,0 +1,367 @@
+/**
+ * @file MeshSimplifier.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the MeshSimplifier class.
+ */
+
+#include "MeshSimplifier.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <queue>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    const GLuint FLOATS_PER_VERTEX = 8;        // Position, normal, texture coordinate
+    const double BORDER_WEIGHT = 10.0;         // Weight of the planes that hold open borders in place
+    const double MIN_NORMAL_DOT = 0.2;         // Smallest cosine between a triangle's normal before and after a collapse
+    const float WELD_TOLERANCE = 1e-5f;        // Positions closer than this fraction of the mesh size are one corner
+    const uint32_t INVALID = 0xFFFFFFFFu;
+
+    // Sum of squared distances to a set of planes, stored as the upper half of a symmetric 4x4 matrix
+    struct Quadric
+    {
+        double a[10] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+        double weight = 0.0; // Sum of the plane weights
+
+        void addPlane(const glm::dvec3& n, double d, double weight) {
+            a[0] += weight * n.x * n.x; a[1] += weight * n.x * n.y; a[2] += weight * n.x * n.z; a[3] += weight * n.x * d;
+            a[4] += weight * n.y * n.y; a[5] += weight * n.y * n.z; a[6] += weight * n.y * d;
+            a[7] += weight * n.z * n.z; a[8] += weight * n.z * d;
+            a[9] += weight * d * d;
+            this->weight += weight;
+        }
+
+        void add(const Quadric& other) {
+            for (int i = 0; i < 10; i++) {
+                a[i] += other.a[i];
+            }
+            weight += other.weight;
+        }
+
+        // Mean squared distance of a point to the planes
+        double evaluate(const glm::dvec3& p) const {
+            if (weight <= 0.0) {
+                return 0.0;
+            }
+            return (a[0] * p.x * p.x + 2.0 * a[1] * p.x * p.y + 2.0 * a[2] * p.x * p.z + 2.0 * a[3] * p.x
+                + a[4] * p.y * p.y + 2.0 * a[5] * p.y * p.z + 2.0 * a[6] * p.y
+                + a[7] * p.z * p.z + 2.0 * a[8] * p.z
+                + a[9]) / weight;
+        }
+    };
+
+    // A candidate collapse of corner 'from' onto corner 'to'
+    struct Collapse
+    {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+        uint32_t fromVersion;
+        uint32_t toVersion;
+
+        bool operator>(const Collapse& other) const { return cost > other.cost; }
+    };
+
+    // The working state of one simplification
+    struct Simplification
+    {
+        const MeshCreator::MeshData& source;
+        std::vector<uint32_t> corner;             // Corner of each source vertex
+        std::vector<glm::dvec3> position;         // Position of each corner
+        std::vector<Quadric> quadric;             // Accumulated planes of each corner
+        std::vector<uint32_t> version;            // Bumped whenever a corner's quadric changes
+        std::vector<bool> removed;                // True once a corner has been collapsed away
+        std::vector<std::vector<uint32_t>> cornerTriangles; // Triangles that touched each corner; may hold dead ones
+        std::vector<uint32_t> triangles;          // Three source vertices per triangle
+        std::vector<bool> alive;
+        size_t aliveCount = 0;
+        std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+        explicit Simplification(const MeshCreator::MeshData& mesh) : source(mesh) {}
+
+        uint32_t cornerOf(uint32_t triangle, int k) const { return corner[triangles[triangle * 3 + k]]; }
+
+        glm::dvec3 triangleNormal(const glm::dvec3& p0, const glm::dvec3& p1, const glm::dvec3& p2) const {
+            return glm::cross(p1 - p0, p2 - p0);
+        }
+
+        void push(uint32_t from, uint32_t to) {
+            Quadric combined = quadric[from];
+            combined.add(quadric[to]);
+            Collapse collapse = { combined.evaluate(position[to]), from, to, version[from], version[to] };
+            queue.push(collapse);
+        }
+
+        void pushEdges(uint32_t c) {
+            for (uint32_t t : cornerTriangles[c]) {
+                if (!alive[t]) {
+                    continue;
+                }
+                for (int k = 0; k < 3; k++) {
+                    uint32_t other = cornerOf(t, k);
+                    if (other != c) {
+                        push(c, other);
+                        push(other, c);
+                    }
+                }
+            }
+        }
+
+        bool collapse(uint32_t from, uint32_t to);
+    };
+
+    /**
+     * @brief Collapses one corner onto a neighbour when the result stays valid.
+     * @return True when the collapse was applied.
+     */
+    bool Simplification::collapse(uint32_t from, uint32_t to) {
+        // Triangles on the edge disappear; their vertices tell which vertex of 'to' replaces each vertex of 'from'
+        std::map<uint32_t, uint32_t> replacement;
+        for (uint32_t t : cornerTriangles[from]) {
+            if (!alive[t]) {
+                continue;
+            }
+            uint32_t fromVertex = INVALID;
+            uint32_t toVertex = INVALID;
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = triangles[t * 3 + k];
+                if (corner[v] == from) {
+                    fromVertex = v;
+                }
+                else if (corner[v] == to) {
+                    toVertex = v;
+                }
+            }
+            if (toVertex == INVALID) {
+                continue;
+            }
+            std::map<uint32_t, uint32_t>::const_iterator existing = replacement.find(fromVertex);
+            if (existing != replacement.end() && existing->second != toVertex) {
+                return false;
+            }
+            replacement[fromVertex] = toVertex;
+        }
+        if (replacement.empty()) {
+            return false;
+        }
+
+        // The remaining triangles must keep their orientation and an attribute to move to
+        for (uint32_t t : cornerTriangles[from]) {
+            if (!alive[t]) {
+                continue;
+            }
+            glm::dvec3 before[3];
+            glm::dvec3 after[3];
+            bool onEdge = false;
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = triangles[t * 3 + k];
+                before[k] = position[corner[v]];
+                after[k] = before[k];
+                if (corner[v] == to) {
+                    onEdge = true;
+                }
+                else if (corner[v] == from) {
+                    if (replacement.find(v) == replacement.end()) {
+                        return false;
+                    }
+                    after[k] = position[to];
+                }
+            }
+            if (onEdge) {
+                continue;
+            }
+            glm::dvec3 normalBefore = triangleNormal(before[0], before[1], before[2]);
+            glm::dvec3 normalAfter = triangleNormal(after[0], after[1], after[2]);
+            double lengths = glm::length(normalBefore) * glm::length(normalAfter);
+            if (lengths <= 0.0 || glm::dot(normalBefore, normalAfter) < MIN_NORMAL_DOT * lengths) {
+                return false;
+            }
+        }
+
+        for (uint32_t t : cornerTriangles[from]) {
+            if (!alive[t]) {
+                continue;
+            }
+            if (cornerOf(t, 0) == to || cornerOf(t, 1) == to || cornerOf(t, 2) == to) {
+                alive[t] = false;
+                aliveCount--;
+                continue;
+            }
+            for (int k = 0; k < 3; k++) {
+                uint32_t& v = triangles[t * 3 + k];
+                if (corner[v] == from) {
+                    v = replacement[v];
+                }
+            }
+            cornerTriangles[to].push_back(t);
+        }
+
+        quadric[to].add(quadric[from]);
+        removed[from] = true;
+        version[to]++;
+        cornerTriangles[from].clear();
+        pushEdges(to);
+        return true;
+    }
+}
+
+/**
+ * @brief Collapses edges until the mesh reaches a triangle count or an error limit.
+ * @param source The mesh to simplify, 8 floats per vertex.
+ * @param targetTriangleCount The triangle count to stop at.
+ * @param maxError The largest distance, in object units, a collapse may move the surface.
+ * @return The simplified mesh. Its vertices are a subset of the source's, in first-use order.
+ */
+MeshCreator::MeshData MeshSimplifier::simplify(const MeshCreator::MeshData& source, size_t targetTriangleCount, float maxError) {
+    Simplification mesh(source);
+    const size_t vertexCount = source.vertices.size() / FLOATS_PER_VERTEX;
+
+    // Vertices that share a position form one corner. Positions are snapped to a grid first, so
+    // seams whose ends were computed with different rounding, like sin(0) and sin(2 pi), still meet.
+    AABB bounds;
+    for (size_t v = 0; v < vertexCount; v++) {
+        const GLfloat* p = &source.vertices[v * FLOATS_PER_VERTEX];
+        bounds.expand(glm::vec3(p[0], p[1], p[2]));
+    }
+    const float extent = bounds.isValid() ? glm::length(bounds.max - bounds.min) : 0.0f;
+    const float cellSize = extent > 0.0f ? extent * WELD_TOLERANCE : 1.0f;
+
+    std::map<std::tuple<long long, long long, long long>, uint32_t> cornerIds;
+    mesh.corner.resize(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        const GLfloat* p = &source.vertices[v * FLOATS_PER_VERTEX];
+        std::tuple<long long, long long, long long> key(std::llround(p[0] / cellSize), std::llround(p[1] / cellSize), std::llround(p[2] / cellSize));
+        std::map<std::tuple<long long, long long, long long>, uint32_t>::const_iterator found = cornerIds.find(key);
+        if (found == cornerIds.end()) {
+            uint32_t id = static_cast<uint32_t>(mesh.position.size());
+            cornerIds[key] = id;
+            mesh.position.push_back(glm::dvec3(p[0], p[1], p[2]));
+            mesh.corner[v] = id;
+        }
+        else {
+            mesh.corner[v] = found->second;
+        }
+    }
+    const size_t cornerCount = mesh.position.size();
+    mesh.quadric.resize(cornerCount);
+    mesh.version.assign(cornerCount, 0);
+    mesh.removed.assign(cornerCount, false);
+    mesh.cornerTriangles.resize(cornerCount);
+
+    // Triangles with two vertices at one position have no area and are dropped
+    for (size_t i = 0; i + 2 < source.indices.size(); i += 3) {
+        uint32_t a = source.indices[i];
+        uint32_t b = source.indices[i + 1];
+        uint32_t c = source.indices[i + 2];
+        if (a >= vertexCount || b >= vertexCount || c >= vertexCount
+            || mesh.corner[a] == mesh.corner[b] || mesh.corner[b] == mesh.corner[c] || mesh.corner[a] == mesh.corner[c]) {
+            continue;
+        }
+        uint32_t t = static_cast<uint32_t>(mesh.triangles.size() / 3);
+        mesh.triangles.push_back(a);
+        mesh.triangles.push_back(b);
+        mesh.triangles.push_back(c);
+        mesh.alive.push_back(true);
+        for (int k = 0; k < 3; k++) {
+            mesh.cornerTriangles[mesh.cornerOf(t, k)].push_back(t);
+        }
+    }
+    mesh.aliveCount = mesh.alive.size();
+    const size_t triangleCount = mesh.alive.size();
+
+    // Every corner starts with the planes of its triangles
+    std::map<std::pair<uint32_t, uint32_t>, int> edgeUse;
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        glm::dvec3 p[3] = { mesh.position[mesh.cornerOf(t, 0)], mesh.position[mesh.cornerOf(t, 1)], mesh.position[mesh.cornerOf(t, 2)] };
+        glm::dvec3 normal = mesh.triangleNormal(p[0], p[1], p[2]);
+        double length = glm::length(normal);
+        if (length <= 0.0) {
+            continue;
+        }
+        normal /= length;
+        for (int k = 0; k < 3; k++) {
+            mesh.quadric[mesh.cornerOf(t, k)].addPlane(normal, -glm::dot(normal, p[0]), 1.0);
+            uint32_t a = mesh.cornerOf(t, k);
+            uint32_t b = mesh.cornerOf(t, (k + 1) % 3);
+            edgeUse[std::make_pair(std::min(a, b), std::max(a, b))]++;
+        }
+    }
+
+    // Edges used by one triangle are open borders; a plane through the edge, perpendicular to the triangle, keeps them in place
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        glm::dvec3 p[3] = { mesh.position[mesh.cornerOf(t, 0)], mesh.position[mesh.cornerOf(t, 1)], mesh.position[mesh.cornerOf(t, 2)] };
+        glm::dvec3 normal = mesh.triangleNormal(p[0], p[1], p[2]);
+        for (int k = 0; k < 3; k++) {
+            uint32_t a = mesh.cornerOf(t, k);
+            uint32_t b = mesh.cornerOf(t, (k + 1) % 3);
+            if (edgeUse[std::make_pair(std::min(a, b), std::max(a, b))] != 1) {
+                continue;
+            }
+            glm::dvec3 borderNormal = glm::cross(p[(k + 1) % 3] - p[k], normal);
+            double length = glm::length(borderNormal);
+            if (length <= 0.0) {
+                continue;
+            }
+            borderNormal /= length;
+            double d = -glm::dot(borderNormal, p[k]);
+            mesh.quadric[a].addPlane(borderNormal, d, BORDER_WEIGHT);
+            mesh.quadric[b].addPlane(borderNormal, d, BORDER_WEIGHT);
+        }
+    }
+
+    // Collapse the cheapest edge first. A rejected collapse can become valid once its neighbourhood
+    // changed, so the queue is rebuilt until a pass makes no progress.
+    const double maxCost = static_cast<double>(maxError) * static_cast<double>(maxError);
+    bool progress = true;
+    while (progress && mesh.aliveCount > targetTriangleCount) {
+        progress = false;
+        for (uint32_t c = 0; c < cornerCount; c++) {
+            if (!mesh.removed[c]) {
+                mesh.pushEdges(c);
+            }
+        }
+        while (!mesh.queue.empty() && mesh.aliveCount > targetTriangleCount) {
+            Collapse candidate = mesh.queue.top();
+            mesh.queue.pop();
+            if (candidate.cost > maxCost) {
+                break;
+            }
+            if (mesh.removed[candidate.from] || mesh.removed[candidate.to]
+                || candidate.fromVersion != mesh.version[candidate.from] || candidate.toVersion != mesh.version[candidate.to]) {
+                continue;
+            }
+            if (mesh.collapse(candidate.from, candidate.to)) {
+                progress = true;
+            }
+        }
+        mesh.queue = std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>>();
+    }
+
+    // Keep the used vertices in the order the triangles first reference them
+    MeshCreator::MeshData result;
+    std::vector<uint32_t> remap(vertexCount, INVALID);
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        if (!mesh.alive[t]) {
+            continue;
+        }
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = mesh.triangles[t * 3 + k];
+            if (remap[v] == INVALID) {
+                remap[v] = static_cast<uint32_t>(result.vertices.size() / FLOATS_PER_VERTEX);
+                const GLfloat* vertex = &source.vertices[v * FLOATS_PER_VERTEX];
+                result.vertices.insert(result.vertices.end(), vertex, vertex + FLOATS_PER_VERTEX);
+            }
+            result.indices.push_back(static_cast<GLushort>(remap[v]));
+        }
+    }
+    return result;
+}
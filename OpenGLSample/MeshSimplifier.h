@@ -0,0 +1,40 @@
+/**
+ * @file MeshSimplifier.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the MeshSimplifier class, which reduces the triangle count of an
+ * indexed mesh with quadric error metric edge collapses.
+ */
+
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <cstddef>
+
+#include "MeshCreator.h"
+
+/**
+ * @class MeshSimplifier
+ * @brief Generates coarser versions of an indexed mesh.
+ *
+ * Vertices that share a position are treated as one corner, so UV seams and hard edges stay closed.
+ * Every corner accumulates the planes of its triangles in a quadric, and the edge whose collapse
+ * moves the surface the least is collapsed first (Garland and Heckbert, 1997). A corner always moves
+ * onto one of its neighbours, so the output only contains vertices of the source and keeps their
+ * normals and texture coordinates. Collapses that would flip a triangle, or that would have to
+ * invent an attribute across a seam, are skipped. Open borders are held in place by extra planes.
+ */
+class MeshSimplifier
+{
+public:
+    /**
+     * @brief Collapses edges until the mesh reaches a triangle count or an error limit.
+     * @param source The mesh to simplify, 8 floats per vertex.
+     * @param targetTriangleCount The triangle count to stop at.
+     * @param maxError The largest distance, in object units, a collapse may move the surface.
+     * @return The simplified mesh. Its vertices are a subset of the source's, in first-use order.
+     */
+    static MeshCreator::MeshData simplify(const MeshCreator::MeshData& source, size_t targetTriangleCount, float maxError);
+};
+#endif // MESHSIMPLIFIER_H
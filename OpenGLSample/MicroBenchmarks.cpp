@@ -0,0 +1,267 @@
+/**
+ * @file MicroBenchmarks.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the MicroBenchmarks class.
+ */
+
+#include "MicroBenchmarks.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Frustum.h"
+#include "LodPolicy.h"
+#include "MeshCreator.h"
+#include "ResourceRegistry.h"
+#include "Textures.h"
+
+const size_t MicroBenchmarks::DEFAULT_MAX_ITEMS;
+const double MicroBenchmarks::MIN_TIME_MS = 50.0;
+const size_t MicroBenchmarks::MAX_MESHES;
+const size_t MicroBenchmarks::MAX_REMOVALS;
+
+// Unnamed namespace
+namespace
+{
+    // Results are added here so the timed loops are not optimized away
+    volatile float benchmarkSink = 0.0f;
+
+    // Seed of the scattered boxes
+    const unsigned int BOX_SEED = 1234u;
+
+    // Sides of the prisms, as in the cylinder meshes
+    const int PRISM_SIDES = 20;
+}
+
+/**
+ * @brief Creates a box item that already has bounds, as if it had been recorded.
+ */
+MicroBenchmarks::BenchmarkItem::BenchmarkItem(const AABB& box, const ResourceRegistry& resources, Camera& camera)
+    : Item(box.getCenter(), resources, camera) {
+    bounds = box;
+    recorded = true;
+    dirty = false;
+}
+
+/**
+ * @brief Creates the suite.
+ * @param maxItems The largest scale to run.
+ */
+MicroBenchmarks::MicroBenchmarks(size_t maxItems) : maxItems(maxItems) {
+}
+
+/**
+ * @brief Runs every benchmark at every scale and prints the results.
+ * @return 0, so it can be used as the exit code of the program.
+ */
+int MicroBenchmarks::run() {
+    std::cout << "benchmark,items,repetitions,ns_per_item" << std::endl;
+    for (size_t count = 10; count <= maxItems; count *= 10) {
+        runSceneBenchmarks(count);
+        if (count <= MAX_MESHES) {
+            runMeshBenchmarks(count);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Times a body, repeating it after the untimed setup until MIN_TIME_MS has passed, and prints the result.
+ * @param name The name printed with the result.
+ * @param items The number of items one run of the body handles.
+ * @param setup Prepares a repetition; not timed.
+ * @param body The code being timed.
+ */
+void MicroBenchmarks::measure(const char* name, size_t items, const std::function<void()>& setup, const std::function<void()>& body) {
+    double elapsedMs = 0.0;
+    size_t repetitions = 0;
+    while (elapsedMs < MIN_TIME_MS) {
+        if (setup) {
+            setup();
+        }
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        body();
+        elapsedMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        repetitions++;
+    }
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%s,%zu,%zu,%.2f", name, items, repetitions, elapsedMs * 1.0e6 / (static_cast<double>(repetitions) * items));
+    std::cout << line << std::endl;
+}
+
+/**
+ * @brief Returns boxes scattered with a fixed seed, about one per 8 cubic units.
+ */
+std::vector<AABB> MicroBenchmarks::makeBoxes(size_t count) {
+    // The volume grows with the count, so the density and the tree's shape stay the same
+    const float halfSide = 0.5f * std::cbrt(8.0f * count);
+    std::mt19937 random(BOX_SEED);
+    std::uniform_real_distribution<float> coordinate(-halfSide, halfSide);
+    std::uniform_real_distribution<float> extent(0.1f, 1.0f);
+
+    std::vector<AABB> boxes(count);
+    for (AABB& box : boxes) {
+        const glm::vec3 center(coordinate(random), coordinate(random), coordinate(random));
+        const glm::vec3 extents(extent(random), extent(random), extent(random));
+        box.min = center - extents;
+        box.max = center + extents;
+    }
+    return boxes;
+}
+
+/**
+ * @brief Times the BSP tree queries, frustum, distance and level of detail code on a number of items.
+ */
+void MicroBenchmarks::runSceneBenchmarks(size_t count) {
+    // The items only need the tables to exist; nothing is drawn
+    MeshCreator meshes;
+    Textures textures = Textures();
+    Shader shader;
+    ResourceRegistry resources(meshes, textures, shader);
+    Camera camera(glm::vec3(0.0f));
+
+    const std::vector<AABB> boxes = makeBoxes(count);
+    std::vector<std::unique_ptr<BenchmarkItem>> items;
+    items.reserve(count);
+    for (const AABB& box : boxes) {
+        items.emplace_back(new BenchmarkItem(box, resources, camera));
+    }
+
+    // Looking down -z from the middle of the boxes
+    Frustum frustum;
+    frustum.update(glm::perspective(glm::radians(60.0f), 4.0f / 3.0f, 0.1f, 100.0f) * camera.GetViewMatrix());
+
+    std::unique_ptr<BSPTree> tree;
+    measure("BSPTree::insert+build", count, [&]() { tree.reset(new BSPTree(nullptr)); }, [&]() {
+        for (const std::unique_ptr<BenchmarkItem>& item : items) {
+            tree->insert(item.get());
+        }
+        tree->build();
+    });
+
+    const size_t removals = std::min(count, MAX_REMOVALS);
+    measure("BSPTree::remove", removals, [&]() {
+        tree.reset(new BSPTree(nullptr));
+        for (const std::unique_ptr<BenchmarkItem>& item : items) {
+            tree->insert(item.get());
+        }
+        tree->build();
+    }, [&]() {
+        // Every count / removals-th item, so removals come from all over the list
+        for (size_t i = 0; i < removals; i++) {
+            tree->remove(items[i * count / removals].get());
+        }
+    });
+
+    tree.reset(new BSPTree(nullptr));
+    for (const std::unique_ptr<BenchmarkItem>& item : items) {
+        tree->insert(item.get());
+    }
+    tree->build();
+    std::vector<Item*> visibleItems;
+    measure("BSPTree::queryVisibleItems", count, nullptr, [&]() {
+        tree->queryVisibleItems(frustum, true, visibleItems, nullptr);
+        benchmarkSink = benchmarkSink + static_cast<float>(visibleItems.size());
+    });
+
+    // One query each, from the middle of the boxes, as the camera and firefly collision make them
+    const glm::vec3 queryDirection = glm::normalize(glm::vec3(1.0f, 0.3f, -0.7f));
+    measure("BSPTree::castRay", count, nullptr, [&]() {
+        BSPTree::RayHit hit;
+        benchmarkSink = benchmarkSink + (tree->castRay(glm::vec3(0.0f), queryDirection, 1000.0f, 0.0f, hit) ? hit.distance : 0.0f);
+    });
+    measure("BSPTree::castRay sphere", count, nullptr, [&]() {
+        BSPTree::RayHit hit;
+        benchmarkSink = benchmarkSink + (tree->castRay(glm::vec3(0.0f), queryDirection * 0.1f, 1.0f, 0.2f, hit) ? hit.distance : 0.0f);
+    });
+    AABB queryBox;
+    queryBox.min = glm::vec3(-0.05f);
+    queryBox.max = glm::vec3(0.05f);
+    measure("BSPTree::overlapsAnyItem", count, nullptr, [&]() {
+        benchmarkSink = benchmarkSink + (tree->overlapsAnyItem(queryBox) ? 1.0f : 0.0f);
+    });
+
+    measure("Frustum::intersects", count, nullptr, [&]() {
+        size_t inside = 0;
+        for (const AABB& box : boxes) {
+            inside += frustum.intersects(box) ? 1 : 0;
+        }
+        benchmarkSink = benchmarkSink + static_cast<float>(inside);
+    });
+
+    BoxList boxList;
+    boxList.reserve(count);
+    for (const AABB& box : boxes) {
+        boxList.push(box);
+    }
+    std::vector<unsigned char> visible;
+    measure("Frustum::cull", count, nullptr, [&]() {
+        frustum.cull(boxList, visible);
+        benchmarkSink = benchmarkSink + visible[0];
+    });
+
+    measure("Item::calculateDistance", count, nullptr, [&]() {
+        float total = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            total += items[i]->calculateDistance(boxes[i].getCenter());
+        }
+        benchmarkSink = benchmarkSink + total;
+    });
+
+    LodPolicy lodPolicy;
+    LodView lodView;
+    lodView.projectionScale = 1.0f / std::tan(glm::radians(30.0f));
+    measure("LodPolicy::selectLevel", count, nullptr, [&]() {
+        int levels = 0;
+        for (const AABB& box : boxes) {
+            levels += lodPolicy.selectLevel(LodPolicy::getScreenSize(box, lodView), LodPolicy::MAX_LEVELS, LodPolicy::LEVEL_UNKNOWN, 0.0f);
+        }
+        benchmarkSink = benchmarkSink + static_cast<float>(levels);
+    });
+
+    // The tree holds raw pointers to the items
+    tree.reset();
+}
+
+/**
+ * @brief Times the mesh generators on a number of meshes.
+ */
+void MicroBenchmarks::runMeshBenchmarks(size_t count) {
+    // A fresh creator per repetition, since every generated mesh is staged into it
+    std::unique_ptr<MeshCreator> creator;
+    std::vector<MeshCreator::GLMesh> meshes;
+    const std::function<void()> setup = [&]() {
+        creator.reset(new MeshCreator());
+        meshes.assign(count, MeshCreator::GLMesh());
+    };
+
+    measure("MeshCreator::makeSphereMesh", count, setup, [&]() {
+        for (MeshCreator::GLMesh& mesh : meshes) {
+            creator->makeSphereMesh(mesh);
+        }
+    });
+    measure("MeshCreator::makeTorusMesh", count, setup, [&]() {
+        for (MeshCreator::GLMesh& mesh : meshes) {
+            creator->makeTorusMesh(mesh, 30, 30);
+        }
+    });
+
+    // Same array sizes as the cylinder meshes
+    std::vector<GLfloat> verts(MeshCreator::FLOATS_PER_VERTEX_TOTAL * (2 + 2 * PRISM_SIDES) + 16);
+    std::vector<GLushort> indices(12 * PRISM_SIDES);
+    MeshCreator prismCreator;
+    measure("MeshCreator::makePrism", count, nullptr, [&]() {
+        for (size_t i = 0; i < count; i++) {
+            prismCreator.makePrism(verts.data(), indices.data(), PRISM_SIDES, 0.25f, 1.0f);
+        }
+        benchmarkSink = benchmarkSink + verts[0];
+    });
+}
@@ -0,0 +1,92 @@
+/**
+ * @file MicroBenchmarks.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the MicroBenchmarks class, which times the scene
+ * management hot paths in isolation, without a GL context.
+ */
+
+#ifndef MICROBENCHMARKS_H
+#define MICROBENCHMARKS_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "BSPTree.h"
+#include "Item.h"
+
+/**
+ * @class MicroBenchmarks
+ * @brief Times the BSP tree, frustum, distance, level of detail and mesh generator code at growing scales.
+ *
+ * Every benchmark runs at 10, 100, 1000 ... items up to the largest scale asked for. The items are
+ * boxes scattered with a fixed seed, at the same density whatever their number, so the results
+ * compare between runs. A benchmark body is repeated until it has run for MIN_TIME_MS, and its
+ * setup is not timed. Each result is printed as one CSV line: name, items, repetitions and
+ * nanoseconds per item.
+ *
+ * The mesh generators stage a whole mesh per item, so they stop at MAX_MESHES; BSPTree::remove
+ * erases from the item list, so it removes at most MAX_REMOVALS items per repetition.
+ */
+class MicroBenchmarks
+{
+public:
+    // Largest scale run when none is given
+    static const size_t DEFAULT_MAX_ITEMS = 1000000;
+    // Time each benchmark body runs for, at least
+    static const double MIN_TIME_MS;
+    // Largest number of meshes a generator benchmark stages
+    static const size_t MAX_MESHES = 1000;
+    // Largest number of items removed per repetition
+    static const size_t MAX_REMOVALS = 1000;
+
+    /**
+     * @brief Creates the suite.
+     * @param maxItems The largest scale to run.
+     */
+    explicit MicroBenchmarks(size_t maxItems);
+
+    /**
+     * @brief Runs every benchmark at every scale and prints the results.
+     * @return 0, so it can be used as the exit code of the program.
+     */
+    int run();
+
+private:
+    // A box standing in for a recorded scene object
+    class BenchmarkItem : public Item
+    {
+    public:
+        BenchmarkItem(const AABB& box, const ResourceRegistry& resources, Camera& camera);
+        void render() override {}
+    };
+
+    size_t maxItems;
+
+    /**
+     * @brief Times a body, repeating it after the untimed setup until MIN_TIME_MS has passed, and prints the result.
+     * @param name The name printed with the result.
+     * @param items The number of items one run of the body handles.
+     * @param setup Prepares a repetition; not timed.
+     * @param body The code being timed.
+     */
+    static void measure(const char* name, size_t items, const std::function<void()>& setup, const std::function<void()>& body);
+
+    /**
+     * @brief Returns boxes scattered with a fixed seed, about one per 8 cubic units.
+     */
+    static std::vector<AABB> makeBoxes(size_t count);
+
+    /**
+     * @brief Times the BSP tree queries, frustum, distance and level of detail code on a number of items.
+     */
+    void runSceneBenchmarks(size_t count);
+
+    /**
+     * @brief Times the mesh generators on a number of meshes.
+     */
+    void runMeshBenchmarks(size_t count);
+};
+#endif // MICROBENCHMARKS_H
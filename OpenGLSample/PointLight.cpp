@@ -10,70 +10,20 @@
 /**
  * @brief Constructor for the PointLight class.
  *
- * This constructor initializes the PointLight object using a configuration file path and a light name.
- * It sets the initial properties of the light and reads additional properties from the configuration file.
+ * This constructor initializes the PointLight object from the descriptor of its section of the
+ * configuration file.
  *
- * @param configFilePath A string representing the path to the configuration file.
- * @param lightName A string representing the name of the light in the configuration file.
+ * @param descriptor The light's section of the configuration file.
+ * @param lightNumber The index of the light among the point lights of the file.
  */
-PointLight::PointLight(const std::string& configFilePath, const std::string& lightName)
-    : LightSource(configFilePath),
-    position(0.0f, 0.0f, 0.0f),
-    constant(1.0f),
-    linear(0.0f),
-    quadratic(0.0f),
-    intensity(0.0f),
-    lightNumber(-1) {
-    // Read the configuration file and set the properties.
-    std::ifstream configFile(configFilePath);
-    std::string line;
-    bool isCurrentLight = false;
-    if (configFile.is_open()) {
-        while (std::getline(configFile, line)) {
-            if (line == "[" + lightName + "]") {
-                isCurrentLight = true;
-            }
-            else if (line[0] == '[') {
-                isCurrentLight = false;
-            }
-            else if (isCurrentLight) {
-                std::istringstream iss(line);
-                std::string key;
-                std::getline(iss, key, '=');
-                if (key == "position") {
-                    iss >> position.x >> position.y >> position.z;
-                }
-                else if (key == "ambient") {
-                    iss >> ambient.x >> ambient.y >> ambient.z;
-                }
-                else if (key == "diffuse") {
-                    iss >> diffuse.x >> diffuse.y >> diffuse.z;
-                }
-                else if (key == "specular") {
-                    iss >> specular.x >> specular.y >> specular.z;
-                }
-                else if (key == "constant") {
-                    iss >> constant;
-                }
-                else if (key == "linear") {
-                    iss >> linear;
-                }
-                else if (key == "quadratic") {
-                    iss >> quadratic;
-                }
-                else if (key == "intensity") {
-                    iss >> intensity;
-                }
-                if (lightName == "PointLight1") {
-                    lightNumber = 0;
-                }
-                else {
-                    lightNumber = 1;
-                }
-            }
-        }
-    }
-    configFile.close();
+PointLight::PointLight(const LightDescriptor& descriptor, int lightNumber)
+    : LightSource(descriptor),
+    position(descriptor.position),
+    constant(descriptor.constant),
+    linear(descriptor.linear),
+    quadratic(descriptor.quadratic),
+    intensity(descriptor.intensity),
+    lightNumber(lightNumber) {
 }
 
 /**
@@ -88,7 +38,7 @@ PointLight::PointLight(const std::string& configFilePath, const std::string& lig
 void PointLight::setToShader(Shader& shader, const std::string& name) const {
     LightSource::setToShader(shader, name);
 
-    std::string light = lightNumber ? "pointLights[1]" : "pointLights[0]";
+    std::string light = "pointLights[" + std::to_string(lightNumber) + "]";
 
     shader.setVec3(light + ".position", position);
     shader.setVec3(light + ".ambient", ambient);
@@ -99,3 +49,48 @@ void PointLight::setToShader(Shader& shader, const std::string& name) const {
     shader.setFloat(light + ".quadratic", quadratic);
     shader.setFloat(light + ".intensity", intensity);
 }
+
+/**
+ * @brief Appends the point light properties to the lights of the light grid.
+ *
+ * Any number of point lights can be shaded, so every point light is appended whatever its lightNumber.
+ *
+ * @param pointLights The point lights that the light grid is built from.
+ */
+void PointLight::writeToList(std::vector<PointLightBlock>& pointLights) const {
+    PointLightBlock light;
+    light.position = position;
+    light.ambient = ambient;
+    light.diffuse = diffuse;
+    light.specular = specular;
+    light.constant = constant;
+    light.linear = linear;
+    light.quadratic = quadratic;
+    light.intensity = intensity;
+    pointLights.push_back(light);
+}
+
+/**
+ * @brief Moves the point light by an offset.
+ * @param offset The offset added to the position.
+ */
+void PointLight::translate(const glm::vec3& offset) {
+    if (offset != glm::vec3(0.0f)) {
+        position += offset;
+        markChanged();
+    }
+}
+
+/**
+ * @brief Takes the position, colors and attenuation of a descriptor, after the configuration file was reloaded.
+ *
+ * @param descriptor The light's section of the reloaded configuration file.
+ */
+void PointLight::configure(const LightDescriptor& descriptor) {
+    position = descriptor.position;
+    constant = descriptor.constant;
+    linear = descriptor.linear;
+    quadratic = descriptor.quadratic;
+    intensity = descriptor.intensity;
+    LightSource::configure(descriptor);
+}
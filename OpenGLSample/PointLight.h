@@ -33,13 +33,13 @@ public:
     /**
      * @brief Constructor for the PointLight class.
      *
-     * This constructor initializes the PointLight object using a configuration file path and a light name.
-     * It sets the initial properties of the light and reads additional properties from the configuration file.
+     * This constructor initializes the PointLight object from the descriptor of its section of the
+     * configuration file.
      *
-     * @param configFilePath A string representing the path to the configuration file.
-     * @param lightName A string representing the name of the light in the configuration file.
+     * @param descriptor The light's section of the configuration file.
+     * @param lightNumber The index of the light among the point lights of the file.
      */
-    PointLight(const std::string& configFilePath, const std::string& lightName);
+    PointLight(const LightDescriptor& descriptor, int lightNumber);
 
     /**
      * @brief Sets the light properties to a shader.
@@ -51,6 +51,28 @@ public:
      * @param name The base name of the light properties in the shader.
      */
     void setToShader(Shader& shader, const std::string& name) const override;
+
+    /**
+     * @brief Appends the point light properties to the lights of the light grid.
+     *
+     * Any number of point lights can be shaded, so every point light is appended whatever its lightNumber.
+     *
+     * @param pointLights The point lights that the light grid is built from.
+     */
+    void writeToList(std::vector<PointLightBlock>& pointLights) const override;
+
+    /**
+     * @brief Moves the point light by an offset.
+     * @param offset The offset added to the position.
+     */
+    void translate(const glm::vec3& offset);
+
+    /**
+     * @brief Takes the position, colors and attenuation of a descriptor, after the configuration file was reloaded.
+     *
+     * @param descriptor The light's section of the reloaded configuration file.
+     */
+    void configure(const LightDescriptor& descriptor) override;
 };
 
 #endif // POINTLIGHT_H
\ No newline at end of file
@@ -26,17 +26,15 @@ public:
     /**
      * @brief Constructor for the PopcornBucket class.
      *
-     * This constructor initializes the PopcornBucket object with the given initial position, transform data, mesh, texture, shader, and camera.
+     * This constructor initializes the PopcornBucket object with the given initial position, transform data, resources, and camera.
      *
      * @param initialPos The initial position of the popcorn bucket as a glm::vec3.
      * @param transformData The transformation data for the popcorn bucket.
-     * @param mesh The mesh data for the popcorn bucket.
-     * @param texture The texture data for the popcorn bucket.
-     * @param shader The shader program used for rendering the popcorn bucket.
+     * @param resources The shared mesh, texture and shader tables.
      * @param inputCamera A reference to the camera object.
      */
-    PopcornBucket (glm::vec3 initialPos, Transform transformData, MeshCreator mesh, Textures texture, Shader shader, Camera& inputCamera)
-        : Item(initialPos, mesh, texture, shader, inputCamera), transformData(transformData) {}
+    PopcornBucket (glm::vec3 initialPos, Transform transformData, const ResourceRegistry& resources, Camera& inputCamera)
+        : Item(initialPos, resources, inputCamera), transformData(transformData) {}
     
     /**
      * @brief Renders the PopcornBucket object.
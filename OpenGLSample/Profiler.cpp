@@ -0,0 +1,320 @@
+/**
+ * @file Profiler.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the Profiler class.
+ */
+
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+const int Profiler::FRAME_LATENCY;
+const size_t Profiler::MAX_CAPTURE_EVENTS;
+const unsigned int Profiler::GPU_THREAD;
+
+// Unnamed namespace
+namespace
+{
+    // Weight of the newest frame in the smoothed frame times
+    const double SMOOTHING = 0.1;
+
+    /**
+     * @brief Writes one complete ("X") trace event; times are in milliseconds, the trace wants microseconds.
+     */
+    void writeTraceZone(std::ofstream& file, const Profiler::Zone& zone, const char* category, unsigned int thread, bool& first) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+            first ? "" : ",\n", zone.name, category, zone.start * 1000.0, (zone.end - zone.start) * 1000.0, thread);
+        file << line;
+        first = false;
+    }
+}
+
+/**
+ * @brief Creates the profiler. Must be called on the GL thread.
+ */
+Profiler::Profiler() : epoch(std::chrono::steady_clock::now()) {
+    // The GL thread is thread 0
+    threads.push_back(std::this_thread::get_id());
+}
+
+/**
+ * @brief Starts a frame: reads back the earlier frames whose queries are available and marks the
+ * frame's start on the GPU.
+ */
+void Profiler::beginFrame() {
+    // Oldest first, stopping at the first frame the GPU has not finished
+    for (int age = 1; age < FRAME_LATENCY; age++) {
+        FrameRecord& older = frames[(frameIndex + age) % FRAME_LATENCY];
+        if (older.pending && !resolve(older, false)) {
+            break;
+        }
+    }
+
+    frameIndex = (frameIndex + 1) % FRAME_LATENCY;
+    FrameRecord& frame = frames[frameIndex];
+    if (frame.pending) {
+        // FRAME_LATENCY frames behind: only now does reading the results wait on the GPU
+        resolve(frame, true);
+    }
+    frame.queryCursor = 0;
+    frame.gpuZones.clear();
+    frame.cpuZones.clear();
+    frame.cpuStart = now();
+    frame.startQuery = takeQuery(frame);
+    glQueryCounter(frame.startQuery, GL_TIMESTAMP);
+}
+
+/**
+ * @brief Ends the frame and records what it drew.
+ * @param counters The draw counters of the frame.
+ */
+void Profiler::endFrame(const Counters& counters) {
+    FrameRecord& frame = frames[frameIndex];
+    frame.endQuery = takeQuery(frame);
+    glQueryCounter(frame.endQuery, GL_TIMESTAMP);
+    frame.cpuEnd = now();
+    frame.counters = counters;
+    {
+        // Zones still open on workers land in the next frame
+        std::lock_guard<std::mutex> lock(zoneMutex);
+        frame.cpuZones.swap(openCpuZones);
+        openCpuZones.clear();
+    }
+    frame.pending = true;
+}
+
+/**
+ * @brief Returns the milliseconds elapsed since the profiler was created.
+ */
+double Profiler::now() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+/**
+ * @brief Records a closed CPU zone. May be called on any thread.
+ * @param name A string literal naming the zone.
+ * @param start The start time, from now().
+ * @param end The end time, from now().
+ */
+void Profiler::addCpuZone(const char* name, double start, double end) {
+    std::lock_guard<std::mutex> lock(zoneMutex);
+    Zone zone = { name, start, end, getThreadIndex() };
+    openCpuZones.push_back(zone);
+}
+
+/**
+ * @brief Marks the start of a GPU zone in the command stream. Must be called on the GL thread.
+ * @param name A string literal naming the zone.
+ * @return The zone, to pass to endGpuZone.
+ */
+size_t Profiler::beginGpuZone(const char* name) {
+    FrameRecord& frame = frames[frameIndex];
+    GpuZone zone = { name, takeQuery(frame), 0 };
+    glQueryCounter(zone.beginQuery, GL_TIMESTAMP);
+    frame.gpuZones.push_back(zone);
+    return frame.gpuZones.size() - 1;
+}
+
+/**
+ * @brief Marks the end of a GPU zone in the command stream.
+ * @param zone The zone returned by beginGpuZone.
+ */
+void Profiler::endGpuZone(size_t zone) {
+    FrameRecord& frame = frames[frameIndex];
+    GLuint query = takeQuery(frame);
+    glQueryCounter(query, GL_TIMESTAMP);
+    frame.gpuZones[zone].endQuery = query;
+}
+
+/**
+ * @brief Starts keeping every resolved frame for a trace.
+ */
+void Profiler::startCapture() {
+    captureZones.clear();
+    captureCounters.clear();
+    capturing = true;
+}
+
+/**
+ * @brief Stops the capture and writes it as a Chrome trace.
+ * @param path The JSON file to write.
+ * @return True when the file was written.
+ */
+bool Profiler::stopCapture(const char* path) {
+    capturing = false;
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cout << "ERROR::PROFILER::TRACE_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    char line[320];
+    size_t threadCount;
+    {
+        std::lock_guard<std::mutex> lock(zoneMutex);
+        threadCount = threads.size();
+    }
+    for (size_t thread = 0; thread <= threadCount; thread++) {
+        const bool gpu = thread == threadCount;
+        std::snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s%s\"}}",
+            first ? "" : ",\n", gpu ? GPU_THREAD : static_cast<unsigned int>(thread),
+            gpu ? "GPU" : (thread == 0 ? "GL thread" : "Worker "), (gpu || thread == 0) ? "" : std::to_string(thread).c_str());
+        file << line;
+        first = false;
+    }
+    for (const Zone& zone : captureZones) {
+        const bool gpu = zone.thread == GPU_THREAD;
+        writeTraceZone(file, zone, gpu ? "gpu" : "cpu", zone.thread, first);
+    }
+    for (const std::pair<double, Counters>& sample : captureCounters) {
+        std::snprintf(line, sizeof(line), ",\n{\"name\":\"Frame\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"drawCalls\":%zu,\"triangles\":%zu,\"stateChanges\":%zu,\"visibleItems\":%zu,\"allocations\":%zu,\"allocatedBytes\":%zu}}",
+            sample.first * 1000.0, sample.second.drawCalls, sample.second.triangles, sample.second.stateChanges, sample.second.visibleItems,
+            sample.second.allocations, sample.second.allocatedBytes);
+        file << line;
+    }
+    file << "\n]}\n";
+
+    std::cout << "Profiler: wrote " << captureZones.size() << " zones of " << captureCounters.size() << " frames to " << path << std::endl;
+    captureZones.clear();
+    captureCounters.clear();
+    return true;
+}
+
+/**
+ * @brief Waits for and resolves every pending frame, oldest first.
+ */
+void Profiler::flush() {
+    for (int age = 1; age <= FRAME_LATENCY; age++) {
+        FrameRecord& frame = frames[(frameIndex + age) % FRAME_LATENCY];
+        if (frame.pending) {
+            resolve(frame, true);
+        }
+    }
+}
+
+/**
+ * @brief Writes a one-line summary of the recent frames, for the window title.
+ * @param summary The buffer to write into.
+ * @param size The size of the buffer in bytes.
+ */
+void Profiler::getSummary(char* summary, size_t size) const {
+    std::snprintf(summary, size, "CPU %.2f ms | GPU %.2f ms | %zu draws | %zu tris | %zu binds | %zu items | %zu allocs%s",
+        averageCpuFrameMs, averageGpuFrameMs, lastCounters.drawCalls, lastCounters.triangles, lastCounters.stateChanges,
+        lastCounters.visibleItems, lastCounters.allocations, capturing ? " | capturing" : "");
+}
+
+/**
+ * @brief Prints the zones and counters of the last resolved frame.
+ */
+void Profiler::printReport() const {
+    std::cout << "Profiler: CPU " << lastCpuFrameMs << " ms, GPU " << lastGpuFrameMs << " ms, "
+        << lastCounters.drawCalls << " draw calls, " << lastCounters.triangles << " triangles, "
+        << lastCounters.stateChanges << " state changes, " << lastCounters.visibleItems << " visible items, "
+        << lastCounters.allocations << " allocations of " << lastCounters.allocatedBytes << " bytes" << std::endl;
+    for (const Zone& zone : lastCpuZones) {
+        std::cout << "  CPU " << zone.name << " (thread " << zone.thread << "): " << zone.end - zone.start << " ms" << std::endl;
+    }
+    for (const Zone& zone : lastGpuZones) {
+        std::cout << "  GPU " << zone.name << ": " << zone.end - zone.start << " ms" << std::endl;
+    }
+}
+
+/**
+ * @brief Releases the query objects.
+ */
+void Profiler::destroy() {
+    for (FrameRecord& frame : frames) {
+        if (!frame.queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        }
+        frame = FrameRecord();
+    }
+}
+
+/**
+ * @brief Returns an unused query object of a frame's pool.
+ */
+GLuint Profiler::takeQuery(FrameRecord& frame) {
+    if (frame.queryCursor == frame.queries.size()) {
+        GLuint query;
+        glGenQueries(1, &query);
+        frame.queries.push_back(query);
+    }
+    return frame.queries[frame.queryCursor++];
+}
+
+/**
+ * @brief Reads a frame's timestamps back and publishes its zones.
+ * @param frame A pending frame.
+ * @param wait Waits for the results when true; otherwise returns false while they are not available.
+ * @return True when the frame was resolved.
+ */
+bool Profiler::resolve(FrameRecord& frame, bool wait) {
+    // The end query was issued last, so every other result is in once it is
+    if (!wait) {
+        GLint available = 0;
+        glGetQueryObjectiv(frame.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0) {
+            return false;
+        }
+    }
+
+    GLuint64 gpuStart = 0;
+    GLuint64 gpuEnd = 0;
+    glGetQueryObjectui64v(frame.startQuery, GL_QUERY_RESULT, &gpuStart);
+    glGetQueryObjectui64v(frame.endQuery, GL_QUERY_RESULT, &gpuEnd);
+
+    // GPU time is placed on the CPU timeline from the frame's start
+    lastGpuZones.clear();
+    for (const GpuZone& gpuZone : frame.gpuZones) {
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(gpuZone.beginQuery, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(gpuZone.endQuery, GL_QUERY_RESULT, &end);
+        Zone zone = { gpuZone.name, frame.cpuStart + (begin - gpuStart) / 1.0e6, frame.cpuStart + (end - gpuStart) / 1.0e6, GPU_THREAD };
+        lastGpuZones.push_back(zone);
+    }
+    lastCpuZones = frame.cpuZones;
+    lastCounters = frame.counters;
+    lastCpuFrameMs = frame.cpuEnd - frame.cpuStart;
+    lastGpuFrameMs = (gpuEnd - gpuStart) / 1.0e6;
+    resolvedFrameCount++;
+    if (averageCpuFrameMs == 0.0) {
+        averageCpuFrameMs = lastCpuFrameMs;
+        averageGpuFrameMs = lastGpuFrameMs;
+    }
+    averageCpuFrameMs += SMOOTHING * (lastCpuFrameMs - averageCpuFrameMs);
+    averageGpuFrameMs += SMOOTHING * (lastGpuFrameMs - averageGpuFrameMs);
+    if (frameLog != nullptr) {
+        FrameTiming timing = { lastCpuFrameMs, lastGpuFrameMs, frame.counters };
+        frameLog->push_back(timing);
+    }
+
+    if (capturing && captureZones.size() < MAX_CAPTURE_EVENTS) {
+        captureZones.insert(captureZones.end(), lastCpuZones.begin(), lastCpuZones.end());
+        captureZones.insert(captureZones.end(), lastGpuZones.begin(), lastGpuZones.end());
+        captureCounters.push_back(std::make_pair(frame.cpuStart, frame.counters));
+    }
+    frame.pending = false;
+    return true;
+}
+
+/**
+ * @brief Returns the index of the calling thread. The caller holds zoneMutex.
+ */
+unsigned int Profiler::getThreadIndex() {
+    const std::thread::id id = std::this_thread::get_id();
+    std::vector<std::thread::id>::iterator found = std::find(threads.begin(), threads.end(), id);
+    if (found != threads.end()) {
+        return static_cast<unsigned int>(found - threads.begin());
+    }
+    threads.push_back(id);
+    return static_cast<unsigned int>(threads.size() - 1);
+}
@@ -0,0 +1,286 @@
+/**
+ * @file Profiler.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the Profiler class, which times CPU zones and GPU
+ * passes of each frame and exports them as a Chrome trace.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+
+/**
+ * @class Profiler
+ * @brief Per-frame CPU zones, GPU pass timings and draw counters.
+ *
+ * CPU zones may be closed on any thread, so the culling and firefly work of the job system is timed
+ * where it runs. GPU passes are bracketed by GL_TIMESTAMP queries, which nest freely, unlike
+ * GL_TIME_ELAPSED. The queries of a frame are read back once they are available, up to
+ * FRAME_LATENCY frames later, so timing never stalls the pipeline; only a frame whose queries are
+ * still pending when its slot comes round again waits for them.
+ *
+ * While a capture runs, every resolved frame is kept and written out as a Chrome trace
+ * (chrome://tracing or ui.perfetto.dev), with one track per thread plus one for the GPU.
+ */
+class Profiler
+{
+public:
+    // Frames whose GPU queries may be in flight at once
+    static const int FRAME_LATENCY = 4;
+    // Zones a capture keeps before it stops recording
+    static const size_t MAX_CAPTURE_EVENTS = 200000;
+
+    // What a frame drew
+    struct Counters
+    {
+        size_t drawCalls = 0;
+        size_t triangles = 0;
+        size_t stateChanges = 0;    // Program, vertex array and texture binds sent to the driver
+        size_t visibleItems = 0;
+        size_t allocations = 0;     // Heap allocations of every thread, from AllocationTracker
+        size_t allocatedBytes = 0;
+    };
+
+    // The times and counters of one resolved frame
+    struct FrameTiming
+    {
+        double cpuMs;   // From beginFrame to endFrame
+        double gpuMs;   // Between the frame's first and last timestamps on the GPU
+        Counters counters;
+    };
+
+    // A timed zone, in milliseconds since the profiler was created
+    struct Zone
+    {
+        const char* name;
+        double start;
+        double end;
+        unsigned int thread;    // Index of the thread, 0 for the GL thread
+    };
+
+    /**
+     * @brief Creates the profiler. Must be called on the GL thread.
+     */
+    Profiler();
+
+    /**
+     * @brief Starts a frame: reads back the earlier frames whose queries are available and marks the
+     * frame's start on the GPU.
+     */
+    void beginFrame();
+
+    /**
+     * @brief Ends the frame and records what it drew.
+     * @param counters The draw counters of the frame.
+     */
+    void endFrame(const Counters& counters);
+
+    /**
+     * @brief Returns the milliseconds elapsed since the profiler was created.
+     */
+    double now() const;
+
+    /**
+     * @brief Records a closed CPU zone. May be called on any thread.
+     * @param name A string literal naming the zone.
+     * @param start The start time, from now().
+     * @param end The end time, from now().
+     */
+    void addCpuZone(const char* name, double start, double end);
+
+    /**
+     * @brief Marks the start of a GPU zone in the command stream. Must be called on the GL thread.
+     * @param name A string literal naming the zone.
+     * @return The zone, to pass to endGpuZone.
+     */
+    size_t beginGpuZone(const char* name);
+
+    /**
+     * @brief Marks the end of a GPU zone in the command stream.
+     * @param zone The zone returned by beginGpuZone.
+     */
+    void endGpuZone(size_t zone);
+
+    /**
+     * @brief Starts keeping every resolved frame for a trace.
+     */
+    void startCapture();
+
+    /**
+     * @brief Stops the capture and writes it as a Chrome trace.
+     * @param path The JSON file to write.
+     * @return True when the file was written.
+     */
+    bool stopCapture(const char* path);
+
+    /**
+     * @brief Returns true while a capture runs.
+     */
+    bool isCapturing() const { return capturing; }
+
+    /**
+     * @brief Appends every frame resolved from now on to a list, for benchmarks.
+     * @param log The list, or nullptr to stop.
+     */
+    void setFrameLog(std::vector<FrameTiming>* log) { frameLog = log; }
+
+    /**
+     * @brief Waits for and resolves every pending frame, oldest first.
+     */
+    void flush();
+
+    /**
+     * @brief Writes a one-line summary of the recent frames, for the window title.
+     * @param summary The buffer to write into.
+     * @param size The size of the buffer in bytes.
+     */
+    void getSummary(char* summary, size_t size) const;
+
+    /**
+     * @brief Prints the zones and counters of the last resolved frame.
+     */
+    void printReport() const;
+
+    /**
+     * @brief Returns the GPU time of the last resolved frame, in milliseconds.
+     */
+    double getLastGpuFrameMs() const { return lastGpuFrameMs; }
+
+    /**
+     * @brief Returns the number of frames resolved so far, which changes when a new GPU time is in.
+     */
+    size_t getResolvedFrameCount() const { return resolvedFrameCount; }
+
+    /**
+     * @brief Releases the query objects.
+     */
+    void destroy();
+
+private:
+    // Track of the GPU zones in the trace
+    static const unsigned int GPU_THREAD = 1000;
+
+    // A GPU zone with its query pair
+    struct GpuZone
+    {
+        const char* name;
+        GLuint beginQuery;
+        GLuint endQuery;
+    };
+
+    // The zones of one frame, kept until its queries are read back
+    struct FrameRecord
+    {
+        bool pending = false;
+        double cpuStart = 0.0;
+        double cpuEnd = 0.0;
+        GLuint startQuery = 0;
+        GLuint endQuery = 0;
+        std::vector<GpuZone> gpuZones;
+        std::vector<Zone> cpuZones;
+        Counters counters;
+        std::vector<GLuint> queries;    // Pool of query objects, reused every time the slot comes round
+        size_t queryCursor = 0;         // Queries of the pool used by this frame
+    };
+
+    std::chrono::steady_clock::time_point epoch;
+    FrameRecord frames[FRAME_LATENCY];
+    int frameIndex = 0;     // Slot of the frame being recorded
+
+    // CPU zones closed since the last endFrame and the threads seen so far, guarded by zoneMutex
+    mutable std::mutex zoneMutex;
+    std::vector<Zone> openCpuZones;
+    std::vector<std::thread::id> threads;
+
+    // Last resolved frame
+    std::vector<Zone> lastCpuZones;
+    std::vector<Zone> lastGpuZones;
+    Counters lastCounters;
+    double lastCpuFrameMs = 0.0;
+    double lastGpuFrameMs = 0.0;
+    size_t resolvedFrameCount = 0;
+    // Smoothed over the recent frames for the summary
+    double averageCpuFrameMs = 0.0;
+    double averageGpuFrameMs = 0.0;
+
+    std::vector<FrameTiming>* frameLog = nullptr;
+
+    bool capturing = false;
+    std::vector<Zone> captureZones;
+    std::vector<std::pair<double, Counters>> captureCounters;
+
+    /**
+     * @brief Returns an unused query object of a frame's pool.
+     */
+    GLuint takeQuery(FrameRecord& frame);
+
+    /**
+     * @brief Reads a frame's timestamps back and publishes its zones.
+     * @param frame A pending frame.
+     * @param wait Waits for the results when true; otherwise returns false while they are not available.
+     * @return True when the frame was resolved.
+     */
+    bool resolve(FrameRecord& frame, bool wait);
+
+    /**
+     * @brief Returns the index of the calling thread. The caller holds zoneMutex.
+     */
+    unsigned int getThreadIndex();
+};
+
+/**
+ * @class ProfileZone
+ * @brief Times a CPU scope. Does nothing without a profiler.
+ */
+class ProfileZone
+{
+public:
+    ProfileZone(Profiler* profiler, const char* name)
+        : profiler(profiler), name(name), start(profiler != nullptr ? profiler->now() : 0.0) {}
+    ~ProfileZone() {
+        if (profiler != nullptr) {
+            profiler->addCpuZone(name, start, profiler->now());
+        }
+    }
+
+private:
+    Profiler* profiler;
+    const char* name;
+    double start;
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+/**
+ * @class GpuProfileZone
+ * @brief Times a GL pass on both the CPU and the GPU. Must be used on the GL thread.
+ */
+class GpuProfileZone
+{
+public:
+    GpuProfileZone(Profiler* profiler, const char* name)
+        : cpuZone(profiler, name), profiler(profiler), zone(profiler != nullptr ? profiler->beginGpuZone(name) : 0) {}
+    ~GpuProfileZone() {
+        if (profiler != nullptr) {
+            profiler->endGpuZone(zone);
+        }
+    }
+
+private:
+    ProfileZone cpuZone;
+    Profiler* profiler;
+    size_t zone;
+
+    GpuProfileZone(const GpuProfileZone&) = delete;
+    GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+};
+#endif // PROFILER_H
@@ -0,0 +1,256 @@
+/**
+ * @file ProgramCache.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the ProgramCache class.
+ */
+
+#include "ProgramCache.h"
+#include <fstream>
+#include <iostream>
+
+const char* const ProgramCache::DEFAULT_PATH = "program_cache.bin";
+
+bool ProgramCache::enabled = false;
+bool ProgramCache::changed = false;
+uint64_t ProgramCache::driverHash = 0;
+std::string ProgramCache::filePath;
+std::map<uint64_t, ProgramCache::Entry> ProgramCache::entries;
+size_t ProgramCache::hits = 0;
+size_t ProgramCache::misses = 0;
+
+// Unnamed namespace
+namespace
+{
+    const uint32_t CACHE_MAGIC = 0x43505247;    // "GRPC"
+    const uint32_t CACHE_VERSION = 1;
+
+    const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    const uint64_t FNV_PRIME = 1099511628211ull;
+
+    /**
+     * @brief Reads one value of a plain type, returning false at the end of the file.
+     */
+    template <typename T>
+    bool readValue(std::ifstream& file, T& value) {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    /**
+     * @brief Writes one value of a plain type.
+     */
+    template <typename T>
+    void writeValue(std::ofstream& file, const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+/**
+ * @brief Reads the cache file and turns the cache on, when the driver supports program binaries.
+ *
+ * Must be called once the GL functions are loaded and before the shaders are created.
+ *
+ * @param path The file path of the cache file.
+ */
+void ProgramCache::enable(const char* path) {
+    GLint formatCount = 0;
+    if (GLAD_GL_VERSION_4_1) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    }
+    if (formatCount <= 0) {
+        std::cout << "Program cache: off, the driver returns no program binaries" << std::endl;
+        return;
+    }
+
+    const char* strings[3] = {
+        reinterpret_cast<const char*>(glGetString(GL_VENDOR)),
+        reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+        reinterpret_cast<const char*>(glGetString(GL_VERSION))
+    };
+    driverHash = FNV_OFFSET;
+    for (const char* text : strings) {
+        const std::string value = text != nullptr ? text : "";
+        driverHash = hash(value.c_str(), value.size() + 1, driverHash);
+    }
+    filePath = path;
+    enabled = true;
+    changed = false;
+    entries.clear();
+
+    // A missing or foreign file starts an empty cache
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return;
+    }
+    uint32_t magic = 0, version = 0, count = 0;
+    uint64_t fileDriver = 0;
+    if (!readValue(file, magic) || !readValue(file, version) || !readValue(file, fileDriver) || !readValue(file, count)
+        || magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        std::cout << "ERROR::PROGRAMCACHE::UNSUPPORTED_FILE " << path << std::endl;
+        return;
+    }
+    if (fileDriver != driverHash) {
+        // Written by another driver; every binary would be rejected
+        std::cout << "Program cache: driver changed, starting over" << std::endl;
+        changed = true;
+        return;
+    }
+
+    // The counts are checked against what is left of the file before anything is allocated, so a
+    // truncated or corrupted file is dropped instead of asking for gigabytes
+    const std::streamoff entriesStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    uint64_t remaining = static_cast<uint64_t>(static_cast<std::streamoff>(file.tellg()) - entriesStart);
+    file.seekg(entriesStart);
+    const uint64_t ENTRY_HEADER_BYTES = sizeof(uint64_t) + sizeof(GLenum) + sizeof(uint32_t);
+    bool valid = count <= remaining / ENTRY_HEADER_BYTES;
+    for (uint32_t i = 0; valid && i < count; i++) {
+        uint64_t key = 0;
+        Entry entry;
+        uint32_t size = 0;
+        if (!readValue(file, key) || !readValue(file, entry.format) || !readValue(file, size)) {
+            valid = false;
+            break;
+        }
+        remaining -= ENTRY_HEADER_BYTES;
+        if (size > remaining) {
+            valid = false;
+            break;
+        }
+        entry.binary.resize(size);
+        if (size > 0 && !file.read(reinterpret_cast<char*>(entry.binary.data()), size)) {
+            valid = false;
+            break;
+        }
+        remaining -= size;
+        entries[key].format = entry.format;
+        entries[key].binary.swap(entry.binary);
+    }
+    if (!valid) {
+        std::cout << "ERROR::PROGRAMCACHE::CORRUPTED_FILE " << path << std::endl;
+        entries.clear();
+        changed = true;
+    }
+}
+
+/**
+ * @brief Writes the cache file if a program was added since it was read.
+ */
+void ProgramCache::save() {
+    if (!enabled) {
+        return;
+    }
+    std::cout << "Program cache: " << hits << " programs loaded from binaries, " << misses << " compiled" << std::endl;
+    if (!changed) {
+        return;
+    }
+    std::ofstream file(filePath.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "ERROR::PROGRAMCACHE::FILE_NOT_WRITTEN " << filePath << std::endl;
+        return;
+    }
+    writeValue(file, CACHE_MAGIC);
+    writeValue(file, CACHE_VERSION);
+    writeValue(file, driverHash);
+    writeValue(file, static_cast<uint32_t>(entries.size()));
+    for (const std::map<uint64_t, Entry>::value_type& entry : entries) {
+        writeValue(file, entry.first);
+        writeValue(file, entry.second.format);
+        writeValue(file, static_cast<uint32_t>(entry.second.binary.size()));
+        file.write(reinterpret_cast<const char*>(entry.second.binary.data()), entry.second.binary.size());
+    }
+    changed = false;
+}
+
+/**
+ * @brief Returns the key of a program built from some sources under the current driver.
+ * @param sources The shader sources and anything else that changes the program, such as captured varyings.
+ */
+uint64_t ProgramCache::makeKey(const std::vector<std::string>& sources) {
+    uint64_t key = driverHash;
+    for (const std::string& source : sources) {
+        // The terminator keeps "ab" + "c" apart from "a" + "bc"
+        key = hash(source.c_str(), source.size() + 1, key);
+    }
+    return key;
+}
+
+/**
+ * @brief Loads a program from its cached binary.
+ * @param key The key returned by makeKey.
+ * @param program A program object with nothing attached.
+ * @return True when the program is linked from the binary; false when it must be compiled.
+ */
+bool ProgramCache::load(uint64_t key, GLuint program) {
+    if (!enabled) {
+        return false;
+    }
+    std::map<uint64_t, Entry>::iterator found = entries.find(key);
+    if (found == entries.end()) {
+        misses++;
+        return false;
+    }
+    glProgramBinary(program, found->second.format, found->second.binary.data(), static_cast<GLsizei>(found->second.binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        // The driver may reject its own binaries after an update that kept the version string
+        entries.erase(found);
+        changed = true;
+        misses++;
+        return false;
+    }
+    hits++;
+    return true;
+}
+
+/**
+ * @brief Asks the driver to keep a program's binary retrievable. Must be called before linking.
+ */
+void ProgramCache::prepare(GLuint program) {
+    if (enabled) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+/**
+ * @brief Adds a linked program's binary to the cache.
+ * @param key The key returned by makeKey.
+ * @param program The linked program.
+ */
+void ProgramCache::store(uint64_t key, GLuint program) {
+    if (!enabled) {
+        return;
+    }
+    GLint linked = GL_FALSE;
+    GLint length = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (linked != GL_TRUE || length <= 0) {
+        return;
+    }
+    Entry& entry = entries[key];
+    entry.binary.resize(static_cast<size_t>(length));
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &entry.format, entry.binary.data());
+    if (written <= 0) {
+        entries.erase(key);
+        return;
+    }
+    entry.binary.resize(static_cast<size_t>(written));
+    changed = true;
+}
+
+/**
+ * @brief Returns the FNV-1a hash of some bytes, continuing from a previous hash.
+ */
+uint64_t ProgramCache::hash(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t value = seed;
+    for (size_t i = 0; i < size; i++) {
+        value ^= bytes[i];
+        value *= FNV_PRIME;
+    }
+    return value;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file ProgramCache.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the ProgramCache class, which keeps the linked shader
+ * programs as driver binaries on disk so later launches skip compiling and linking them.
+ */
+
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+/**
+ * @class ProgramCache
+ * @brief A file of program binaries, keyed by a hash of the shader sources and the driver.
+ *
+ * Every Shader looks its sources up here before compiling them. The cache is process-wide, since
+ * shaders are created all over the renderer, and is off until enable() is called with a current
+ * context whose driver can return program binaries (OpenGL 4.1). Binaries from another driver,
+ * GPU or driver version never match, because the vendor, renderer and version strings are part
+ * of every key. A binary the driver rejects is compiled from source again and replaced.
+ */
+class ProgramCache
+{
+public:
+    // File the binaries are kept in, next to the other files the program writes
+    static const char* const DEFAULT_PATH;
+
+    /**
+     * @brief Reads the cache file and turns the cache on, when the driver supports program binaries.
+     *
+     * Must be called once the GL functions are loaded and before the shaders are created.
+     *
+     * @param path The file path of the cache file.
+     */
+    static void enable(const char* path);
+
+    /**
+     * @brief Writes the cache file if a program was added since it was read.
+     */
+    static void save();
+
+    /**
+     * @brief Returns true when programs are looked up in and added to the cache.
+     */
+    static bool isEnabled() { return enabled; }
+
+    /**
+     * @brief Returns the key of a program built from some sources under the current driver.
+     * @param sources The shader sources and anything else that changes the program, such as captured varyings.
+     */
+    static uint64_t makeKey(const std::vector<std::string>& sources);
+
+    /**
+     * @brief Loads a program from its cached binary.
+     * @param key The key returned by makeKey.
+     * @param program A program object with nothing attached.
+     * @return True when the program is linked from the binary; false when it must be compiled.
+     */
+    static bool load(uint64_t key, GLuint program);
+
+    /**
+     * @brief Asks the driver to keep a program's binary retrievable. Must be called before linking.
+     */
+    static void prepare(GLuint program);
+
+    /**
+     * @brief Adds a linked program's binary to the cache.
+     * @param key The key returned by makeKey.
+     * @param program The linked program.
+     */
+    static void store(uint64_t key, GLuint program);
+
+private:
+    // A program binary and the format the driver gave it
+    struct Entry
+    {
+        GLenum format = 0;
+        std::vector<unsigned char> binary;
+    };
+
+    static bool enabled;
+    static bool changed;            // True when an entry was added since the file was read
+    static uint64_t driverHash;     // Hash of the vendor, renderer and version strings
+    static std::string filePath;
+    static std::map<uint64_t, Entry> entries;
+    static size_t hits;
+    static size_t misses;
+
+    /**
+     * @brief Returns the FNV-1a hash of some bytes, continuing from a previous hash.
+     */
+    static uint64_t hash(const void* data, size_t size, uint64_t seed);
+};
+#endif // PROGRAMCACHE_H
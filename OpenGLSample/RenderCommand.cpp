@@ -0,0 +1,673 @@
+/**
+ * @file RenderCommand.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the RenderCommandList class.
+ */
+
+#include "RenderCommand.h"
+#include <algorithm>
+#include <tuple>
+
+/**
+ * @brief Appends a command to the end of the list.
+ * @param command The command to append.
+ * @return The index of the new command.
+ */
+size_t RenderCommandList::add(const RenderCommand& command) {
+    commands.push_back(command);
+    commands.back().textureSetId = getTextureSetId(command);
+    commands.back().materialId = getMaterialId(command);
+    lodLevels.push_back(LodPolicy::LEVEL_UNKNOWN);
+    return commands.size() - 1;
+}
+
+/**
+ * @brief Overwrites a recorded command.
+ * @param index The index of the command to overwrite.
+ * @param command The new command.
+ */
+void RenderCommandList::set(size_t index, const RenderCommand& command) {
+    commands[index] = command;
+    commands[index].textureSetId = getTextureSetId(command);
+    commands[index].materialId = getMaterialId(command);
+    lodLevels[index] = LodPolicy::LEVEL_UNKNOWN;
+}
+
+/**
+ * @brief Returns the id of a command's texture set, assigning a new one the first time it is seen.
+ */
+unsigned short RenderCommandList::getTextureSetId(const RenderCommand& command) {
+    std::tuple<GLuint, GLuint, GLuint> textureSet(command.diffuseTexture, command.specularTexture, command.overlayTexture);
+    std::map<std::tuple<GLuint, GLuint, GLuint>, unsigned short>::iterator it = textureSetIds.find(textureSet);
+    if (it != textureSetIds.end()) {
+        return it->second;
+    }
+
+    unsigned short id = static_cast<unsigned short>(textureSetIds.size());
+    textureSetIds[textureSet] = id;
+    return id;
+}
+
+/**
+ * @brief Returns the id of a command's material in the material table.
+ */
+unsigned short RenderCommandList::getMaterialId(const RenderCommand& command) {
+    return materials.getMaterialId(command.diffuseTexture, command.specularTexture, command.overlayTexture, command.shininess, command.uvScale);
+}
+
+/**
+ * @brief Packs a draw's state into a sort key.
+ *
+ * From most to least significant: 8 bits of shader, 16 bits of texture set, 16 bits of VAO and
+ * 24 bits of depth, so that sorting by key groups draws by the most expensive state change first
+ * and orders draws sharing all state front to back.
+ *
+ * @param shader The program handle.
+ * @param textureSetId The texture set id.
+ * @param vao The vertex array handle.
+ * @param depth The distance to the camera.
+ * @return The packed key.
+ */
+uint64_t RenderCommandList::makeSortKey(GLuint shader, unsigned short textureSetId, GLuint vao, float depth) {
+    // Depth is quantized over the far plane distance
+    const float maxDepth = 100.0f;
+    const uint64_t depthBits = 0xFFFFFF;
+    float normalized = std::min(std::max(depth / maxDepth, 0.0f), 1.0f);
+    uint64_t quantizedDepth = static_cast<uint64_t>(normalized * depthBits);
+
+    return (static_cast<uint64_t>(shader & 0xFF) << 56)
+        | (static_cast<uint64_t>(textureSetId) << 40)
+        | (static_cast<uint64_t>(vao & 0xFFFF) << 24)
+        | quantizedDepth;
+}
+
+/**
+ * @brief Removes every recorded command.
+ */
+void RenderCommandList::clear() {
+    commands.clear();
+    lodLevels.clear();
+}
+
+/**
+ * @brief Writes the level of detail meshes of a command, most detailed first.
+ *
+ * The high and low meshes come first, followed by the levels generated below the coarsest of them.
+ *
+ * @param command The command to resolve.
+ * @param levels Receives up to LodPolicy::MAX_LEVELS meshes.
+ * @return The number of levels.
+ */
+int RenderCommandList::getLodMeshes(const RenderCommand& command, const MeshCreator::GLMesh* levels[LodPolicy::MAX_LEVELS]) {
+    int count = 0;
+    levels[count++] = command.highMesh;
+    if (command.lowMesh != nullptr && command.lowMesh != command.highMesh) {
+        levels[count++] = command.lowMesh;
+    }
+    for (const MeshCreator::GLMesh* mesh = levels[count - 1]->coarser; mesh != nullptr && count < LodPolicy::MAX_LEVELS; mesh = mesh->coarser) {
+        levels[count++] = mesh;
+    }
+    return count;
+}
+
+/**
+ * @brief Draws a single command immediately.
+ *
+ * Binds the texture set, sets the material uniforms and the model matrix, and draws the
+ * most detailed mesh.
+ *
+ * @param command The command to draw.
+ * @param shader The lighting shader used for the draw.
+ */
+void RenderCommandList::draw(const RenderCommand& command, const Shader& shader) {
+    const MeshCreator::GLMesh* mesh = command.highMesh;
+
+    // bind textures on corresponding texture units
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, command.diffuseTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, command.specularTexture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, command.overlayTexture);
+
+    // Immediate draws are not in the material table
+    shader.setInt("materialIndex", MaterialTable::NO_MATERIAL);
+    shader.setFloat("material.shininess", command.shininess);
+    shader.setVec2("uvScale", command.uvScale);
+    shader.setMat4("model", command.model);
+
+    glBindVertexArray(mesh->vao);
+    glDrawElementsBaseVertex(GL_TRIANGLES, mesh->nIndices, GL_UNSIGNED_SHORT, mesh->getIndexOffset(), mesh->baseVertex);
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Culls the commands of a run of ranges and selects their level of detail.
+ *
+ * Commands whose bounds lie outside the frustum or that are too small on screen are dropped.
+ * The level each command selects is kept for the next frame's hysteresis. Makes no GL calls
+ * and writes only the levels of the given commands, so disjoint runs can be processed on
+ * different threads.
+ *
+ * @param ranges The command ranges of the visible items.
+ * @param firstRange The first range to process.
+ * @param endRange One past the last range to process.
+ * @param frustum The view frustum.
+ * @param planeCount The number of frustum planes to test, starting with the near plane.
+ * @param lodPolicy The thresholds the levels are selected with.
+ * @param lodView The camera values of the frame.
+ * @param draws Receives one entry per command that is drawn, in command order.
+ */
+void RenderCommandList::cullCommands(const std::vector<CommandRange>& ranges, size_t firstRange, size_t endRange, const Frustum& frustum,
+    int planeCount, const LodPolicy& lodPolicy, const LodView& lodView, std::vector<VisibleDraw>& draws) {
+    const MeshCreator::GLMesh* levels[LodPolicy::MAX_LEVELS];
+    for (size_t r = firstRange; r < endRange; r++) {
+        const CommandRange& range = ranges[r];
+        for (size_t i = range.first; i < range.first + range.count; i++) {
+            const RenderCommand& command = commands[i];
+            if (command.bounds.isValid() && !frustum.intersects(command.bounds, planeCount)) {
+                continue;
+            }
+            const MeshCreator::GLMesh* mesh = command.highMesh;
+            if (command.useDistanceLod) {
+                const int levelCount = getLodMeshes(command, levels);
+                const float screenSize = LodPolicy::getScreenSize(command.bounds, lodView);
+                const int level = lodPolicy.selectLevel(screenSize, levelCount, lodLevels[i], lodView.bias);
+                lodLevels[i] = static_cast<unsigned char>(level);
+                if (level >= levelCount) {
+                    continue;
+                }
+                mesh = levels[level];
+            }
+
+            VisibleDraw draw;
+            draw.command = static_cast<uint32_t>(i);
+            draw.mesh = mesh;
+            draw.depth = glm::length(lodView.viewPosition - command.position);
+            draws.push_back(draw);
+        }
+    }
+}
+
+/**
+ * @brief Returns the shader a command is drawn with: its variant when variants are set, otherwise the pass's shader.
+ */
+const Shader& RenderCommandList::selectShader(const RenderCommand& command, const Shader& shader) const {
+    if (shaderVariants == nullptr) {
+        return shader;
+    }
+    // Without an overlay texture the overlay sample returns the default the shader compares against
+    const unsigned int overlay = command.overlayTexture != 0 ? ShaderVariants::OVERLAY : 0;
+    return shaderVariants->get((shaderFeatures & ~ShaderVariants::OVERLAY) | overlay);
+}
+
+/**
+ * @brief Gathers the visible draws into the draw queue and sorts it.
+ * @param draws The visible draws, with their meshes already selected.
+ * @param shader The shader the draws will use, unless variants are set.
+ * @param withDepth Includes front-to-back depth in the key when true.
+ * @param withTextureSets Includes the texture set in the key when true.
+ */
+void RenderCommandList::buildQueue(const std::vector<VisibleDraw>& draws, const Shader& shader, bool withDepth, bool withTextureSets) {
+    drawQueue.clear();
+    triangleCount = 0;
+    for (const VisibleDraw& visible : draws) {
+        const RenderCommand& command = commands[visible.command];
+        float depth = withDepth ? visible.depth : 0.0f;
+        unsigned short textureSetId = withTextureSets ? command.textureSetId : 0;
+        const Shader& drawShader = selectShader(command, shader);
+        QueuedDraw draw = { makeSortKey(drawShader.ID, textureSetId, visible.mesh->vao, depth), &command, visible.mesh, &drawShader };
+        drawQueue.push_back(draw);
+        triangleCount += visible.mesh->nIndices / 3;
+    }
+    arenaStableSort(drawQueue, [](const QueuedDraw& a, const QueuedDraw& b) { return a.key < b.key; }, frameArena);
+}
+
+/**
+ * @brief Binds a command's texture set through the state cache.
+ */
+void RenderCommandList::bindTextures(const RenderCommand& command, GLStateCache& stateCache) {
+    // bind textures on corresponding texture units
+    stateCache.bindTexture(0, GL_TEXTURE_2D, command.diffuseTexture);
+    stateCache.bindTexture(1, GL_TEXTURE_2D, command.specularTexture);
+    stateCache.bindTexture(2, GL_TEXTURE_2D, command.overlayTexture);
+}
+
+/**
+ * @brief Draws a list of visible draws.
+ *
+ * Sorts the draws by key, binds the texture set, selects the material and sets the model matrix,
+ * and issues the draw for each entry. Binds go through the state cache and the material index is
+ * only re-sent when it differs from the previous draw.
+ *
+ * @param draws The culled draws, with their meshes selected.
+ * @param shader The lighting shader used for the draws.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void RenderCommandList::execute(const std::vector<VisibleDraw>& draws, const Shader& shader, GLStateCache& stateCache) {
+    drawCallCount = 0;
+    buildQueue(draws, shader, true);
+    materials.upload(nullptr, stateCache);
+
+    // Per-draw uniform handles, resolved once per program
+    const Shader* currentShader = &shader;
+    GLint materialLocation = shader.getUniformLocation("materialIndex");
+    GLint modelLocation = shader.getUniformLocation("model");
+
+    // Material index last sent during this pass
+    int currentMaterial = MaterialTable::NO_MATERIAL;
+
+    stateCache.useProgram(shader.ID);
+    for (const QueuedDraw& draw : drawQueue) {
+        const RenderCommand& command = *draw.command;
+        if (draw.shader != currentShader) {
+            // The previous variant is left reading the material uniforms, like the shader after the pass
+            currentShader->setInt(materialLocation, MaterialTable::NO_MATERIAL);
+            currentShader = draw.shader;
+            stateCache.useProgram(currentShader->ID);
+            materialLocation = currentShader->getUniformLocation("materialIndex");
+            modelLocation = currentShader->getUniformLocation("model");
+            currentMaterial = MaterialTable::NO_MATERIAL;
+        }
+        bindTextures(command, stateCache);
+
+        if (currentMaterial != command.materialId) {
+            currentShader->setInt(materialLocation, command.materialId);
+            currentMaterial = command.materialId;
+        }
+        currentShader->setMat4(modelLocation, command.model);
+
+        // Activate the VBOs contained within the mesh's VAO
+        stateCache.bindVertexArray(draw.mesh->vao);
+        glDrawElementsBaseVertex(GL_TRIANGLES, draw.mesh->nIndices, GL_UNSIGNED_SHORT, draw.mesh->getIndexOffset(), draw.mesh->baseVertex);
+        drawCallCount++;
+    }
+
+    // Later draws with this shader set their material through the uniforms
+    currentShader->setInt(materialLocation, MaterialTable::NO_MATERIAL);
+}
+
+/**
+ * @brief Makes a batch's shader current, passing the texture source over from the previous shader.
+ * @param current The shader of the previous batch, or nullptr; receives next.
+ * @param next The shader of the batch, or nullptr to only reset the previous one.
+ * @param useArray Whether the textures are read from the texture array.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void RenderCommandList::useBatchShader(const Shader*& current, const Shader* next, bool useArray, GLStateCache& stateCache) {
+    if (current == next) {
+        return;
+    }
+    // Draws outside these paths bind their texture sets, so a shader is not left reading the array
+    if (current != nullptr && useArray) {
+        current->setInt(current->getUniformLocation("useTextureArray"), 0);
+    }
+    current = next;
+    if (next == nullptr) {
+        return;
+    }
+    stateCache.useProgram(next->ID);
+    if (useArray) {
+        next->setInt(next->getUniformLocation("useTextureArray"), 1);
+    }
+}
+
+/**
+ * @brief Returns true when two queued draws can be merged into one instanced draw call.
+ */
+bool RenderCommandList::sameBatch(const QueuedDraw& a, const QueuedDraw& b) {
+    // Each instance reads its own material, so only the bound state has to match
+    return a.key == b.key && a.mesh == b.mesh && a.shader == b.shader;
+}
+
+/**
+ * @brief Draws a list of visible draws with instancing.
+ *
+ * Visible draws that share a mesh and texture set are merged into a single
+ * glDrawElementsInstancedBaseVertex call. Their model matrices are streamed into
+ * an instance buffer bound to attribute locations 3 to 6, and their material ids to location 7,
+ * so the shader must be the instanced variant of 6.multiple_lights.vs. With a texture array,
+ * the texture set is left out of the batch too and each material reads the layers of its textures.
+ *
+ * @param draws The culled draws, with their meshes selected.
+ * @param shader The instanced lighting shader used for the draws.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void RenderCommandList::executeInstanced(const std::vector<VisibleDraw>& draws, const Shader& shader, GLStateCache& stateCache) {
+    drawCallCount = 0;
+    const bool useArray = textureArray != nullptr;
+
+    // Without depth in the key, draws that can share an instanced call sort next to each other
+    buildQueue(draws, shader, false, !useArray);
+    if (drawQueue.empty()) {
+        return;
+    }
+    sortQueueByBatch();
+    uploadInstanceTransforms();
+    uploadInstanceMaterials();
+    materials.upload(textureArray, stateCache);
+
+    const Shader* currentShader = nullptr;
+    if (useArray) {
+        textureArray->bind(stateCache);
+    }
+    size_t batchStart = 0;
+    while (batchStart < drawQueue.size()) {
+        size_t batchEnd = batchStart + 1;
+        while (batchEnd < drawQueue.size() && sameBatch(drawQueue[batchStart], drawQueue[batchEnd])) {
+            batchEnd++;
+        }
+
+        const RenderCommand& command = *drawQueue[batchStart].command;
+        const MeshCreator::GLMesh* mesh = drawQueue[batchStart].mesh;
+        GLsizei instanceCount = static_cast<GLsizei>(batchEnd - batchStart);
+        useBatchShader(currentShader, drawQueue[batchStart].shader, useArray, stateCache);
+
+        if (!useArray) {
+            bindTextures(command, stateCache);
+        }
+
+        // Point the instance attributes of this VAO at the batch's matrices and materials
+        stateCache.bindVertexArray(mesh->vao);
+        bindInstanceAttributes(batchStart, true);
+
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh->nIndices, GL_UNSIGNED_SHORT, mesh->getIndexOffset(), instanceCount, mesh->baseVertex);
+        drawCallCount++;
+        batchStart = batchEnd;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // reset the texture source
+    useBatchShader(currentShader, nullptr, useArray, stateCache);
+}
+
+/**
+ * @brief Returns true when two queued draws share the texture set and vertex array of one multi-draw call.
+ */
+bool RenderCommandList::sameTextureSet(const QueuedDraw& a, const QueuedDraw& b) {
+    return a.key == b.key && a.shader == b.shader;
+}
+
+/**
+ * @brief Sorts the draw queue so that draws sharing a batch sit next to each other.
+ */
+void RenderCommandList::sortQueueByBatch() {
+    // Key before mesh, so the meshes of a texture set are contiguous for the indirect path too
+    arenaStableSort(drawQueue, [](const QueuedDraw& a, const QueuedDraw& b) {
+        return std::tie(a.key, a.mesh) < std::tie(b.key, b.mesh);
+    }, frameArena);
+}
+
+/**
+ * @brief Streams the model matrices of the draw queue, in queue order, into the instance buffer.
+ */
+void RenderCommandList::uploadInstanceTransforms() {
+    instanceTransforms.clear();
+    for (const QueuedDraw& draw : drawQueue) {
+        instanceTransforms.push_back(draw.command->model);
+    }
+    uploadStream(GL_ARRAY_BUFFER, &instanceTransforms[0], instanceTransforms.size() * sizeof(glm::mat4), instanceVbo, instanceCapacity,
+        transformSource, transformOffset);
+}
+
+/**
+ * @brief Streams the material ids of the draw queue, in queue order, into the material buffer.
+ */
+void RenderCommandList::uploadInstanceMaterials() {
+    instanceMaterials.clear();
+    for (const QueuedDraw& draw : drawQueue) {
+        instanceMaterials.push_back(draw.command->materialId);
+    }
+    uploadStream(GL_ARRAY_BUFFER, &instanceMaterials[0], instanceMaterials.size() * sizeof(GLint), materialVbo, materialCapacity,
+        materialSource, materialOffset);
+}
+
+/**
+ * @brief Copies one frame's stream into the ring, or into its own buffer when there is no ring or no room.
+ * @param target The binding the stream is read through.
+ * @param data The bytes of the stream.
+ * @param size The number of bytes.
+ * @param ownBuffer The stream's own buffer, created on first use.
+ * @param ownCapacity The size of ownBuffer in bytes, grown when needed.
+ * @param source Receives the buffer the stream was copied into.
+ * @param offset Receives the offset of the stream in source.
+ */
+void RenderCommandList::uploadStream(GLenum target, const void* data, size_t size, GLuint& ownBuffer, size_t& ownCapacity,
+    GLuint& source, GLintptr& offset) {
+    if (streamBuffer != nullptr) {
+        const GLintptr written = streamBuffer->write(data, static_cast<GLsizeiptr>(size), sizeof(glm::vec4));
+        if (written != StreamBuffer::NO_SPACE) {
+            source = streamBuffer->getBuffer();
+            offset = written;
+            return;
+        }
+    }
+    if (ownBuffer == 0) {
+        glGenBuffers(1, &ownBuffer);
+    }
+    glBindBuffer(target, ownBuffer);
+    if (size > ownCapacity) {
+        ownCapacity = std::max(size, ownCapacity * 2);
+    }
+    // Orphan the previous contents so the driver does not stall on last frame's draws
+    glBufferData(target, ownCapacity, NULL, GL_STREAM_DRAW);
+    glBufferSubData(target, 0, size, data);
+    source = ownBuffer;
+    offset = 0;
+}
+
+/**
+ * @brief Points attribute locations 3 to 6 of the bound VAO at the instance buffer.
+ * @param firstInstance The first matrix read by instance 0.
+ * @param withMaterials Also points attribute location 7 at the material buffer when true, otherwise
+ * disables it so every instance reads NO_MATERIAL.
+ */
+void RenderCommandList::bindInstanceAttributes(size_t firstInstance, bool withMaterials) {
+    // One vec4 column per location
+    glBindBuffer(GL_ARRAY_BUFFER, transformSource);
+    for (GLuint column = 0; column < 4; column++) {
+        GLuint location = 3 + column;
+        size_t offset = transformOffset + firstInstance * sizeof(glm::mat4) + column * sizeof(glm::vec4);
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)offset);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    // A VAO keeps the material attribute of an earlier pass, which may point past the current ids
+    const GLuint materialLocation = 7;
+    if (!withMaterials) {
+        glDisableVertexAttribArray(materialLocation);
+        glVertexAttribI4i(materialLocation, MaterialTable::NO_MATERIAL, 0, 0, 0);
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, materialSource);
+    glEnableVertexAttribArray(materialLocation);
+    glVertexAttribIPointer(materialLocation, 1, GL_INT, sizeof(GLint), (void*)(materialOffset + firstInstance * sizeof(GLint)));
+    glVertexAttribDivisor(materialLocation, 1);
+}
+
+/**
+ * @brief Draws a list of visible draws with multi-draw indirect.
+ *
+ * Every draw that shares a texture set with others, whatever its mesh and material, goes out in one
+ * glMultiDrawElementsIndirect call. One command per mesh is written into the indirect buffer, and
+ * its base instance selects its model matrices in the instance buffer, so the shader is the same
+ * instanced variant used by executeInstanced. Falls back to executeInstanced without GL 4.3.
+ *
+ * @param draws The culled draws, with their meshes selected.
+ * @param shader The instanced lighting shader used for the draws.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void RenderCommandList::executeIndirect(const std::vector<VisibleDraw>& draws, const Shader& shader, GLStateCache& stateCache) {
+    if (!isIndirectSupported()) {
+        executeInstanced(draws, shader, stateCache);
+        return;
+    }
+    drawCallCount = 0;
+    const bool useArray = textureArray != nullptr;
+
+    buildQueue(draws, shader, false, !useArray);
+    if (drawQueue.empty()) {
+        return;
+    }
+    sortQueueByBatch();
+    uploadInstanceTransforms();
+    uploadInstanceMaterials();
+    materials.upload(textureArray, stateCache);
+
+    // One command per run of the same mesh; instances of a command are consecutive matrices
+    indirectCommands.clear();
+    for (size_t i = 0; i < drawQueue.size(); i++) {
+        const MeshCreator::GLMesh* mesh = drawQueue[i].mesh;
+        if (i > 0 && sameBatch(drawQueue[i - 1], drawQueue[i])) {
+            indirectCommands.back().instanceCount++;
+            continue;
+        }
+        DrawElementsIndirectCommand command = { mesh->nIndices, 1, mesh->firstIndex, mesh->baseVertex, static_cast<GLuint>(i) };
+        indirectCommands.push_back(command);
+    }
+
+    uploadStream(GL_DRAW_INDIRECT_BUFFER, &indirectCommands[0], indirectCommands.size() * sizeof(DrawElementsIndirectCommand),
+        indirectBuffer, indirectCapacity, indirectSource, indirectOffset);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectSource);
+
+    const Shader* currentShader = nullptr;
+    if (useArray) {
+        textureArray->bind(stateCache);
+    }
+    size_t groupStart = 0;   // First queued draw of the texture set
+    size_t commandStart = 0; // First indirect command of the texture set
+    while (groupStart < drawQueue.size()) {
+        // The queue and the commands advance together: a command covers a run of one mesh
+        size_t groupEnd = groupStart;
+        size_t commandEnd = commandStart;
+        while (groupEnd < drawQueue.size() && sameTextureSet(drawQueue[groupStart], drawQueue[groupEnd])) {
+            groupEnd += indirectCommands[commandEnd].instanceCount;
+            commandEnd++;
+        }
+
+        const RenderCommand& command = *drawQueue[groupStart].command;
+        useBatchShader(currentShader, drawQueue[groupStart].shader, useArray, stateCache);
+        if (!useArray) {
+            bindTextures(command, stateCache);
+        }
+
+        // The base instance of each command offsets into the matrices and materials, so the attributes start at 0
+        stateCache.bindVertexArray(drawQueue[groupStart].mesh->vao);
+        bindInstanceAttributes(0, true);
+
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, (void*)(indirectOffset + commandStart * sizeof(DrawElementsIndirectCommand)),
+            static_cast<GLsizei>(commandEnd - commandStart), 0);
+        drawCallCount++;
+        groupStart = groupEnd;
+        commandStart = commandEnd;
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // reset the texture source
+    useBatchShader(currentShader, nullptr, useArray, stateCache);
+}
+
+/**
+ * @brief Writes the depth of a list of visible draws, strictly front to back.
+ *
+ * Used as a depth pre-pass: no textures or material uniforms are bound, so the queue is sorted by
+ * depth alone and the nearest occluders fill the depth buffer first. With instancing, draws of one
+ * mesh are merged into one instanced call and the meshes are drawn in the order of their nearest
+ * draw, so the shader must be the instanced variant of the depth program.
+ *
+ * @param draws The culled draws, with their meshes selected.
+ * @param shader The depth-only shader, regular or instanced.
+ * @param instanced Merges the draws of each mesh into one instanced call when true.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void RenderCommandList::executeDepth(const std::vector<VisibleDraw>& draws, const Shader& shader, bool instanced, GLStateCache& stateCache) {
+    depthDrawCallCount = 0;
+
+    // Depth is the only state that matters here
+    drawQueue.clear();
+    triangleCount = 0;
+    for (const VisibleDraw& visible : draws) {
+        QueuedDraw draw = { makeSortKey(0, 0, 0, visible.depth), &commands[visible.command], visible.mesh, &shader };
+        drawQueue.push_back(draw);
+    }
+    if (drawQueue.empty()) {
+        return;
+    }
+    arenaStableSort(drawQueue, [](const QueuedDraw& a, const QueuedDraw& b) { return a.key < b.key; }, frameArena);
+
+    stateCache.useProgram(shader.ID);
+    if (!instanced) {
+        const GLint modelLocation = shader.getUniformLocation("model");
+        for (const QueuedDraw& draw : drawQueue) {
+            shader.setMat4(modelLocation, draw.command->model);
+            stateCache.bindVertexArray(draw.mesh->vao);
+            glDrawElementsBaseVertex(GL_TRIANGLES, draw.mesh->nIndices, GL_UNSIGNED_SHORT, draw.mesh->getIndexOffset(), draw.mesh->baseVertex);
+            depthDrawCallCount++;
+        }
+        return;
+    }
+
+    // Give every draw the key of its mesh's nearest draw, so each mesh's draws become one run
+    // and the runs stay front to back; the stable sort keeps each run front to back too
+    typedef std::pair<const MeshCreator::GLMesh* const, uint64_t> MeshKey;
+    const FrameAllocator<MeshKey> scratch(frameArena);
+    std::map<const MeshCreator::GLMesh*, uint64_t, std::less<const MeshCreator::GLMesh*>, FrameAllocator<MeshKey>> nearestMeshKeys(scratch);
+    for (QueuedDraw& draw : drawQueue) {
+        // The queue is sorted, so a mesh's first draw is its nearest
+        draw.key = nearestMeshKeys.insert(std::make_pair(draw.mesh, draw.key)).first->second;
+    }
+    arenaStableSort(drawQueue, [](const QueuedDraw& a, const QueuedDraw& b) {
+        return std::tie(a.key, a.mesh) < std::tie(b.key, b.mesh);
+    }, frameArena);
+    uploadInstanceTransforms();
+
+    size_t batchStart = 0;
+    while (batchStart < drawQueue.size()) {
+        size_t batchEnd = batchStart + 1;
+        while (batchEnd < drawQueue.size() && drawQueue[batchEnd].mesh == drawQueue[batchStart].mesh) {
+            batchEnd++;
+        }
+
+        const MeshCreator::GLMesh* mesh = drawQueue[batchStart].mesh;
+        stateCache.bindVertexArray(mesh->vao);
+        bindInstanceAttributes(batchStart);
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh->nIndices, GL_UNSIGNED_SHORT, mesh->getIndexOffset(),
+            static_cast<GLsizei>(batchEnd - batchStart), mesh->baseVertex);
+        depthDrawCallCount++;
+        batchStart = batchEnd;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * @brief Returns true when the context supports multi-draw indirect with base instances (GL 4.3).
+ */
+bool RenderCommandList::isIndirectSupported() {
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+/**
+ * @brief Releases the instance, material and indirect buffers and the material table.
+ */
+void RenderCommandList::destroyBuffers() {
+    if (instanceVbo != 0) {
+        glDeleteBuffers(1, &instanceVbo);
+        instanceVbo = 0;
+        instanceCapacity = 0;
+    }
+    if (materialVbo != 0) {
+        glDeleteBuffers(1, &materialVbo);
+        materialVbo = 0;
+        materialCapacity = 0;
+    }
+    materials.destroy();
+    if (indirectBuffer != 0) {
+        glDeleteBuffers(1, &indirectBuffer);
+        indirectBuffer = 0;
+        indirectCapacity = 0;
+    }
+}
@@ -0,0 +1,436 @@
+/**
+ * @file RenderCommand.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the RenderCommand struct and the RenderCommandList class.
+ * Items record their draws into a RenderCommandList once, and the scene replays the recorded
+ * commands every frame instead of rebuilding them.
+ */
+
+#ifndef RENDERCOMMAND_H
+#define RENDERCOMMAND_H
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "MeshCreator.h"
+#include "shader.h"
+#include "ShaderVariants.h"
+#include "camera.h"
+#include "GLStateCache.h"
+#include "Frustum.h"
+#include "LodPolicy.h"
+#include "TextureArray.h"
+#include "MaterialTable.h"
+#include "TransformGraph.h"
+#include "StreamBuffer.h"
+#include "FrameArena.h"
+
+/**
+ * @struct RenderCommand
+ * @brief A single recorded draw of a submesh.
+ *
+ * Stores everything needed to draw one submesh: the high and low detail meshes, the texture set,
+ * the material properties, and the model matrix computed when the item was recorded. The list
+ * interns the texture set and material properties into its MaterialTable.
+ */
+struct RenderCommand
+{
+    const MeshCreator::GLMesh* highMesh = nullptr; // Level 0, drawn when large on screen
+    const MeshCreator::GLMesh* lowMesh = nullptr;  // Level 1 when it differs from highMesh
+    bool useDistanceLod = true;                    // Select the mesh by screen size, otherwise always draw highMesh
+    GLuint diffuseTexture = 0;                     // Texture bound to GL_TEXTURE0
+    GLuint specularTexture = 0;                    // Texture bound to GL_TEXTURE1
+    GLuint overlayTexture = 0;                     // Texture bound to GL_TEXTURE2
+    unsigned short textureSetId = 0;               // Index of the diffuse/specular/overlay combination, assigned by the list
+    unsigned short materialId = 0;                 // Index in the material table, assigned by the list
+    float shininess = 2.0f;                        // material.shininess
+    glm::vec2 uvScale = glm::vec2(1.0f, 1.0f);     // Texture coordinate scale
+    glm::mat4 model = glm::mat4(1.0f);             // World transformation of the submesh
+    glm::vec3 position = glm::vec3(0.0f);          // World position used for the distance check
+    uint32_t transformNode = TransformGraph::NO_NODE; // Node the model matrix was taken from, or NO_NODE
+    AABB bounds;                                   // World bounds of both meshes, used for culling
+};
+
+/**
+ * @struct CommandRange
+ * @brief A contiguous run of commands owned by one item.
+ */
+struct CommandRange
+{
+    size_t first = 0;   // Index of the first command
+    size_t count = 0;   // Number of commands in the run
+};
+
+/**
+ * @struct VisibleDraw
+ * @brief A command that passed culling, with the level of detail selected for it.
+ */
+struct VisibleDraw
+{
+    uint32_t command = 0;                      // Index of the command, which holds the transform and material
+    const MeshCreator::GLMesh* mesh = nullptr; // Mesh of the selected level of detail
+    float depth = 0.0f;                        // Distance to the camera
+};
+
+/**
+ * @class RenderCommandList
+ * @brief A flat array of recorded draws.
+ *
+ * Items append their commands once and overwrite them in place when they change. When executed,
+ * the visible commands are gathered into a draw queue and sorted by a packed 64-bit key
+ * (shader, texture set, VAO, then front-to-back depth) so that state changes are minimized.
+ *
+ * Draws select their material from the Materials uniform block by index rather than through
+ * material uniforms, so draws of different materials share a batch. With a TextureArray, the
+ * instanced and indirect paths also read every texture from its layer instead of binding the
+ * texture set, so draws of different texture sets share a batch too.
+ *
+ * With ShaderVariants set, each draw is shaded by the variant of the frame's features that also
+ * leaves out the overlay when the draw has none. The variant's program is the shader field of the
+ * sort key, so draws of one variant stay together and the program changes once per variant.
+ */
+class RenderCommandList
+{
+private:
+    std::vector<RenderCommand> commands;
+    std::vector<unsigned char> lodLevels;   // Level each command drew last, for hysteresis
+
+    // A visible command paired with the mesh chosen for it this frame
+    struct QueuedDraw
+    {
+        uint64_t key;
+        const RenderCommand* command;
+        const MeshCreator::GLMesh* mesh;
+        const Shader* shader;   // Program the draw is shaded with
+    };
+
+    // Layout of one glMultiDrawElementsIndirect command
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance; // First model matrix of the command in the instance buffer
+    };
+
+    // Texture sets seen so far, keyed by (diffuse, specular, overlay)
+    std::map<std::tuple<GLuint, GLuint, GLuint>, unsigned short> textureSetIds;
+
+    MaterialTable materials;                    // Every material of the recorded commands
+    TextureArray* textureArray = nullptr;       // Layers of the texture sets, when set
+    ShaderVariants* shaderVariants = nullptr;   // Permutations the draws select from, when set
+    unsigned int shaderFeatures = ShaderVariants::ALL_FEATURES; // Features the frame's lights need
+    GLuint materialVbo = 0;                     // Per-instance material ids
+    size_t materialCapacity = 0;                // Size of the material buffer in bytes
+    std::vector<GLint> instanceMaterials;       // Scratch list reused every frame
+
+    GLuint instanceVbo = 0;                     // Per-instance model matrices
+    size_t instanceCapacity = 0;                // Size of the instance buffer in bytes
+    std::vector<QueuedDraw> drawQueue;          // Scratch list reused every frame
+    std::vector<glm::mat4> instanceTransforms;  // Scratch list reused every frame
+    GLuint indirectBuffer = 0;                  // Draw commands of the indirect path
+    size_t indirectCapacity = 0;                // Size of the indirect buffer in bytes
+    std::vector<DrawElementsIndirectCommand> indirectCommands; // Scratch list reused every frame
+    StreamBuffer* streamBuffer = nullptr;       // Ring the per-frame streams are written into, when set
+    GLuint transformSource = 0;                 // Buffer and offset of the last uploaded matrices
+    GLintptr transformOffset = 0;
+    GLuint materialSource = 0;                  // Buffer and offset of the last uploaded material ids
+    GLintptr materialOffset = 0;
+    GLuint indirectSource = 0;                  // Buffer and offset of the last uploaded indirect commands
+    GLintptr indirectOffset = 0;
+    FrameArena* frameArena = nullptr;           // Scratch memory of the sorts, when set
+    size_t drawCallCount = 0;                   // Draw calls issued by the last execute
+    size_t depthDrawCallCount = 0;              // Draw calls issued by the last executeDepth
+    size_t triangleCount = 0;                   // Triangles drawn by the last execute
+
+    /**
+     * @brief Returns the id of a command's texture set, assigning a new one the first time it is seen.
+     */
+    unsigned short getTextureSetId(const RenderCommand& command);
+
+    /**
+     * @brief Returns the id of a command's material in the material table.
+     */
+    unsigned short getMaterialId(const RenderCommand& command);
+
+    /**
+     * @brief Returns the shader a command is drawn with: its variant when variants are set, otherwise the pass's shader.
+     */
+    const Shader& selectShader(const RenderCommand& command, const Shader& shader) const;
+
+    /**
+     * @brief Gathers the visible draws into the draw queue and sorts it.
+     * @param draws The visible draws, with their meshes already selected.
+     * @param shader The shader the draws will use, unless variants are set.
+     * @param withDepth Includes front-to-back depth in the key when true.
+     * @param withTextureSets Includes the texture set in the key when true.
+     */
+    void buildQueue(const std::vector<VisibleDraw>& draws, const Shader& shader, bool withDepth, bool withTextureSets = true);
+
+    /**
+     * @brief Makes a batch's shader current, passing the texture source over from the previous shader.
+     * @param current The shader of the previous batch, or nullptr; receives next.
+     * @param next The shader of the batch, or nullptr to only reset the previous one.
+     * @param useArray Whether the textures are read from the texture array.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    static void useBatchShader(const Shader*& current, const Shader* next, bool useArray, GLStateCache& stateCache);
+
+    /**
+     * @brief Returns true when two queued draws can be merged into one instanced draw call.
+     */
+    static bool sameBatch(const QueuedDraw& a, const QueuedDraw& b);
+
+    /**
+     * @brief Returns true when two queued draws share the texture set and vertex array of one multi-draw call.
+     */
+    static bool sameTextureSet(const QueuedDraw& a, const QueuedDraw& b);
+
+    /**
+     * @brief Sorts the draw queue so that draws sharing a batch sit next to each other.
+     */
+    void sortQueueByBatch();
+
+    /**
+     * @brief Streams the model matrices of the draw queue, in queue order, into the instance buffer.
+     */
+    void uploadInstanceTransforms();
+
+    /**
+     * @brief Streams the material ids of the draw queue, in queue order, into the material buffer.
+     */
+    void uploadInstanceMaterials();
+
+    /**
+     * @brief Copies one frame's stream into the ring, or into its own buffer when there is no ring or no room.
+     * @param target The binding the stream is read through.
+     * @param data The bytes of the stream.
+     * @param size The number of bytes.
+     * @param ownBuffer The stream's own buffer, created on first use.
+     * @param ownCapacity The size of ownBuffer in bytes, grown when needed.
+     * @param source Receives the buffer the stream was copied into.
+     * @param offset Receives the offset of the stream in source.
+     */
+    void uploadStream(GLenum target, const void* data, size_t size, GLuint& ownBuffer, size_t& ownCapacity,
+        GLuint& source, GLintptr& offset);
+
+    /**
+     * @brief Points attribute locations 3 to 6 of the bound VAO at the instance buffer.
+     * @param firstInstance The first matrix read by instance 0.
+     * @param withMaterials Also points attribute location 7 at the material buffer when true, otherwise
+     * disables it so every instance reads NO_MATERIAL.
+     */
+    void bindInstanceAttributes(size_t firstInstance, bool withMaterials = false);
+
+    /**
+     * @brief Binds a command's texture set through the state cache.
+     */
+    static void bindTextures(const RenderCommand& command, GLStateCache& stateCache);
+
+public:
+    /**
+     * @brief Appends a command to the end of the list.
+     * @param command The command to append.
+     * @return The index of the new command.
+     */
+    size_t add(const RenderCommand& command);
+
+    /**
+     * @brief Overwrites a recorded command.
+     * @param index The index of the command to overwrite.
+     * @param command The new command.
+     */
+    void set(size_t index, const RenderCommand& command);
+
+    /**
+     * @brief Removes every recorded command.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of recorded commands.
+     */
+    size_t size() const { return commands.size(); }
+
+    const RenderCommand& operator[](size_t index) const { return commands[index]; }
+
+    /**
+     * @brief Reads the textures of the instanced and indirect paths from a texture array.
+     * @param array The array the texture sets are added to, or nullptr to bind each texture set.
+     */
+    void setTextureArray(TextureArray* array) { textureArray = array; }
+
+    /**
+     * @brief Shades the draws of the next executes with specialized variants instead of the shader passed in.
+     * @param variants The permutations of that shader, or nullptr to draw everything with it.
+     * @param features The features every draw needs this frame; OVERLAY is added per draw.
+     */
+    void setShaderVariants(ShaderVariants* variants, unsigned int features) {
+        shaderVariants = variants;
+        shaderFeatures = features;
+    }
+
+    /**
+     * @brief Writes the instance matrices, material ids and indirect commands into a ring instead of orphaned buffers.
+     * @param buffer The ring, or nullptr to use the list's own buffers.
+     */
+    void setStreamBuffer(StreamBuffer* buffer) { streamBuffer = buffer; }
+
+    /**
+     * @brief Takes the scratch memory of the draw sorts from a frame arena instead of the heap.
+     * @param arena The arena, reset after the frame, or nullptr to use the heap.
+     */
+    void setFrameArena(FrameArena* arena) { frameArena = arena; }
+
+    /**
+     * @brief Returns the number of distinct materials in the material table.
+     */
+    size_t getMaterialCount() const { return materials.size(); }
+
+    /**
+     * @brief Packs a draw's state into a sort key.
+     *
+     * From most to least significant: 8 bits of shader, 16 bits of texture set, 16 bits of VAO and
+     * 24 bits of depth, so that sorting by key groups draws by the most expensive state change first
+     * and orders draws sharing all state front to back.
+     *
+     * @param shader The program handle.
+     * @param textureSetId The texture set id.
+     * @param vao The vertex array handle.
+     * @param depth The distance to the camera.
+     * @return The packed key.
+     */
+    static uint64_t makeSortKey(GLuint shader, unsigned short textureSetId, GLuint vao, float depth);
+
+    /**
+     * @brief Writes the level of detail meshes of a command, most detailed first.
+     *
+     * The high and low meshes come first, followed by the levels generated below the coarsest of them.
+     *
+     * @param command The command to resolve.
+     * @param levels Receives up to LodPolicy::MAX_LEVELS meshes.
+     * @return The number of levels.
+     */
+    static int getLodMeshes(const RenderCommand& command, const MeshCreator::GLMesh* levels[LodPolicy::MAX_LEVELS]);
+
+    /**
+     * @brief Culls the commands of a run of ranges and selects their level of detail.
+     *
+     * Commands whose bounds lie outside the frustum or that are too small on screen are dropped.
+     * The level each command selects is kept for the next frame's hysteresis. Makes no GL calls
+     * and writes only the levels of the given commands, so disjoint runs can be processed on
+     * different threads.
+     *
+     * @param ranges The command ranges of the visible items.
+     * @param firstRange The first range to process.
+     * @param endRange One past the last range to process.
+     * @param frustum The view frustum.
+     * @param planeCount The number of frustum planes to test, starting with the near plane.
+     * @param lodPolicy The thresholds the levels are selected with.
+     * @param lodView The camera values of the frame.
+     * @param draws Receives one entry per command that is drawn, in command order.
+     */
+    void cullCommands(const std::vector<CommandRange>& ranges, size_t firstRange, size_t endRange, const Frustum& frustum,
+        int planeCount, const LodPolicy& lodPolicy, const LodView& lodView, std::vector<VisibleDraw>& draws);
+
+    /**
+     * @brief Draws a single command immediately.
+     *
+     * Binds the texture set, sets the material uniforms and the model matrix, and draws the
+     * most detailed mesh.
+     *
+     * @param command The command to draw.
+     * @param shader The lighting shader used for the draw.
+     */
+    static void draw(const RenderCommand& command, const Shader& shader);
+
+    /**
+     * @brief Draws a list of visible draws.
+     *
+     * Sorts the draws by key, binds the texture set, selects the material and sets the model matrix,
+     * and issues the draw for each entry. Binds go through the state cache and the material index is
+     * only re-sent when it differs from the previous draw.
+     *
+     * @param draws The culled draws, with their meshes selected.
+     * @param shader The lighting shader used for the draws.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void execute(const std::vector<VisibleDraw>& draws, const Shader& shader, GLStateCache& stateCache);
+
+    /**
+     * @brief Draws a list of visible draws with instancing.
+     *
+     * Visible draws that share a mesh and texture set are merged into a single
+     * glDrawElementsInstancedBaseVertex call. Their model matrices are streamed into
+     * an instance buffer bound to attribute locations 3 to 6, and their material ids to location 7,
+     * so the shader must be the instanced variant of 6.multiple_lights.vs. With a texture array,
+     * the texture set is left out of the batch too and each material reads the layers of its textures.
+     *
+     * @param draws The culled draws, with their meshes selected.
+     * @param shader The instanced lighting shader used for the draws.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void executeInstanced(const std::vector<VisibleDraw>& draws, const Shader& shader, GLStateCache& stateCache);
+
+    /**
+     * @brief Draws a list of visible draws with multi-draw indirect.
+     *
+     * Every draw that shares a texture set with others, whatever its mesh and material, goes out in one
+     * glMultiDrawElementsIndirect call. One command per mesh is written into the indirect buffer, and
+     * its base instance selects its model matrices in the instance buffer, so the shader is the same
+     * instanced variant used by executeInstanced. Falls back to executeInstanced without GL 4.3.
+     *
+     * @param draws The culled draws, with their meshes selected.
+     * @param shader The instanced lighting shader used for the draws.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void executeIndirect(const std::vector<VisibleDraw>& draws, const Shader& shader, GLStateCache& stateCache);
+
+    /**
+     * @brief Writes the depth of a list of visible draws, strictly front to back.
+     *
+     * Used as a depth pre-pass: no textures or material uniforms are bound, so the queue is sorted by
+     * depth alone and the nearest occluders fill the depth buffer first. With instancing, draws of one
+     * mesh are merged into one instanced call and the meshes are drawn in the order of their nearest
+     * draw, so the shader must be the instanced variant of the depth program.
+     *
+     * @param draws The culled draws, with their meshes selected.
+     * @param shader The depth-only shader, regular or instanced.
+     * @param instanced Merges the draws of each mesh into one instanced call when true.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void executeDepth(const std::vector<VisibleDraw>& draws, const Shader& shader, bool instanced, GLStateCache& stateCache);
+
+    /**
+     * @brief Returns true when the context supports multi-draw indirect with base instances (GL 4.3).
+     */
+    static bool isIndirectSupported();
+
+    /**
+     * @brief Returns the number of draw calls issued by the last execute.
+     */
+    size_t getDrawCallCount() const { return drawCallCount; }
+
+    /**
+     * @brief Returns the number of draw calls issued by the last executeDepth.
+     */
+    size_t getDepthDrawCallCount() const { return depthDrawCallCount; }
+
+    /**
+     * @brief Returns the number of triangles drawn by the last execute.
+     */
+    size_t getTriangleCount() const { return triangleCount; }
+
+    /**
+     * @brief Releases the instance, material and indirect buffers and the material table.
+     */
+    void destroyBuffers();
+};
+#endif // RENDERCOMMAND_H
@@ -0,0 +1,154 @@
+/**
+ * @file ResourceManager.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the ResourceManager class.
+ */
+
+#include "ResourceManager.h"
+#include <iostream>
+
+const size_t ResourceManager::DEFAULT_BUDGET_BYTES;
+
+/**
+ * @brief Creates the manager.
+ * @param loader The loader that streams the texture files in.
+ * @param budgetBytes The resident bytes above which unreferenced textures are evicted.
+ */
+ResourceManager::ResourceManager(TextureLoader& loader, size_t budgetBytes)
+    : loader(loader), budgetBytes(budgetBytes) {
+}
+
+/**
+ * @brief Creates a texture showing the placeholder; its file is read once it is first acquired.
+ * @param path The file path to the texture image.
+ * @param wrapMode The wrapping mode for the texture (e.g., GL_REPEAT, GL_CLAMP_TO_EDGE).
+ * @return The ID of the generated texture.
+ */
+GLuint ResourceManager::registerTexture(const char* path, GLint wrapMode) {
+    GLuint texture = loader.createTexture(wrapMode);
+    resources[texture].path = path;
+    return texture;
+}
+
+/**
+ * @brief Adds a reference to a texture, streaming it in when it is not resident.
+ * @param texture A registered texture; other textures and 0 are ignored.
+ */
+void ResourceManager::acquire(GLuint texture) {
+    std::map<GLuint, Resource>::iterator found = resources.find(texture);
+    if (found == resources.end()) {
+        return;
+    }
+    Resource& resource = found->second;
+    resource.references++;
+    removeLru(resource);
+    if (resource.state == State::Unloaded) {
+        loader.streamTexture(texture, resource.path.c_str());
+        resource.state = State::Loading;
+    }
+}
+
+/**
+ * @brief Removes a reference from a texture. Without references it may be evicted.
+ * @param texture A registered texture; other textures and 0 are ignored.
+ */
+void ResourceManager::release(GLuint texture) {
+    std::map<GLuint, Resource>::iterator found = resources.find(texture);
+    if (found == resources.end() || found->second.references == 0) {
+        return;
+    }
+    Resource& resource = found->second;
+    resource.references--;
+    if (resource.references == 0 && resource.state == State::Resident) {
+        pushLru(texture, resource);
+    }
+}
+
+/**
+ * @brief Accounts the textures the loader uploaded this frame and evicts down to the budget.
+ *
+ * Must be called after TextureLoader::update.
+ */
+void ResourceManager::update() {
+    evictions.clear();
+    for (const TextureLoader::Upload& upload : loader.getUploads()) {
+        std::map<GLuint, Resource>::iterator found = resources.find(upload.texture);
+        if (found == resources.end()) {
+            continue;
+        }
+        Resource& resource = found->second;
+        resource.state = State::Resident;
+        resource.bytes = upload.bytes;
+        textureBytes += upload.bytes;
+        // Released while it was loading
+        if (resource.references == 0) {
+            pushLru(upload.texture, resource);
+        }
+    }
+
+    while (getResidentBytes() > budgetBytes && !lru.empty()) {
+        GLuint texture = lru.front();
+        Resource& resource = resources[texture];
+        removeLru(resource);
+        loader.unloadTexture(texture);
+        evictions.push_back(texture);
+        textureBytes -= resource.bytes;
+        evictedBytes += resource.bytes;
+        evictionCount++;
+        resource.bytes = 0;
+        resource.state = State::Unloaded;
+    }
+}
+
+/**
+ * @brief Prints the resident, pinned and evicted bytes against the budget.
+ */
+void ResourceManager::printStats() const {
+    size_t residentCount = 0;
+    size_t loadingCount = 0;
+    for (const std::pair<const GLuint, Resource>& entry : resources) {
+        if (entry.second.state == State::Resident) {
+            residentCount++;
+        }
+        else if (entry.second.state == State::Loading) {
+            loadingCount++;
+        }
+    }
+    std::cout << "Resources: " << getResidentBytes() / 1024 << " of " << budgetBytes / 1024 << " KB resident ("
+        << residentCount << " of " << resources.size() << " textures, " << loadingCount << " loading, "
+        << pinnedBytes / 1024 << " KB pinned, " << arrayBytes / 1024 << " KB in the array), " << evictedBytes / 1024 << " KB evicted in "
+        << evictionCount << " evictions" << std::endl;
+}
+
+/**
+ * @brief Forgets every texture. The textures themselves are deleted by their owner.
+ */
+void ResourceManager::destroy() {
+    resources.clear();
+    lru.clear();
+    evictions.clear();
+    textureBytes = 0;
+    pinnedBytes = 0;
+    arrayBytes = 0;
+}
+
+/**
+ * @brief Lists a resident texture without references as the most recently used.
+ */
+void ResourceManager::pushLru(GLuint texture, Resource& resource) {
+    removeLru(resource);
+    resource.lruEntry = lru.insert(lru.end(), texture);
+    resource.inLru = true;
+}
+
+/**
+ * @brief Takes a texture off the least recently used list.
+ */
+void ResourceManager::removeLru(Resource& resource) {
+    if (resource.inLru) {
+        lru.erase(resource.lruEntry);
+        resource.inLru = false;
+    }
+}
@@ -0,0 +1,153 @@
+/**
+ * @file ResourceManager.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the ResourceManager class, which streams textures in
+ * while the scene needs them and evicts the least recently used ones under a memory budget.
+ */
+
+#ifndef RESOURCEMANAGER_H
+#define RESOURCEMANAGER_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+#include "TextureLoader.h"
+
+/**
+ * @class ResourceManager
+ * @brief Reference-counted textures that are resident only while used or while the budget allows.
+ *
+ * A registered texture is created with the placeholder and keeps its name for its whole life, so
+ * scene objects and recorded commands can hold it before it is loaded. The first reference streams
+ * its file in through the TextureLoader. When the last reference is released the texture stays
+ * resident, and joins the least recently used list. Each update evicts from the front of that list,
+ * putting the placeholder back, until the resident bytes fit the budget. Referenced textures are
+ * never evicted, so the budget can be exceeded while the scene needs more than it allows.
+ *
+ * Memory that is always resident, such as the shared mesh buffers, is counted against the budget
+ * as pinned bytes, and so are the texture array's copies of the textures.
+ */
+class ResourceManager
+{
+public:
+    // Budget used when none is given on the command line
+    static const size_t DEFAULT_BUDGET_BYTES = 256 * 1024 * 1024;
+
+    /**
+     * @brief Creates the manager.
+     * @param loader The loader that streams the texture files in.
+     * @param budgetBytes The resident bytes above which unreferenced textures are evicted.
+     */
+    ResourceManager(TextureLoader& loader, size_t budgetBytes);
+
+    /**
+     * @brief Creates a texture showing the placeholder; its file is read once it is first acquired.
+     * @param path The file path to the texture image.
+     * @param wrapMode The wrapping mode for the texture (e.g., GL_REPEAT, GL_CLAMP_TO_EDGE).
+     * @return The ID of the generated texture.
+     */
+    GLuint registerTexture(const char* path, GLint wrapMode);
+
+    /**
+     * @brief Adds a reference to a texture, streaming it in when it is not resident.
+     * @param texture A registered texture; other textures and 0 are ignored.
+     */
+    void acquire(GLuint texture);
+
+    /**
+     * @brief Removes a reference from a texture. Without references it may be evicted.
+     * @param texture A registered texture; other textures and 0 are ignored.
+     */
+    void release(GLuint texture);
+
+    /**
+     * @brief Counts memory that is always resident against the budget.
+     * @param bytes The bytes to add.
+     */
+    void addPinnedBytes(size_t bytes) { pinnedBytes += bytes; }
+
+    /**
+     * @brief Counts the texture array against the budget; it only grows, so it is set each frame.
+     * @param bytes The GPU memory of the array.
+     */
+    void setArrayBytes(size_t bytes) { arrayBytes = bytes; }
+
+    /**
+     * @brief Accounts the textures the loader uploaded this frame and evicts down to the budget.
+     *
+     * Must be called after TextureLoader::update.
+     */
+    void update();
+
+    /**
+     * @brief Returns the textures evicted by the last update.
+     */
+    const std::vector<GLuint>& getEvictions() const { return evictions; }
+
+    /**
+     * @brief Returns the resident bytes, pinned and array bytes included.
+     */
+    size_t getResidentBytes() const { return textureBytes + pinnedBytes + arrayBytes; }
+
+    /**
+     * @brief Returns the bytes evicted so far.
+     */
+    size_t getEvictedBytes() const { return evictedBytes; }
+
+    /**
+     * @brief Prints the resident, pinned and evicted bytes against the budget.
+     */
+    void printStats() const;
+
+    /**
+     * @brief Forgets every texture. The textures themselves are deleted by their owner.
+     */
+    void destroy();
+
+private:
+    // Where a texture's file is
+    enum class State
+    {
+        Unloaded,   // Shows the placeholder
+        Loading,    // Queued on the loader
+        Resident    // Uploaded
+    };
+
+    // A registered texture
+    struct Resource
+    {
+        std::string path;
+        State state = State::Unloaded;
+        int references = 0;
+        size_t bytes = 0;                        // Estimated GPU memory while resident
+        bool inLru = false;                      // True while listed in lru
+        std::list<GLuint>::iterator lruEntry;    // Position in lru while inLru
+    };
+
+    TextureLoader& loader;
+    std::map<GLuint, Resource> resources;
+    std::list<GLuint> lru;          // Resident textures without references, least recently used first
+    size_t budgetBytes;
+    size_t pinnedBytes = 0;
+    size_t arrayBytes = 0;          // Bytes of the texture array
+    size_t textureBytes = 0;        // Bytes of the resident textures
+    size_t evictedBytes = 0;
+    size_t evictionCount = 0;
+    std::vector<GLuint> evictions;  // Textures evicted by the last update
+
+    /**
+     * @brief Lists a resident texture without references as the most recently used.
+     */
+    void pushLru(GLuint texture, Resource& resource);
+
+    /**
+     * @brief Takes a texture off the least recently used list.
+     */
+    void removeLru(Resource& resource);
+};
+#endif // RESOURCEMANAGER_H
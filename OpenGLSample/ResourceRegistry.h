@@ -0,0 +1,50 @@
+/**
+ * @file ResourceRegistry.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the ResourceRegistry class, which gives scene objects
+ * shared access to the mesh, texture and shader tables.
+ */
+
+#ifndef RESOURCEREGISTRY_H
+#define RESOURCEREGISTRY_H
+
+#include "MeshCreator.h"
+#include "Textures.h"
+#include "shader.h"
+
+/**
+ * @class ResourceRegistry
+ * @brief Shared, read-only view of the GPU resources used by scene objects.
+ *
+ * The registry does not own the resources; main() creates and destroys them. Items keep a
+ * reference to the registry instead of copying every GLMesh and texture handle, so an item costs
+ * the same no matter how many resources exist.
+ */
+class ResourceRegistry
+{
+private:
+    const MeshCreator& meshes;
+    const Textures& textures;
+    const Shader& lightingShader;
+
+public:
+    /**
+     * @brief Constructor for the ResourceRegistry class.
+     * @param meshTable The meshes created by MeshCreator::createMeshes.
+     * @param textureTable The textures created by Textures::createTextures.
+     * @param shader The lighting shader used for immediate draws.
+     */
+    ResourceRegistry(const MeshCreator& meshTable, const Textures& textureTable, const Shader& shader)
+        : meshes(meshTable), textures(textureTable), lightingShader(shader) {}
+
+    // The registry is shared by reference only
+    ResourceRegistry(const ResourceRegistry&) = delete;
+    ResourceRegistry& operator=(const ResourceRegistry&) = delete;
+
+    const MeshCreator& getMeshes() const { return meshes; }
+    const Textures& getTextures() const { return textures; }
+    const Shader& getLightingShader() const { return lightingShader; }
+};
+#endif // RESOURCEREGISTRY_H
@@ -0,0 +1,245 @@
+/**
+ * @file SceneFile.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the SceneFile class.
+ */
+
+#include "SceneFile.h"
+#include <fstream>
+#include <iostream>
+
+const uint32_t SceneFile::MAGIC;
+const uint32_t SceneFile::VERSION;
+const uint32_t SceneFile::NO_ID;
+
+// Unnamed namespace
+namespace
+{
+    // Mesh IDs; new meshes go at the end so older files keep their meaning
+    MeshCreator::GLMesh MeshCreator::* const MESHES[] = {
+        &MeshCreator::gPlaneMesh, &MeshCreator::gPyramidMesh, &MeshCreator::gFrustumPyramidMesh,
+        &MeshCreator::gCylinderMesh, &MeshCreator::gLowCylinderMesh, &MeshCreator::gCubeMesh,
+        &MeshCreator::gSphereMesh, &MeshCreator::gLowSphereMesh, &MeshCreator::gTorusMesh,
+        &MeshCreator::gLowTorusMesh, &MeshCreator::gConeMesh, &MeshCreator::gSkyboxMesh
+    };
+    const uint32_t MESH_COUNT = sizeof(MESHES) / sizeof(MESHES[0]);
+
+    // Texture IDs, in the same way
+    GLuint Textures::* const TEXTURES[] = {
+        &Textures::gTextureFence, &Textures::gTextureGrass, &Textures::gTextureDesk, &Textures::gTextureHammerHead,
+        &Textures::gSpecularHammerHead, &Textures::gTextureWood, &Textures::gTextureGreen, &Textures::gTextureClear,
+        &Textures::gTextureOrange, &Textures::gTextureYellow, &Textures::gTextureEyes, &Textures::gTextureQuestion,
+        &Textures::gTextureBrass, &Textures::gTextureSnowflakes, &Textures::gTextureLeaf, &Textures::gTextureLeaf2,
+        &Textures::gTexture4Panel, &Textures::gTextureDrinkFront, &Textures::gTextureDrinkTop, &Textures::gSpecularLow,
+        &Textures::gSpecularPlastic, &Textures::gSpecularMetal, &Textures::gTextureBrick
+    };
+    const uint32_t TEXTURE_COUNT = sizeof(TEXTURES) / sizeof(TEXTURES[0]);
+
+    /**
+     * @brief Returns true for a texture ID a record may hold.
+     */
+    bool isTextureId(uint32_t id) {
+        return id == SceneFile::NO_ID || id < TEXTURE_COUNT;
+    }
+
+    /**
+     * @brief Writes a record array.
+     */
+    template <typename T>
+    void writeRecords(std::ofstream& file, const std::vector<T>& records) {
+        if (!records.empty()) {
+            file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+        }
+    }
+}
+
+// The records are read in place, so they must hold only 32-bit fields
+static_assert(sizeof(SceneFile::TableSetRecord) == 16 * 4, "TableSetRecord must not be padded");
+static_assert(sizeof(SceneFile::ItemRecord) == 3 * 4, "ItemRecord must not be padded");
+static_assert(sizeof(SceneFile::CommandRecord) == 25 * 4, "CommandRecord must not be padded");
+static_assert(sizeof(BSPTree::NodeData) == 6 * 4, "BSPTree::NodeData must not be padded");
+static_assert(sizeof(SceneFile::FireflyRecord) == 4 * 4, "FireflyRecord must not be padded");
+
+/**
+ * @brief Writes a scene file.
+ * @param path The file path of the scene file.
+ * @param contents The records to write.
+ * @return True when the file was written.
+ */
+bool SceneFile::write(const char* path, const Contents& contents) {
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.fireflySeed = contents.fireflySeed;
+    header.sectionCount = SECTION_COUNT;
+    const size_t counts[SECTION_COUNT] = {
+        contents.tableSets.size(), contents.items.size(), contents.commands.size(), contents.treeNodes.size(), contents.fireflies.size()
+    };
+    size_t offset = sizeof(Header);
+    for (int section = 0; section < SECTION_COUNT; section++) {
+        header.sections[section].offset = static_cast<uint32_t>(offset);
+        header.sections[section].count = static_cast<uint32_t>(counts[section]);
+        offset += counts[section] * getRecordSize(static_cast<Section>(section));
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "ERROR::SCENEFILE::FILE_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeRecords(file, contents.tableSets);
+    writeRecords(file, contents.items);
+    writeRecords(file, contents.commands);
+    writeRecords(file, contents.treeNodes);
+    writeRecords(file, contents.fireflies);
+    if (!file) {
+        std::cout << "ERROR::SCENEFILE::FILE_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+    std::cout << "Scene file: " << contents.items.size() << " items, " << contents.commands.size() << " draws, "
+        << offset << " bytes written to " << path << std::endl;
+    return true;
+}
+
+/**
+ * @brief Reads a scene file, replacing the loaded one.
+ *
+ * The header, the section bounds and every index and ID are checked, so the records can be
+ * used without further checks.
+ *
+ * @param path The file path of the scene file.
+ * @return False when the file is missing or is not a valid scene file of this version.
+ */
+bool SceneFile::load(const char* path) {
+    storage.clear();
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cout << "ERROR::SCENEFILE::FILE_NOT_FOUND " << path << std::endl;
+        return false;
+    }
+    const std::streamoff size = file.tellg();
+    if (size < static_cast<std::streamoff>(sizeof(Header)) || size % sizeof(uint32_t) != 0) {
+        std::cout << "ERROR::SCENEFILE::BAD_SIZE " << path << std::endl;
+        return false;
+    }
+
+    // One read; the records are used where they land
+    storage.resize(static_cast<size_t>(size) / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(storage.data()), size);
+    if (!file) {
+        std::cout << "ERROR::SCENEFILE::READ_FAILED " << path << std::endl;
+        storage.clear();
+        return false;
+    }
+
+    const Header& header = getHeader();
+    if (header.magic != MAGIC || header.version != VERSION || header.sectionCount != SECTION_COUNT) {
+        std::cout << "ERROR::SCENEFILE::UNSUPPORTED_FORMAT " << path << std::endl;
+        storage.clear();
+        return false;
+    }
+    for (int section = 0; section < SECTION_COUNT; section++) {
+        const SectionEntry& entry = header.sections[section];
+        const uint64_t end = entry.offset + static_cast<uint64_t>(entry.count) * getRecordSize(static_cast<Section>(section));
+        if (entry.offset < sizeof(Header) || entry.offset % sizeof(uint32_t) != 0 || end > static_cast<uint64_t>(size)) {
+            std::cout << "ERROR::SCENEFILE::BAD_SECTION " << section << " " << path << std::endl;
+            storage.clear();
+            return false;
+        }
+    }
+    if (!validate()) {
+        std::cout << "ERROR::SCENEFILE::BAD_RECORD " << path << std::endl;
+        storage.clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks the indices and IDs of the loaded records.
+ */
+bool SceneFile::validate() const {
+    const ItemRecord* items = getItems();
+    for (size_t i = 0; i < getCount(ITEMS); i++) {
+        const ItemRecord& item = items[i];
+        if ((item.tableSet != NO_ID && item.tableSet >= getCount(TABLE_SETS))
+            || static_cast<uint64_t>(item.firstCommand) + item.commandCount > getCount(COMMANDS)) {
+            return false;
+        }
+    }
+    const CommandRecord* commands = getCommands();
+    for (size_t i = 0; i < getCount(COMMANDS); i++) {
+        const CommandRecord& command = commands[i];
+        if (command.highMesh >= MESH_COUNT || command.lowMesh >= MESH_COUNT || !isTextureId(command.diffuseTexture)
+            || !isTextureId(command.specularTexture) || !isTextureId(command.overlayTexture)) {
+            return false;
+        }
+    }
+    // The tree's structure is checked when it is set, against the items it was given
+    return true;
+}
+
+/**
+ * @brief Returns the record size of a section.
+ */
+size_t SceneFile::getRecordSize(Section section) {
+    switch (section) {
+    case TABLE_SETS:
+        return sizeof(TableSetRecord);
+    case ITEMS:
+        return sizeof(ItemRecord);
+    case COMMANDS:
+        return sizeof(CommandRecord);
+    case TREE_NODES:
+        return sizeof(BSPTree::NodeData);
+    case FIREFLIES:
+        return sizeof(FireflyRecord);
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Returns the ID of a mesh, or NO_ID when it is not one of the named meshes.
+ */
+uint32_t SceneFile::getMeshId(const MeshCreator& meshes, const MeshCreator::GLMesh* mesh) {
+    for (uint32_t id = 0; id < MESH_COUNT; id++) {
+        if (&(meshes.*MESHES[id]) == mesh) {
+            return id;
+        }
+    }
+    return NO_ID;
+}
+
+/**
+ * @brief Returns the mesh of an ID checked by load.
+ */
+const MeshCreator::GLMesh* SceneFile::getMesh(const MeshCreator& meshes, uint32_t id) {
+    return &(meshes.*MESHES[id]);
+}
+
+/**
+ * @brief Returns the ID of a texture handle, or NO_ID for no texture or a handle that is not a scene texture.
+ */
+uint32_t SceneFile::getTextureId(const Textures& textures, GLuint texture) {
+    if (texture == 0) {
+        return NO_ID;
+    }
+    for (uint32_t id = 0; id < TEXTURE_COUNT; id++) {
+        if (textures.*TEXTURES[id] == texture) {
+            return id;
+        }
+    }
+    return NO_ID;
+}
+
+/**
+ * @brief Returns the texture handle of an ID checked by load, or 0 for NO_ID.
+ */
+GLuint SceneFile::getTexture(const Textures& textures, uint32_t id) {
+    return id == NO_ID ? 0 : textures.*TEXTURES[id];
+}
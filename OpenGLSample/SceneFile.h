@@ -0,0 +1,185 @@
+/**
+ * @file SceneFile.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the SceneFile class, which writes and reads the binary
+ * scene description: the table sets, the items and their recorded draws, the BSP nodes and the fireflies.
+ */
+
+#ifndef SCENEFILE_H
+#define SCENEFILE_H
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+
+#include "BSPTree.h"
+#include "MeshCreator.h"
+#include "Textures.h"
+
+/**
+ * @class SceneFile
+ * @brief A scene as flat arrays of fixed-size records, read in one piece and used in place.
+ *
+ * The file starts with a header that gives the offset and record count of each section. Every
+ * record is made of 32-bit fields, so the sections stay aligned and the loaded bytes are used as
+ * the record arrays without parsing; a memory-mapped file could be used the same way. Draws name
+ * their meshes and textures by ID, an index into fixed tables of the MeshCreator and Textures
+ * members, since GL handles change from run to run. The BSP nodes are stored as the tree built
+ * them, so a loaded scene skips the build.
+ */
+class SceneFile
+{
+public:
+    static const uint32_t MAGIC = 0x424E4353;   // "SCNB"
+    static const uint32_t VERSION = 1;
+    static const uint32_t NO_ID = 0xffffffffu;  // No table set, or no texture
+
+    // The record arrays, in file order
+    enum Section
+    {
+        TABLE_SETS, ITEMS, COMMANDS, TREE_NODES, FIREFLIES, SECTION_COUNT
+    };
+
+    // Placement of a table set, parent of the items on it
+    struct TableSetRecord
+    {
+        float transform[16];
+    };
+
+    // An item and its run of command records
+    struct ItemRecord
+    {
+        uint32_t tableSet;      // Index of the item's table set, or NO_ID for a top-level item
+        uint32_t firstCommand;
+        uint32_t commandCount;
+    };
+
+    // One recorded draw of an item
+    struct CommandRecord
+    {
+        float local[16];        // Matrix of the submesh relative to its item
+        float uvScale[2];
+        float shininess;
+        uint32_t highMesh;      // Mesh IDs
+        uint32_t lowMesh;
+        uint32_t diffuseTexture;  // Texture IDs, or NO_ID
+        uint32_t specularTexture;
+        uint32_t overlayTexture;
+        uint32_t useDistanceLod;  // 1 to select the mesh by screen size
+    };
+
+    // A firefly's spawn point and speed
+    struct FireflyRecord
+    {
+        float position[3];
+        float speed;
+    };
+
+    // Everything a scene file holds, gathered before it is written
+    struct Contents
+    {
+        uint32_t fireflySeed = 0;
+        std::vector<TableSetRecord> tableSets;
+        std::vector<ItemRecord> items;
+        std::vector<CommandRecord> commands;
+        std::vector<BSPTree::NodeData> treeNodes;   // Items are indices into items
+        std::vector<FireflyRecord> fireflies;
+    };
+
+    /**
+     * @brief Writes a scene file.
+     * @param path The file path of the scene file.
+     * @param contents The records to write.
+     * @return True when the file was written.
+     */
+    static bool write(const char* path, const Contents& contents);
+
+    /**
+     * @brief Reads a scene file, replacing the loaded one.
+     *
+     * The header, the section bounds and every index and ID are checked, so the records can be
+     * used without further checks.
+     *
+     * @param path The file path of the scene file.
+     * @return False when the file is missing or is not a valid scene file of this version.
+     */
+    bool load(const char* path);
+
+    /**
+     * @brief Returns the number of records in a section of the loaded file.
+     */
+    size_t getCount(Section section) const { return storage.empty() ? 0 : getHeader().sections[section].count; }
+
+    /**
+     * @brief Returns the seed of the firefly movement.
+     */
+    uint32_t getFireflySeed() const { return storage.empty() ? 0 : getHeader().fireflySeed; }
+
+    const TableSetRecord* getTableSets() const { return getSection<TableSetRecord>(TABLE_SETS); }
+    const ItemRecord* getItems() const { return getSection<ItemRecord>(ITEMS); }
+    const CommandRecord* getCommands() const { return getSection<CommandRecord>(COMMANDS); }
+    const BSPTree::NodeData* getTreeNodes() const { return getSection<BSPTree::NodeData>(TREE_NODES); }
+    const FireflyRecord* getFireflies() const { return getSection<FireflyRecord>(FIREFLIES); }
+
+    /**
+     * @brief Returns the ID of a mesh, or NO_ID when it is not one of the named meshes.
+     */
+    static uint32_t getMeshId(const MeshCreator& meshes, const MeshCreator::GLMesh* mesh);
+
+    /**
+     * @brief Returns the mesh of an ID checked by load.
+     */
+    static const MeshCreator::GLMesh* getMesh(const MeshCreator& meshes, uint32_t id);
+
+    /**
+     * @brief Returns the ID of a texture handle, or NO_ID for no texture or a handle that is not a scene texture.
+     */
+    static uint32_t getTextureId(const Textures& textures, GLuint texture);
+
+    /**
+     * @brief Returns the texture handle of an ID checked by load, or 0 for NO_ID.
+     */
+    static GLuint getTexture(const Textures& textures, uint32_t id);
+
+private:
+    struct SectionEntry
+    {
+        uint32_t offset;    // Bytes from the start of the file
+        uint32_t count;     // Records in the section
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t fireflySeed;
+        uint32_t sectionCount;
+        SectionEntry sections[SECTION_COUNT];
+    };
+
+    // The whole file; 32-bit words keep every record aligned
+    std::vector<uint32_t> storage;
+
+    /**
+     * @brief Returns the record size of a section.
+     */
+    static size_t getRecordSize(Section section);
+
+    /**
+     * @brief Checks the indices and IDs of the loaded records.
+     */
+    bool validate() const;
+
+    const Header& getHeader() const { return *reinterpret_cast<const Header*>(storage.data()); }
+
+    template <typename T>
+    const T* getSection(Section section) const {
+        if (storage.empty()) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T*>(reinterpret_cast<const unsigned char*>(storage.data()) + getHeader().sections[section].offset);
+    }
+};
+#endif // SCENEFILE_H
@@ -0,0 +1,34 @@
+/**
+ * @file SceneFileItem.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the SceneFileItem class methods.
+ */
+
+#include "SceneFileItem.h"
+#include <glm/gtc/type_ptr.hpp>
+
+/**
+ * @brief Renders the item from its command records.
+ */
+void SceneFileItem::render() {
+    const Transform noTransform;
+    for (size_t i = 0; i < commandCount; i++) {
+        const SceneFile::CommandRecord& command = commands[i];
+        setShininess(command.shininess);
+        bindTexture(GL_TEXTURE0, SceneFile::getTexture(gTexture, command.diffuseTexture));
+        bindTexture(GL_TEXTURE1, SceneFile::getTexture(gTexture, command.specularTexture));
+        bindTexture(GL_TEXTURE2, SceneFile::getTexture(gTexture, command.overlayTexture));
+        setUVScale(glm::vec2(command.uvScale[0], command.uvScale[1]));
+
+        glm::vec3 translationVec = setLocalTransform(glm::make_mat4(command.local), noTransform);
+        const MeshCreator::GLMesh* highMesh = SceneFile::getMesh(gMesh, command.highMesh);
+        if (command.useDistanceLod != 0) {
+            drawMeshBasedOnDistance(*highMesh, *SceneFile::getMesh(gMesh, command.lowMesh), translationVec);
+        }
+        else {
+            drawMesh(*highMesh);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+/**
+ * @file SceneFileItem.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the SceneFileItem class.
+ */
+
+#ifndef SCENEFILEITEM_H
+#define SCENEFILEITEM_H
+
+#include "Item.h"
+#include "SceneFile.h"
+
+/**
+ * @class SceneFileItem
+ * @brief An item loaded from a scene file, which replays its command records.
+ *
+ * The records stay in the loaded scene file, which must outlive the item. Recording the item
+ * resolves the mesh and texture IDs and places each draw through the transform graph, as the
+ * hand-written items do with drawObject.
+ */
+class SceneFileItem :
+    public Item
+{
+    const SceneFile::CommandRecord* commands;
+    size_t commandCount;
+
+public:
+    /**
+     * @brief Constructor for the SceneFileItem class.
+     * @param commands The item's first command record.
+     * @param commandCount The number of command records.
+     * @param resources The shared mesh, texture and shader tables.
+     * @param inputCamera A reference to the camera object.
+     */
+    SceneFileItem(const SceneFile::CommandRecord* commands, size_t commandCount, const ResourceRegistry& resources, Camera& inputCamera)
+        : Item(glm::vec3(0.0f), resources, inputCamera), commands(commands), commandCount(commandCount) {}
+
+    /**
+     * @brief Renders the item from its command records.
+     */
+    void render();
+};
+#endif // SCENEFILEITEM_H
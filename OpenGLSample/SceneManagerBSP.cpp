@@ -7,12 +7,63 @@
  */
 
 #include "SceneManagerBSP.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <glm/gtc/type_ptr.hpp>
 
+#include "SceneFileItem.h"
+
+namespace
+{
+	// Half the size of the box around the camera whose items keep their textures resident
+	const float STREAMING_RADIUS = 12.0f;
+
+	// Distance between copies of the table sets, wider than the three sets together
+	const float COPY_SPACING = 30.0f;
+
+	// Frames an occlusion result is trusted for after the frame that issued its query
+	const unsigned int MAX_OCCLUSION_AGE = 4;
+
+	// Growth of the query boxes, so a box is never hidden by the faces of its own item or clipped by the near plane
+	const float OCCLUSION_BOX_MARGIN = 0.05f;
+
+	// Contacts a sliding sphere resolves per move, and the gap it keeps from what it touched
+	const int SLIDE_ITERATIONS = 3;
+	const float SLIDE_SKIN = 0.001f;
+
+	// Half the size of the box a firefly tests against the submeshes
+	const float FIREFLY_EXTENT = 0.05f;
+
+	/**
+	 * @brief Returns an item's bounds grown by OCCLUSION_BOX_MARGIN.
+	 */
+	AABB getOcclusionBox(const Item* item) {
+		AABB box = item->getBounds();
+		box.min -= glm::vec3(OCCLUSION_BOX_MARGIN);
+		box.max += glm::vec3(OCCLUSION_BOX_MARGIN);
+		return box;
+	}
+
+	/**
+	 * @brief Returns true when a point lies inside a box; its faces are then behind the viewer and say nothing.
+	 */
+	bool containsPoint(const AABB& box, const glm::vec3& point) {
+		return point.x >= box.min.x && point.x <= box.max.x
+			&& point.y >= box.min.y && point.y <= box.max.y
+			&& point.z >= box.min.z && point.z <= box.max.z;
+	}
+}
 
  /**
   * @brief Initializes the scene with specified transformations.
+  *
+  * Once every item is created and recorded, the BSP tree is rebuilt as a balanced tree.
+  *
+  * @param scale The number of table set copies and fireflies, and the firefly seed.
   */
-void SceneManagerBSP::initializeScene() {
+void SceneManagerBSP::initializeScene(const SceneScale& scale) {
 
 	std::vector<std::pair<float, glm::vec3>> transformValues = {
 		{0.0f, glm::vec3(0.0f, 0.0f, 0.0f)},
@@ -20,22 +71,174 @@ void SceneManagerBSP::initializeScene() {
 		{270.0f, glm::vec3(8.0f, 0.0f, -17.5f)}
 	};
 
-	for (const auto& values : transformValues) {
-		transformData.rotation = glm::rotate(glm::radians(values.first), glm::vec3(0.0f, 1.0f, 0.0f));
-		transformData.translation = glm::translate(values.second);
-		createTable(transformData);
+	const int copies = std::max(1, scale.tableCopies);
+	for (int copy = 0; copy < copies; copy++) {
+		const glm::vec3 offset = getCopyOffset(copy, copies);
+		for (const auto& values : transformValues) {
+			transformData.rotation = glm::rotate(glm::radians(values.first), glm::vec3(0.0f, 1.0f, 0.0f));
+			transformData.translation = glm::translate(values.second + offset);
+			createTable(transformData);
+		}
 	}
 
-	for (int i = 0; i < 10; i++) {
-		glm::vec3 position = fireflyPositions[i]; // Initial position
+	// Every ten fireflies go round the next copy
+	for (int i = 0; i < scale.fireflyCount; i++) {
+		glm::vec3 position = fireflyPositions[i % 10] + getCopyOffset((i / 10) % copies, copies); // Initial position
 		// Update the position
 		float speed = 1.1295f;
-		float angle = 0.0f;
-		Transform fireflyTransform;
-		FireFly* firefly = new FireFly(position, speed, fireflyTransform, gMesh, gTexture, lightingShader, camera);
-		// Add the FireFly object to the vector
-		addObject(firefly);
+		fireflies.add(position, speed);
+	}
+	fireflySeed = scale.fireflySeed;
+	fireflies.reseed(fireflySeed);
+
+	finishScene(nullptr, 0);
+}
+
+/**
+ * @brief Creates the scene from a scene file instead of the built-in layout.
+ *
+ * The table sets, items and fireflies are created from the file's records, and the tree takes the
+ * file's nodes instead of being built. Must be called instead of initializeScene, on a scene
+ * created without a root item.
+ *
+ * @param path The file path of the scene file.
+ * @return False, with nothing created, when the file cannot be read.
+ */
+bool SceneManagerBSP::loadScene(const char* path) {
+	if (!sceneFile.load(path)) {
+		return false;
+	}
+
+	const SceneFile::TableSetRecord* tableSets = sceneFile.getTableSets();
+	for (size_t i = 0; i < sceneFile.getCount(SceneFile::TABLE_SETS); i++) {
+		tableSetNodes.push_back(transforms.createNode(TransformGraph::NO_NODE, glm::make_mat4(tableSets[i].transform)));
+	}
+	// Added in file order, so the tree's item indices match the records
+	const SceneFile::ItemRecord* items = sceneFile.getItems();
+	for (size_t i = 0; i < sceneFile.getCount(SceneFile::ITEMS); i++) {
+		const SceneFile::ItemRecord& record = items[i];
+		const uint32_t parentNode = record.tableSet == SceneFile::NO_ID ? TransformGraph::NO_NODE : tableSetNodes[record.tableSet];
+		addObject(new SceneFileItem(sceneFile.getCommands() + record.firstCommand, record.commandCount, resources, camera), parentNode);
 	}
+	const SceneFile::FireflyRecord* fireflyRecords = sceneFile.getFireflies();
+	for (size_t i = 0; i < sceneFile.getCount(SceneFile::FIREFLIES); i++) {
+		const SceneFile::FireflyRecord& record = fireflyRecords[i];
+		fireflies.add(glm::vec3(record.position[0], record.position[1], record.position[2]), record.speed);
+	}
+	fireflySeed = sceneFile.getFireflySeed();
+	fireflies.reseed(fireflySeed);
+
+	finishScene(sceneFile.getTreeNodes(), sceneFile.getCount(SceneFile::TREE_NODES));
+	return true;
+}
+
+/**
+ * @brief Writes the scene as a scene file that loadScene reads back.
+ *
+ * Every item must have been recorded with drawObject placements of the named meshes and scene
+ * textures, as initializeScene leaves them.
+ *
+ * @param path The file path of the scene file.
+ * @return True when the file was written.
+ */
+bool SceneManagerBSP::saveScene(const char* path) {
+	jobs.wait(simulationJob);
+	SceneFile::Contents contents;
+	contents.fireflySeed = fireflySeed;
+
+	for (uint32_t node : tableSetNodes) {
+		SceneFile::TableSetRecord record;
+		std::memcpy(record.transform, glm::value_ptr(transforms.getLocal(node)), sizeof(record.transform));
+		contents.tableSets.push_back(record);
+	}
+
+	// In the tree's order, which its node data indexes
+	for (const Item* item : bsptree->getItems()) {
+		if (item->isDirty() || item->getTransformNode() == TransformGraph::NO_NODE) {
+			std::cout << "ERROR::SCENEMANAGERBSP::ITEM_NOT_RECORDED" << std::endl;
+			return false;
+		}
+		SceneFile::ItemRecord itemRecord;
+		const uint32_t parentNode = transforms.getParent(item->getTransformNode());
+		const std::vector<uint32_t>::const_iterator tableSet = std::find(tableSetNodes.begin(), tableSetNodes.end(), parentNode);
+		itemRecord.tableSet = tableSet == tableSetNodes.end() ? SceneFile::NO_ID : static_cast<uint32_t>(tableSet - tableSetNodes.begin());
+		itemRecord.firstCommand = static_cast<uint32_t>(contents.commands.size());
+		itemRecord.commandCount = static_cast<uint32_t>(item->getCommandRange().count);
+		contents.items.push_back(itemRecord);
+
+		const CommandRange range = item->getCommandRange();
+		for (size_t i = range.first; i < range.first + range.count; i++) {
+			const RenderCommand& command = commandList[i];
+			SceneFile::CommandRecord record;
+			const glm::mat4 local = command.transformNode != TransformGraph::NO_NODE ? transforms.getLocal(command.transformNode) : command.model;
+			std::memcpy(record.local, glm::value_ptr(local), sizeof(record.local));
+			record.uvScale[0] = command.uvScale.x;
+			record.uvScale[1] = command.uvScale.y;
+			record.shininess = command.shininess;
+			record.highMesh = SceneFile::getMeshId(resources.getMeshes(), command.highMesh);
+			record.lowMesh = SceneFile::getMeshId(resources.getMeshes(), command.lowMesh);
+			record.diffuseTexture = SceneFile::getTextureId(resources.getTextures(), command.diffuseTexture);
+			record.specularTexture = SceneFile::getTextureId(resources.getTextures(), command.specularTexture);
+			record.overlayTexture = SceneFile::getTextureId(resources.getTextures(), command.overlayTexture);
+			record.useDistanceLod = command.useDistanceLod ? 1 : 0;
+			if (record.highMesh == SceneFile::NO_ID || record.lowMesh == SceneFile::NO_ID
+				|| (command.diffuseTexture != 0 && record.diffuseTexture == SceneFile::NO_ID)
+				|| (command.specularTexture != 0 && record.specularTexture == SceneFile::NO_ID)
+				|| (command.overlayTexture != 0 && record.overlayTexture == SceneFile::NO_ID)) {
+				std::cout << "ERROR::SCENEMANAGERBSP::UNNAMED_RESOURCE" << std::endl;
+				return false;
+			}
+			contents.commands.push_back(record);
+		}
+	}
+	bsptree->getNodeData(contents.treeNodes);
+
+	for (size_t i = 0; i < fireflies.size(); i++) {
+		const glm::vec3 spawn = fireflies.getSpawnPosition(i);
+		SceneFile::FireflyRecord record = { { spawn.x, spawn.y, spawn.z }, fireflies.getSpeed(i) };
+		contents.fireflies.push_back(record);
+	}
+	return SceneFile::write(path, contents);
+}
+
+/**
+ * @brief Records every item, sets up the tree and the fireflies, and bakes the environment.
+ *
+ * Shared by initializeScene and loadScene, once the items and fireflies are added.
+ *
+ * @param treeNodes The nodes of a tree built earlier over the items, or nullptr to build the tree.
+ * @param treeNodeCount The number of nodes.
+ */
+void SceneManagerBSP::finishScene(const BSPTree::NodeData* treeNodes, size_t treeNodeCount) {
+	fireflies.createBuffers(resources.getMeshes().gLowSphereMesh);
+
+	// Record every item once so the bulk build can split on real bounds
+	for (Item* item : objects) {
+		item->record(commandList);
+	}
+	if (treeNodes == nullptr || !bsptree->setNodeData(treeNodes, treeNodeCount)) {
+		if (treeNodes != nullptr) {
+			std::cout << "ERROR::SCENEMANAGERBSP::TREE_NODES_REJECTED" << std::endl;
+		}
+		bsptree->build();
+	}
+	for (FrameState& frame : frames) {
+		frame.visibleItems.reserve(objects.size());
+		frame.visibleRanges.reserve(objects.size());
+		frame.visibleDraws.reserve(commandList.size());
+	}
+	std::cout << "Scene tree: " << objects.size() << " items, depth " << bsptree->getDepth() << std::endl;
+
+	createEnvironment();
+	printMemoryFootprint();
+}
+
+/**
+ * @brief Returns where a copy of the table sets goes; copies fill a square grid, the first at the origin.
+ */
+glm::vec3 SceneManagerBSP::getCopyOffset(int copy, int copies) {
+	const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(copies))));
+	return glm::vec3((copy % columns) * COPY_SPACING, 0.0f, -(copy / columns) * COPY_SPACING);
 }
 
 /**
@@ -43,55 +246,796 @@ void SceneManagerBSP::initializeScene() {
  * @param transformData The transformation data for positioning the objects.
  */
 void SceneManagerBSP::createTable(Transform transformData) {
-	Table* table = new Table(startPosition, transformData, gMesh, gTexture, lightingShader, camera);
-	addObject(table);
+	// The items take the set's placement from its node, so they are placed at the node's origin
+	uint32_t setNode = transforms.createNode(TransformGraph::NO_NODE, transformData.translation * transformData.rotation * transformData.scale);
+	tableSetNodes.push_back(setNode);
+	const Transform onSet;
+
+	Table* table = new Table(startPosition, onSet, resources, camera);
+	addObject(table, setNode);
+
+	DrinkBox* drinkBox = new DrinkBox(startPosition, onSet, resources, camera);
+	addObject(drinkBox, setNode);
+
+	PopcornBucket* bucket = new PopcornBucket(startPosition, onSet, resources, camera);
+	addObject(bucket, setNode);
 
-	DrinkBox* drinkBox = new DrinkBox(startPosition, transformData, gMesh, gTexture, lightingShader, camera);
-	addObject(drinkBox);
+	FireFlower* fireFlower = new FireFlower(startPosition, onSet, resources, camera);
+	addObject(fireFlower, setNode);
+
+	Hammer* hammer = new Hammer(startPosition, onSet, resources, camera);
+	addObject(hammer, setNode);
+}
+
+/**
+ * @brief Moves a table set and every item on it.
+ *
+ * Only the set's node changes; the next beginFrame recomputes the world matrices below it and
+ * rewrites the affected commands, without recording the items again.
+ *
+ * @param tableSet The table set, in the order createTable was called.
+ * @param transform The new placement of the set.
+ */
+void SceneManagerBSP::setTableTransform(size_t tableSet, const Transform& transform) {
+	if (tableSet >= tableSetNodes.size()) {
+		std::cout << "ERROR::SCENEMANAGERBSP::UNKNOWN_TABLE_SET" << std::endl;
+		return;
+	}
+	transforms.setLocal(tableSetNodes[tableSet], transform.translation * transform.rotation * transform.scale);
+}
+
+/**
+ * @brief Bakes the floor and fence into the static environment batch.
+ */
+void SceneManagerBSP::createEnvironment() {
+	// Record the walls once, then bake their draws into world space
+	Transform wallsTransform;
+	Walls walls(startPosition, wallsTransform, resources, camera);
+	RenderCommandList wallCommands;
+	walls.record(wallCommands);
 
-	PopcornBucket* bucket = new PopcornBucket(startPosition, transformData, gMesh, gTexture, lightingShader, camera);
-	addObject(bucket);
+	const MeshCreator::MeshData planeData = MeshCreator::getPlaneData();
+	for (size_t i = 0; i < wallCommands.size(); i++) {
+		environment.add(wallCommands[i], planeData);
+		const GLuint textures[3] = { wallCommands[i].diffuseTexture, wallCommands[i].specularTexture, wallCommands[i].overlayTexture };
+		for (GLuint texture : textures) {
+			if (texture != 0 && std::find(pinnedTextures.begin(), pinnedTextures.end(), texture) == pinnedTextures.end()) {
+				pinnedTextures.push_back(texture);
+			}
+		}
+	}
+	environment.build();
+	pinnedTextures.push_back(resources.getTextures().gTextureYellow);
+}
 
-	FireFlower* fireFlower = new FireFlower(startPosition, transformData, gMesh, gTexture, lightingShader, camera);
-	addObject(fireFlower);
+/**
+ * @brief Sets the resource manager that streams the item textures in and out by region.
+ *
+ * The environment and firefly textures are acquired for good. Must be called once, after
+ * initializeScene and before the first frame.
+ *
+ * @param manager The manager the textures were registered with.
+ */
+void SceneManagerBSP::setResourceManager(ResourceManager* manager) {
+	resourceManager = manager;
+	for (GLuint texture : pinnedTextures) {
+		resourceManager->acquire(texture);
+	}
+}
 
-	Hammer* hammer = new Hammer(startPosition, transformData, gMesh, gTexture, lightingShader, camera);
-	addObject(hammer);
+/**
+ * @brief Prints the memory used by the recorded commands and the static batch.
+ */
+void SceneManagerBSP::printMemoryFootprint() const {
+	std::cout << "Scene memory: " << commandList.size() << " recorded commands ("
+		<< commandList.size() * sizeof(RenderCommand) << " bytes), static batch "
+		<< environment.getMemoryFootprint() << " bytes in "
+		<< environment.getDrawCallCount() << " draw calls, "
+		<< transforms.size() << " transform nodes" << std::endl;
 }
 
 /**
- * @brief Adds an object to the BSP tree.
+ * @brief Adds an object to the BSP tree. The scene takes ownership of the object.
+ *
+ * A running simulation step is finished first. The object gets a node in the transform graph.
+ *
  * @param obj A pointer to the Item object to be inserted.
+ * @param parentNode The transform node the object is placed relative to, or TransformGraph::NO_NODE.
  */
-void SceneManagerBSP::addObject(Item* obj) {
+void SceneManagerBSP::addObject(Item* obj, uint32_t parentNode) {
+	jobs.wait(simulationJob);
+	if (obj->getTransformNode() == TransformGraph::NO_NODE) {
+		obj->attachTransform(transforms, parentNode);
+	}
+	objects.push_back(obj);
 	bsptree->insert(obj);
+	staticRevision++;
 }
 
 /**
- * @brief Removes an item from the BSP tree.
+ * @brief Removes an item from the BSP tree and deletes it.
+ *
+ * A running simulation step is finished first, and the item is dropped from both frame states.
+ *
  * @param obj The item to be removed from the BSP tree.
  */
 void SceneManagerBSP::removeObject(Item* obj) {
+	jobs.wait(simulationJob);
+	std::vector<Item*>::iterator found = std::find(objects.begin(), objects.end(), obj);
+	if (found == objects.end()) {
+		return;
+	}
+	objects.erase(found);
 	bsptree->remove(obj);
+	releaseTextures(obj);
+	std::map<const Item*, OcclusionQuery>::iterator occlusion = occlusionQueries.find(obj);
+	if (occlusion != occlusionQueries.end()) {
+		glDeleteQueries(1, &occlusion->second.query);
+		occlusionQueries.erase(occlusion);
+	}
+	for (FrameState& frame : frames) {
+		frame.visibleItems.erase(std::remove(frame.visibleItems.begin(), frame.visibleItems.end(), obj), frame.visibleItems.end());
+	}
+	delete obj;
+	staticRevision++;
 }
 
 /**
- * @brief A method to render the scene.
- * @param checkFrustum A boolean parameter to check the frustum.
+ * @brief Refits the tree, culls the items and their submeshes and moves the fireflies into a frame state.
+ *
+ * Item and submesh culling and level of detail selection are split across the job system.
+ * Makes no GL calls and does not write the command list, so it can run on a worker while the
+ * GL thread submits the other frame state.
+ *
+ * @param frame The frame state that receives the results.
+ * @param input The view and settings of the frame.
  */
-void SceneManagerBSP::renderScene(bool checkFrustum) {
+void SceneManagerBSP::simulate(FrameState& frame, const FrameInput& input) {
+	ProfileZone zone(profiler, "Simulate");
+	frame.input = input;
+	frame.frustum.update(input.viewProjection);
+	{
+		ProfileZone queryZone(profiler, "BSP query");
+		// Occlusion queries are issued in list order, so the nearest boxes go first
+		bsptree->queryVisibleItems(frame.frustum, input.checkFrustum, frame.visibleItems, &jobs, input.occlusionCulling ? &input.lodView.viewPosition : nullptr);
+	}
+
+	// Items recorded later, on the GL thread, add their draws in prepareFrame
+	frame.visibleRanges.clear();
+	for (Item* item : frame.visibleItems) {
+		if (!item->isDirty()) {
+			frame.visibleRanges.push_back(item->getCommandRange());
+		}
+	}
+	{
+		ProfileZone cullZone(profiler, "Submesh culling");
+		cullingStage.run(commandList, frame.visibleRanges, frame.frustum, Frustum::getPlaneCount(input.checkFrustum), lodPolicy, input.lodView, jobs, frame.visibleDraws);
+	}
 
-	std::vector<Item*> visibleItems = bsptree->getCurrentFrontItems(camera, checkFrustum);
-	for (Item* item : visibleItems) {
-		item->render();
+	// Every firefly moves, visible or not
+	if (!fireflies.isGpuSimulated()) {
+		ProfileZone fireflyZone(profiler, "FireFly move");
+		fireflies.update(input.deltaTime, [this](const glm::vec3& position) {
+			AABB box;
+			box.min = position - glm::vec3(FIREFLY_EXTENT);
+			box.max = position + glm::vec3(FIREFLY_EXTENT);
+			return overlapsSettled(box);
+		});
+		fireflies.writeSnapshot(frame.fireflyPositions);
+	}
+}
 
-		FireFly* movingObject = dynamic_cast<FireFly*>(item);
-		if (movingObject != nullptr) {
-			// This object is a MovingItem, so call its move function
-			movingObject->move(deltaTime);
+/**
+ * @brief Records the visible items that are not recorded yet and adds their draws.
+ *
+ * First copies the world matrices the transform graph recomputed into the recorded commands.
+ * Also moves the firefly state to or from the GPU when the setting changed. Runs on the GL
+ * thread while no simulation is running.
+ *
+ * @param frame The frame state about to be submitted.
+ */
+void SceneManagerBSP::prepareFrame(FrameState& frame) {
+	ProfileZone zone(profiler, "Prepare frame");
+	// Moved nodes rewrite the matrices of the commands below them; static furniture costs nothing here
+	if (transforms.update() > 0) {
+		for (Item* item : objects) {
+			if (item->refreshTransforms(commandList)) {
+				bsptree->markBoundsChanged(item);
+				staticRevision++;
+			}
 		}
 	}
-	Transform wallsTransform;
-	Walls* walls = new Walls(startPosition, wallsTransform, gMesh, gTexture, lightingShader, camera);
-	walls->render();
+
+	for (Item* item : frame.visibleItems) {
+		if (item->isDirty()) {
+			item->record(commandList);
+			bsptree->markBoundsChanged(item);
+			staticRevision++;
+			// A re-recorded item may draw with other textures
+			if (streamedTextures.count(item) != 0) {
+				releaseTextures(item);
+				acquireTextures(item);
+			}
+
+			std::vector<CommandRange> recorded(1, item->getCommandRange());
+			commandList.cullCommands(recorded, 0, 1, frame.frustum, Frustum::getPlaneCount(frame.input.checkFrustum), lodPolicy, frame.input.lodView, frame.visibleDraws);
+		}
+	}
+
+	fireflies.setGpuSimulation(frame.input.gpuParticles);
+	if (!fireflies.isGpuSimulated() && frame.fireflyPositions.size() != fireflies.size()) {
+		// Simulated on the GPU, or before fireflies were added: draw the state as it is now
+		fireflies.writeSnapshot(frame.fireflyPositions);
+	}
+
+	applyOcclusion(frame);
+	updateStreaming(frame);
+
+	// Bounds recorded above are used by the next step's culling and by the queries until then
+	settleTree();
+}
+
+/**
+ * @brief Reads the occlusion results that are ready and drops the draws of the occluded visible items.
+ *
+ * Never waits on a query. A result is used only while it is at most MAX_OCCLUSION_AGE frames old,
+ * so an item that comes back into view is not hidden by what was in front of it long ago.
+ *
+ * @param frame The frame state about to be submitted.
+ */
+void SceneManagerBSP::applyOcclusion(FrameState& frame) {
+	occludedItemCount = 0;
+	if (!frame.input.occlusionCulling) {
+		return;
+	}
+	ProfileZone zone(profiler, "Occlusion results");
+
+	occludedCommands.assign(commandList.size(), 0);
+	for (const Item* item : frame.visibleItems) {
+		std::map<const Item*, OcclusionQuery>::iterator found = occlusionQueries.find(item);
+		if (found == occlusionQueries.end()) {
+			continue;
+		}
+		OcclusionQuery& occlusion = found->second;
+		if (occlusion.pending) {
+			GLuint available = GL_FALSE;
+			glGetQueryObjectuiv(occlusion.query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available == GL_TRUE) {
+				GLuint anySamples = GL_TRUE;
+				glGetQueryObjectuiv(occlusion.query, GL_QUERY_RESULT, &anySamples);
+				occlusion.pending = false;
+				occlusion.occluded = anySamples == GL_FALSE;
+				occlusion.resultFrame = occlusion.issuedFrame;
+			}
+		}
+		if (!occlusion.occluded || occlusionFrame - occlusion.resultFrame > MAX_OCCLUSION_AGE
+			|| item->isDirty() || containsPoint(getOcclusionBox(item), frame.input.lodView.viewPosition)) {
+			continue;
+		}
+		const CommandRange range = item->getCommandRange();
+		std::fill(occludedCommands.begin() + range.first, occludedCommands.begin() + range.first + range.count, 1);
+		occludedItemCount++;
+	}
+
+	if (occludedItemCount > 0) {
+		frame.visibleDraws.erase(std::remove_if(frame.visibleDraws.begin(), frame.visibleDraws.end(),
+			[this](const VisibleDraw& draw) { return occludedCommands[draw.command] != 0; }), frame.visibleDraws.end());
+	}
+}
+
+/**
+ * @brief References the textures of the items near the camera and of the visible items, and releases the others.
+ *
+ * The nearby items are those of the BSP region within STREAMING_RADIUS of the camera. Runs on
+ * the GL thread while no simulation is running.
+ *
+ * @param frame The frame state about to be submitted.
+ */
+void SceneManagerBSP::updateStreaming(const FrameState& frame) {
+	if (resourceManager == nullptr) {
+		return;
+	}
+	ProfileZone zone(profiler, "Texture streaming");
+
+	AABB region;
+	region.min = frame.input.lodView.viewPosition - glm::vec3(STREAMING_RADIUS);
+	region.max = frame.input.lodView.viewPosition + glm::vec3(STREAMING_RADIUS);
+	bsptree->queryItemsInRegion(region, regionItems);
+	// Visible items are streamed however far they are
+	regionItems.insert(regionItems.end(), frame.visibleItems.begin(), frame.visibleItems.end());
+	// Items never recorded have no commands to read their textures from yet
+	regionItems.erase(std::remove_if(regionItems.begin(), regionItems.end(), [](const Item* item) { return !item->hasBounds(); }), regionItems.end());
+	std::sort(regionItems.begin(), regionItems.end());
+	regionItems.erase(std::unique(regionItems.begin(), regionItems.end()), regionItems.end());
+
+	// Acquire before releasing, so a texture shared by an item leaving and one entering stays referenced
+	for (const Item* item : regionItems) {
+		if (streamedTextures.count(item) == 0) {
+			acquireTextures(item);
+		}
+	}
+	std::map<const Item*, std::vector<GLuint>>::iterator streamed = streamedTextures.begin();
+	while (streamed != streamedTextures.end()) {
+		const Item* item = streamed->first;
+		++streamed;
+		if (!std::binary_search(regionItems.begin(), regionItems.end(), item)) {
+			releaseTextures(item);
+		}
+	}
+}
+
+/**
+ * @brief Builds the tree if its items changed and refits the ancestors of the items whose bounds changed.
+ *
+ * Must be called on the GL thread while no simulation is running.
+ */
+void SceneManagerBSP::settleTree() {
+	if (bsptree->isBuildPending()) {
+		bsptree->build();
+	}
+	if (bsptree->isRefitPending()) {
+		bsptree->refitChanged();
+	}
+}
+
+/**
+ * @brief Settles the tree before a query from outside the frame, waiting for a running simulation only if it is needed.
+ */
+void SceneManagerBSP::settleTreeForQuery() {
+	// Only the GL thread changes the tree, so a settled tree stays settled while a worker reads it
+	if (bsptree->isBuildPending() || bsptree->isRefitPending()) {
+		jobs.wait(simulationJob);
+		settleTree();
+	}
+}
+
+/**
+ * @brief Casts a ray or sweeps a sphere against the recorded submeshes of a settled tree.
+ * @param origin The start of the ray, or the center of the sphere.
+ * @param direction The direction of the ray; distances are in multiples of its length.
+ * @param maxDistance The end of the ray.
+ * @param radius The radius of the swept sphere, 0 for a ray.
+ * @param hit Receives the closest submesh's item, distance and face normal.
+ * @return True when a submesh is met before maxDistance.
+ */
+bool SceneManagerBSP::castSettled(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float radius, BSPTree::RayHit& hit) const {
+	const RenderCommandList& commands = commandList;
+	return bsptree->castRay(origin, direction, maxDistance, radius, hit,
+		[&commands](const Item& item, const glm::vec3& rayOrigin, const glm::vec3& rayDirection, float rayEnd, float rayRadius,
+			float& distance, glm::vec3& normal) {
+			const CommandRange range = item.getCommandRange();
+			bool found = false;
+			for (size_t i = range.first; i < range.first + range.count; i++) {
+				float entry = 0.0f;
+				glm::vec3 face;
+				// Submeshes that contain the origin are left behind, not hit
+				if (commands[i].bounds.inflated(rayRadius).intersectRay(rayOrigin, rayDirection, rayEnd, entry, face) && entry >= 0.0f) {
+					rayEnd = entry;
+					distance = entry;
+					normal = face;
+					found = true;
+				}
+			}
+			return found;
+		});
+}
+
+/**
+ * @brief Returns true when a recorded submesh of a settled tree overlaps a box.
+ */
+bool SceneManagerBSP::overlapsSettled(const AABB& box) const {
+	const RenderCommandList& commands = commandList;
+	return bsptree->overlapsAnyItem(box, [&commands](const Item& item, const AABB& region) {
+		const CommandRange range = item.getCommandRange();
+		for (size_t i = range.first; i < range.first + range.count; i++) {
+			if (commands[i].bounds.overlaps(region)) {
+				return true;
+			}
+		}
+		return false;
+	});
+}
+
+/**
+ * @brief Writes the items with a recorded submesh that overlaps a box into a caller-provided vector.
+ *
+ * Items not recorded yet have no bounds and are left out. Call on the GL thread.
+ *
+ * @param box The world-space box.
+ * @param result Receives the items in tree order; it is cleared but keeps its capacity.
+ */
+void SceneManagerBSP::queryBox(const AABB& box, std::vector<Item*>& result) {
+	settleTreeForQuery();
+	bsptree->queryItemsInRegion(box, result);
+	result.erase(std::remove_if(result.begin(), result.end(), [this, &box](const Item* item) {
+		if (!item->hasBounds()) {
+			return true;
+		}
+		const CommandRange range = item->getCommandRange();
+		for (size_t i = range.first; i < range.first + range.count; i++) {
+			if (commandList[i].bounds.overlaps(box)) {
+				return false;
+			}
+		}
+		return true;
+	}), result.end());
+}
+
+/**
+ * @brief Returns true when a recorded submesh overlaps a box. Call on the GL thread.
+ */
+bool SceneManagerBSP::overlapsBox(const AABB& box) {
+	settleTreeForQuery();
+	return overlapsSettled(box);
+}
+
+/**
+ * @brief Finds the first recorded submesh along a ray. Call on the GL thread.
+ *
+ * Submeshes whose bounds contain the origin are ignored.
+ *
+ * @param origin The start of the ray.
+ * @param direction The direction of the ray; it does not need to be normalized.
+ * @param maxDistance The length of the ray in world units.
+ * @param hit Receives the submesh's item, the distance in world units and the normal of the face met.
+ * @return True when a submesh is met within maxDistance.
+ */
+bool SceneManagerBSP::rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BSPTree::RayHit& hit) {
+	const float length = glm::length(direction);
+	if (length <= 0.0f) {
+		return false;
+	}
+	settleTreeForQuery();
+	return castSettled(origin, direction / length, maxDistance, 0.0f, hit);
+}
+
+/**
+ * @brief Finds the first recorded submesh a moving sphere touches. Call on the GL thread.
+ *
+ * Submeshes the sphere already overlaps are ignored, so it can always move out of them.
+ *
+ * @param center The center of the sphere before the move.
+ * @param radius The radius of the sphere.
+ * @param motion The move.
+ * @param hit Receives the submesh's item, the fraction of the move made before contact and the normal of the face touched.
+ * @return True when the sphere touches a submesh during the move.
+ */
+bool SceneManagerBSP::sweepSphere(const glm::vec3& center, float radius, const glm::vec3& motion, BSPTree::RayHit& hit) {
+	settleTreeForQuery();
+	return castSettled(center, motion, 1.0f, radius, hit);
+}
+
+/**
+ * @brief Moves a sphere as far as it goes, sliding along the submeshes it touches. Call on the GL thread.
+ * @param center The center of the sphere before the move.
+ * @param radius The radius of the sphere.
+ * @param motion The move asked for.
+ * @return The center of the sphere after the move.
+ */
+glm::vec3 SceneManagerBSP::slideSphere(const glm::vec3& center, float radius, const glm::vec3& motion) {
+	settleTreeForQuery();
+	glm::vec3 position = center;
+	glm::vec3 remaining = motion;
+	for (int i = 0; i < SLIDE_ITERATIONS; i++) {
+		const float length = glm::length(remaining);
+		BSPTree::RayHit hit;
+		if (length <= 0.0f || !castSettled(position, remaining, 1.0f, radius, hit)) {
+			return position + remaining;
+		}
+		// Stop just short of the face, then keep the part of the move along it
+		const float travel = std::max(hit.distance - SLIDE_SKIN / length, 0.0f);
+		position += remaining * travel;
+		remaining *= 1.0f - travel;
+		remaining -= hit.normal * glm::dot(remaining, hit.normal);
+	}
+	return position;
+}
+
+/**
+ * @brief Acquires the distinct textures of an item's recorded commands.
+ */
+void SceneManagerBSP::acquireTextures(const Item* item) {
+	std::vector<GLuint>& textures = streamedTextures[item];
+	const CommandRange range = item->getCommandRange();
+	for (size_t i = range.first; i < range.first + range.count; i++) {
+		const RenderCommand& command = commandList[i];
+		const GLuint commandTextures[3] = { command.diffuseTexture, command.specularTexture, command.overlayTexture };
+		for (GLuint texture : commandTextures) {
+			if (texture != 0 && std::find(textures.begin(), textures.end(), texture) == textures.end()) {
+				textures.push_back(texture);
+			}
+		}
+	}
+	for (GLuint texture : textures) {
+		resourceManager->acquire(texture);
+	}
+}
+
+/**
+ * @brief Releases the textures acquired for an item, if any.
+ */
+void SceneManagerBSP::releaseTextures(const Item* item) {
+	std::map<const Item*, std::vector<GLuint>>::iterator found = streamedTextures.find(item);
+	if (found == streamedTextures.end()) {
+		return;
+	}
+	for (GLuint texture : found->second) {
+		resourceManager->release(texture);
+	}
+	streamedTextures.erase(found);
+}
+
+/**
+ * @brief Starts a frame: selects the frame state to submit and, when pipelined, starts the next simulation.
+ *
+ * Without pipelining, the frame is simulated here with the given input. With pipelining, the
+ * frame state a worker finished during the last frame is submitted, and a worker simulates the
+ * given input into the other state while this frame is drawn. The first pipelined frame is
+ * simulated here and submitted twice, so the fireflies never step twice for one input.
+ * Items first drawn this frame are recorded here, on the calling thread, while no simulation runs.
+ *
+ * @param input The view and settings of this frame.
+ * @param pipelined Simulates on a worker, one frame ahead of the submission, when true.
+ */
+void SceneManagerBSP::beginFrame(const FrameInput& input, bool pipelined) {
+	jobs.wait(simulationJob);
+	settleTree();
+
+	if (simulationPending) {
+		// The worker finished the other frame state during the last frame
+		renderIndex = 1 - renderIndex;
+		simulationPending = false;
+		prepareFrame(frames[renderIndex]);
+	}
+	else {
+		simulate(frames[renderIndex], input);
+		prepareFrame(frames[renderIndex]);
+		if (pipelined) {
+			// Nothing was simulated ahead: the next frame submits a copy of this one while a worker catches up
+			frames[1 - renderIndex] = frames[renderIndex];
+			simulationPending = true;
+			return;
+		}
+	}
+
+	if (pipelined) {
+		FrameState& next = frames[1 - renderIndex];
+		simulationPending = true;
+		pipelinedInput = input;
+		jobs.submit([this, &next]() { simulate(next, pipelinedInput); }, simulationJob);
+	}
+}
+
+/**
+ * @brief Submits the frame selected by beginFrame.
+ *
+ * The visible draws are executed and the fireflies are drawn.
+ * With instancing, draws that share a mesh and texture set are merged into one instanced draw call.
+ * With multi-draw indirect as well, draws that share a texture set go out in one call whatever their mesh.
+ * With occlusion culling, the bounding boxes of the visible items are then tested against the opaque
+ * depth, and the items found hidden are skipped in the next frames until a query sees them again.
+ * With shader variants set, each draw is shaded by the variant of the given features, without the
+ * overlay when it has none. Must be called on the GL thread.
+ *
+ * @param shaderFeatures The ShaderVariants features the current lights need.
+ */
+void SceneManagerBSP::submitFrame(unsigned int shaderFeatures) {
+	const FrameState& frame = frames[renderIndex];
+	if (frame.input.depthPrepass) {
+		GpuProfileZone zone(profiler, "Depth pre-pass");
+		const Shader& shader = frame.input.useInstancing ? depthInstancedShader : depthShader;
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		commandList.executeDepth(frame.visibleDraws, shader, frame.input.useInstancing, stateCache);
+		environment.drawDepth(shader, stateCache);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+		// Only the nearest surface of each pixel passes now
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	// Collect the query issued last time this slot was used, then count this frame's shaded samples.
+	// A slot whose result is not in yet is left alone, and the frame goes uncounted
+	GLuint& query = overdrawQueries[overdrawQueryIndex];
+	bool countFrame = countOverdraw;
+	if (countFrame && query == 0) {
+		glGenQueries(1, &query);
+	}
+	if (countFrame && overdrawQueryIssued[overdrawQueryIndex]) {
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_TRUE) {
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &shadedSamples);
+			overdrawQueryIssued[overdrawQueryIndex] = false;
+		}
+		else {
+			countFrame = false;
+		}
+	}
+	if (countFrame) {
+		glBeginQuery(GL_SAMPLES_PASSED, query);
+	}
+
+	commandList.setTextureArray(frame.input.useTextureArray ? textureArray : nullptr);
+	// The features are those of this frame's lights, even when the draws were culled a frame earlier
+	ShaderVariants* variants = frame.input.useInstancing ? instancedVariants : lightingVariants;
+	commandList.setShaderVariants(variants, shaderFeatures);
+	{
+		GpuProfileZone zone(profiler, "Lighting pass");
+		if (frame.input.useInstancing && frame.input.useIndirect) {
+			commandList.executeIndirect(frame.visibleDraws, instancedShader, stateCache);
+		}
+		else if (frame.input.useInstancing) {
+			commandList.executeInstanced(frame.visibleDraws, instancedShader, stateCache);
+		}
+		else {
+			commandList.execute(frame.visibleDraws, lightingShader, stateCache);
+		}
+		// The batch mixes the wall sections, so it keeps the overlay
+		const Shader& environmentShader = frame.input.useInstancing ? instancedShader : lightingShader;
+		environment.draw(variants != nullptr ? variants->get(shaderFeatures | ShaderVariants::OVERLAY) : environmentShader, stateCache);
+	}
+
+	if (countFrame) {
+		glEndQuery(GL_SAMPLES_PASSED);
+		overdrawQueryIssued[overdrawQueryIndex] = true;
+	}
+	overdrawQueryIndex = (overdrawQueryIndex + 1) % OVERDRAW_QUERY_COUNT;
+	if (frame.input.depthPrepass) {
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	}
+	issueOcclusionQueries(frame);
+
+	// All fireflies are drawn with one call
+	GpuProfileZone zone(profiler, "Fireflies");
+	if (fireflies.isGpuSimulated()) {
+		fireflies.updateGpu(frame.input.deltaTime, fireflyUpdateShader, stateCache);
+	}
+	fireflies.draw(fireflyShader, resources.getTextures().gTextureYellow, stateCache, frame.fireflyPositions);
+}
+
+/**
+ * @brief Issues a bounding box query for each visible item, front to back, against the depth of the opaque pass.
+ *
+ * Items whose last query has no result yet and items with the camera inside their box issue none.
+ *
+ * @param frame The frame state being submitted.
+ */
+void SceneManagerBSP::issueOcclusionQueries(const FrameState& frame) {
+	occlusionFrame++;
+	occlusionQueryCount = 0;
+	if (!frame.input.occlusionCulling) {
+		return;
+	}
+	GpuProfileZone zone(profiler, "Occlusion queries");
+
+	// The boxes only test depth; they must not write it or hide each other
+	const MeshCreator::GLMesh& cube = resources.getMeshes().gCubeMesh;
+	stateCache.useProgram(depthShader.ID);
+	stateCache.bindVertexArray(cube.vao);
+	const GLint modelLocation = depthShader.getUniformLocation("model");
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+
+	for (const Item* item : frame.visibleItems) {
+		if (!item->hasBounds() || item->isDirty()) {
+			continue;
+		}
+		const AABB box = getOcclusionBox(item);
+		OcclusionQuery& occlusion = occlusionQueries[item];
+		if (occlusion.pending || containsPoint(box, frame.input.lodView.viewPosition)) {
+			continue;
+		}
+		if (occlusion.query == 0) {
+			glGenQueries(1, &occlusion.query);
+		}
+
+		// The cube mesh spans -0.5 to 0.5 on every axis
+		const glm::mat4 model = glm::translate(box.getCenter()) * glm::scale(box.max - box.min);
+		depthShader.setMat4(modelLocation, model);
+		glBeginQuery(GL_ANY_SAMPLES_PASSED, occlusion.query);
+		glDrawElementsBaseVertex(GL_TRIANGLES, cube.nIndices, GL_UNSIGNED_SHORT, cube.getIndexOffset(), cube.baseVertex);
+		glEndQuery(GL_ANY_SAMPLES_PASSED);
+		occlusion.pending = true;
+		occlusion.issuedFrame = occlusionFrame;
+		occlusionQueryCount++;
+	}
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+}
+
+/**
+ * @brief Renders the shadow maps of the frame selected by beginFrame.
+ *
+ * Every recorded item and the environment are static casters, drawn only into the caches that are
+ * stale. The fireflies are dynamic casters, drawn over every live map each frame. Must be called on
+ * the GL thread, after ShadowMaps::update and before the Camera block is uploaded for the frame.
+ *
+ * @param shadows The shadow maps, fitted to this frame's camera and lights.
+ * @param cameraBuffer The Camera uniform buffer, which receives each shadow view.
+ */
+void SceneManagerBSP::renderShadows(ShadowMaps& shadows, UniformBuffer& cameraBuffer) {
+	const FrameState& frame = frames[renderIndex];
+
+	// Casters outside the camera's view still shadow what it sees, so every command is drawn
+	if (shadows.needsStaticPass()) {
+		shadowDraws.clear();
+		for (Item* item : objects) {
+			if (item->isDirty()) {
+				continue;
+			}
+			const CommandRange range = item->getCommandRange();
+			for (size_t i = range.first; i < range.first + range.count; i++) {
+				VisibleDraw draw;
+				draw.command = static_cast<uint32_t>(i);
+				draw.mesh = commandList[i].highMesh;
+				shadowDraws.push_back(draw);
+			}
+		}
+	}
+
+	for (int view = 0; view < ShadowMaps::VIEW_COUNT; view++) {
+		if (!shadows.isViewActive(view)) {
+			continue;
+		}
+		if (shadows.beginStaticPass(view, cameraBuffer)) {
+			commandList.executeDepth(shadowDraws, shadows.getCasterShader(), false, stateCache);
+			environment.drawDepth(shadows.getCasterShader(), stateCache);
+		}
+		shadows.beginDynamicPass(view, cameraBuffer);
+		fireflies.drawDepth(shadows.getParticleCasterShader(), stateCache, frame.fireflyPositions);
+	}
+	shadows.endPasses(stateCache);
+}
+
+/**
+ * @brief Prints the visibility query counters of the last submitted frame.
+ *
+ * Waits for a running simulation step, which writes the counters.
+ */
+void SceneManagerBSP::printVisibilityStats() {
+	jobs.wait(simulationJob);
+	std::cout << "Visible items: " << frames[renderIndex].visibleItems.size()
+		<< ", visible draws: " << frames[renderIndex].visibleDraws.size()
+		<< ", visibility query allocations: " << bsptree->getQueryAllocations()
+		<< ", materials: " << commandList.getMaterialCount() << std::endl;
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	const double pixels = std::max(1.0, static_cast<double>(viewport[2]) * viewport[3]);
+	if (countOverdraw) {
+		std::cout << "Opaque fragments shaded: " << shadedSamples << " (" << shadedSamples / pixels << " per pixel"
+			<< (frames[renderIndex].input.depthPrepass ? ", depth pre-pass on)" : ", depth pre-pass off)") << std::endl;
+	}
+	else {
+		// The queries are only issued from now on
+		std::cout << "Opaque fragments shaded: counted from the next frames" << std::endl;
+		countOverdraw = true;
+	}
+	std::cout << "Occluded items: " << occludedItemCount << " of " << frames[renderIndex].visibleItems.size()
+		<< ", occlusion queries: " << occlusionQueryCount
+		<< (frames[renderIndex].input.occlusionCulling ? " (occlusion culling on)" : " (occlusion culling off)") << std::endl;
+}
+
+/**
+ * @brief Releases the GL buffers owned by the scene. A running simulation step is finished first.
+ */
+void SceneManagerBSP::destroyBuffers() {
+	jobs.wait(simulationJob);
+	commandList.destroyBuffers();
+	environment.destroy();
+	for (int i = 0; i < OVERDRAW_QUERY_COUNT; i++) {
+		if (overdrawQueries[i] != 0) {
+			glDeleteQueries(1, &overdrawQueries[i]);
+			overdrawQueries[i] = 0;
+			overdrawQueryIssued[i] = false;
+		}
+	}
+	for (std::map<const Item*, OcclusionQuery>::value_type& occlusion : occlusionQueries) {
+		glDeleteQueries(1, &occlusion.second.query);
+	}
+	occlusionQueries.clear();
+	fireflies.destroyBuffers();
 }
\ No newline at end of file
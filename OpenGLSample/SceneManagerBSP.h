@@ -9,16 +9,59 @@
 #ifndef SCENEMANAGERBSP_H
 #define SCENEMANAGERBSP_H
 
+#include <map>
 #include <vector>
 #include "BSPtree.h"
 #include "Item.h"
-#include "FireFly.h"
+#include "FireFlySystem.h"
 #include "Table.h"
 #include "DrinkBox.h"
 #include "PopcornBucket.h"
 #include "FireFlower.h"
 #include "Hammer.h"
 #include "Walls.h"
+#include "ResourceRegistry.h"
+#include "RenderCommand.h"
+#include "GLStateCache.h"
+#include "StaticBatch.h"
+#include "JobSystem.h"
+#include "CullingStage.h"
+#include "ShadowMaps.h"
+#include "UniformBuffer.h"
+#include "ResourceManager.h"
+#include "TransformGraph.h"
+#include "Profiler.h"
+#include "SceneFile.h"
+#include "StreamBuffer.h"
+
+/**
+ * @struct FrameInput
+ * @brief The view and settings a frame is simulated and drawn with.
+ */
+struct FrameInput
+{
+	glm::mat4 viewProjection = glm::mat4(1.0f); // Used to extract the culling frustum
+	LodView lodView;                            // Camera values used for level of detail and depth
+	float deltaTime = 0.0f;                     // Time step of the firefly simulation
+	bool checkFrustum = false;                  // Tests all six planes instead of only the near plane
+	bool useInstancing = false;                 // Draws with the instanced shader
+	bool useIndirect = false;                   // With instancing, submits with multi-draw indirect when available
+	bool gpuParticles = false;                  // Moves the fireflies with transform feedback
+	bool depthPrepass = false;                  // Lays down the opaque depth first, so the lighting pass shades each pixel once
+	bool useTextureArray = false;               // With instancing, reads the textures from the texture array, when one is set
+	bool occlusionCulling = false;              // Skips items whose bounding box was hidden in an earlier frame
+};
+
+/**
+ * @struct SceneScale
+ * @brief How much of the scene initializeScene creates, so benchmarks can scale it up.
+ */
+struct SceneScale
+{
+	int tableCopies = 1;        // Copies of the three table sets, laid out in a grid
+	int fireflyCount = 10;      // Fireflies, spread over the copies
+	uint32_t fireflySeed = 0;   // Seed of the firefly movement; 0 is the default sequence
+};
 
 /**
  * @class SceneManagerBSP
@@ -26,19 +69,96 @@
  *
  * This class is responsible for managing various objects in the scene,
  * utilizing a BSP tree for efficient rendering and collision detection.
+ *
+ * A frame is split into a simulation step and a submission step. The simulation culls the items and
+ * moves the fireflies without touching GL; the submission records dirty items, refits the tree and
+ * issues the GL calls. The results of a simulation live in one of two frame states. When the
+ * frame is pipelined, a worker simulates the next frame into one state while the GL thread submits
+ * the other, so the submitted frame was culled with the view of the frame before it.
+ *
+ * The spatial queries (box overlap, ray cast, sphere sweep) walk the same tree and then test the
+ * bounds of the items' recorded submeshes, so a table blocks with its top and legs rather than the
+ * box around the whole set. The tree is only built and refit on the GL thread while no simulation
+ * runs, so the queries can run on the GL thread while a worker culls, and inside the simulation.
  */
 class SceneManagerBSP {
 private:
-    std::vector<Item*> objects; // Vector to store all objects
+    std::vector<Item*> objects; // Vector to store all objects, owned by the scene
     BSPTree* bsptree;
-	MeshCreator gMesh;
-	Textures gTexture;
+	const ResourceRegistry& resources;
 	Shader lightCubeShader;
 	Shader lightingShader;
+	Shader instancedShader;
+	Shader fireflyShader;
+	Shader fireflyUpdateShader;
+	Shader depthShader;
+	Shader depthInstancedShader;
 	Camera& camera;
 	float& deltaTime;
+	GLStateCache& stateCache;
+	JobSystem& jobs;
 	Transform transformData;
 	glm::vec3 startPosition = glm::vec3(0.0f, 0.0f, 0.0f);
+	RenderCommandList commandList;           // Recorded draws of every item in the scene
+	CullingStage cullingStage;               // Submesh culling and level of detail, run by the simulation
+	LodPolicy lodPolicy;                     // Screen-size thresholds of the levels of detail
+	FireFlySystem fireflies;                 // Every firefly, simulated and drawn as one batch
+	StaticBatch environment;                 // Floor and fence baked into one buffer, always drawn
+	unsigned int staticRevision = 1;         // Bumped whenever a recorded item or the item list changes
+	std::vector<VisibleDraw> shadowDraws;    // Every recorded command, gathered when a shadow cache is stale
+	TextureArray* textureArray = nullptr;    // Layers of the item textures, used when the frame asks for it
+	ShaderVariants* lightingVariants = nullptr;  // Permutations of lightingShader, when set
+	ShaderVariants* instancedVariants = nullptr; // Permutations of instancedShader, when set
+	ResourceManager* resourceManager = nullptr;               // Streams the textures of the nearby items, when set
+	std::vector<GLuint> pinnedTextures;                       // Textures of the environment and fireflies, always referenced
+	std::map<const Item*, std::vector<GLuint>> streamedTextures; // Textures referenced by each streamed item
+	std::vector<Item*> regionItems;                           // Scratch list of the items to stream this frame
+	TransformGraph transforms;               // Table set, item and submesh transforms with cached world matrices
+	std::vector<uint32_t> tableSetNodes;     // Node of each table set, in creation order
+	Profiler* profiler = nullptr;            // Times the simulation steps and the passes, when set
+	SceneFile sceneFile;                     // Records of a loaded scene, which its items replay
+	uint32_t fireflySeed = 0;                // Seed the fireflies were last reseeded with
+
+	// The result of one simulation step, handed from the simulation to the submission
+	struct FrameState
+	{
+		FrameInput input;
+		Frustum frustum;                         // View volume extracted from the input
+		std::vector<Item*> visibleItems;         // Items that passed culling
+		std::vector<CommandRange> visibleRanges; // Command ranges of the visible recorded items
+		std::vector<VisibleDraw> visibleDraws;   // Submeshes that passed culling, with their mesh selected
+		FireFlySystem::Snapshot fireflyPositions;
+	};
+
+	FrameState frames[2];
+	int renderIndex = 0;                     // Frame state submitted this frame
+	bool simulationPending = false;          // True when a worker simulates into the other frame state
+	FrameInput pipelinedInput;               // Input of that simulation; a copy in the job would not fit std::function inline
+	JobCounter simulationJob;                // Counts the running simulation, at most one
+
+	// Samples that passed the depth test in the opaque lighting pass, counted once the stats were first
+	// printed. A slot is read only once its result is available, one more slot than frames in flight
+	static const int OVERDRAW_QUERY_COUNT = StreamBuffer::FRAME_COUNT + 1;
+	GLuint overdrawQueries[OVERDRAW_QUERY_COUNT] = {};
+	bool overdrawQueryIssued[OVERDRAW_QUERY_COUNT] = {};
+	int overdrawQueryIndex = 0;
+	bool countOverdraw = false;              // Set by the first printVisibilityStats
+	GLuint64 shadedSamples = 0;              // Result of the newest query that completed
+
+	// Bounding box query of an item, issued after the opaque pass and read frames later
+	struct OcclusionQuery
+	{
+		GLuint query = 0;
+		bool pending = false;                    // Issued, with no result read back yet
+		bool occluded = false;                   // No sample of the box passed the depth test
+		unsigned int issuedFrame = 0;            // The submitted frame that issued the query
+		unsigned int resultFrame = 0;            // The submitted frame that issued the query occluded was read from
+	};
+	std::map<const Item*, OcclusionQuery> occlusionQueries;
+	std::vector<unsigned char> occludedCommands; // Scratch flags of the commands of the occluded items
+	unsigned int occlusionFrame = 0;         // Counts the submitted frames
+	size_t occludedItemCount = 0;            // Visible items skipped in the frame selected by beginFrame
+	size_t occlusionQueryCount = 0;          // Box queries issued by the last submitFrame
 
 
 	glm::vec3 fireflyPositions[10] = {
@@ -54,29 +174,175 @@ private:
 		glm::vec3(3.5f, 4.5f, -16.5f)
 	};
 
+	/**
+	 * @brief Culls the items and their submeshes and moves the fireflies into a frame state.
+	 *
+	 * Item and submesh culling and level of detail selection are split across the job system. CPU
+	 * fireflies turn back from the submeshes they fly into.
+	 * Makes no GL calls and does not write the command list, so it can run on a worker while the
+	 * GL thread submits the other frame state.
+	 *
+	 * @param frame The frame state that receives the results.
+	 * @param input The view and settings of the frame.
+	 */
+	void simulate(FrameState& frame, const FrameInput& input);
+
+	/**
+	 * @brief Records the visible items that are not recorded yet and adds their draws.
+	 *
+	 * First copies the world matrices the transform graph recomputed into the recorded commands.
+	 * Also moves the firefly state to or from the GPU when the setting changed. Runs on the GL
+	 * thread while no simulation is running.
+	 *
+	 * @param frame The frame state about to be submitted.
+	 */
+	void prepareFrame(FrameState& frame);
+
+	/**
+	 * @brief References the textures of the items near the camera and of the visible items, and releases the others.
+	 *
+	 * The nearby items are those of the BSP region within STREAMING_RADIUS of the camera. Runs on
+	 * the GL thread while no simulation is running.
+	 *
+	 * @param frame The frame state about to be submitted.
+	 */
+	void updateStreaming(const FrameState& frame);
+
+	/**
+	 * @brief Reads the occlusion results that are ready and drops the draws of the occluded visible items.
+	 *
+	 * Never waits on a query. A result is used only while it is at most MAX_OCCLUSION_AGE frames old,
+	 * so an item that comes back into view is not hidden by what was in front of it long ago.
+	 *
+	 * @param frame The frame state about to be submitted.
+	 */
+	void applyOcclusion(FrameState& frame);
+
+	/**
+	 * @brief Issues a bounding box query for each visible item, front to back, against the depth of the opaque pass.
+	 *
+	 * Items whose last query has no result yet and items with the camera inside their box issue none.
+	 *
+	 * @param frame The frame state being submitted.
+	 */
+	void issueOcclusionQueries(const FrameState& frame);
+
+	/**
+	 * @brief Returns where a copy of the table sets goes; copies fill a square grid, the first at the origin.
+	 */
+	static glm::vec3 getCopyOffset(int copy, int copies);
+
+	/**
+	 * @brief Records every item, sets up the tree and the fireflies, and bakes the environment.
+	 *
+	 * Shared by initializeScene and loadScene, once the items and fireflies are added.
+	 *
+	 * @param treeNodes The nodes of a tree built earlier over the items, or nullptr to build the tree.
+	 * @param treeNodeCount The number of nodes.
+	 */
+	void finishScene(const BSPTree::NodeData* treeNodes, size_t treeNodeCount);
+
+	/**
+	 * @brief Builds the tree if its items changed and refits the ancestors of the items whose bounds changed.
+	 *
+	 * Must be called on the GL thread while no simulation is running.
+	 */
+	void settleTree();
+
+	/**
+	 * @brief Settles the tree before a query from outside the frame, waiting for a running simulation only if it is needed.
+	 */
+	void settleTreeForQuery();
+
+	/**
+	 * @brief Casts a ray or sweeps a sphere against the recorded submeshes of a settled tree.
+	 * @param origin The start of the ray, or the center of the sphere.
+	 * @param direction The direction of the ray; distances are in multiples of its length.
+	 * @param maxDistance The end of the ray.
+	 * @param radius The radius of the swept sphere, 0 for a ray.
+	 * @param hit Receives the closest submesh's item, distance and face normal.
+	 * @return True when a submesh is met before maxDistance.
+	 */
+	bool castSettled(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float radius, BSPTree::RayHit& hit) const;
+
+	/**
+	 * @brief Returns true when a recorded submesh of a settled tree overlaps a box.
+	 */
+	bool overlapsSettled(const AABB& box) const;
+
+	/**
+	 * @brief Acquires the distinct textures of an item's recorded commands.
+	 */
+	void acquireTextures(const Item* item);
+
+	/**
+	 * @brief Releases the textures acquired for an item, if any.
+	 */
+	void releaseTextures(const Item* item);
+
 public:
 	/**
 	 * @brief Constructor for SceneManagerBSP.
-	 * @param rootItem A pointer to the root item for the BSP tree.
-	 * @param mesh The mesh creator object.
-	 * @param texture The texture object.
+	 * @param rootItem A pointer to the first item of the BSP tree, or nullptr; the scene takes ownership of it.
+	 * @param registry The shared mesh, texture and shader tables.
 	 * @param cubeShader The shader for the light cube.
 	 * @param shader The shader for lighting.
+	 * @param instanced The instanced variant of the lighting shader.
+	 * @param particles The lighting shader variant that draws the fireflies.
+	 * @param particleUpdate The transform feedback program that moves the fireflies on the GPU.
+	 * @param depth The depth-only variant of the lighting shader, used by the depth pre-pass.
+	 * @param depthInstanced The depth-only variant of the instanced lighting shader.
 	 * @param cam A reference to the camera object.
 	 * @param dt A reference to the delta time variable.
+	 * @param cache The cache that filters redundant GL binds.
+	 * @param jobSystem The workers that run pipelined simulation steps.
 	 */
-	SceneManagerBSP(Item* rootItem, MeshCreator mesh, Textures texture, Shader cubeShader, Shader shader, Camera& cam, float& dt)
-		: bsptree(new BSPTree(rootItem)), gMesh(mesh), gTexture(texture), lightCubeShader(cubeShader), lightingShader(shader), camera(cam), deltaTime(dt) {
+	SceneManagerBSP(Item* rootItem, const ResourceRegistry& registry, Shader cubeShader, Shader shader, Shader instanced, Shader particles, Shader particleUpdate, Shader depth, Shader depthInstanced, Camera& cam, float& dt, GLStateCache& cache, JobSystem& jobSystem)
+		: bsptree(new BSPTree(nullptr)), resources(registry), lightCubeShader(cubeShader), lightingShader(shader), instancedShader(instanced), fireflyShader(particles), fireflyUpdateShader(particleUpdate), depthShader(depth), depthInstancedShader(depthInstanced), camera(cam), deltaTime(dt), stateCache(cache), jobs(jobSystem) {
+		if (rootItem != nullptr) {
+			addObject(rootItem);
+		}
 	}
 
     ~SceneManagerBSP() {
+        jobs.wait(simulationJob);
         delete bsptree;
+        for (Item* item : objects) {
+            delete item;
+        }
     }
 
 	/**
 	 * @brief Initializes the scene with specified transformations.
+	 *
+	 * Once every item is created and recorded, the BSP tree is rebuilt as a balanced tree.
+	 *
+	 * @param scale The number of table set copies and fireflies, and the firefly seed.
+	 */
+	void initializeScene(const SceneScale& scale = SceneScale());
+
+	/**
+	 * @brief Creates the scene from a scene file instead of the built-in layout.
+	 *
+	 * The table sets, items and fireflies are created from the file's records, and the tree takes the
+	 * file's nodes instead of being built. Must be called instead of initializeScene, on a scene
+	 * created without a root item.
+	 *
+	 * @param path The file path of the scene file.
+	 * @return False, with nothing created, when the file cannot be read.
+	 */
+	bool loadScene(const char* path);
+
+	/**
+	 * @brief Writes the scene as a scene file that loadScene reads back.
+	 *
+	 * Every item must have been recorded with drawObject placements of the named meshes and scene
+	 * textures, as initializeScene leaves them.
+	 *
+	 * @param path The file path of the scene file.
+	 * @return True when the file was written.
 	 */
-	void initializeScene();
+	bool saveScene(const char* path);
 
 	/**
 	 * @brief Creates a table and associated objects, and adds them to the BSP tree.
@@ -85,21 +351,220 @@ public:
 	void createTable(Transform transformData);
 
 	/**
-	 * @brief Adds an object to the BSP tree.
+	 * @brief Bakes the floor and fence into the static environment batch.
+	 */
+	void createEnvironment();
+
+	/**
+	 * @brief Adds an object to the BSP tree. The scene takes ownership of the object.
+	 *
+	 * A running simulation step is finished first. The object gets a node in the transform graph.
+	 *
 	 * @param obj A pointer to the Item object to be inserted.
+	 * @param parentNode The transform node the object is placed relative to, or TransformGraph::NO_NODE.
 	 */
-	void addObject(Item* obj);
+	void addObject(Item* obj, uint32_t parentNode = TransformGraph::NO_NODE);
 
 	/**
-	 * @brief Removes an item from the BSP tree.
+	 * @brief Moves a table set and every item on it.
+	 *
+	 * Only the set's node changes; the next beginFrame recomputes the world matrices below it and
+	 * rewrites the affected commands, without recording the items again.
+	 *
+	 * @param tableSet The table set, in the order createTable was called.
+	 * @param transform The new placement of the set.
+	 */
+	void setTableTransform(size_t tableSet, const Transform& transform);
+
+	/**
+	 * @brief Removes an item from the BSP tree and deletes it.
+	 *
+	 * A running simulation step is finished first, and the item is dropped from both frame states.
+	 *
 	 * @param obj The item to be removed from the BSP tree.
 	 */
 	void removeObject(Item* obj);
 
 	/**
-	 * @brief A method to render the scene.
-	 * @param checkFrustum A boolean parameter to check the frustum.
+	 * @brief Starts a frame: selects the frame state to submit and, when pipelined, starts the next simulation.
+	 *
+	 * Without pipelining, the frame is simulated here with the given input. With pipelining, the
+	 * frame state a worker finished during the last frame is submitted, and a worker simulates the
+	 * given input into the other state while this frame is drawn. The first pipelined frame is
+	 * simulated here and submitted twice, so the fireflies never step twice for one input.
+	 * Items first drawn this frame are recorded here, on the calling thread, while no simulation runs.
+	 *
+	 * @param input The view and settings of this frame.
+	 * @param pipelined Simulates on a worker, one frame ahead of the submission, when true.
+	 */
+	void beginFrame(const FrameInput& input, bool pipelined);
+
+	/**
+	 * @brief Submits the frame selected by beginFrame.
+	 *
+	 * The visible draws are executed and the fireflies are drawn. With the depth pre-pass, the opaque
+	 * draws first write only depth, front to back, and are then shaded with GL_EQUAL and depth writes off.
+	 * With instancing, draws that share a mesh and texture set are merged into one instanced draw call.
+	 * With multi-draw indirect as well, draws that share a texture set go out in one call whatever their mesh.
+	 * With occlusion culling, the bounding boxes of the visible items are then tested against the opaque
+	 * depth, and the items found hidden are skipped in the next frames until a query sees them again.
+	 * With shader variants set, each draw is shaded by the variant of the given features, without the
+	 * overlay when it has none. Must be called on the GL thread.
+	 *
+	 * @param shaderFeatures The ShaderVariants features the current lights need.
+	 */
+	void submitFrame(unsigned int shaderFeatures = ShaderVariants::ALL_FEATURES);
+
+	/**
+	 * @brief Renders the shadow maps of the frame selected by beginFrame.
+	 *
+	 * Every recorded item and the environment are static casters, drawn only into the caches that are
+	 * stale. The fireflies are dynamic casters, drawn over every live map each frame. Must be called on
+	 * the GL thread, after ShadowMaps::update and before the Camera block is uploaded for the frame.
+	 *
+	 * @param shadows The shadow maps, fitted to this frame's camera and lights.
+	 * @param cameraBuffer The Camera uniform buffer, which receives each shadow view.
+	 */
+	void renderShadows(ShadowMaps& shadows, UniformBuffer& cameraBuffer);
+
+	/**
+	 * @brief Sets the texture array the instanced paths read the item textures from.
+	 * @param array The array, or nullptr to always bind each texture set.
+	 */
+	void setTextureArray(TextureArray* array) { textureArray = array; }
+
+	/**
+	 * @brief Sets the permutations the lighting pass selects its programs from.
+	 * @param lighting The variants of the lighting shader, or nullptr to always use the full shader.
+	 * @param instanced The variants of the instanced shader, or nullptr to always use the full shader.
+	 */
+	void setShaderVariants(ShaderVariants* lighting, ShaderVariants* instanced) {
+		lightingVariants = lighting;
+		instancedVariants = instanced;
+	}
+
+	/**
+	 * @brief Writes the per-frame instance data and firefly positions into a ring instead of orphaned buffers.
+	 * @param buffer The ring, or nullptr to use the scene's own buffers.
+	 */
+	void setStreamBuffer(StreamBuffer* buffer) {
+		commandList.setStreamBuffer(buffer);
+		fireflies.setStreamBuffer(buffer);
+	}
+
+	/**
+	 * @brief Takes the scratch memory of the submission's draw sorts from a frame arena.
+	 * @param arena The arena, reset after the frame, or nullptr to use the heap.
+	 */
+	void setFrameArena(FrameArena* arena) { commandList.setFrameArena(arena); }
+
+	/**
+	 * @brief Sets the profiler that times the simulation steps, on whichever thread they run, and the passes.
+	 * @param frameProfiler The profiler, or nullptr to time nothing.
+	 */
+	void setProfiler(Profiler* frameProfiler) { profiler = frameProfiler; }
+
+	/**
+	 * @brief Sets the resource manager that streams the item textures in and out by region.
+	 *
+	 * The environment and firefly textures are acquired for good. Must be called once, after
+	 * initializeScene and before the first frame.
+	 *
+	 * @param manager The manager the textures were registered with.
+	 */
+	void setResourceManager(ResourceManager* manager);
+
+	/**
+	 * @brief Returns a number that changes whenever the static shadow casters change.
+	 */
+	unsigned int getStaticRevision() const { return staticRevision; }
+
+	/**
+	 * @brief Returns the number of draw calls issued by the last submitFrame.
+	 *
+	 * Includes the depth pre-pass when it is on, which draws the environment with one call, and the
+	 * occlusion query boxes.
+	 */
+	size_t getDrawCallCount() const { return commandList.getDrawCallCount() + (frames[renderIndex].input.depthPrepass ? commandList.getDepthDrawCallCount() + 1 : 0) + environment.getDrawCallCount() + fireflies.getDrawCallCount() + occlusionQueryCount; }
+
+	/**
+	 * @brief Returns the number of triangles shaded by the last submitFrame, depth pre-pass excluded.
+	 */
+	size_t getTriangleCount() const { return commandList.getTriangleCount() + environment.getTriangleCount() + fireflies.getTriangleCount(); }
+
+	/**
+	 * @brief Returns the number of items that passed culling in the frame selected by beginFrame.
+	 */
+	size_t getVisibleItemCount() const { return frames[renderIndex].visibleItems.size(); }
+
+	/**
+	 * @brief Writes the items with a recorded submesh that overlaps a box into a caller-provided vector.
+	 *
+	 * Items not recorded yet have no bounds and are left out. Call on the GL thread.
+	 *
+	 * @param box The world-space box.
+	 * @param result Receives the items in tree order; it is cleared but keeps its capacity.
+	 */
+	void queryBox(const AABB& box, std::vector<Item*>& result);
+
+	/**
+	 * @brief Returns true when a recorded submesh overlaps a box. Call on the GL thread.
+	 */
+	bool overlapsBox(const AABB& box);
+
+	/**
+	 * @brief Finds the first recorded submesh along a ray. Call on the GL thread.
+	 *
+	 * Submeshes whose bounds contain the origin are ignored.
+	 *
+	 * @param origin The start of the ray.
+	 * @param direction The direction of the ray; it does not need to be normalized.
+	 * @param maxDistance The length of the ray in world units.
+	 * @param hit Receives the submesh's item, the distance in world units and the normal of the face met.
+	 * @return True when a submesh is met within maxDistance.
+	 */
+	bool rayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BSPTree::RayHit& hit);
+
+	/**
+	 * @brief Finds the first recorded submesh a moving sphere touches. Call on the GL thread.
+	 *
+	 * Submeshes the sphere already overlaps are ignored, so it can always move out of them.
+	 *
+	 * @param center The center of the sphere before the move.
+	 * @param radius The radius of the sphere.
+	 * @param motion The move.
+	 * @param hit Receives the submesh's item, the fraction of the move made before contact and the normal of the face touched.
+	 * @return True when the sphere touches a submesh during the move.
+	 */
+	bool sweepSphere(const glm::vec3& center, float radius, const glm::vec3& motion, BSPTree::RayHit& hit);
+
+	/**
+	 * @brief Moves a sphere as far as it goes, sliding along the submeshes it touches. Call on the GL thread.
+	 * @param center The center of the sphere before the move.
+	 * @param radius The radius of the sphere.
+	 * @param motion The move asked for.
+	 * @return The center of the sphere after the move.
+	 */
+	glm::vec3 slideSphere(const glm::vec3& center, float radius, const glm::vec3& motion);
+
+	/**
+	 * @brief Prints the memory used by the recorded commands and the static batch.
+	 */
+	void printMemoryFootprint() const;
+
+	/**
+	 * @brief Prints the visibility query counters of the last submitted frame.
+	 *
+	 * Waits for a running simulation step, which writes the counters. Also prints the fragments shaded
+	 * by the newest completed opaque pass per pixel of the viewport, which the depth pre-pass brings
+	 * down to the covered fraction of the screen, and the visible items skipped as occluded. The
+	 * fragments are only counted after the first call.
+	 */
+	void printVisibilityStats();
+
+	/**
+	 * @brief Releases the GL buffers owned by the scene. A running simulation step is finished first.
 	 */
-	void renderScene(bool checkFrustum);
+	void destroyBuffers();
 };
 #endif //SCENEMANAGERBSP_H
\ No newline at end of file
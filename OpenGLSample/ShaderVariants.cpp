@@ -0,0 +1,90 @@
+/**
+ * @file ShaderVariants.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the ShaderVariants class.
+ */
+
+#include "ShaderVariants.h"
+
+const unsigned int ShaderVariants::SPOT_LIGHT;
+const unsigned int ShaderVariants::POINT_LIGHTS;
+const unsigned int ShaderVariants::OVERLAY;
+const unsigned int ShaderVariants::ALL_FEATURES;
+const unsigned int ShaderVariants::VARIANT_COUNT;
+
+/**
+ * @brief Creates the permutations of a shader; none is compiled yet.
+ *
+ * @param fullShader The shader compiled from the files without defines, used as the variant with every feature.
+ * @param vertexPath The vertex shader file of fullShader.
+ * @param fragmentPath The fragment shader file of fullShader.
+ * @param supportedFeatures The features the files can leave out; the others are always compiled in.
+ * @param configure Sets the sampler units and uniform block bindings of each new variant, as for fullShader.
+ */
+ShaderVariants::ShaderVariants(const Shader& fullShader, const char* vertexPath, const char* fragmentPath, unsigned int supportedFeatures,
+    const std::function<void(Shader&)>& configure)
+    : vertexPath(vertexPath), fragmentPath(fragmentPath), supportedFeatures(supportedFeatures & ALL_FEATURES), configure(configure) {
+    variants[ALL_FEATURES] = fullShader;
+}
+
+/**
+ * @brief Returns the variant that computes a set of features, compiling it the first time.
+ *
+ * Must be called on the GL thread. Features the files cannot leave out are added to the mask.
+ *
+ * @param features A mask of SPOT_LIGHT, POINT_LIGHTS and OVERLAY.
+ * @return The variant, which stays valid until destroy.
+ */
+const Shader& ShaderVariants::get(unsigned int features) {
+    const unsigned int mask = (features | ~supportedFeatures) & ALL_FEATURES;
+    Shader& variant = variants[mask];
+    if (variant.ID == 0) {
+        variant = Shader(vertexPath.c_str(), fragmentPath.c_str(), nullptr, getDefines(mask));
+        if (configure) {
+            configure(variant);
+        }
+    }
+    return variant;
+}
+
+/**
+ * @brief Returns the #define lines that leave out the features missing from a mask.
+ */
+std::string ShaderVariants::getDefines(unsigned int features) {
+    std::string defines;
+    if ((features & SPOT_LIGHT) == 0) {
+        defines += "#define SPOT_LIGHT 0\n";
+    }
+    if ((features & POINT_LIGHTS) == 0) {
+        defines += "#define POINT_LIGHTS 0\n";
+    }
+    if ((features & OVERLAY) == 0) {
+        defines += "#define OVERLAY 0\n";
+    }
+    return defines;
+}
+
+/**
+ * @brief Returns the number of variants compiled so far, the full shader included.
+ */
+size_t ShaderVariants::getCompiledCount() const {
+    size_t count = 0;
+    for (const Shader& variant : variants) {
+        count += variant.ID != 0 ? 1 : 0;
+    }
+    return count;
+}
+
+/**
+ * @brief Deletes the programs of the compiled variants. The full shader is left to its owner.
+ */
+void ShaderVariants::destroy() {
+    for (unsigned int mask = 0; mask < ALL_FEATURES; mask++) {
+        if (variants[mask].ID != 0) {
+            glDeleteProgram(variants[mask].ID);
+            variants[mask] = Shader();
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/**
+ * @file ShaderVariants.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the ShaderVariants class, which compiles specialized
+ * variants of the lighting shader that leave out the lights and textures a draw does not use.
+ */
+
+#ifndef SHADERVARIANTS_H
+#define SHADERVARIANTS_H
+
+#include <functional>
+#include <string>
+#include <glad/glad.h>
+
+#include "shader.h"
+
+/**
+ * @class ShaderVariants
+ * @brief The permutations of one shader, selected by a mask of the features they compute.
+ *
+ * Each feature is a preprocessor switch of 6.multiple_lights.fs that defaults to on. A variant is
+ * compiled from the same files with the switches of its missing features defined as 0, so the
+ * compiler removes their uniforms, samples and loops instead of the fragments paying for a branch.
+ * The variant with every feature is the shader given to the constructor. The others are compiled the
+ * first time they are requested; the program cache keeps that cheap after the first run.
+ */
+class ShaderVariants
+{
+public:
+    static const unsigned int SPOT_LIGHT = 1;       // The spot light term
+    static const unsigned int POINT_LIGHTS = 2;     // The cluster lookup and the point light loop
+    static const unsigned int OVERLAY = 4;          // The overlay sample and blend
+    static const unsigned int ALL_FEATURES = SPOT_LIGHT | POINT_LIGHTS | OVERLAY;
+    static const unsigned int VARIANT_COUNT = ALL_FEATURES + 1;
+
+    /**
+     * @brief Creates the permutations of a shader; none is compiled yet.
+     *
+     * @param fullShader The shader compiled from the files without defines, used as the variant with every feature.
+     * @param vertexPath The vertex shader file of fullShader.
+     * @param fragmentPath The fragment shader file of fullShader.
+     * @param supportedFeatures The features the files can leave out; the others are always compiled in.
+     * @param configure Sets the sampler units and uniform block bindings of each new variant, as for fullShader.
+     */
+    ShaderVariants(const Shader& fullShader, const char* vertexPath, const char* fragmentPath, unsigned int supportedFeatures,
+        const std::function<void(Shader&)>& configure);
+
+    /**
+     * @brief Returns the variant that computes a set of features, compiling it the first time.
+     *
+     * Must be called on the GL thread. Features the files cannot leave out are added to the mask.
+     *
+     * @param features A mask of SPOT_LIGHT, POINT_LIGHTS and OVERLAY.
+     * @return The variant, which stays valid until destroy.
+     */
+    const Shader& get(unsigned int features);
+
+    /**
+     * @brief Returns the #define lines that leave out the features missing from a mask.
+     */
+    static std::string getDefines(unsigned int features);
+
+    /**
+     * @brief Returns the number of variants compiled so far, the full shader included.
+     */
+    size_t getCompiledCount() const;
+
+    /**
+     * @brief Deletes the programs of the compiled variants. The full shader is left to its owner.
+     */
+    void destroy();
+
+private:
+    Shader variants[VARIANT_COUNT];     // Indexed by feature mask; ID 0 until compiled
+    std::string vertexPath;
+    std::string fragmentPath;
+    unsigned int supportedFeatures;
+    std::function<void(Shader&)> configure;
+};
+#endif // SHADERVARIANTS_H
@@ -0,0 +1,319 @@
+/**
+ * @file ShadowMaps.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the ShadowMaps class.
+ */
+
+#include "ShadowMaps.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+
+const int ShadowMaps::CASCADE_COUNT;
+const int ShadowMaps::SPOT_VIEW;
+const int ShadowMaps::VIEW_COUNT;
+const GLsizei ShadowMaps::CASCADE_RESOLUTION;
+const GLsizei ShadowMaps::SPOT_RESOLUTION;
+const GLuint ShadowMaps::CASCADE_UNIT;
+const GLuint ShadowMaps::SPOT_UNIT;
+const float ShadowMaps::SHADOW_DISTANCE = 40.0f;
+
+namespace
+{
+    const float CASCADE_SPLIT_LAMBDA = 0.75f;   // Blend of logarithmic (1) and uniform (0) cascade splits
+    const float CASCADE_MARGIN = 1.25f;         // Half extent of a cascade over its slice's bounding radius
+    const float SNAP_FRACTION = 0.25f;          // Grid cell the cascade centers snap to, over the radius
+    const float RADIUS_ROUNDING = 8.0f;         // Radii are rounded up to 1/8 unit so they do not flicker
+    const float CASTER_REACH = 30.0f;           // How far towards the light casters outside a cascade are kept
+    const float SPOT_NEAR = 0.1f;
+    const float SPOT_FAR = 30.0f;
+    const float SPOT_FOV_MARGIN = 2.0f;         // Degrees added around the spot light's cone
+    const float POLYGON_OFFSET_FACTOR = 2.0f;   // Slope-scaled depth bias of the casters
+    const float POLYGON_OFFSET_UNITS = 4.0f;
+
+    /**
+     * @brief Returns an up vector that is not parallel to a direction.
+     */
+    glm::vec3 getUpVector(const glm::vec3& direction)
+    {
+        return std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    /**
+     * @brief Creates a depth texture that compares against a reference depth when sampled.
+     * @param target GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY.
+     * @param resolution The width and height in texels.
+     * @param layers The number of layers of an array texture.
+     */
+    GLuint createDepthMap(GLenum target, GLsizei resolution, GLsizei layers)
+    {
+        // Outside the map everything is lit
+        const GLfloat border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(target, texture);
+        if (target == GL_TEXTURE_2D_ARRAY) {
+            glTexImage3D(target, 0, GL_DEPTH_COMPONENT24, resolution, resolution, layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        }
+        else {
+            glTexImage2D(target, 0, GL_DEPTH_COMPONENT24, resolution, resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        }
+        // Linear filtering of a comparison gives 2x2 percentage-closer filtering for free
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        glTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, border);
+        glTexParameteri(target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glBindTexture(target, 0);
+        return texture;
+    }
+}
+
+/**
+ * @brief Compiles the caster shaders and creates the depth maps and the Shadows uniform buffer.
+ */
+ShadowMaps::ShadowMaps()
+    : casterShader("../OpenGLSample/shaderfiles/6.multiple_lights.vs", "../OpenGLSample/shaderfiles/depth_only.fs"),
+    particleCasterShader("../OpenGLSample/shaderfiles/6.firefly_instanced.vs", "../OpenGLSample/shaderfiles/depth_only.fs") {
+    casterShader.bindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+    particleCasterShader.bindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+
+    for (int kind = 0; kind < MAP_KIND_COUNT; kind++) {
+        cascadeMaps[kind] = createDepthMap(GL_TEXTURE_2D_ARRAY, CASCADE_RESOLUTION, CASCADE_COUNT);
+        spotMaps[kind] = createDepthMap(GL_TEXTURE_2D, SPOT_RESOLUTION, 1);
+    }
+
+    // Depth only: neither framebuffer has a color attachment
+    glGenFramebuffers(MAP_KIND_COUNT, framebuffers);
+    for (int kind = 0; kind < MAP_KIND_COUNT; kind++) {
+        attachMap(framebuffers[kind], static_cast<MapKind>(kind), 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "ERROR::SHADOWMAPS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    shadowsBuffer.create(sizeof(ShadowsBlock), SHADOWS_BLOCK_BINDING);
+}
+
+/**
+ * @brief Fits the shadow views to the camera and the lights, and uploads the Shadows block.
+ *
+ * A view whose matrices differ from the ones its cache was rendered with, or any view after the
+ * static geometry changed, renders its static casters again in the next beginStaticPass.
+ *
+ * @param camera The camera the cascades follow.
+ * @param fovY The camera's vertical field of view in radians.
+ * @param aspect The camera's aspect ratio.
+ * @param zNear The distance of the camera's near plane.
+ * @param lightDirection The direction the directional light shines in.
+ * @param spotPosition The position of the spot light.
+ * @param spotDirection The direction of the spot light.
+ * @param spotOuterCutOff The outer cut-off angle of the spot light in degrees.
+ * @param spotEnabled Renders the spot light's map when true.
+ * @param staticRevision Changes whenever the static geometry changes.
+ */
+void ShadowMaps::update(const Camera& camera, float fovY, float aspect, float zNear, const glm::vec3& lightDirection,
+    const glm::vec3& spotPosition, const glm::vec3& spotDirection, float spotOuterCutOff, bool spotEnabled,
+    unsigned int staticRevision) {
+    staticPassCount = 0;
+    if (staticRevision != cachedRevision) {
+        for (View& view : views) {
+            view.cacheValid = false;
+        }
+        cachedRevision = staticRevision;
+    }
+
+    const glm::vec3 direction = glm::normalize(lightDirection);
+    const glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), direction, getUpVector(direction));
+
+    // Squared distance of a frustum corner from the view axis, per unit of depth
+    const float tanHalfFov = std::tan(fovY * 0.5f);
+    const float cornerSlope = tanHalfFov * tanHalfFov * (1.0f + aspect * aspect);
+
+    float sliceNear = zNear;
+    for (int cascade = 0; cascade < CASCADE_COUNT; cascade++) {
+        const float fraction = (cascade + 1) / static_cast<float>(CASCADE_COUNT);
+        const float logSplit = zNear * std::pow(SHADOW_DISTANCE / zNear, fraction);
+        const float uniformSplit = zNear + (SHADOW_DISTANCE - zNear) * fraction;
+        const float sliceFar = CASCADE_SPLIT_LAMBDA * logSplit + (1.0f - CASCADE_SPLIT_LAMBDA) * uniformSplit;
+
+        // Smallest sphere around the slice's corners, centered on the view axis. It does not depend
+        // on the camera's orientation, so a cascade's size never changes.
+        const float centerDepth = std::min((sliceNear + sliceFar) * (1.0f + cornerSlope) * 0.5f, sliceFar);
+        float radius = std::max(
+            std::sqrt((centerDepth - sliceNear) * (centerDepth - sliceNear) + sliceNear * sliceNear * cornerSlope),
+            std::sqrt((sliceFar - centerDepth) * (sliceFar - centerDepth) + sliceFar * sliceFar * cornerSlope));
+        radius = std::ceil(radius * RADIUS_ROUNDING) / RADIUS_ROUNDING;
+
+        // The center moves in whole grid cells of whole texels: the map stays put, and its cache
+        // valid, while the camera moves within a cell
+        const float halfExtent = radius * CASCADE_MARGIN;
+        const float texel = 2.0f * halfExtent / CASCADE_RESOLUTION;
+        const float cell = std::max(texel, std::floor(radius * SNAP_FRACTION / texel) * texel);
+        const glm::vec3 center = glm::vec3(lightRotation * glm::vec4(camera.Position + camera.Front * centerDepth, 1.0f));
+        const glm::vec3 snappedCenter = glm::floor(center / cell) * cell;
+
+        const glm::mat4 view = glm::translate(glm::mat4(1.0f), -snappedCenter) * lightRotation;
+        const glm::mat4 projection = glm::ortho(-halfExtent, halfExtent, -halfExtent, halfExtent, -(halfExtent + CASTER_REACH), halfExtent);
+        setView(cascade, view, projection);
+        block.cascadeViewProjection[cascade] = projection * view;
+        block.cascadeSplits[cascade] = sliceFar;
+        sliceNear = sliceFar;
+    }
+
+    this->spotEnabled = spotEnabled;
+    block.spotShadows = spotEnabled ? 1 : 0;
+    if (spotEnabled) {
+        const glm::vec3 spotForward = glm::normalize(spotDirection);
+        const float fov = std::min(2.0f * spotOuterCutOff + SPOT_FOV_MARGIN, 170.0f);
+        const glm::mat4 view = glm::lookAt(spotPosition, spotPosition + spotForward, getUpVector(spotForward));
+        const glm::mat4 projection = glm::perspective(glm::radians(fov), 1.0f, SPOT_NEAR, SPOT_FAR);
+        setView(SPOT_VIEW, view, projection);
+        block.spotViewProjection = projection * view;
+    }
+
+    shadowsBuffer.update(&block);
+}
+
+/**
+ * @brief Stores the matrices of a view and invalidates its cache when they changed.
+ */
+void ShadowMaps::setView(int view, const glm::mat4& viewMatrix, const glm::mat4& projection) {
+    View& state = views[view];
+    state.view = viewMatrix;
+    state.projection = projection;
+    if (state.cachedView != viewMatrix || state.cachedProjection != projection) {
+        state.cacheValid = false;
+    }
+}
+
+/**
+ * @brief Returns true when at least one active view must render its static casters again.
+ */
+bool ShadowMaps::needsStaticPass() const {
+    for (int view = 0; view < VIEW_COUNT; view++) {
+        if (isViewActive(view) && !views[view].cacheValid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Attaches one depth map of a view to a framebuffer.
+ */
+void ShadowMaps::attachMap(GLuint framebuffer, MapKind kind, int view) const {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    if (view == SPOT_VIEW) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, spotMaps[kind], 0);
+    }
+    else {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cascadeMaps[kind], 0, view);
+    }
+}
+
+/**
+ * @brief Saves the viewport, binds a view's map and sets the viewport and Camera block to the view.
+ */
+void ShadowMaps::bindView(int view, MapKind kind, UniformBuffer& cameraBuffer) {
+    if (!viewportSaved) {
+        glGetIntegerv(GL_VIEWPORT, savedViewport);
+        viewportSaved = true;
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(POLYGON_OFFSET_FACTOR, POLYGON_OFFSET_UNITS);
+    }
+    attachMap(framebuffers[kind], kind, view);
+    glViewport(0, 0, getResolution(view), getResolution(view));
+
+    CameraBlock cameraBlock = {};
+    cameraBlock.projection = views[view].projection;
+    cameraBlock.view = views[view].view;
+    cameraBlock.viewPos = glm::vec3(glm::inverse(views[view].view)[3]);
+    cameraBuffer.update(&cameraBlock);
+}
+
+/**
+ * @brief Starts rendering the static casters of a view into its cache, when the cache is stale.
+ *
+ * Binds the cache, clears it and loads the view's matrices into the Camera block.
+ *
+ * @param view The view, from 0 to VIEW_COUNT - 1.
+ * @param cameraBuffer The Camera uniform buffer.
+ * @return False when the cache is current and nothing has to be drawn.
+ */
+bool ShadowMaps::beginStaticPass(int view, UniformBuffer& cameraBuffer) {
+    View& state = views[view];
+    if (state.cacheValid) {
+        return false;
+    }
+
+    bindView(view, CACHE, cameraBuffer);
+    glDepthMask(GL_TRUE);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    state.cachedView = state.view;
+    state.cachedProjection = state.projection;
+    state.cacheValid = true;
+    staticPassCount++;
+    return true;
+}
+
+/**
+ * @brief Copies a view's cache into its live map and binds the live map for the dynamic casters.
+ * @param view The view, from 0 to VIEW_COUNT - 1.
+ * @param cameraBuffer The Camera uniform buffer.
+ */
+void ShadowMaps::beginDynamicPass(int view, UniformBuffer& cameraBuffer) {
+    const GLsizei resolution = getResolution(view);
+    attachMap(framebuffers[CACHE], CACHE, view);
+    attachMap(framebuffers[LIVE], LIVE, view);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[CACHE]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[LIVE]);
+    glBlitFramebuffer(0, 0, resolution, resolution, 0, 0, resolution, resolution, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    bindView(view, LIVE, cameraBuffer);
+}
+
+/**
+ * @brief Restores the default framebuffer and viewport and binds the live maps for the scene shaders.
+ *
+ * The Camera block still holds the last shadow view; the caller uploads the camera's again.
+ *
+ * @param stateCache The cache that filters redundant binds.
+ */
+void ShadowMaps::endPasses(GLStateCache& stateCache) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (viewportSaved) {
+        glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        viewportSaved = false;
+    }
+    stateCache.bindTexture(CASCADE_UNIT, GL_TEXTURE_2D_ARRAY, cascadeMaps[LIVE]);
+    stateCache.bindTexture(SPOT_UNIT, GL_TEXTURE_2D, spotMaps[LIVE]);
+}
+
+/**
+ * @brief Releases the depth maps, framebuffers, shaders and uniform buffer.
+ */
+void ShadowMaps::destroy() {
+    glDeleteFramebuffers(MAP_KIND_COUNT, framebuffers);
+    glDeleteTextures(MAP_KIND_COUNT, cascadeMaps);
+    glDeleteTextures(MAP_KIND_COUNT, spotMaps);
+    for (int kind = 0; kind < MAP_KIND_COUNT; kind++) {
+        framebuffers[kind] = 0;
+        cascadeMaps[kind] = 0;
+        spotMaps[kind] = 0;
+    }
+    glDeleteProgram(casterShader.ID);
+    glDeleteProgram(particleCasterShader.ID);
+    shadowsBuffer.destroy();
+}
@@ -0,0 +1,191 @@
+/**
+ * @file ShadowMaps.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the ShadowMaps class, which renders the cascaded shadow map
+ * of the directional light and the shadow map of the spot light, caching what the static geometry casts.
+ */
+
+#ifndef SHADOWMAPS_H
+#define SHADOWMAPS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "camera.h"
+#include "GLStateCache.h"
+#include "UniformBuffer.h"
+
+/**
+ * @class ShadowMaps
+ * @brief Depth maps of the directional and spot lights, with the static casters cached.
+ *
+ * The directional light covers the view out to SHADOW_DISTANCE with SHADOW_CASCADE_COUNT cascades.
+ * Each cascade is a square around the bounding sphere of its slice of the view frustum, and its center
+ * is snapped to a coarse grid in light space, so its matrices only change when the camera crosses a grid
+ * cell. The spot light has one perspective map along its cone.
+ *
+ * Every view keeps two depth maps. The cache holds the static geometry and is re-rendered only when the
+ * view's matrices or the static geometry changed. The live map, which the scene shaders sample, is a
+ * copy of the cache with the dynamic casters drawn over it every frame.
+ *
+ * The matrices of each view are loaded into the Camera block while it is rendered, so the casters are
+ * drawn with the scene's own vertex shaders and an empty fragment shader.
+ */
+class ShadowMaps
+{
+public:
+    static const int CASCADE_COUNT = SHADOW_CASCADE_COUNT;
+    static const int SPOT_VIEW = CASCADE_COUNT;       // Views are the cascades, then the spot light
+    static const int VIEW_COUNT = CASCADE_COUNT + 1;
+
+    static const GLsizei CASCADE_RESOLUTION = 1024;
+    static const GLsizei SPOT_RESOLUTION = 1024;
+
+    // Texture units of the live maps, after the G-buffer targets
+    static const GLuint CASCADE_UNIT = 11;
+    static const GLuint SPOT_UNIT = 12;
+
+    // View distance covered by the cascades
+    static const float SHADOW_DISTANCE;
+
+    /**
+     * @brief Compiles the caster shaders and creates the depth maps and the Shadows uniform buffer.
+     */
+    ShadowMaps();
+
+    /**
+     * @brief Fits the shadow views to the camera and the lights, and uploads the Shadows block.
+     *
+     * A view whose matrices differ from the ones its cache was rendered with, or any view after the
+     * static geometry changed, renders its static casters again in the next beginStaticPass.
+     *
+     * @param camera The camera the cascades follow.
+     * @param fovY The camera's vertical field of view in radians.
+     * @param aspect The camera's aspect ratio.
+     * @param zNear The distance of the camera's near plane.
+     * @param lightDirection The direction the directional light shines in.
+     * @param spotPosition The position of the spot light.
+     * @param spotDirection The direction of the spot light.
+     * @param spotOuterCutOff The outer cut-off angle of the spot light in degrees.
+     * @param spotEnabled Renders the spot light's map when true.
+     * @param staticRevision Changes whenever the static geometry changes.
+     */
+    void update(const Camera& camera, float fovY, float aspect, float zNear, const glm::vec3& lightDirection,
+        const glm::vec3& spotPosition, const glm::vec3& spotDirection, float spotOuterCutOff, bool spotEnabled,
+        unsigned int staticRevision);
+
+    /**
+     * @brief Returns true when a view is rendered this frame.
+     */
+    bool isViewActive(int view) const { return view != SPOT_VIEW || spotEnabled; }
+
+    /**
+     * @brief Returns true when at least one active view must render its static casters again.
+     */
+    bool needsStaticPass() const;
+
+    /**
+     * @brief Starts rendering the static casters of a view into its cache, when the cache is stale.
+     *
+     * Binds the cache, clears it and loads the view's matrices into the Camera block.
+     *
+     * @param view The view, from 0 to VIEW_COUNT - 1.
+     * @param cameraBuffer The Camera uniform buffer.
+     * @return False when the cache is current and nothing has to be drawn.
+     */
+    bool beginStaticPass(int view, UniformBuffer& cameraBuffer);
+
+    /**
+     * @brief Copies a view's cache into its live map and binds the live map for the dynamic casters.
+     * @param view The view, from 0 to VIEW_COUNT - 1.
+     * @param cameraBuffer The Camera uniform buffer.
+     */
+    void beginDynamicPass(int view, UniformBuffer& cameraBuffer);
+
+    /**
+     * @brief Restores the default framebuffer and viewport and binds the live maps for the scene shaders.
+     *
+     * The Camera block still holds the last shadow view; the caller uploads the camera's again.
+     *
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void endPasses(GLStateCache& stateCache);
+
+    /**
+     * @brief Returns the depth-only shader for meshes drawn with a model matrix.
+     */
+    const Shader& getCasterShader() const { return casterShader; }
+
+    /**
+     * @brief Returns the depth-only shader for the fireflies.
+     */
+    const Shader& getParticleCasterShader() const { return particleCasterShader; }
+
+    /**
+     * @brief Returns the number of views whose static casters were rendered again by the last frame.
+     */
+    int getStaticPassCount() const { return staticPassCount; }
+
+    /**
+     * @brief Streams the Shadows block, rewritten every update, through a ring.
+     * @param buffer The ring, or nullptr to update the block's own buffer.
+     */
+    void setStreamBuffer(StreamBuffer* buffer) { shadowsBuffer.setStreamBuffer(buffer); }
+
+    /**
+     * @brief Releases the depth maps, framebuffers, shaders and uniform buffer.
+     */
+    void destroy();
+
+private:
+    enum MapKind { CACHE = 0, LIVE, MAP_KIND_COUNT };
+
+    // Matrices one view was last fitted with, and those its cache was rendered with
+    struct View
+    {
+        glm::mat4 view = glm::mat4(1.0f);
+        glm::mat4 projection = glm::mat4(1.0f);
+        glm::mat4 cachedView = glm::mat4(1.0f);
+        glm::mat4 cachedProjection = glm::mat4(1.0f);
+        bool cacheValid = false;
+    };
+
+    Shader casterShader;         // Scene meshes and the static batch
+    Shader particleCasterShader; // Fireflies
+
+    View views[VIEW_COUNT];
+    GLuint cascadeMaps[MAP_KIND_COUNT] = { 0, 0 }; // One layer per cascade
+    GLuint spotMaps[MAP_KIND_COUNT] = { 0, 0 };
+    GLuint framebuffers[MAP_KIND_COUNT] = { 0, 0 }; // Read and draw targets of the copies
+    UniformBuffer shadowsBuffer;
+    ShadowsBlock block = {};
+    bool spotEnabled = false;
+    unsigned int cachedRevision = 0;
+    int staticPassCount = 0;
+    GLint savedViewport[4] = { 0, 0, 0, 0 };
+    bool viewportSaved = false;
+
+    /**
+     * @brief Stores the matrices of a view and invalidates its cache when they changed.
+     */
+    void setView(int view, const glm::mat4& viewMatrix, const glm::mat4& projection);
+
+    /**
+     * @brief Attaches one depth map of a view to a framebuffer.
+     */
+    void attachMap(GLuint framebuffer, MapKind kind, int view) const;
+
+    /**
+     * @brief Saves the viewport, binds a view's map and sets the viewport and Camera block to the view.
+     */
+    void bindView(int view, MapKind kind, UniformBuffer& cameraBuffer);
+
+    /**
+     * @brief Returns the resolution of a view's maps.
+     */
+    static GLsizei getResolution(int view) { return view == SPOT_VIEW ? SPOT_RESOLUTION : CASCADE_RESOLUTION; }
+};
+#endif // SHADOWMAPS_H
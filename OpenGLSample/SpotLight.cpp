@@ -10,61 +10,22 @@
 /**
  * @brief Constructor for the SpotLight class.
  *
- * This constructor initializes the SpotLight object using a configuration file path and a Camera object. It sets up the light properties and reads additional settings from the configuration file.
+ * This constructor initializes the SpotLight object from the descriptor of its section of the configuration file and a Camera object, which gives its position and direction.
  *
- * @param configFilePath A string representing the path to the configuration file.
+ * @param descriptor The light's section of the configuration file.
  * @param camera A Camera object used to initialize the SpotLight.
  */
-SpotLight::SpotLight(const std::string& configFilePath, Camera camera) 
-    : LightSource(configFilePath),
-    position(0.0f, 0.0f, 0.0f),
-    constant(1.0f),
-    linear(0.0f),
-    quadratic(0.0f),
-    cutOff(0.0f),
-    outerCutOff(0.0f),
-    originalDiffuse(0.0f, 0.0f, 0.0f),
-    originalSpecular(0.0f, 0.0f, 0.0f) {
-    std::ifstream configFile(configFilePath);
-    std::string line;
-    while (std::getline(configFile, line)) {
-        std::istringstream iss(line);
-        std::string key;
-        if (std::getline(iss, key, '=')) {
-            std::string value;
-            if (std::getline(iss, value)) {
-                if (key == "ambient") {
-                    std::istringstream(value) >> ambient.x >> ambient.y >> ambient.z;
-                }
-                else if (key == "diffuse") {
-                    std::istringstream(value) >> diffuse.x >> diffuse.y >> diffuse.z;
-                }
-                else if (key == "specular") {
-                    std::istringstream(value) >> specular.x >> specular.y >> specular.z;
-                }
-                else if (key == "constant") {
-                    std::istringstream(value) >> constant;
-                }
-                else if (key == "linear") {
-                    std::istringstream(value) >> linear;
-                }
-                else if (key == "quadratic") {
-                    std::istringstream(value) >> quadratic;
-                }
-                else if (key == "cutoff") {
-                    std::istringstream(value) >> cutOff;
-                }
-                else if (key == "outercutoff") {
-                    std::istringstream(value) >> outerCutOff;
-                }
-            }
-        }
-        position = camera.Position;
-        direction = camera.Front;
-        originalDiffuse = diffuse;
-        originalSpecular = specular;
-    }
-    configFile.close();
+SpotLight::SpotLight(const LightDescriptor& descriptor, const Camera& camera)
+    : LightSource(descriptor),
+    direction(camera.Front),
+    position(camera.Position),
+    constant(descriptor.constant),
+    linear(descriptor.linear),
+    quadratic(descriptor.quadratic),
+    cutOff(descriptor.cutOff),
+    outerCutOff(descriptor.outerCutOff),
+    originalDiffuse(descriptor.diffuse),
+    originalSpecular(descriptor.specular) {
 }
 
 /**
@@ -90,6 +51,26 @@ void SpotLight::setToShader(Shader& shader, const std::string& name) const {
     shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(outerCutOff)));
 }
 
+/**
+ * @brief Writes the SpotLight properties into the Lights uniform block.
+ *
+ * The cut-off angles are stored as cosines, as expected by the fragment shader.
+ *
+ * @param block The Lights block that will be uploaded to the uniform buffer.
+ */
+void SpotLight::writeToBlock(LightsBlock& block) const {
+    block.spotLight.position = position;
+    block.spotLight.direction = direction;
+    block.spotLight.ambient = ambient;
+    block.spotLight.diffuse = diffuse;
+    block.spotLight.specular = specular;
+    block.spotLight.constant = constant;
+    block.spotLight.linear = linear;
+    block.spotLight.quadratic = quadratic;
+    block.spotLight.cutOff = glm::cos(glm::radians(cutOff));
+    block.spotLight.outerCutOff = glm::cos(glm::radians(outerCutOff));
+}
+
 /**
  * @brief Updates the SpotLight's properties based on the Camera's properties.
  *
@@ -98,8 +79,11 @@ void SpotLight::setToShader(Shader& shader, const std::string& name) const {
  * @param camera A reference to the Camera object whose properties will be used to update the SpotLight.
  */
 void SpotLight::updateWithCamera(const Camera& camera) {
-    position = camera.Position;
-    direction = camera.Front;
+    if (position != camera.Position || direction != camera.Front) {
+        position = camera.Position;
+        direction = camera.Front;
+        markChanged();
+    }
 }
 
 /**
@@ -110,12 +94,48 @@ void SpotLight::updateWithCamera(const Camera& camera) {
  * @param showFlashlight A boolean parameter that determines whether to show the flashlight (true) or not (false).
  */
 void SpotLight::toggleFlashlight(bool showFlashlight) {
-    if (!showFlashlight) {
-        diffuse = glm::vec3(0.0f, 0.0f, 0.0f);
-        specular = glm::vec3(0.0f, 0.0f, 0.0f);
-    }
-    else {
-        diffuse = originalDiffuse;
-        specular = originalSpecular;
+    glm::vec3 newDiffuse = showFlashlight ? originalDiffuse : glm::vec3(0.0f, 0.0f, 0.0f);
+    glm::vec3 newSpecular = showFlashlight ? originalSpecular : glm::vec3(0.0f, 0.0f, 0.0f);
+    if (diffuse != newDiffuse || specular != newSpecular) {
+        diffuse = newDiffuse;
+        specular = newSpecular;
+        markChanged();
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Returns true when the SpotLight adds any light, so the lighting shader must compute it.
+ */
+bool SpotLight::isLit() const {
+    const glm::vec3 none(0.0f);
+    return ambient != none || diffuse != none || specular != none;
+}
+
+/**
+ * @brief Takes the colors, attenuation and cut-off angles of a descriptor, after the configuration file was reloaded.
+ *
+ * The position and direction keep following the camera, and the flashlight mode keeps applying to the new colors.
+ *
+ * @param descriptor The light's section of the reloaded configuration file.
+ */
+void SpotLight::configure(const LightDescriptor& descriptor) {
+    const bool showFlashlight = diffuse == originalDiffuse && specular == originalSpecular;
+    constant = descriptor.constant;
+    linear = descriptor.linear;
+    quadratic = descriptor.quadratic;
+    cutOff = descriptor.cutOff;
+    outerCutOff = descriptor.outerCutOff;
+    originalDiffuse = descriptor.diffuse;
+    originalSpecular = descriptor.specular;
+    LightSource::configure(descriptor);
+    toggleFlashlight(showFlashlight);
+}
+
+/**
+ * @brief Turns the light off, flashlight mode included, after its section was removed from the configuration file.
+ */
+void SpotLight::switchOff() {
+    originalDiffuse = glm::vec3(0.0f);
+    originalSpecular = glm::vec3(0.0f);
+    LightSource::switchOff();
+}
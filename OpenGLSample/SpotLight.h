@@ -36,12 +36,12 @@ public:
     /**
      * @brief Constructor for the SpotLight class.
      *
-     * This constructor initializes the SpotLight object using a configuration file path and a Camera object. It sets up the light properties and reads additional settings from the configuration file.
+     * This constructor initializes the SpotLight object from the descriptor of its section of the configuration file and a Camera object, which gives its position and direction.
      *
-     * @param configFilePath A string representing the path to the configuration file.
+     * @param descriptor The light's section of the configuration file.
      * @param camera A Camera object used to initialize the SpotLight.
      */
-    SpotLight(const std::string& configFilePath, Camera camera);
+    SpotLight(const LightDescriptor& descriptor, const Camera& camera);
 
     /**
      * @brief Sets the SpotLight properties to a shader.
@@ -53,6 +53,15 @@ public:
      */
     void setToShader(Shader& shader, const std::string& name) const override;
 
+    /**
+     * @brief Writes the SpotLight properties into the Lights uniform block.
+     *
+     * The cut-off angles are stored as cosines, as expected by the fragment shader.
+     *
+     * @param block The Lights block that will be uploaded to the uniform buffer.
+     */
+    void writeToBlock(LightsBlock& block) const override;
+
     /**
      * @brief Updates the SpotLight's properties based on the Camera's properties.
      *
@@ -70,6 +79,25 @@ public:
      * @param showFlashlight A boolean parameter that determines whether to show the flashlight (true) or not (false).
      */
     void toggleFlashlight(bool showFlashlight);
+
+    /**
+     * @brief Returns true when the SpotLight adds any light, so the lighting shader must compute it.
+     */
+    bool isLit() const;
+
+    /**
+     * @brief Takes the colors, attenuation and cut-off angles of a descriptor, after the configuration file was reloaded.
+     *
+     * The position and direction keep following the camera, and the flashlight mode keeps applying to the new colors.
+     *
+     * @param descriptor The light's section of the reloaded configuration file.
+     */
+    void configure(const LightDescriptor& descriptor) override;
+
+    /**
+     * @brief Turns the light off, flashlight mode included, after its section was removed from the configuration file.
+     */
+    void switchOff() override;
 };
 
 #endif // SPOTLIGHT_H
\ No newline at end of file
@@ -0,0 +1,202 @@
+/**
+ * @file StaticBatch.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the StaticBatch class.
+ */
+
+#include "StaticBatch.h"
+#include <iostream>
+
+namespace
+{
+    const GLuint FLOATS_PER_VERTEX = 8; // position, normal, texture coordinate
+}
+
+/**
+ * @brief Returns the section drawn with the command's texture set, creating it if needed.
+ */
+StaticBatch::Section& StaticBatch::findSection(const RenderCommand& command) {
+    for (Section& section : sections) {
+        if (section.diffuseTexture == command.diffuseTexture
+            && section.specularTexture == command.specularTexture
+            && section.overlayTexture == command.overlayTexture
+            && section.shininess == command.shininess) {
+            return section;
+        }
+    }
+
+    Section section;
+    section.diffuseTexture = command.diffuseTexture;
+    section.specularTexture = command.specularTexture;
+    section.overlayTexture = command.overlayTexture;
+    section.shininess = command.shininess;
+    section.firstIndex = 0;
+    section.indexCount = 0;
+    sections.push_back(section);
+    return sections.back();
+}
+
+/**
+ * @brief Bakes a recorded draw into the batch.
+ * @param command The recorded draw; its model matrix, texture set, shininess and uvScale are used.
+ * @param mesh The CPU data of the mesh the command draws.
+ */
+void StaticBatch::add(const RenderCommand& command, const MeshCreator::MeshData& mesh) {
+    GLuint baseVertex = static_cast<GLuint>(vertices.size() / FLOATS_PER_VERTEX);
+    glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(command.model)));
+
+    for (size_t i = 0; i + FLOATS_PER_VERTEX <= mesh.vertices.size(); i += FLOATS_PER_VERTEX) {
+        glm::vec4 position = command.model * glm::vec4(mesh.vertices[i], mesh.vertices[i + 1], mesh.vertices[i + 2], 1.0f);
+        glm::vec3 normal = glm::normalize(normalMatrix * glm::vec3(mesh.vertices[i + 3], mesh.vertices[i + 4], mesh.vertices[i + 5]));
+        glm::vec2 uv = glm::vec2(mesh.vertices[i + 6], mesh.vertices[i + 7]) * command.uvScale;
+
+        vertices.push_back(position.x);
+        vertices.push_back(position.y);
+        vertices.push_back(position.z);
+        vertices.push_back(normal.x);
+        vertices.push_back(normal.y);
+        vertices.push_back(normal.z);
+        vertices.push_back(uv.x);
+        vertices.push_back(uv.y);
+    }
+
+    Section& section = findSection(command);
+    for (GLushort index : mesh.indices) {
+        section.indices.push_back(baseVertex + index);
+    }
+}
+
+/**
+ * @brief Uploads the baked geometry and releases the CPU copies.
+ */
+void StaticBatch::build() {
+    // Lay the sections out one after another in a single index buffer
+    std::vector<GLuint> indices;
+    for (Section& section : sections) {
+        section.firstIndex = static_cast<GLuint>(indices.size());
+        section.indexCount = static_cast<GLuint>(section.indices.size());
+        indices.insert(indices.end(), section.indices.begin(), section.indices.end());
+        std::vector<GLuint>().swap(section.indices);
+    }
+
+    vertexBytes = vertices.size() * sizeof(GLfloat);
+    indexBytes = indices.size() * sizeof(GLuint);
+    if (vertexBytes == 0 || indexBytes == 0) {
+        std::cout << "ERROR::STATICBATCH::EMPTY_BATCH" << std::endl;
+        return;
+    }
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(2, vbos);
+    glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbos[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indices.data(), GL_STATIC_DRAW);
+
+    // Same layout as the MeshCreator meshes
+    GLint stride = sizeof(float) * FLOATS_PER_VERTEX;
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * 3));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * 6));
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+    std::vector<GLfloat>().swap(vertices);
+}
+
+/**
+ * @brief Draws every section of the batch.
+ *
+ * Works with both the regular and the instanced lighting shader: the model matrix uniform and
+ * the generic instance attributes are set to identity, since the geometry is already in world space.
+ *
+ * @param shader The lighting shader used for the draws.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void StaticBatch::draw(const Shader& shader, GLStateCache& stateCache) const {
+    if (vao == 0) {
+        return;
+    }
+
+    stateCache.useProgram(shader.ID);
+    setIdentityTransform(shader);
+    shader.setVec2(shader.getUniformLocation("uvScale"), glm::vec2(1.0f, 1.0f));
+
+    const GLint shininessLocation = shader.getUniformLocation("material.shininess");
+    stateCache.bindVertexArray(vao);
+    for (const Section& section : sections) {
+        // bind textures on corresponding texture units
+        stateCache.bindTexture(0, GL_TEXTURE_2D, section.diffuseTexture);
+        stateCache.bindTexture(1, GL_TEXTURE_2D, section.specularTexture);
+        stateCache.bindTexture(2, GL_TEXTURE_2D, section.overlayTexture);
+        shader.setFloat(shininessLocation, section.shininess);
+
+        glDrawElements(GL_TRIANGLES, section.indexCount, GL_UNSIGNED_INT, (void*)(section.firstIndex * sizeof(GLuint)));
+    }
+}
+
+/**
+ * @brief Writes the depth of the whole batch with one draw call.
+ *
+ * The sections lie back to back in the index buffer, and the depth-only shader needs none of the
+ * textures that separate them. Works with both the regular and the instanced depth shader.
+ *
+ * @param shader The depth-only shader.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void StaticBatch::drawDepth(const Shader& shader, GLStateCache& stateCache) const {
+    if (vao == 0) {
+        return;
+    }
+
+    stateCache.useProgram(shader.ID);
+    setIdentityTransform(shader);
+    stateCache.bindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexBytes / sizeof(GLuint)), GL_UNSIGNED_INT, 0);
+}
+
+/**
+ * @brief Sets the model matrix uniform and the generic instance attributes to identity, and selects
+ * the material uniforms over the material table.
+ */
+void StaticBatch::setIdentityTransform(const Shader& shader) {
+    shader.setMat4(shader.getUniformLocation("model"), glm::mat4(1.0f));
+    // Identity for the instanced shader's per-instance matrix, locations 3 to 6
+    glVertexAttrib4f(3, 1.0f, 0.0f, 0.0f, 0.0f);
+    glVertexAttrib4f(4, 0.0f, 1.0f, 0.0f, 0.0f);
+    glVertexAttrib4f(5, 0.0f, 0.0f, 1.0f, 0.0f);
+    glVertexAttrib4f(6, 0.0f, 0.0f, 0.0f, 1.0f);
+    // Both shaders read the material uniforms set per section instead of the material table
+    shader.setInt(shader.getUniformLocation("materialIndex"), MaterialTable::NO_MATERIAL);
+    glVertexAttribI4i(7, MaterialTable::NO_MATERIAL, 0, 0, 0);
+}
+
+/**
+ * @brief Returns the memory used by the batch in bytes, GPU buffers included.
+ */
+size_t StaticBatch::getMemoryFootprint() const {
+    size_t bytes = sizeof(*this) + sections.capacity() * sizeof(Section) + vertices.capacity() * sizeof(GLfloat);
+    for (const Section& section : sections) {
+        bytes += section.indices.capacity() * sizeof(GLuint);
+    }
+    return bytes + vertexBytes + indexBytes;
+}
+
+/**
+ * @brief Releases the GL buffers.
+ */
+void StaticBatch::destroy() {
+    if (vao != 0) {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(2, vbos);
+        vao = 0;
+        vbos[0] = 0;
+        vbos[1] = 0;
+    }
+}
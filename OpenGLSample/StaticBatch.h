@@ -0,0 +1,118 @@
+/**
+ * @file StaticBatch.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the StaticBatch class, which bakes static geometry
+ * into a single vertex buffer.
+ */
+
+#ifndef STATICBATCH_H
+#define STATICBATCH_H
+
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "MeshCreator.h"
+#include "RenderCommand.h"
+#include "GLStateCache.h"
+#include "shader.h"
+
+/**
+ * @class StaticBatch
+ * @brief Static geometry pre-transformed into world space and merged into one VBO and IBO.
+ *
+ * Recorded draws are baked once: positions and normals are transformed by the model matrix and the
+ * uvScale is folded into the texture coordinates. Draws that share a texture set and shininess are
+ * merged into one section, and each section is drawn with a single glDrawElements call.
+ */
+class StaticBatch
+{
+private:
+    // A run of indices drawn with one texture set
+    struct Section
+    {
+        GLuint diffuseTexture;
+        GLuint specularTexture;
+        GLuint overlayTexture;
+        float shininess;
+        std::vector<GLuint> indices;  // Released once the batch is built
+        GLuint firstIndex;
+        GLuint indexCount;
+    };
+
+    std::vector<GLfloat> vertices;  // Released once the batch is built
+    std::vector<Section> sections;
+    GLuint vao = 0;
+    GLuint vbos[2] = { 0, 0 };
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+
+    /**
+     * @brief Returns the section drawn with the command's texture set, creating it if needed.
+     */
+    Section& findSection(const RenderCommand& command);
+
+    /**
+     * @brief Sets the model matrix uniform and the generic instance attributes to identity, and selects
+     * the material uniforms over the material table.
+     */
+    static void setIdentityTransform(const Shader& shader);
+
+public:
+    /**
+     * @brief Bakes a recorded draw into the batch.
+     * @param command The recorded draw; its model matrix, texture set, shininess and uvScale are used.
+     * @param mesh The CPU data of the mesh the command draws.
+     */
+    void add(const RenderCommand& command, const MeshCreator::MeshData& mesh);
+
+    /**
+     * @brief Uploads the baked geometry and releases the CPU copies.
+     */
+    void build();
+
+    /**
+     * @brief Draws every section of the batch.
+     *
+     * Works with both the regular and the instanced lighting shader: the model matrix uniform and
+     * the generic instance attributes are set to identity, since the geometry is already in world space.
+     *
+     * @param shader The lighting shader used for the draws.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void draw(const Shader& shader, GLStateCache& stateCache) const;
+
+    /**
+     * @brief Writes the depth of the whole batch with one draw call.
+     *
+     * The sections lie back to back in the index buffer, and the depth-only shader needs none of the
+     * textures that separate them. Works with both the regular and the instanced depth shader.
+     *
+     * @param shader The depth-only shader.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void drawDepth(const Shader& shader, GLStateCache& stateCache) const;
+
+    /**
+     * @brief Returns the number of draw calls issued by draw().
+     */
+    size_t getDrawCallCount() const { return sections.size(); }
+
+    /**
+     * @brief Returns the number of triangles drawn by draw().
+     */
+    size_t getTriangleCount() const { return indexBytes / sizeof(GLuint) / 3; }
+
+    /**
+     * @brief Returns the memory used by the batch in bytes, GPU buffers included.
+     */
+    size_t getMemoryFootprint() const;
+
+    /**
+     * @brief Releases the GL buffers.
+     */
+    void destroy();
+};
+#endif // STATICBATCH_H
@@ -0,0 +1,272 @@
+/**
+ * @file StreamBuffer.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the StreamBuffer class.
+ */
+
+#include "StreamBuffer.h"
+#include <cstring>
+#include <iostream>
+
+const GLsizeiptr StreamBuffer::DEFAULT_FRAME_SIZE;
+const int StreamBuffer::FRAME_COUNT;
+const GLintptr StreamBuffer::NO_SPACE;
+
+// GL 4.4 tokens, missing from the GL 4.3 loader
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// Unnamed namespace
+namespace
+{
+    // Alignment of every write, enough for a vec4 attribute and an indirect command
+    const GLsizeiptr MIN_ALIGNMENT = 16;
+
+    /**
+     * @brief Returns true when the context exposes an extension.
+     */
+    bool hasExtension(const char* name) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension != nullptr && std::strcmp(extension, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Returns true when the context is at least a version.
+     */
+    bool hasVersion(GLint major, GLint minor) {
+        GLint contextMajor = 0, contextMinor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+        glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+        return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+    }
+}
+
+/**
+ * @brief Allocates the buffer, persistently mapped when the driver supports it.
+ *
+ * Must be called once the GL functions are loaded.
+ *
+ * @param frameSize The size of one frame region in bytes.
+ * @param loader The function that returns GL entry points, used to find glBufferStorage.
+ */
+void StreamBuffer::create(GLsizeiptr frameSize, GLADloadproc loader) {
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    uniformAlignment = alignment > 0 ? alignment : uniformAlignment;
+    regionSize = (frameSize + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+
+    bufferStorage = nullptr;
+    if (loader != nullptr && (hasVersion(4, 4) || hasExtension("GL_ARB_buffer_storage"))) {
+        bufferStorage = reinterpret_cast<BufferStorageProc>(loader("glBufferStorage"));
+    }
+    allocate();
+    region = -1;
+    frameNumber = 0;
+    waitCount = orphanCount = overflowCount = 0;
+}
+
+/**
+ * @brief Starts writing into the next region, waiting only if the GPU is still reading it.
+ */
+void StreamBuffer::beginFrame() {
+    if (buffer == 0) {
+        return;
+    }
+    frameNumber++;
+
+    // Regions grow after a frame that did not fit, once the GPU is done with the old storage
+    if (overflowed) {
+        waitForAll();
+        if (mapped != nullptr) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            mapped = nullptr;
+        }
+        glDeleteBuffers(1, &buffer);
+        regionSize *= 2;
+        allocate();
+        overflowed = false;
+    }
+
+    region = (region + 1) % FRAME_COUNT;
+    head = 0;
+    GLsync& fence = fences[region];
+    if (fence == 0) {
+        return;
+    }
+    if (mapped != nullptr) {
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            waitCount++;
+            while (status == GL_TIMEOUT_EXPIRED) {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            }
+        }
+        glDeleteSync(fence);
+        fence = 0;
+        return;
+    }
+
+    // Without a persistent mapping, fresh storage is cheaper than a wait
+    const GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        orphanCount++;
+        for (GLsync& pending : fences) {
+            if (pending != 0) {
+                glDeleteSync(pending);
+                pending = 0;
+            }
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, regionSize * FRAME_COUNT, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return;
+    }
+    glDeleteSync(fence);
+    fence = 0;
+}
+
+/**
+ * @brief Copies data into the current region.
+ * @param data The bytes to copy.
+ * @param size The number of bytes.
+ * @param alignment What the offset must be a multiple of; 0 for the uniform block alignment.
+ * @return The offset of the copy in the buffer, or NO_SPACE when the region is full.
+ */
+GLintptr StreamBuffer::write(const void* data, GLsizeiptr size, GLsizeiptr alignment) {
+    if (buffer == 0 || region < 0) {
+        return NO_SPACE;
+    }
+    if (alignment <= 0) {
+        alignment = uniformAlignment;
+    }
+    alignment = alignment > MIN_ALIGNMENT ? alignment : MIN_ALIGNMENT;
+    const GLintptr start = (head + alignment - 1) / alignment * alignment;
+    if (start + size > regionSize) {
+        overflowed = true;
+        overflowCount++;
+        return NO_SPACE;
+    }
+    head = start + size;
+    const GLintptr offset = region * regionSize + start;
+    if (size <= 0) {
+        return offset;
+    }
+
+    if (mapped != nullptr) {
+        std::memcpy(mapped + offset, data, static_cast<size_t>(size));
+        return offset;
+    }
+    // The region's fence has signaled, so nothing the GPU still reads is overwritten
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    void* range = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size,
+        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    if (range == nullptr) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return NO_SPACE;
+    }
+    std::memcpy(range, data, static_cast<size_t>(size));
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return offset;
+}
+
+/**
+ * @brief Fences the current region once every draw that reads it has been issued.
+ */
+void StreamBuffer::endFrame() {
+    if (buffer == 0 || region < 0) {
+        return;
+    }
+    if (fences[region] != 0) {
+        glDeleteSync(fences[region]);
+    }
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/**
+ * @brief Prints the mapping mode and how often frames waited, orphaned or overflowed.
+ */
+void StreamBuffer::printStats() const {
+    std::cout << "Stream buffer: " << FRAME_COUNT << " x " << regionSize / 1024 << " KB, "
+        << (isPersistent() ? "persistently mapped" : "mapped per write") << ", " << waitCount << " waits, "
+        << orphanCount << " orphans, " << overflowCount << " overflowed writes" << std::endl;
+}
+
+/**
+ * @brief Unmaps and releases the buffer, once its fences have signaled.
+ */
+void StreamBuffer::destroy() {
+    if (buffer == 0) {
+        return;
+    }
+    waitForAll();
+    if (mapped != nullptr) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        mapped = nullptr;
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    region = -1;
+}
+
+/**
+ * @brief Creates the buffer storage for the current region size and maps it when persistent.
+ */
+void StreamBuffer::allocate() {
+    const GLsizeiptr totalSize = regionSize * FRAME_COUNT;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    mapped = nullptr;
+    if (bufferStorage != nullptr) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_COPY_WRITE_BUFFER, totalSize, NULL, flags);
+        mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags));
+        if (mapped == nullptr) {
+            // Immutable storage cannot be respecified, so the fallback starts on a new buffer
+            std::cout << "ERROR::STREAMBUFFER::MAP_FAILED falling back to a mapping per write" << std::endl;
+            bufferStorage = nullptr;
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            glDeleteBuffers(1, &buffer);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        }
+    }
+    if (mapped == nullptr) {
+        glBufferData(GL_COPY_WRITE_BUFFER, totalSize, NULL, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+/**
+ * @brief Waits for every region's fence and deletes the fences.
+ */
+void StreamBuffer::waitForAll() {
+    for (GLsync& fence : fences) {
+        if (fence == 0) {
+            continue;
+        }
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (status == GL_TIMEOUT_EXPIRED) {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        glDeleteSync(fence);
+        fence = 0;
+    }
+}
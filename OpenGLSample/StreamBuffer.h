@@ -0,0 +1,120 @@
+/**
+ * @file StreamBuffer.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the StreamBuffer class, a triple-buffered ring that
+ * every per-frame upload is written into without waiting on the GPU.
+ */
+
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <cstddef>
+#include <glad/glad.h>
+
+/**
+ * @class StreamBuffer
+ * @brief One buffer object split into a region per frame in flight, each guarded by a fence.
+ *
+ * A frame writes only into its own region, which the GPU finished reading when its fence signaled,
+ * so no write needs the driver to synchronize. With GL 4.4 or ARB_buffer_storage the buffer is
+ * mapped once, persistently and coherently, and a write is a memcpy. Under plain GL 3.3 each write
+ * maps its range unsynchronized instead, and a region whose fence has not signaled yet is not waited
+ * for: the whole buffer is orphaned and the frame starts on fresh storage.
+ *
+ * A write that does not fit the region returns NO_SPACE and the caller uploads it the way it did
+ * before; the region is doubled at the next beginFrame. The same buffer serves uniform blocks,
+ * vertex attributes and indirect commands, so writes are aligned to every binding's needs.
+ */
+class StreamBuffer
+{
+public:
+    static const GLsizeiptr DEFAULT_FRAME_SIZE = 4 * 1024 * 1024;   // Bytes per frame region
+    static const int FRAME_COUNT = 3;                                // Regions, and frames in flight
+    static const GLintptr NO_SPACE = -1;
+
+    /**
+     * @brief Allocates the buffer, persistently mapped when the driver supports it.
+     *
+     * Must be called once the GL functions are loaded.
+     *
+     * @param frameSize The size of one frame region in bytes.
+     * @param loader The function that returns GL entry points, used to find glBufferStorage.
+     */
+    void create(GLsizeiptr frameSize, GLADloadproc loader);
+
+    /**
+     * @brief Starts writing into the next region, waiting only if the GPU is still reading it.
+     */
+    void beginFrame();
+
+    /**
+     * @brief Copies data into the current region.
+     * @param data The bytes to copy.
+     * @param size The number of bytes.
+     * @param alignment What the offset must be a multiple of; 0 for the uniform block alignment.
+     * @return The offset of the copy in the buffer, or NO_SPACE when the region is full.
+     */
+    GLintptr write(const void* data, GLsizeiptr size, GLsizeiptr alignment = 0);
+
+    /**
+     * @brief Fences the current region once every draw that reads it has been issued.
+     */
+    void endFrame();
+
+    /**
+     * @brief Returns the buffer object the offsets of write refer to.
+     */
+    GLuint getBuffer() const { return buffer; }
+
+    /**
+     * @brief Returns a number that changes at every beginFrame.
+     */
+    unsigned int getFrameNumber() const { return frameNumber; }
+
+    /**
+     * @brief Returns true when the buffer is persistently mapped.
+     */
+    bool isPersistent() const { return mapped != nullptr; }
+
+    /**
+     * @brief Prints the mapping mode and how often frames waited, orphaned or overflowed.
+     */
+    void printStats() const;
+
+    /**
+     * @brief Unmaps and releases the buffer, once its fences have signaled.
+     */
+    void destroy();
+
+private:
+    typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    GLuint buffer = 0;
+    GLsizeiptr regionSize = 0;
+    GLsizeiptr uniformAlignment = 256;          // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    BufferStorageProc bufferStorage = nullptr;  // Null without GL 4.4 or ARB_buffer_storage
+    unsigned char* mapped = nullptr;            // Start of the persistent mapping
+    GLsync fences[FRAME_COUNT] = {};            // Signaled once the GPU is done with each region
+    int region = -1;                            // Region written this frame, -1 before the first frame
+    GLintptr head = 0;                          // Next free byte of the region, from its start
+    bool overflowed = false;                    // A write did not fit this frame
+    unsigned int frameNumber = 0;
+
+    // Since create
+    size_t waitCount = 0;                       // Frames that waited for their region's fence
+    size_t orphanCount = 0;                     // Frames that orphaned the buffer instead
+    size_t overflowCount = 0;                   // Writes that did not fit their region
+
+    /**
+     * @brief Creates the buffer storage for the current region size and maps it when persistent.
+     */
+    void allocate();
+
+    /**
+     * @brief Waits for every region's fence and deletes the fences.
+     */
+    void waitForAll();
+};
+#endif // STREAMBUFFER_H
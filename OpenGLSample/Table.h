@@ -27,17 +27,15 @@ public:
     /**
      * @brief Constructor for the Table class.
      *
-     * This constructor initializes the Table object with the given initial position, transform data, mesh, texture, shader, and camera.
+     * This constructor initializes the Table object with the given initial position, transform data, resources, and camera.
      *
      * @param initialPos The initial position of the table as a glm::vec3.
      * @param transformData The transformation data for the table.
-     * @param mesh The mesh data for the table.
-     * @param texture The texture data for the table.
-     * @param shader The shader program used for rendering the table.
+     * @param resources The shared mesh, texture and shader tables.
      * @param inputCamera A reference to the camera object.
      */
-    Table(glm::vec3 initialPos, Transform transformData, MeshCreator mesh, Textures texture, Shader shader, Camera& inputCamera)
-        : Item(initialPos, mesh, texture, shader, inputCamera), transformData(transformData) {}
+    Table(glm::vec3 initialPos, Transform transformData, const ResourceRegistry& resources, Camera& inputCamera)
+        : Item(initialPos, resources, inputCamera), transformData(transformData) {}
 
     /**
      * @brief Renders the Table object.
@@ -0,0 +1,250 @@
+/**
+ * @file TextureArray.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the TextureArray class.
+ */
+
+#include "TextureArray.h"
+#include <algorithm>
+#include <cmath>
+
+const GLsizei TextureArray::LAYER_SIZE;
+const GLsizei TextureArray::INITIAL_CAPACITY;
+const GLuint TextureArray::TEXTURE_UNIT;
+const int TextureArray::MIRROR_DIFFUSE;
+const int TextureArray::MIRROR_SPECULAR;
+const int TextureArray::MIRROR_OVERLAY;
+
+namespace
+{
+    // What an unbound texture unit returns
+    const GLfloat BLACK[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    // The copy samples the source through unit 0, which the material textures are rebound to anyway
+    const GLuint SOURCE_UNIT = 0;
+}
+
+/**
+ * @brief Compiles the copy shader and creates the array with its black layer.
+ * @param stateCache The cache that filters redundant binds.
+ */
+TextureArray::TextureArray(GLStateCache& stateCache)
+    : copyShader("../OpenGLSample/shaderfiles/deferred_fullscreen.vs", "../OpenGLSample/shaderfiles/texture_array_copy.fs") {
+    glUseProgram(copyShader.ID);
+    copyShader.setInt("source", SOURCE_UNIT);
+    copyShader.setFloat("layerSize", static_cast<float>(LAYER_SIZE));
+    glUseProgram(0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glGenVertexArrays(1, &emptyVao);
+
+    sources.push_back(Source());
+    allocate(INITIAL_CAPACITY, stateCache);
+}
+
+/**
+ * @brief Returns the layers of a texture set, assigning layers to the textures seen for the first time.
+ * @param diffuseTexture The texture bound to GL_TEXTURE0, or 0.
+ * @param specularTexture The texture bound to GL_TEXTURE1, or 0.
+ * @param overlayTexture The texture bound to GL_TEXTURE2, or 0.
+ * @param stateCache The cache that filters redundant binds.
+ * @return The diffuse, specular and overlay layers, then the MIRROR_ bits of the mirrored ones.
+ */
+glm::ivec4 TextureArray::getLayers(GLuint diffuseTexture, GLuint specularTexture, GLuint overlayTexture, GLStateCache& stateCache) {
+    glm::ivec4 layers(getLayer(diffuseTexture, stateCache), getLayer(specularTexture, stateCache), getLayer(overlayTexture, stateCache), 0);
+    const int mirrorBits[3] = { MIRROR_DIFFUSE, MIRROR_SPECULAR, MIRROR_OVERLAY };
+    for (int i = 0; i < 3; i++) {
+        if (sources[layers[i]].mirrored) {
+            layers.w |= mirrorBits[i];
+        }
+    }
+    return layers;
+}
+
+/**
+ * @brief Copies the textures into the layers that are out of date and rebuilds the mipmaps.
+ *
+ * The texture loader re-specifies the textures in place, so the layers of the uploaded textures
+ * are copied again. The layers of the evicted textures are freed for the next new texture.
+ *
+ * @param uploads The textures the loader uploaded this frame.
+ * @param evicted The textures the resource manager evicted this frame.
+ * @param stateCache The cache that filters redundant binds.
+ */
+void TextureArray::update(const std::vector<TextureLoader::Upload>& uploads, const std::vector<GLuint>& evicted, GLStateCache& stateCache) {
+    for (const TextureLoader::Upload& upload : uploads) {
+        std::map<GLuint, int>::const_iterator found = layersByTexture.find(upload.texture);
+        if (found != layersByTexture.end()) {
+            sources[found->second].stale = true;
+        }
+    }
+    // Nothing samples a freed layer, so it is not cleared until it is reused
+    for (GLuint texture : evicted) {
+        std::map<GLuint, int>::iterator found = layersByTexture.find(texture);
+        if (found == layersByTexture.end()) {
+            continue;
+        }
+        sources[found->second] = Source();
+        sources[found->second].stale = false;
+        freeLayers.push_back(found->second);
+        layersByTexture.erase(found);
+    }
+
+    bool copied = false;
+    GLint viewport[4];
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (!sources[i].stale) {
+            continue;
+        }
+        if (!copied) {
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glViewport(0, 0, LAYER_SIZE, LAYER_SIZE);
+            glDisable(GL_DEPTH_TEST);
+            stateCache.useProgram(copyShader.ID);
+            stateCache.bindVertexArray(emptyVao);
+            copied = true;
+        }
+        copyLayer(static_cast<int>(i), stateCache);
+        sources[i].stale = false;
+    }
+    if (!copied) {
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glEnable(GL_DEPTH_TEST);
+    stateCache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, array);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
+
+/**
+ * @brief Binds the array to TEXTURE_UNIT.
+ */
+void TextureArray::bind(GLStateCache& stateCache) const {
+    stateCache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, array);
+}
+
+/**
+ * @brief Returns the GPU memory of the array, every allocated layer and mipmap included.
+ */
+size_t TextureArray::getBytes() const {
+    size_t layerBytes = 0;
+    for (GLsizei size = LAYER_SIZE; size > 0; size /= 2) {
+        layerBytes += static_cast<size_t>(size) * size * 4;
+    }
+    return layerBytes * capacity;
+}
+
+/**
+ * @brief Releases the array, the framebuffer and the copy shader.
+ */
+void TextureArray::destroy() {
+    glDeleteTextures(1, &array);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteVertexArrays(1, &emptyVao);
+    glDeleteProgram(copyShader.ID);
+    array = 0;
+    framebuffer = 0;
+    emptyVao = 0;
+    sources.clear();
+    freeLayers.clear();
+    layersByTexture.clear();
+}
+
+/**
+ * @brief Returns the layer of a texture, assigning the next one the first time it is seen.
+ */
+int TextureArray::getLayer(GLuint texture, GLStateCache& stateCache) {
+    if (texture == 0) {
+        return 0;
+    }
+    std::map<GLuint, int>::const_iterator found = layersByTexture.find(texture);
+    if (found != layersByTexture.end()) {
+        return found->second;
+    }
+
+    if (freeLayers.empty() && static_cast<GLsizei>(sources.size()) == capacity) {
+        allocate(capacity * 2, stateCache);
+    }
+
+    Source source;
+    source.texture = texture;
+    GLint wrapMode = GL_REPEAT;
+    stateCache.bindTexture(SOURCE_UNIT, GL_TEXTURE_2D, texture);
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, &wrapMode);
+    source.mirrored = wrapMode == GL_MIRRORED_REPEAT;
+
+    int layer = static_cast<int>(sources.size());
+    if (freeLayers.empty()) {
+        sources.push_back(source);
+    }
+    else {
+        layer = freeLayers.back();
+        freeLayers.pop_back();
+        sources[layer] = source;
+    }
+    layersByTexture[texture] = layer;
+    return layer;
+}
+
+/**
+ * @brief Allocates the array with room for the given number of layers; every layer must be copied again.
+ */
+void TextureArray::allocate(GLsizei layerCount, GLStateCache& stateCache) {
+    // The new array may get the deleted name back, which the cache would take as still bound
+    if (array != 0) {
+        stateCache.forgetTexture(array);
+        glDeleteTextures(1, &array);
+    }
+    capacity = layerCount;
+
+    // Every level is specified up front, so the array is complete before its first mipmaps are generated
+    glGenTextures(1, &array);
+    stateCache.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, array);
+    GLint level = 0;
+    for (GLsizei size = LAYER_SIZE; size > 0; size /= 2, level++) {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, size, size, capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, level - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    for (Source& source : sources) {
+        source.stale = true;
+    }
+}
+
+/**
+ * @brief Resamples a texture into one layer of the bound framebuffer's array.
+ */
+void TextureArray::copyLayer(int layer, GLStateCache& stateCache) {
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array, 0, layer);
+    const Source& source = sources[layer];
+    if (source.texture == 0) {
+        glClearBufferfv(GL_COLOR, 0, BLACK);
+        return;
+    }
+
+    stateCache.bindTexture(SOURCE_UNIT, GL_TEXTURE_2D, source.texture);
+    GLint width = 1;
+    GLint height = 1;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+
+    // Larger textures are read from the mip nearest the layer's size, so no texel is skipped
+    float lod = std::log2(static_cast<float>(std::max(width, height)) / LAYER_SIZE);
+    GLint minFilter = GL_LINEAR;
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &minFilter);
+    if (lod > 0.0f) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+    copyShader.setFloat("lod", std::max(lod, 0.0f));
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+}
@@ -0,0 +1,129 @@
+/**
+ * @file TextureArray.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the TextureArray class, which gathers the material textures
+ * into the layers of one GL_TEXTURE_2D_ARRAY so that draws with different textures can share a draw call.
+ */
+
+#ifndef TEXTUREARRAY_H
+#define TEXTUREARRAY_H
+
+#include <map>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "GLStateCache.h"
+#include "TextureLoader.h"
+
+/**
+ * @class TextureArray
+ * @brief Copies of the material textures, one per layer of a 2D array texture.
+ *
+ * Every texture is resampled into a LAYER_SIZE square layer on the GPU, so the textures keep their own
+ * size and format, cooked or not. A layer is copied again when the TextureLoader replaces its texture's
+ * placeholder, and given to the next new texture once the ResourceManager evicts its own. Layer 0 is opaque black, which is what an unbound texture unit returns, so a draw
+ * without a specular or overlay texture reads the same values from the array as it did without one.
+ *
+ * The array has a single sampler state, so the layers of textures that mirror their coordinates are
+ * flagged and mirrored by the fragment shader.
+ */
+class TextureArray
+{
+public:
+    static const GLsizei LAYER_SIZE = 1024;
+    static const GLsizei INITIAL_CAPACITY = 8;
+
+    // Texture unit of the array, after the shadow maps
+    static const GLuint TEXTURE_UNIT = 13;
+
+    // Bit of TextureLayers.w set for each material slot that mirrors its coordinates
+    static const int MIRROR_DIFFUSE = 1;
+    static const int MIRROR_SPECULAR = 2;
+    static const int MIRROR_OVERLAY = 4;
+
+    /**
+     * @brief Compiles the copy shader and creates the array with its black layer.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    explicit TextureArray(GLStateCache& stateCache);
+
+    /**
+     * @brief Returns the layers of a texture set, assigning layers to the textures seen for the first time.
+     * @param diffuseTexture The texture bound to GL_TEXTURE0, or 0.
+     * @param specularTexture The texture bound to GL_TEXTURE1, or 0.
+     * @param overlayTexture The texture bound to GL_TEXTURE2, or 0.
+     * @param stateCache The cache that filters redundant binds.
+     * @return The diffuse, specular and overlay layers, then the MIRROR_ bits of the mirrored ones.
+     */
+    glm::ivec4 getLayers(GLuint diffuseTexture, GLuint specularTexture, GLuint overlayTexture, GLStateCache& stateCache);
+
+    /**
+     * @brief Copies the textures into the layers that are out of date and rebuilds the mipmaps.
+     *
+     * The texture loader re-specifies the textures in place, so the layers of the uploaded textures
+     * are copied again. The layers of the evicted textures are freed for the next new texture.
+     *
+     * @param uploads The textures the loader uploaded this frame.
+     * @param evicted The textures the resource manager evicted this frame.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    void update(const std::vector<TextureLoader::Upload>& uploads, const std::vector<GLuint>& evicted, GLStateCache& stateCache);
+
+    /**
+     * @brief Binds the array to TEXTURE_UNIT.
+     */
+    void bind(GLStateCache& stateCache) const;
+
+    /**
+     * @brief Returns the number of layers in use, including the black layer.
+     */
+    size_t getLayerCount() const { return sources.size() - freeLayers.size(); }
+
+    /**
+     * @brief Returns the GPU memory of the array, every allocated layer and mipmap included.
+     */
+    size_t getBytes() const;
+
+    /**
+     * @brief Releases the array, the framebuffer and the copy shader.
+     */
+    void destroy();
+
+private:
+    // A texture copied into one layer
+    struct Source
+    {
+        GLuint texture = 0;
+        bool mirrored = false;
+        bool stale = true;
+    };
+
+    Shader copyShader;
+    GLuint array = 0;
+    GLuint framebuffer = 0;
+    GLuint emptyVao = 0;
+    GLsizei capacity = 0;
+    std::vector<Source> sources;            // One per layer; layer 0 is the black layer
+    std::vector<int> freeLayers;            // Layers of evicted textures, reused before new ones
+    std::map<GLuint, int> layersByTexture;
+
+    /**
+     * @brief Returns the layer of a texture, assigning the next one the first time it is seen.
+     */
+    int getLayer(GLuint texture, GLStateCache& stateCache);
+
+    /**
+     * @brief Allocates the array with room for the given number of layers; every layer must be copied again.
+     */
+    void allocate(GLsizei layerCount, GLStateCache& stateCache);
+
+    /**
+     * @brief Resamples a texture into one layer of the bound framebuffer's array.
+     */
+    void copyLayer(int layer, GLStateCache& stateCache);
+};
+#endif // TEXTUREARRAY_H
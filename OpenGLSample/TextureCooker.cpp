@@ -0,0 +1,416 @@
+/**
+ * @file TextureCooker.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the TextureCooker class.
+ */
+
+#include "TextureCooker.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    // DDS header fields, from the DirectX documentation of DDS_HEADER and DDS_PIXELFORMAT
+    const uint32_t DDS_MAGIC = 0x20534444;           // "DDS "
+    const uint32_t DDS_HEADER_SIZE = 124;
+    const uint32_t DDS_PIXELFORMAT_SIZE = 32;
+    const uint32_t DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000;
+    const uint32_t DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+    const uint32_t FOURCC_DXT1 = 0x31545844;         // "DXT1"
+    const uint32_t FOURCC_DXT5 = 0x35545844;         // "DXT5"
+
+    // Positions of the fields in the header, in 32-bit words after the magic
+    enum HeaderField
+    {
+        FIELD_SIZE = 0, FIELD_FLAGS = 1, FIELD_HEIGHT = 2, FIELD_WIDTH = 3, FIELD_LINEAR_SIZE = 4,
+        FIELD_MIP_COUNT = 6, FIELD_PF_SIZE = 18, FIELD_PF_FLAGS = 19, FIELD_PF_FOURCC = 20, FIELD_CAPS = 26,
+        HEADER_WORDS = 31
+    };
+
+    const int BLOCK_DIM = 4;
+    const int BLOCK_TEXELS = BLOCK_DIM * BLOCK_DIM;
+
+    // An uncompressed RGBA8 mip level
+    struct Rgba
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<unsigned char> texels;
+    };
+
+    /**
+     * @brief Returns the size of one level in bytes.
+     */
+    size_t getLevelSize(int width, int height, size_t blockSize)
+    {
+        size_t blocksX = std::max(1, (width + BLOCK_DIM - 1) / BLOCK_DIM);
+        size_t blocksY = std::max(1, (height + BLOCK_DIM - 1) / BLOCK_DIM);
+        return blocksX * blocksY * blockSize;
+    }
+
+    /**
+     * @brief Averages 2x2 texels of a level into the next smaller level.
+     */
+    Rgba downsample(const Rgba& source)
+    {
+        Rgba level;
+        level.width = std::max(1, source.width / 2);
+        level.height = std::max(1, source.height / 2);
+        level.texels.resize(static_cast<size_t>(level.width) * level.height * 4);
+        for (int y = 0; y < level.height; y++) {
+            int y0 = std::min(y * 2, source.height - 1);
+            int y1 = std::min(y * 2 + 1, source.height - 1);
+            for (int x = 0; x < level.width; x++) {
+                int x0 = std::min(x * 2, source.width - 1);
+                int x1 = std::min(x * 2 + 1, source.width - 1);
+                for (int c = 0; c < 4; c++) {
+                    int sum = source.texels[(static_cast<size_t>(y0) * source.width + x0) * 4 + c]
+                        + source.texels[(static_cast<size_t>(y0) * source.width + x1) * 4 + c]
+                        + source.texels[(static_cast<size_t>(y1) * source.width + x0) * 4 + c]
+                        + source.texels[(static_cast<size_t>(y1) * source.width + x1) * 4 + c];
+                    level.texels[(static_cast<size_t>(y) * level.width + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+        return level;
+    }
+
+    /**
+     * @brief Packs a color into 5:6:5 bits.
+     */
+    uint16_t pack565(const int color[3])
+    {
+        return static_cast<uint16_t>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+    }
+
+    /**
+     * @brief Expands a 5:6:5 color to 8 bits per channel, as the hardware decodes it.
+     */
+    void unpack565(uint16_t packed, int color[3])
+    {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    /**
+     * @brief Compresses the colors of a block into 8 bytes of BC1.
+     *
+     * The endpoints span the block's bounding box, inset by a sixteenth of it to reduce the error
+     * of the texels in between. The block is always encoded in its four-color mode.
+     */
+    void encodeColorBlock(const unsigned char block[BLOCK_TEXELS][4], unsigned char* out)
+    {
+        int minColor[3] = { 255, 255, 255 };
+        int maxColor[3] = { 0, 0, 0 };
+        for (int i = 0; i < BLOCK_TEXELS; i++) {
+            for (int c = 0; c < 3; c++) {
+                minColor[c] = std::min(minColor[c], static_cast<int>(block[i][c]));
+                maxColor[c] = std::max(maxColor[c], static_cast<int>(block[i][c]));
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            int inset = (maxColor[c] - minColor[c]) / 16;
+            minColor[c] += inset;
+            maxColor[c] -= inset;
+        }
+
+        // The larger endpoint comes first, which selects the four-color mode
+        uint16_t color0 = pack565(maxColor);
+        uint16_t color1 = pack565(minColor);
+        uint32_t indices = 0;
+        if (color0 != color1) {
+            int palette[4][3];
+            unpack565(color0, palette[0]);
+            unpack565(color1, palette[1]);
+            for (int c = 0; c < 3; c++) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            for (int i = 0; i < BLOCK_TEXELS; i++) {
+                int best = 0;
+                int bestDistance = 0x7FFFFFFF;
+                for (int p = 0; p < 4; p++) {
+                    int distance = 0;
+                    for (int c = 0; c < 3; c++) {
+                        int delta = block[i][c] - palette[p][c];
+                        distance += delta * delta;
+                    }
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= static_cast<uint32_t>(best) << (2 * i);
+            }
+        }
+
+        out[0] = static_cast<unsigned char>(color0 & 0xFF);
+        out[1] = static_cast<unsigned char>(color0 >> 8);
+        out[2] = static_cast<unsigned char>(color1 & 0xFF);
+        out[3] = static_cast<unsigned char>(color1 >> 8);
+        for (int b = 0; b < 4; b++) {
+            out[4 + b] = static_cast<unsigned char>((indices >> (8 * b)) & 0xFF);
+        }
+    }
+
+    /**
+     * @brief Compresses the alpha of a block into the 8 bytes that precede the colors in BC3.
+     */
+    void encodeAlphaBlock(const unsigned char block[BLOCK_TEXELS][4], unsigned char* out)
+    {
+        int minAlpha = 255, maxAlpha = 0;
+        for (int i = 0; i < BLOCK_TEXELS; i++) {
+            minAlpha = std::min(minAlpha, static_cast<int>(block[i][3]));
+            maxAlpha = std::max(maxAlpha, static_cast<int>(block[i][3]));
+        }
+
+        // The larger endpoint comes first, which selects eight interpolated values
+        uint64_t indices = 0;
+        if (maxAlpha != minAlpha) {
+            int palette[8];
+            palette[0] = maxAlpha;
+            palette[1] = minAlpha;
+            for (int p = 2; p < 8; p++) {
+                palette[p] = ((8 - p) * maxAlpha + (p - 1) * minAlpha) / 7;
+            }
+            for (int i = 0; i < BLOCK_TEXELS; i++) {
+                int best = 0;
+                int bestDistance = 256;
+                for (int p = 0; p < 8; p++) {
+                    int distance = std::abs(block[i][3] - palette[p]);
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= static_cast<uint64_t>(best) << (3 * i);
+            }
+        }
+
+        out[0] = static_cast<unsigned char>(maxAlpha);
+        out[1] = static_cast<unsigned char>(minAlpha);
+        for (int b = 0; b < 6; b++) {
+            out[2 + b] = static_cast<unsigned char>((indices >> (8 * b)) & 0xFF);
+        }
+    }
+
+    /**
+     * @brief Compresses a level into BC1 or BC3 blocks, appended to the output.
+     *
+     * Blocks that reach past the edge of a level repeat its last row and column.
+     */
+    void compressLevel(const Rgba& level, bool withAlpha, std::vector<unsigned char>& output)
+    {
+        size_t blockSize = withAlpha ? 16 : 8;
+        int blocksX = std::max(1, (level.width + BLOCK_DIM - 1) / BLOCK_DIM);
+        int blocksY = std::max(1, (level.height + BLOCK_DIM - 1) / BLOCK_DIM);
+        size_t start = output.size();
+        output.resize(start + static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+        unsigned char block[BLOCK_TEXELS][4];
+        unsigned char* out = output.data() + start;
+        for (int by = 0; by < blocksY; by++) {
+            for (int bx = 0; bx < blocksX; bx++) {
+                for (int i = 0; i < BLOCK_TEXELS; i++) {
+                    int x = std::min(bx * BLOCK_DIM + i % BLOCK_DIM, level.width - 1);
+                    int y = std::min(by * BLOCK_DIM + i / BLOCK_DIM, level.height - 1);
+                    std::memcpy(block[i], &level.texels[(static_cast<size_t>(y) * level.width + x) * 4], 4);
+                }
+                if (withAlpha) {
+                    encodeAlphaBlock(block, out);
+                    encodeColorBlock(block, out + 8);
+                }
+                else {
+                    encodeColorBlock(block, out);
+                }
+                out += blockSize;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Creates a cooker that compresses on the job system.
+ * @param jobs The job system that runs one job per file.
+ */
+TextureCooker::TextureCooker(JobSystem& jobs)
+    : jobs(jobs), failures(0)
+{
+}
+
+/**
+ * @brief Starts cooking an image file.
+ * @param path The file path to the source image.
+ * @param flip Flips the image vertically when true, as for the textures of the scene objects.
+ */
+void TextureCooker::cook(const std::string& path, bool flip)
+{
+    jobs.submit([this, path, flip]() {
+        if (!cookFile(path, flip)) {
+            failures.fetch_add(1, std::memory_order_relaxed);
+        }
+    }, cooking);
+}
+
+/**
+ * @brief Waits for every cook job and reports the files that failed.
+ * @return The number of files that could not be cooked.
+ */
+int TextureCooker::finish()
+{
+    jobs.wait(cooking);
+    return failures.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the path of the cooked file of a source image.
+ * @param path The file path to the source image.
+ */
+std::string TextureCooker::getCookedPath(const std::string& path)
+{
+    size_t extension = path.find_last_of('.');
+    size_t directory = path.find_last_of("/\\");
+    if (extension == std::string::npos || (directory != std::string::npos && extension < directory)) {
+        return path + ".dds";
+    }
+    return path.substr(0, extension) + ".dds";
+}
+
+/**
+ * @brief Reads a cooked file.
+ * @param path The file path to the cooked file.
+ * @param image Receives the compressed image.
+ * @return False when the file is missing or is not a DDS file this cooker writes.
+ */
+bool TextureCooker::readCooked(const std::string& path, CompressedImage& image)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::streamoff fileSize = file.tellg();
+    const std::streamoff headerBytes = sizeof(uint32_t) * (HEADER_WORDS + 1);
+    if (fileSize < headerBytes) {
+        return false;
+    }
+    file.seekg(0);
+
+    uint32_t magic;
+    uint32_t header[HEADER_WORDS];
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file || magic != DDS_MAGIC || header[FIELD_SIZE] != DDS_HEADER_SIZE || !(header[FIELD_PF_FLAGS] & DDPF_FOURCC)) {
+        return false;
+    }
+
+    size_t blockSize;
+    if (header[FIELD_PF_FOURCC] == FOURCC_DXT1) {
+        image.format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        blockSize = 8;
+    }
+    else if (header[FIELD_PF_FOURCC] == FOURCC_DXT5) {
+        image.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        blockSize = 16;
+    }
+    else {
+        return false;
+    }
+
+    int width = static_cast<int>(header[FIELD_WIDTH]);
+    int height = static_cast<int>(header[FIELD_HEIGHT]);
+    uint32_t levelCount = (header[FIELD_FLAGS] & DDSD_MIPMAPCOUNT) ? std::max(1u, header[FIELD_MIP_COUNT]) : 1u;
+    image.levels.clear();
+    size_t offset = 0;
+    for (uint32_t l = 0; l < levelCount; l++) {
+        CompressedImage::Level level;
+        level.width = std::max(1, width >> l);
+        level.height = std::max(1, height >> l);
+        level.offset = offset;
+        level.size = getLevelSize(level.width, level.height, blockSize);
+        offset += level.size;
+        image.levels.push_back(level);
+    }
+    if (static_cast<std::streamoff>(offset) > fileSize - headerBytes) {
+        return false;
+    }
+
+    image.data.resize(offset);
+    file.read(reinterpret_cast<char*>(image.data.data()), static_cast<std::streamsize>(offset));
+    return static_cast<bool>(file);
+}
+
+/**
+ * @brief Loads, mips, compresses and writes one file.
+ * @return True when the cooked file was written.
+ */
+bool TextureCooker::cookFile(const std::string& path, bool flip)
+{
+    Rgba level;
+    int channels;
+    unsigned char* data = stbi_load(path.c_str(), &level.width, &level.height, &channels, 4);
+    if (data == nullptr) {
+        std::cout << "ERROR::TEXTURECOOKER::FAILED_TO_LOAD " << path << std::endl;
+        return false;
+    }
+    size_t rowSize = static_cast<size_t>(level.width) * 4;
+    level.texels.resize(rowSize * level.height);
+    for (int y = 0; y < level.height; y++) {
+        int sourceRow = flip ? level.height - 1 - y : y;
+        std::memcpy(&level.texels[y * rowSize], data + sourceRow * rowSize, rowSize);
+    }
+    stbi_image_free(data);
+
+    bool withAlpha = false;
+    for (size_t i = 3; i < level.texels.size(); i += 4) {
+        if (level.texels[i] != 255) {
+            withAlpha = true;
+            break;
+        }
+    }
+
+    // Compress every level down to 1x1
+    std::vector<unsigned char> blocks;
+    uint32_t levelCount = 1;
+    int width = level.width;
+    int height = level.height;
+    compressLevel(level, withAlpha, blocks);
+    while (level.width > 1 || level.height > 1) {
+        level = downsample(level);
+        compressLevel(level, withAlpha, blocks);
+        levelCount++;
+    }
+
+    uint32_t header[HEADER_WORDS] = {};
+    header[FIELD_SIZE] = DDS_HEADER_SIZE;
+    header[FIELD_FLAGS] = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header[FIELD_HEIGHT] = static_cast<uint32_t>(height);
+    header[FIELD_WIDTH] = static_cast<uint32_t>(width);
+    header[FIELD_LINEAR_SIZE] = static_cast<uint32_t>(getLevelSize(width, height, withAlpha ? 16 : 8));
+    header[FIELD_MIP_COUNT] = levelCount;
+    header[FIELD_PF_SIZE] = DDS_PIXELFORMAT_SIZE;
+    header[FIELD_PF_FLAGS] = DDPF_FOURCC;
+    header[FIELD_PF_FOURCC] = withAlpha ? FOURCC_DXT5 : FOURCC_DXT1;
+    header[FIELD_CAPS] = DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+    std::string cookedPath = getCookedPath(path);
+    std::ofstream file(cookedPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cout << "ERROR::TEXTURECOOKER::FAILED_TO_WRITE " << cookedPath << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(blocks.data()), static_cast<std::streamsize>(blocks.size()));
+    return static_cast<bool>(file);
+}
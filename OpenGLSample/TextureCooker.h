@@ -0,0 +1,105 @@
+/**
+ * @file TextureCooker.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the TextureCooker class, which converts the image files of the
+ * scene offline into block-compressed DDS files with their mip chains, and reads those files back at runtime.
+ */
+
+#ifndef TEXTURECOOKER_H
+#define TEXTURECOOKER_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+#include "JobSystem.h"
+
+// S3TC is an extension on every desktop driver rather than core OpenGL
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+/**
+ * @struct CompressedImage
+ * @brief A block-compressed image and its mip chain, as read from a cooked file.
+ */
+struct CompressedImage
+{
+    struct Level
+    {
+        int width = 0;
+        int height = 0;
+        size_t offset = 0;  // Offset of the level in data
+        size_t size = 0;
+    };
+
+    GLenum format = 0;      // GL_COMPRESSED_RGB_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    std::vector<Level> levels;
+    std::vector<unsigned char> data;
+};
+
+/**
+ * @class TextureCooker
+ * @brief Cooks image files into DDS files of BC1 or BC3 blocks with a full mip chain.
+ *
+ * Opaque images are cooked to BC1 and images with any translucent texel to BC3. The mips are
+ * box-filtered from the full image before it is compressed, so the runtime neither decodes a JPEG or
+ * PNG nor generates mipmaps. A cooked file sits next to its source with a .dds extension.
+ *
+ * Rows are stored in the order the runtime uploads them: textures are flipped to OpenGL's bottom-up
+ * rows when cooked, cubemap faces are not.
+ */
+class TextureCooker
+{
+public:
+    /**
+     * @brief Creates a cooker that compresses on the job system.
+     * @param jobs The job system that runs one job per file.
+     */
+    explicit TextureCooker(JobSystem& jobs);
+
+    /**
+     * @brief Starts cooking an image file.
+     * @param path The file path to the source image.
+     * @param flip Flips the image vertically when true, as for the textures of the scene objects.
+     */
+    void cook(const std::string& path, bool flip);
+
+    /**
+     * @brief Waits for every cook job and reports the files that failed.
+     * @return The number of files that could not be cooked.
+     */
+    int finish();
+
+    /**
+     * @brief Returns the path of the cooked file of a source image.
+     * @param path The file path to the source image.
+     */
+    static std::string getCookedPath(const std::string& path);
+
+    /**
+     * @brief Reads a cooked file.
+     * @param path The file path to the cooked file.
+     * @param image Receives the compressed image.
+     * @return False when the file is missing or is not a DDS file this cooker writes.
+     */
+    static bool readCooked(const std::string& path, CompressedImage& image);
+
+private:
+    JobSystem& jobs;
+    JobCounter cooking;
+    std::atomic<int> failures;
+
+    /**
+     * @brief Loads, mips, compresses and writes one file.
+     * @return True when the cooked file was written.
+     */
+    static bool cookFile(const std::string& path, bool flip);
+};
+#endif // TEXTURECOOKER_H
@@ -0,0 +1,386 @@
+/**
+ * @file TextureLoader.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the TextureLoader class.
+ */
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "TextureLoader.h"
+#include <cstring>
+#include <iostream>
+
+const size_t TextureLoader::UPLOAD_BUDGET_BYTES;
+
+namespace
+{
+    // Mid grey, so untextured objects are visible but clearly not final
+    const unsigned char PLACEHOLDER_TEXEL[4] = { 128, 128, 128, 255 };
+    const int CUBE_FACE_COUNT = 6;
+    // More levels than a 16384 texel texture has
+    const GLint MAX_MIP_LEVELS = 16;
+
+    /**
+     * @brief Returns the pixel format of an image with the given number of channels.
+     */
+    GLenum getFormat(int channels)
+    {
+        if (channels == 1)
+            return GL_RED;
+        if (channels == 3)
+            return GL_RGB;
+        return GL_RGBA;
+    }
+}
+
+/**
+ * @brief Creates the loader.
+ * @param jobs The job system that decodes the image files.
+ * @param stateCache The cache that filters redundant binds.
+ */
+TextureLoader::TextureLoader(JobSystem& jobs, GLStateCache& stateCache)
+    : jobs(jobs), stateCache(stateCache)
+{
+    glGenBuffers(1, &unpackBuffer);
+    useCooked = isS3tcSupported();
+}
+
+/**
+ * @brief Creates a texture showing the placeholder and starts decoding its image file.
+ * @param path The file path to the texture image.
+ * @param wrapMode The wrapping mode for the texture (e.g., GL_REPEAT, GL_CLAMP_TO_EDGE).
+ * @return The ID of the generated texture.
+ */
+GLuint TextureLoader::loadTexture(const char* path, GLint wrapMode)
+{
+    GLuint texture = createTexture(wrapMode);
+    streamTexture(texture, path);
+    return texture;
+}
+
+/**
+ * @brief Creates a texture showing the placeholder without reading any file.
+ * @param wrapMode The wrapping mode for the texture (e.g., GL_REPEAT, GL_CLAMP_TO_EDGE).
+ * @return The ID of the generated texture.
+ */
+GLuint TextureLoader::createTexture(GLint wrapMode)
+{
+    GLuint texture = createPlaceholder(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return texture;
+}
+
+/**
+ * @brief Starts decoding an image file into a texture made by createTexture.
+ * @param texture The texture that receives the image; it keeps its current contents until then.
+ * @param path The file path to the texture image.
+ */
+void TextureLoader::streamTexture(GLuint texture, const char* path)
+{
+    std::unique_ptr<Request> request(new Request());
+    request->target = GL_TEXTURE_2D;
+    request->texture = texture;
+    request->images.resize(1);
+    request->images[0].path = path;
+    submit(std::move(request));
+}
+
+/**
+ * @brief Puts the placeholder back into an uploaded texture and releases its mipmaps.
+ *
+ * The texture keeps its name and parameters, so it can be streamed in again later.
+ *
+ * @param texture A texture with no request still pending.
+ */
+void TextureLoader::unloadTexture(GLuint texture)
+{
+    stateCache.bindTexture(0, GL_TEXTURE_2D, texture);
+    // An empty image frees the storage of its level
+    for (GLint level = 1; level < MAX_MIP_LEVELS; level++) {
+        GLint width = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+        if (width == 0) {
+            break;
+        }
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_TEXEL);
+    // Cooked uploads limit the levels to their chain; 1000 is the GL default
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+    revision++;
+}
+
+/**
+ * @brief Creates a cubemap showing the placeholder and starts decoding its six faces.
+ *
+ * The faces are uploaded together once all of them are decoded, so the cubemap is never incomplete.
+ *
+ * @param faces The image files of the +X, -X, +Y, -Y, +Z and -Z faces.
+ * @return The ID of the generated cubemap texture.
+ */
+GLuint TextureLoader::loadCubeMap(const std::vector<std::string>& faces)
+{
+    std::unique_ptr<Request> request(new Request());
+    request->target = GL_TEXTURE_CUBE_MAP;
+    request->texture = createPlaceholder(GL_TEXTURE_CUBE_MAP);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    request->images.resize(faces.size());
+    for (size_t i = 0; i < faces.size(); i++) {
+        request->images[i].path = faces[i];
+    }
+
+    GLuint texture = request->texture;
+    submit(std::move(request));
+    return texture;
+}
+
+/**
+ * @brief Uploads the decoded textures, in the order they were requested, up to the frame's budget.
+ */
+void TextureLoader::update()
+{
+    uploads.clear();
+    size_t uploadedBytes = 0;
+    size_t next = 0;
+    while (next < requests.size()) {
+        Request& request = *requests[next];
+        if (!request.decoded.isDone()) {
+            next++;
+            continue;
+        }
+        size_t bytes = getByteCount(request);
+        if (uploadedBytes > 0 && uploadedBytes + bytes > UPLOAD_BUDGET_BYTES) {
+            break;
+        }
+        upload(request);
+        Upload uploaded = { request.texture, getResidentBytes(request) };
+        uploads.push_back(uploaded);
+        revision++;
+        uploadedBytes += bytes;
+        requests.erase(requests.begin() + next);
+    }
+}
+
+/**
+ * @brief Waits for the decode jobs and releases the unpack buffer.
+ *
+ * Textures that were not uploaded yet keep their placeholder; their owner still deletes them.
+ */
+void TextureLoader::destroy()
+{
+    for (std::unique_ptr<Request>& request : requests) {
+        jobs.wait(request->decoded);
+    }
+    requests.clear();
+    if (unpackBuffer != 0) {
+        glDeleteBuffers(1, &unpackBuffer);
+        unpackBuffer = 0;
+    }
+}
+
+/**
+ * @brief Creates a texture of the given target filled with the placeholder.
+ */
+GLuint TextureLoader::createPlaceholder(GLenum target)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    stateCache.bindTexture(0, target, texture);
+    if (target == GL_TEXTURE_CUBE_MAP) {
+        for (int i = 0; i < CUBE_FACE_COUNT; i++) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_TEXEL);
+        }
+    }
+    else {
+        glTexImage2D(target, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_TEXEL);
+    }
+    return texture;
+}
+
+/**
+ * @brief Queues a request and submits one background decode job per image.
+ *
+ * Decoding runs in the background queue, so a frame's wait for its own jobs never runs a decode.
+ */
+void TextureLoader::submit(std::unique_ptr<Request> request)
+{
+    // Textures are flipped to OpenGL's bottom-up rows; cubemap faces are addressed top-down
+    bool flip = request->target == GL_TEXTURE_2D;
+    bool cooked = useCooked;
+    for (Image& image : request->images) {
+        Image* decoded = &image;
+        jobs.submitBackground([decoded, flip, cooked]() { decode(*decoded, flip, cooked); }, request->decoded);
+    }
+    requests.push_back(std::move(request));
+}
+
+/**
+ * @brief Decodes an image file into an Image.
+ * @param image Receives the pixels; its path names the file.
+ * @param flip Flips the image vertically when true.
+ * @param useCooked Reads the image's cooked file instead, when it has one.
+ */
+void TextureLoader::decode(Image& image, bool flip, bool useCooked)
+{
+    // Cooked files are already flipped and mipmapped
+    if (useCooked && TextureCooker::readCooked(TextureCooker::getCookedPath(image.path), image.compressed)) {
+        image.width = image.compressed.levels[0].width;
+        image.height = image.compressed.levels[0].height;
+        return;
+    }
+    image.compressed.format = 0;
+
+    unsigned char* data = stbi_load(image.path.c_str(), &image.width, &image.height, &image.channels, 0);
+    if (data == nullptr) {
+        return;
+    }
+    if (flip) {
+        flipImageVertically(data, image.width, image.height, image.channels);
+    }
+    image.pixels.assign(data, data + static_cast<size_t>(image.width) * image.height * image.channels);
+    stbi_image_free(data);
+}
+
+/**
+ * @brief Uploads a request's images through the unpack buffer.
+ */
+void TextureLoader::upload(Request& request)
+{
+    stateCache.bindTexture(0, request.target, request.texture);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+    // Rows of RGB images are not padded to four bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    bool complete = true;
+    bool compressed = true;
+    for (size_t i = 0; i < request.images.size(); i++) {
+        const Image& image = request.images[i];
+        const std::vector<unsigned char>& bytes = image.compressed.format != 0 ? image.compressed.data : image.pixels;
+        if (bytes.empty()) {
+            std::cout << "Texture failed to load at path: " << image.path << std::endl;
+            complete = false;
+            continue;
+        }
+
+        // Orphan the previous upload's storage, so the driver never waits for it to be consumed
+        GLsizeiptr size = static_cast<GLsizeiptr>(bytes.size());
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped == nullptr) {
+            complete = false;
+            continue;
+        }
+        std::memcpy(mapped, bytes.data(), bytes.size());
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        GLenum target = request.target == GL_TEXTURE_CUBE_MAP ? GLenum(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i) : request.target;
+        if (image.compressed.format != 0) {
+            // Every level comes from the cooked file
+            for (size_t l = 0; l < image.compressed.levels.size(); l++) {
+                const CompressedImage::Level& level = image.compressed.levels[l];
+                glCompressedTexImage2D(target, static_cast<GLint>(l), image.compressed.format, level.width, level.height, 0,
+                    static_cast<GLsizei>(level.size), (void*)level.offset);
+            }
+            glTexParameteri(request.target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.compressed.levels.size()) - 1);
+        }
+        else {
+            GLenum format = getFormat(image.channels);
+            glTexImage2D(target, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, (void*)0);
+            compressed = false;
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (complete && !compressed && request.target == GL_TEXTURE_2D) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+}
+
+/**
+ * @brief Returns the number of bytes of a request's images.
+ */
+size_t TextureLoader::getByteCount(const Request& request)
+{
+    size_t bytes = 0;
+    for (const Image& image : request.images) {
+        bytes += image.pixels.size() + image.compressed.data.size();
+    }
+    return bytes;
+}
+
+/**
+ * @brief Returns the estimated GPU memory of a request's texture once uploaded, mipmaps included.
+ */
+size_t TextureLoader::getResidentBytes(const Request& request)
+{
+    size_t bytes = 0;
+    for (const Image& image : request.images) {
+        if (image.compressed.format != 0) {
+            // The cooked file holds every level
+            bytes += image.compressed.data.size();
+        }
+        else if (request.target == GL_TEXTURE_2D) {
+            // The generated mipmaps add a third
+            bytes += image.pixels.size() + image.pixels.size() / 3;
+        }
+        else {
+            bytes += image.pixels.size();
+        }
+    }
+    return bytes;
+}
+
+/**
+ * @brief Returns true when the driver exposes GL_EXT_texture_compression_s3tc.
+ */
+bool TextureLoader::isS3tcSupported()
+{
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension != nullptr && std::strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Flips an image vertically.
+ *
+ * This method flips an image vertically to match OpenGL's coordinate system, where the Y axis goes up.
+ *
+ * @param image A pointer to the image data.
+ * @param width The width of the image.
+ * @param height The height of the image.
+ * @param channels The number of color channels in the image.
+ */
+void TextureLoader::flipImageVertically(unsigned char* image, int width, int height, int channels)
+{
+    for (int j = 0; j < height / 2; ++j)
+    {
+        int index1 = j * width * channels;
+        int index2 = (height - 1 - j) * width * channels;
+
+        for (int i = width * channels; i > 0; --i)
+        {
+            unsigned char tmp = image[index1];
+            image[index1] = image[index2];
+            image[index2] = tmp;
+            ++index1;
+            ++index2;
+        }
+    }
+}
@@ -0,0 +1,206 @@
+/**
+ * @file TextureLoader.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the TextureLoader class, which decodes image files on the
+ * job system and streams them into textures while the scene is already being drawn.
+ */
+
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+#include "JobSystem.h"
+#include "GLStateCache.h"
+#include "TextureCooker.h"
+
+/**
+ * @class TextureLoader
+ * @brief Loads textures asynchronously, showing a placeholder until each one is ready.
+ *
+ * A request creates the texture right away and fills it with a 1x1 placeholder, so its handle can be
+ * given to the scene objects before any file is read. The image files are decoded by background jobs.
+ * Once a request's images are decoded, update copies them into a pixel unpack buffer and re-specifies
+ * the texture from it on the GL thread, a budgeted number of bytes per frame.
+ *
+ * When the driver supports S3TC and an image has a file cooked by TextureCooker, the cooked blocks and
+ * mips are read and uploaded as they are, instead of decoding the source image and generating its mipmaps.
+ *
+ * A texture can also be created without a file and streamed in or unloaded later, which is how
+ * ResourceManager keeps only the textures of the nearby scene resident.
+ */
+class TextureLoader
+{
+public:
+    // Bytes uploaded by one update; a frame uploads at least one texture whatever its size
+    static const size_t UPLOAD_BUDGET_BYTES = 8 * 1024 * 1024;
+
+    /**
+     * @brief Creates the loader.
+     * @param jobs The job system that decodes the image files.
+     * @param stateCache The cache that filters redundant binds.
+     */
+    TextureLoader(JobSystem& jobs, GLStateCache& stateCache);
+
+    // A texture uploaded by the last update
+    struct Upload
+    {
+        GLuint texture;
+        size_t bytes;   // Estimated GPU memory of the texture, mipmaps included
+    };
+
+    /**
+     * @brief Creates a texture showing the placeholder and starts decoding its image file.
+     * @param path The file path to the texture image.
+     * @param wrapMode The wrapping mode for the texture (e.g., GL_REPEAT, GL_CLAMP_TO_EDGE).
+     * @return The ID of the generated texture.
+     */
+    GLuint loadTexture(const char* path, GLint wrapMode);
+
+    /**
+     * @brief Creates a texture showing the placeholder without reading any file.
+     * @param wrapMode The wrapping mode for the texture (e.g., GL_REPEAT, GL_CLAMP_TO_EDGE).
+     * @return The ID of the generated texture.
+     */
+    GLuint createTexture(GLint wrapMode);
+
+    /**
+     * @brief Starts decoding an image file into a texture made by createTexture.
+     * @param texture The texture that receives the image; it keeps its current contents until then.
+     * @param path The file path to the texture image.
+     */
+    void streamTexture(GLuint texture, const char* path);
+
+    /**
+     * @brief Puts the placeholder back into an uploaded texture and releases its mipmaps.
+     *
+     * The texture keeps its name and parameters, so it can be streamed in again later.
+     *
+     * @param texture A texture with no request still pending.
+     */
+    void unloadTexture(GLuint texture);
+
+    /**
+     * @brief Creates a cubemap showing the placeholder and starts decoding its six faces.
+     *
+     * The faces are uploaded together once all of them are decoded, so the cubemap is never incomplete.
+     *
+     * @param faces The image files of the +X, -X, +Y, -Y, +Z and -Z faces.
+     * @return The ID of the generated cubemap texture.
+     */
+    GLuint loadCubeMap(const std::vector<std::string>& faces);
+
+    /**
+     * @brief Uploads the decoded textures, in the order they were requested, up to the frame's budget.
+     */
+    void update();
+
+    /**
+     * @brief Returns the number of textures that still show the placeholder.
+     */
+    size_t getPendingCount() const { return requests.size(); }
+
+    /**
+     * @brief Returns a number that changes whenever a texture's contents change, uploaded or unloaded.
+     */
+    unsigned int getRevision() const { return revision; }
+
+    /**
+     * @brief Returns the textures uploaded by the last update.
+     */
+    const std::vector<Upload>& getUploads() const { return uploads; }
+
+    /**
+     * @brief Waits for the decode jobs and releases the unpack buffer.
+     *
+     * Textures that were not uploaded yet keep their placeholder; their owner still deletes them.
+     */
+    void destroy();
+
+private:
+    // One decoded image file
+    struct Image
+    {
+        std::string path;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        std::vector<unsigned char> pixels; // Empty when the file failed to load or was cooked
+        CompressedImage compressed;        // The cooked file, when its format is not 0
+    };
+
+    // A texture waiting for its images
+    struct Request
+    {
+        GLuint texture = 0;
+        GLenum target = GL_TEXTURE_2D;
+        std::vector<Image> images;    // One image, or the six cubemap faces
+        JobCounter decoded;           // Done once every image is decoded
+    };
+
+    JobSystem& jobs;
+    GLStateCache& stateCache;
+    std::vector<std::unique_ptr<Request>> requests;
+    GLuint unpackBuffer = 0;
+    unsigned int revision = 0;
+    std::vector<Upload> uploads;    // Textures uploaded by the last update
+    bool useCooked = false;         // Reads cooked files when the driver supports S3TC
+
+    /**
+     * @brief Creates a texture of the given target filled with the placeholder.
+     */
+    GLuint createPlaceholder(GLenum target);
+
+    /**
+     * @brief Queues a request and submits one background decode job per image.
+     *
+     * Decoding runs in the background queue, so a frame's wait for its own jobs never runs a decode.
+     */
+    void submit(std::unique_ptr<Request> request);
+
+    /**
+     * @brief Decodes an image file into an Image.
+     * @param image Receives the pixels; its path names the file.
+     * @param flip Flips the image vertically when true.
+     * @param useCooked Reads the image's cooked file instead, when it has one.
+     */
+    static void decode(Image& image, bool flip, bool useCooked);
+
+    /**
+     * @brief Returns true when the driver exposes GL_EXT_texture_compression_s3tc.
+     */
+    static bool isS3tcSupported();
+
+    /**
+     * @brief Uploads a request's images through the unpack buffer.
+     */
+    void upload(Request& request);
+
+    /**
+     * @brief Returns the number of bytes of a request's images.
+     */
+    static size_t getByteCount(const Request& request);
+
+    /**
+     * @brief Returns the estimated GPU memory of a request's texture once uploaded, mipmaps included.
+     */
+    static size_t getResidentBytes(const Request& request);
+
+    /**
+     * @brief Flips an image vertically.
+     *
+     * This method flips an image vertically to match OpenGL's coordinate system, where the Y axis goes up.
+     *
+     * @param image A pointer to the image data.
+     * @param width The width of the image.
+     * @param height The height of the image.
+     * @param channels The number of color channels in the image.
+     */
+    static void flipImageVertically(unsigned char* image, int width, int height, int channels);
+};
+#endif // TEXTURELOADER_H
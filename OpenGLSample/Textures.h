@@ -16,6 +16,10 @@
 #include <glad/glad.h>
 #include <vector>
 
+#include "TextureLoader.h"
+#include "TextureCooker.h"
+#include "ResourceManager.h"
+
 using namespace std;
 
 /**
@@ -54,9 +58,21 @@ public:
     /**
      * @brief Creates and assigns textures.
      *
-     * This method loads and assigns textures from specified image files.
+     * This method assigns textures to the specified image files. The textures show a placeholder until
+     * the scene acquires them from the resource manager and their files are uploaded.
+     *
+     * @param manager The resource manager that streams the image files in on demand.
      */
-    void createTextures();
+    void createTextures(ResourceManager& manager);
+
+    /**
+     * @brief Cooks the image files of every texture and of the skybox into compressed files.
+     *
+     * The textures are cooked flipped, as they are loaded; the skybox faces are not.
+     *
+     * @param cooker The cooker that compresses the files.
+     */
+    void cookTextures(TextureCooker& cooker);
 
     /**
      * @brief Destroys all textures.
@@ -70,33 +86,23 @@ public:
      *
      * This method loads a cubemap texture from six image files, each representing one face of the cubemap.
      *
+     * @param loader The loader that streams the image files in.
      * @return The ID of the generated cubemap texture.
      */
-    unsigned int loadSkyBox();
+    unsigned int loadSkyBox(TextureLoader& loader);
 
 private:
     /**
-     * @brief Flips an image vertically.
-     *
-     * This method flips an image vertically to match OpenGL's coordinate system, where the Y axis goes up.
-     *
-     * @param image A pointer to the image data.
-     * @param width The width of the image.
-     * @param height The height of the image.
-     * @param channels The number of color channels in the image.
-     */
-    void flipImageVertically(unsigned char* image, int width, int height, int channels);
-    
-    /**
-     * @brief Generates and loads a texture from a file.
+     * @brief Generates a texture for a file.
      *
-     * This method generates a texture ID, loads the texture data from the specified file path, and sets the texture parameters.
+     * This method generates a texture ID, sets the texture parameters and registers the file path with the resource manager.
      *
+     * @param manager The resource manager that streams the image file in.
      * @param path The file path to the texture image.
      * @param wrapMode The wrapping mode for the texture (e.g., GL_REPEAT, GL_CLAMP_TO_EDGE).
      * @return The ID of the generated texture.
      */
-    unsigned int loadTexture(const char* filename, GLuint wrapMode);
+    unsigned int loadTexture(ResourceManager& manager, const char* filename, GLuint wrapMode);
 
     /**
      * @brief Destroys a texture in OpenGL.
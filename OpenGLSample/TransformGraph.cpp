@@ -0,0 +1,149 @@
+/**
+ * @file TransformGraph.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the TransformGraph class.
+ */
+
+#include "TransformGraph.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORMGRAPH_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+const uint32_t TransformGraph::NO_NODE;
+
+/**
+ * @brief Adds a node under a parent.
+ *
+ * The world matrix is computed right away when the parent's is up to date.
+ *
+ * @param parent The parent node, or NO_NODE for a top-level node.
+ * @param local The node's transformation relative to its parent.
+ * @return The new node.
+ */
+uint32_t TransformGraph::createNode(uint32_t parent, const glm::mat4& local) {
+    uint32_t node = static_cast<uint32_t>(locals.size());
+    locals.push_back(local);
+    parents.push_back(parent);
+    depths.push_back(parent == NO_NODE ? 0 : depths[parent] + 1);
+    changed.push_back(0);
+
+    glm::mat4 world = local;
+    bool parentDirty = parent != NO_NODE && dirty[parent] != 0;
+    if (parent != NO_NODE && !parentDirty) {
+        multiply(worlds[parent], local, world);
+    }
+    worlds.push_back(world);
+    dirty.push_back(parentDirty ? 1 : 0);
+    if (parentDirty) {
+        dirtyCount++;
+    }
+    return node;
+}
+
+/**
+ * @brief Changes a node's local matrix. The node and its subtree are recomputed by the next update.
+ *
+ * An unchanged matrix does not mark the node dirty.
+ *
+ * @param node The node to change.
+ * @param local The node's transformation relative to its parent.
+ */
+void TransformGraph::setLocal(uint32_t node, const glm::mat4& local) {
+    if (std::memcmp(&locals[node], &local, sizeof(glm::mat4)) == 0) {
+        return;
+    }
+    locals[node] = local;
+    if (dirty[node] == 0) {
+        dirty[node] = 1;
+        dirtyCount++;
+    }
+}
+
+/**
+ * @brief Recomputes the world matrices of the dirty nodes and of every node below them.
+ * @return The number of world matrices recomputed, which isChanged reports until the next update.
+ */
+size_t TransformGraph::update() {
+    if (changedCount > 0) {
+        std::fill(changed.begin(), changed.end(), 0);
+        changedCount = 0;
+    }
+    if (dirtyCount == 0) {
+        return 0;
+    }
+
+    // Parents come first, so a parent marked in this pass is marked before its children
+    const size_t levelCount = *std::max_element(depths.begin(), depths.end()) + 1;
+    levelStarts.assign(levelCount + 1, 0);
+    for (size_t i = 0; i < locals.size(); i++) {
+        const uint32_t parent = parents[i];
+        const bool parentChanged = parent != NO_NODE && changed[parent] != 0;
+        if (dirty[i] == 0 && !parentChanged) {
+            continue;
+        }
+        dirty[i] = 0;
+        changed[i] = 1;
+        changedCount++;
+        levelStarts[depths[i] + 1]++;
+    }
+    dirtyCount = 0;
+
+    // Counting sort of the marked nodes by depth
+    for (size_t level = 0; level < levelCount; level++) {
+        levelStarts[level + 1] += levelStarts[level];
+    }
+    batch.resize(changedCount);
+    for (size_t i = 0; i < locals.size(); i++) {
+        if (changed[i] != 0) {
+            batch[levelStarts[depths[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+    // Placing the nodes advanced each start to the next level's; shift them back
+    for (size_t level = levelCount; level > 0; level--) {
+        levelStarts[level] = levelStarts[level - 1];
+    }
+    levelStarts[0] = 0;
+
+    // Every parent of a level was finished by the level above
+    for (size_t i = 0; i < levelStarts[1]; i++) {
+        worlds[batch[i]] = locals[batch[i]];
+    }
+    for (size_t level = 1; level < levelCount; level++) {
+        for (size_t i = levelStarts[level]; i < levelStarts[level + 1]; i++) {
+            const uint32_t node = batch[i];
+            multiply(worlds[parents[node]], locals[node], worlds[node]);
+        }
+    }
+    return changedCount;
+}
+
+/**
+ * @brief Writes the product of two matrices.
+ */
+void TransformGraph::multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result) {
+#ifdef TRANSFORMGRAPH_USE_SSE2
+    // Column j of the product is the columns of a weighted by column j of b
+    const float* columns = &a[0][0];
+    const __m128 a0 = _mm_loadu_ps(columns);
+    const __m128 a1 = _mm_loadu_ps(columns + 4);
+    const __m128 a2 = _mm_loadu_ps(columns + 8);
+    const __m128 a3 = _mm_loadu_ps(columns + 12);
+    float* out = &result[0][0];
+    for (int j = 0; j < 4; j++) {
+        const float* weights = &b[j][0];
+        __m128 column = _mm_mul_ps(a0, _mm_set1_ps(weights[0]));
+        column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(weights[1])));
+        column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(weights[2])));
+        column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(weights[3])));
+        _mm_storeu_ps(out + 4 * j, column);
+    }
+#else
+    result = a * b;
+#endif
+}
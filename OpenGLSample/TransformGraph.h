@@ -0,0 +1,107 @@
+/**
+ * @file TransformGraph.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the TransformGraph class, which caches the local and
+ * world matrices of a hierarchy of transforms and recomputes only the ones that changed.
+ */
+
+#ifndef TRANSFORMGRAPH_H
+#define TRANSFORMGRAPH_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @class TransformGraph
+ * @brief A hierarchy of transforms with cached world matrices.
+ *
+ * The scene uses three levels: a table set, the items placed on it and the submeshes of each item.
+ * A node's world matrix is its parent's world matrix times its local matrix. Nodes are stored in
+ * flat arrays, and a node is always created after its parent, so one forward pass over the arrays
+ * visits every parent before its children. Changing a local matrix only marks the node dirty; the
+ * next update marks the dirty nodes and everything below them in that pass, sorts the marked nodes
+ * by depth and then recomputes one depth level at a time. The products of a level do not depend on
+ * each other, so they run back to back, each done four floats at a time. An update with nothing
+ * dirty does no matrix math at all.
+ */
+class TransformGraph
+{
+public:
+    // Parent of the top-level nodes
+    static const uint32_t NO_NODE = 0xffffffffu;
+
+    /**
+     * @brief Adds a node under a parent.
+     *
+     * The world matrix is computed right away when the parent's is up to date.
+     *
+     * @param parent The parent node, or NO_NODE for a top-level node.
+     * @param local The node's transformation relative to its parent.
+     * @return The new node.
+     */
+    uint32_t createNode(uint32_t parent, const glm::mat4& local);
+
+    /**
+     * @brief Changes a node's local matrix. The node and its subtree are recomputed by the next update.
+     *
+     * An unchanged matrix does not mark the node dirty.
+     *
+     * @param node The node to change.
+     * @param local The node's transformation relative to its parent.
+     */
+    void setLocal(uint32_t node, const glm::mat4& local);
+
+    /**
+     * @brief Recomputes the world matrices of the dirty nodes and of every node below them.
+     * @return The number of world matrices recomputed, which isChanged reports until the next update.
+     */
+    size_t update();
+
+    /**
+     * @brief Returns the cached world matrix of a node, as of the last update.
+     */
+    const glm::mat4& getWorld(uint32_t node) const { return worlds[node]; }
+
+    /**
+     * @brief Returns the matrix of a node relative to its parent.
+     */
+    const glm::mat4& getLocal(uint32_t node) const { return locals[node]; }
+
+    /**
+     * @brief Returns the parent of a node, or NO_NODE for a top-level node.
+     */
+    uint32_t getParent(uint32_t node) const { return parents[node]; }
+
+    /**
+     * @brief Returns true when the last update recomputed the node's world matrix.
+     */
+    bool isChanged(uint32_t node) const { return changed[node] != 0; }
+
+    /**
+     * @brief Returns the number of nodes.
+     */
+    size_t size() const { return locals.size(); }
+
+private:
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> depths;       // 0 for a top-level node
+    std::vector<unsigned char> dirty;   // Local matrix changed since the last update
+    std::vector<unsigned char> changed; // World matrix recomputed by the last update
+    size_t dirtyCount = 0;
+    size_t changedCount = 0;
+
+    // Reused by update: the nodes to recompute sorted by depth, and where each level starts
+    std::vector<uint32_t> batch;
+    std::vector<size_t> levelStarts;
+
+    /**
+     * @brief Writes the product of two matrices.
+     */
+    static void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result);
+};
+#endif // TRANSFORMGRAPH_H
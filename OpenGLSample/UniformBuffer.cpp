@@ -0,0 +1,128 @@
+/**
+ * @file UniformBuffer.cpp
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the implementation of the UniformBuffer class.
+ */
+
+#include "UniformBuffer.h"
+#include <cstring>
+#include "StreamBuffer.h"
+
+/**
+ * @brief Allocates the buffer and binds it to a binding point.
+ * @param bufferSize The size of the block in bytes.
+ * @param binding The uniform block binding point.
+ */
+void UniformBuffer::create(GLsizeiptr bufferSize, GLuint binding) {
+    size = bufferSize;
+    this->binding = binding;
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+}
+
+/**
+ * @brief Replaces the contents of the buffer.
+ * @param data The new block contents, bufferSize bytes long.
+ */
+void UniformBuffer::update(const void* data) {
+    if (stream != nullptr) {
+        std::memcpy(contents.data(), data, static_cast<size_t>(size));
+        upload();
+        return;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/**
+ * @brief Replaces part of the contents of the buffer.
+ * @param offset The offset of the range in bytes.
+ * @param length The length of the range in bytes.
+ * @param data The new contents of the range, length bytes long.
+ */
+void UniformBuffer::update(GLintptr offset, GLsizeiptr length, const void* data) {
+    if (stream != nullptr) {
+        std::memcpy(contents.data() + offset, data, static_cast<size_t>(length));
+        upload();
+        return;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, length, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/**
+ * @brief Streams the block through a ring from now on, or stops streaming it with nullptr.
+ * @param buffer The ring; it must outlive the block or be unset before it is destroyed.
+ */
+void UniformBuffer::setStreamBuffer(StreamBuffer* buffer) {
+    if (buffer == stream) {
+        return;
+    }
+    if (stream == nullptr) {
+        // The block so far lives in ubo
+        contents.assign(static_cast<size_t>(size), 0);
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glGetBufferSubData(GL_UNIFORM_BUFFER, 0, size, contents.data());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    stream = buffer;
+    if (stream != nullptr) {
+        upload();
+        return;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, contents.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+    contents.clear();
+    streamed = false;
+}
+
+/**
+ * @brief Writes the block again when the ring moved to a new frame since its last update.
+ *
+ * A streamed block that was not updated this frame would be read from a region that is about to
+ * be reused. Call this once per frame, before the first draw, for blocks that skip unchanged updates.
+ */
+void UniformBuffer::refresh() {
+    if (stream != nullptr && streamedFrame != stream->getFrameNumber()) {
+        upload();
+    }
+}
+
+/**
+ * @brief Writes the whole block into the ring and binds it, or into ubo when the ring is full.
+ */
+void UniformBuffer::upload() {
+    const GLintptr offset = stream->write(contents.data(), size);
+    streamedFrame = stream->getFrameNumber();
+    if (offset != StreamBuffer::NO_SPACE) {
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, stream->getBuffer(), offset, size);
+        streamed = true;
+        return;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, contents.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    if (streamed) {
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+        streamed = false;
+    }
+}
+
+/**
+ * @brief Releases the buffer.
+ */
+void UniformBuffer::destroy() {
+    if (ubo != 0) {
+        glDeleteBuffers(1, &ubo);
+        ubo = 0;
+    }
+}
@@ -0,0 +1,239 @@
+/**
+ * @file UniformBuffer.h
+ * @author Michael Gagujas
+ * @date August 18, 2024
+ *
+ * @brief This file contains the definition of the UniformBuffer class and the std140 layouts of the
+ * uniform blocks shared by the scene shaders.
+ */
+
+#ifndef UNIFORMBUFFER_H
+#define UNIFORMBUFFER_H
+
+#include <cstddef>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+class StreamBuffer;
+
+// Binding points of the shared uniform blocks
+const GLuint CAMERA_BLOCK_BINDING = 0;
+const GLuint LIGHTS_BLOCK_BINDING = 1;
+const GLuint SHADOWS_BLOCK_BINDING = 2;
+const GLuint MATERIALS_BLOCK_BINDING = 3;
+
+// Cascades of the directional light's shadow map
+const int SHADOW_CASCADE_COUNT = 3;
+
+// Entries of the Materials uniform block; 8 KB, well within the 16 KB every driver allows
+const int MAX_MATERIALS = 256;
+
+/**
+ * @struct CameraBlock
+ * @brief std140 layout of the Camera uniform block.
+ */
+struct CameraBlock
+{
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec3 viewPos;
+    float padding;
+};
+
+/**
+ * @struct DirLightBlock
+ * @brief std140 layout of the DirLight struct in the Lights uniform block.
+ */
+struct DirLightBlock
+{
+    glm::vec3 direction;
+    float padding0;
+    glm::vec3 ambient;
+    float padding1;
+    glm::vec3 diffuse;
+    float padding2;
+    glm::vec3 specular;
+    float padding3;
+};
+
+/**
+ * @struct PointLightBlock
+ * @brief Layout of one point light in the light buffer of LightGrid.
+ *
+ * Each vec3 is followed by a float that fills the rest of its 16-byte texel, matching the four
+ * texels fetched per light by 6.multiple_lights.fs.
+ */
+struct PointLightBlock
+{
+    glm::vec3 position;
+    float constant;
+    glm::vec3 ambient;
+    float linear;
+    glm::vec3 diffuse;
+    float quadratic;
+    glm::vec3 specular;
+    float intensity;
+};
+
+/**
+ * @struct SpotLightBlock
+ * @brief std140 layout of the SpotLight struct in the Lights uniform block.
+ *
+ * Each vec3 is followed by a float that fills the rest of its 16-byte slot.
+ */
+struct SpotLightBlock
+{
+    glm::vec3 position;
+    float cutOff;
+    glm::vec3 direction;
+    float outerCutOff;
+    glm::vec3 ambient;
+    float constant;
+    glm::vec3 diffuse;
+    float linear;
+    glm::vec3 specular;
+    float quadratic;
+};
+
+/**
+ * @struct LightClustersBlock
+ * @brief std140 layout of the LightClusters struct in the Lights uniform block.
+ *
+ * Describes how a fragment finds its cluster in the light grid: the tile is gl_FragCoord.xy divided
+ * by tileSize, and the depth slice is log(view depth) * sliceScale + sliceBias.
+ */
+struct LightClustersBlock
+{
+    GLuint gridSize[3];       // Tiles across, tiles down and depth slices
+    GLuint pointLightCount;   // Point lights in the light buffer
+    glm::vec2 tileSize;       // Size of a tile in pixels
+    float sliceScale;
+    float sliceBias;
+};
+
+/**
+ * @struct LightsBlock
+ * @brief std140 layout of the Lights uniform block.
+ *
+ * The point lights do not fit a uniform block; they are read from the buffer textures of LightGrid.
+ */
+struct LightsBlock
+{
+    DirLightBlock dirLight;
+    LightClustersBlock clusters;
+    SpotLightBlock spotLight;
+};
+
+/**
+ * @struct ShadowsBlock
+ * @brief std140 layout of the Shadows uniform block.
+ *
+ * The matrices take world space to the clip space of each shadow map. A fragment uses the first
+ * cascade whose split distance is beyond its view depth, and is unshadowed past the last one.
+ */
+struct ShadowsBlock
+{
+    glm::mat4 cascadeViewProjection[SHADOW_CASCADE_COUNT];
+    glm::mat4 spotViewProjection;
+    glm::vec4 cascadeSplits;   // Far view depth of each cascade
+    GLint spotShadows;         // 0 when the spot light's shadow map is not rendered
+    float padding[3];
+};
+
+/**
+ * @struct MaterialBlock
+ * @brief std140 layout of one entry of the Materials uniform block.
+ */
+struct MaterialBlock
+{
+    glm::vec2 uvScale;      // Texture coordinate scale
+    float shininess;        // Specular exponent
+    float padding;
+    glm::ivec4 layers;      // Diffuse, specular and overlay layers in TextureArray, then the mirrored slots
+};
+
+/**
+ * @struct MaterialsBlock
+ * @brief std140 layout of the Materials uniform block, indexed by a draw's material id.
+ */
+struct MaterialsBlock
+{
+    MaterialBlock materials[MAX_MATERIALS];
+};
+
+static_assert(sizeof(CameraBlock) == 144, "CameraBlock must match the std140 layout");
+static_assert(sizeof(DirLightBlock) == 64, "DirLightBlock must match the std140 layout");
+static_assert(sizeof(PointLightBlock) == 64, "PointLightBlock must match the std140 layout");
+static_assert(sizeof(SpotLightBlock) == 80, "SpotLightBlock must match the std140 layout");
+static_assert(sizeof(LightClustersBlock) == 32, "LightClustersBlock must match the std140 layout");
+static_assert(offsetof(LightsBlock, spotLight) == 96, "LightsBlock must match the std140 layout");
+static_assert(sizeof(ShadowsBlock) == 288, "ShadowsBlock must match the std140 layout");
+static_assert(sizeof(MaterialBlock) == 32, "MaterialBlock must match the std140 layout");
+
+/**
+ * @class UniformBuffer
+ * @brief A uniform buffer object bound to a fixed binding point.
+ *
+ * A block that changes every frame can be streamed: each update writes the whole block into the
+ * current frame's region of a StreamBuffer and binds that range, instead of rewriting a buffer the
+ * GPU may still be reading. The block's own buffer is kept for the writes that do not fit the ring.
+ */
+class UniformBuffer
+{
+private:
+    GLuint ubo = 0;
+    GLsizeiptr size = 0;
+    GLuint binding = 0;
+    StreamBuffer* stream = nullptr;         // Ring the block is streamed through, or nullptr
+    std::vector<unsigned char> contents;    // Whole block, kept while streamed so partial updates can be rewritten
+    unsigned int streamedFrame = 0;         // Ring frame of the last streamed write
+    bool streamed = false;                  // The binding points into the ring, not at ubo
+
+    /**
+     * @brief Writes the whole block into the ring and binds it, or into ubo when the ring is full.
+     */
+    void upload();
+
+public:
+    /**
+     * @brief Allocates the buffer and binds it to a binding point.
+     * @param bufferSize The size of the block in bytes.
+     * @param binding The uniform block binding point.
+     */
+    void create(GLsizeiptr bufferSize, GLuint binding);
+
+    /**
+     * @brief Replaces the contents of the buffer.
+     * @param data The new block contents, bufferSize bytes long.
+     */
+    void update(const void* data);
+
+    /**
+     * @brief Replaces part of the contents of the buffer.
+     * @param offset The offset of the range in bytes.
+     * @param length The length of the range in bytes.
+     * @param data The new contents of the range, length bytes long.
+     */
+    void update(GLintptr offset, GLsizeiptr length, const void* data);
+
+    /**
+     * @brief Streams the block through a ring from now on, or stops streaming it with nullptr.
+     * @param buffer The ring; it must outlive the block or be unset before it is destroyed.
+     */
+    void setStreamBuffer(StreamBuffer* buffer);
+
+    /**
+     * @brief Writes the block again when the ring moved to a new frame since its last update.
+     *
+     * A streamed block that was not updated this frame would be read from a region that is about to
+     * be reused. Call this once per frame, before the first draw, for blocks that skip unchanged updates.
+     */
+    void refresh();
+
+    /**
+     * @brief Releases the buffer.
+     */
+    void destroy();
+};
+#endif // UNIFORMBUFFER_H
@@ -15,6 +15,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <functional>
 
 #include <vector>
 
@@ -62,6 +63,8 @@ public:
 	float MouseSensitivity;
 	float Zoom;
 	float Fov = 75.0f; // Field of View
+	// Returns where a keyboard move from a position ends up, for collision; moves freely when empty
+	std::function<glm::vec3(const glm::vec3& position, const glm::vec3& motion)> ResolveMove;
 
 
 	/**
@@ -126,6 +129,7 @@ public:
 	 *
 	 * This method updates the camera's position based on the direction of movement and the elapsed time.
 	 * It accepts an input parameter in the form of a camera-defined ENUM to abstract it from windowing systems.
+	 * When ResolveMove is set, the move goes through it, so the scene can stop the camera at what it hits.
 	 *
 	 * @param direction A Camera_Movement enum value indicating the direction of movement (FORWARD, BACKWARD, LEFT, RIGHT, UP, DOWN).
 	 * @param deltaTime A float representing the time elapsed since the last frame.
@@ -133,18 +137,20 @@ public:
 	void ProcessKeyboard(Camera_Movement direction, float deltaTime)
 	{
 		float velocity = MovementSpeed * deltaTime;
+		glm::vec3 motion(0.0f);
 		if (direction == FORWARD)
-			Position += Front * velocity;
+			motion += Front * velocity;
 		if (direction == BACKWARD)
-			Position -= Front * velocity;
+			motion -= Front * velocity;
 		if (direction == LEFT)
-			Position -= Right * velocity;
+			motion -= Right * velocity;
 		if (direction == RIGHT)
-			Position += Right * velocity;
+			motion += Right * velocity;
 		if (direction == DOWN)
-			Position -= Up * velocity;
+			motion -= Up * velocity;
 		if (direction == UP)
-			Position += Up * velocity;
+			motion += Up * velocity;
+		Position = ResolveMove ? ResolveMove(Position, motion) : Position + motion;
 	}
 
 	/**
@@ -209,6 +215,22 @@ public:
 		updateCameraVectors();
 	}
 
+	/**
+	 * @brief Places the camera at a position with the given Euler angles.
+	 *
+	 * Used to replay a recorded camera path.
+	 *
+	 * @param position The new position of the camera.
+	 * @param yaw The new yaw angle in degrees.
+	 * @param pitch The new pitch angle in degrees.
+	 */
+	void SetPose(glm::vec3 position, float yaw, float pitch) {
+		Position = position;
+		Yaw = yaw;
+		Pitch = pitch;
+		updateCameraVectors();
+	}
+
 private:
 	/**
 	 * @brief Updates the camera's vectors based on its current Euler angles.
@@ -35,12 +35,43 @@
  *       F      - Toggle flashlight on/off                                                                     
  *       B      - Toggle skybox                                                                                
  *       V      - Toggle Frustum View                                                                          
+ *       N      - Toggle instanced rendering                                                                   
+ *       X      - Toggle multi-draw indirect for instanced rendering (OpenGL 4.3)                              
+ *       G      - Toggle GPU firefly simulation                                                                
+ *       M      - Toggle simulating the next frame on worker threads                                           
+ *       T      - Toggle LOD bias driven by the frame-time budget                                              
+ *       Z      - Toggle the depth pre-pass                                                                    
+ *       Y      - Toggle reading the instanced draws' textures from one texture array                          
+ *       3      - Toggle occlusion culling of the items hidden in earlier frames
+ *       4      - Toggle camera collision with the scene items
+ *       5      - Toggle the render resolution scaling that holds the GPU frame time under 60 Hz
+ *       C      - Print GL bind and visibility counters for the last frame                                    
+ *       H      - Start/stop a profiler capture, written to frame_trace.json when stopped
  *       R      - Invert Camera                                                                                
- *      ESC     - Closes window                                                                                                                                                                                          
+ *      ESC     - Closes window                                                                                
+ *                                                                                                           
+ *  Command line:                                                                                             
+ *  --deferred  - Light the scene from a G-buffer instead of in the forward pass
+ *  --cook-textures - Compress the texture files into .dds files next to them, then exit
+ *  --vram-budget <MB> - Evict the textures of distant objects once this much memory is resident
+ *  --benchmark <path> - Replay a camera path in a hidden window, write the frame times to benchmark_results.json and exit
+ *  --bench-tables <N>, --bench-fireflies <M>, --bench-seed <S>, --bench-output <file> - Scene size, firefly seed and results file of the benchmark
+ *  --record-path <file> - Record the camera's moves as a path for --benchmark, written on exit
+ *  --scene <file> - Load the scene from a binary scene file instead of the built-in layout
+ *  --save-scene <file> - Write the built-in scene, at the --bench-tables and --bench-fireflies size, as a scene file and exit
+ *  --no-program-cache - Compile every shader from source instead of loading the binaries in program_cache.bin
+ *  --no-shader-variants - Shade every forward draw with the full lighting shader instead of the variant of its lights and overlay
+ *  --no-stream-buffer - Upload the per-frame uniform blocks, instance data and firefly positions into their own buffers instead of the fenced ring
+ *  --microbench [items] - Time the culling, tree, LOD and mesh generator code from 10 up to 1M (or items) items, then exit
  */
 #pragma once
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
 #include <iostream> 
+#include <memory>
 #include <string>
 
 #include <glad/glad.h>
@@ -54,13 +85,35 @@
 #include "camera.h"
 #include "MeshCreator.h"
 #include "Textures.h"
+#include "TextureLoader.h"
+#include "TextureCooker.h"
+#include "TextureArray.h"
+#include "ResourceManager.h"
 #include "LightManager.h"
 #include "DirectLight.h"
 #include "PointLight.h"
 #include "SpotLight.h"
-#include "FireFly.h"
 #include "SceneManagerBSP.h"
 #include "Table.h"
+#include "GLStateCache.h"
+#include "UniformBuffer.h"
+#include "LightGrid.h"
+#include "ResourceRegistry.h"
+#include "JobSystem.h"
+#include "LodPolicy.h"
+#include "DeferredRenderer.h"
+#include "ShadowMaps.h"
+#include "Profiler.h"
+#include "Benchmark.h"
+#include "CameraPath.h"
+#include "MicroBenchmarks.h"
+#include "ProgramCache.h"
+#include "ShaderVariants.h"
+#include "LightConfig.h"
+#include "StreamBuffer.h"
+#include "DynamicResolution.h"
+#include "FrameArena.h"
+#include "AllocationTracker.h"
 
 using namespace::std;
 
@@ -79,6 +132,15 @@ namespace
 	float lastX = SCR_WIDTH / 2.0f;
 	float lastY = SCR_HEIGHT / 2.0f;
 	bool firstMouse = true;
+	const float FIELD_OF_VIEW = 60.0f;
+	const float NEAR_PLANE = 0.1f;
+	const float FAR_PLANE = 100.0f;
+	// Radius of the sphere the camera collides as, larger than the near plane so it never clips what it touches
+	const float CAMERA_RADIUS = 0.2f;
+
+	// Lights, parsed once and parsed again when the file changes
+	const char* const LIGHT_CONFIG_PATH = "../OpenGLSample/resources/lightsConfig.ini";
+	const double LIGHT_CONFIG_CHECK_SECONDS = 0.5;
 
 	// Timing
 	float deltaTime = 0.0f;
@@ -86,23 +148,128 @@ namespace
 
 	// Default status values
 	int lightNumber = 1;
+	// Point lights moved with the keyboard, selected by lightNumber
+	LightHandle<PointLight> pointLight1;
+	LightHandle<PointLight> pointLight2;
 	bool showPerspective = true;
 	bool showFlashlight = true;
 	bool showSkybox = true;
 	bool checkFrustum = false;
+	bool useInstancing = false;
+	bool useIndirect = true;
+	bool gpuParticles = false;
+	bool pipelineFrames = true;
+	bool depthPrepass = false;
+	bool useTextureArray = true;
+	bool occlusionCulling = false;
+	bool cameraCollision = true;
+	bool printStats = false;
+	bool toggleCapture = false;
+
+	// Profiler capture file and how often the window title shows the profiler summary
+	const char* TRACE_PATH = "frame_trace.json";
+	const double TITLE_INTERVAL = 0.5;
+
+	// Coarsens the levels of detail while frames miss a 60 Hz budget
+	LodBiasController lodBudget(1.0f / 60.0f);
+	// Lowers the render resolution, and the levels of detail with it, while the GPU misses the same budget
+	DynamicResolution dynamicResolution(1.0f / 60.0f);
+
+	// Filters redundant program, vertex array and texture binds
+	GLStateCache stateCache;
 
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-void processInput(GLFWwindow* window, LightManager lightManager);
-void moveLight(string direction, float time, LightManager lightManager);
+void processInput(GLFWwindow* window, LightManager& lightManager);
+void moveLight(string direction, float time, LightManager& lightManager);
 void toggleEvent(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 
-int main()
+int main(int argc, char* argv[])
 {
+	// Deferred shading is chosen at startup, since the scene shaders are built for one mode or the other
+	bool useDeferred = false;
+	bool cookTextures = false;
+	size_t vramBudget = ResourceManager::DEFAULT_BUDGET_BYTES;
+	Benchmark::Settings benchmarkSettings;
+	std::string recordPathFile;
+	std::string sceneFile;
+	std::string saveSceneFile;
+	bool useProgramCache = true;
+	bool useShaderVariants = true;
+	bool useStreamBuffer = true;
+	size_t microbenchItems = 0;
+	for (int i = 1; i < argc; i++) {
+		if (string(argv[i]) == "--deferred") {
+			useDeferred = true;
+		}
+		if (string(argv[i]) == "--cook-textures") {
+			cookTextures = true;
+		}
+		if (string(argv[i]) == "--vram-budget" && i + 1 < argc) {
+			vramBudget = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10)) * 1024 * 1024;
+		}
+		if (string(argv[i]) == "--benchmark" && i + 1 < argc) {
+			benchmarkSettings.pathFile = argv[++i];
+		}
+		if (string(argv[i]) == "--bench-tables" && i + 1 < argc) {
+			benchmarkSettings.tableCopies = static_cast<int>(std::strtol(argv[++i], nullptr, 10));
+		}
+		if (string(argv[i]) == "--bench-fireflies" && i + 1 < argc) {
+			benchmarkSettings.fireflyCount = static_cast<int>(std::strtol(argv[++i], nullptr, 10));
+		}
+		if (string(argv[i]) == "--bench-seed" && i + 1 < argc) {
+			benchmarkSettings.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		if (string(argv[i]) == "--bench-output" && i + 1 < argc) {
+			benchmarkSettings.outputFile = argv[++i];
+		}
+		if (string(argv[i]) == "--record-path" && i + 1 < argc) {
+			recordPathFile = argv[++i];
+		}
+		if (string(argv[i]) == "--scene" && i + 1 < argc) {
+			sceneFile = argv[++i];
+		}
+		if (string(argv[i]) == "--save-scene" && i + 1 < argc) {
+			saveSceneFile = argv[++i];
+		}
+		if (string(argv[i]) == "--no-program-cache") {
+			useProgramCache = false;
+		}
+		if (string(argv[i]) == "--no-shader-variants") {
+			useShaderVariants = false;
+		}
+		if (string(argv[i]) == "--no-stream-buffer") {
+			useStreamBuffer = false;
+		}
+		if (string(argv[i]) == "--microbench") {
+			microbenchItems = MicroBenchmarks::DEFAULT_MAX_ITEMS;
+			if (i + 1 < argc && argv[i + 1][0] != '-') {
+				microbenchItems = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+			}
+		}
+	}
+
+	// Cooking converts the texture files offline and exits without opening a window
+	if (cookTextures) {
+		JobSystem cookJobs(JobSystem::getDefaultWorkerCount());
+		TextureCooker cooker(cookJobs);
+		Textures textures;
+		textures.cookTextures(cooker);
+		int failures = cooker.finish();
+		std::cout << "Cooked the textures, " << failures << " failed" << std::endl;
+		return failures == 0 ? 0 : -1;
+	}
+
+	// The microbenchmarks need no GL context either
+	if (microbenchItems > 0) {
+		MicroBenchmarks microBenchmarks(microbenchItems);
+		return microBenchmarks.run();
+	}
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -114,6 +281,21 @@ int main()
 		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 	#endif
 
+	// A benchmark replays its path without input, in a window that is never shown
+	std::unique_ptr<Benchmark> benchmark;
+	if (!benchmarkSettings.pathFile.empty()) {
+		benchmark.reset(new Benchmark(benchmarkSettings));
+		if (!benchmark->load()) {
+			glfwTerminate();
+			return -1;
+		}
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+	// Saving a scene needs the meshes and textures of a context, but no window
+	if (!saveSceneFile.empty()) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+
 	// glfw window creation
 	// --------------------
 	const char* WINDOW_TITLE = "Michael Gagujas Capstone";
@@ -129,6 +311,10 @@ int main()
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
 	glfwSetKeyCallback(window, toggleEvent);
+	if (benchmark) {
+		// Frames are not held to the refresh rate
+		glfwSwapInterval(0);
+	}
 
 
 	// tell GLFW to capture our mouse
@@ -141,6 +327,13 @@ int main()
 		std::cout << "Failed to initialize GLAD" << std::endl;
 		return -1;
 	}
+	if (!RenderCommandList::isIndirectSupported()) {
+		std::cout << "OpenGL 4.3 is not available; instanced rendering uses one draw call per mesh" << std::endl;
+	}
+	// Every shader created from here on links from its cached binary when it can
+	if (useProgramCache) {
+		ProgramCache::enable(ProgramCache::DEFAULT_PATH);
+	}
 
 	// configure global opengl state
 	// -----------------------------
@@ -148,10 +341,21 @@ int main()
 
 	// build and compile our shader zprogram
 	// ------------------------------------
-	Shader lightingShader("../OpenGLSample/shaderfiles/6.multiple_lights.vs", "../OpenGLSample/shaderfiles/6.multiple_lights.fs");
+	// In deferred mode the scene shaders write the G-buffer instead of lighting each fragment
+	const string sceneFragmentShader = useDeferred ? "../OpenGLSample/shaderfiles/gbuffer.fs" : "../OpenGLSample/shaderfiles/6.multiple_lights.fs";
+	Shader lightingShader("../OpenGLSample/shaderfiles/6.multiple_lights.vs", sceneFragmentShader.c_str());
+	Shader instancedShader("../OpenGLSample/shaderfiles/6.multiple_lights_instanced.vs", sceneFragmentShader.c_str());
+	Shader fireflyShader("../OpenGLSample/shaderfiles/6.firefly_instanced.vs", sceneFragmentShader.c_str());
+	Shader fireflyUpdateShader("../OpenGLSample/shaderfiles/6.firefly_update.vs", { "outPosition", "outSpawn", "outMotion", "outSeed" });
 	Shader lightCubeShader("../OpenGLSample/shaderfiles/6.light_cube.vs", "../OpenGLSample/shaderfiles/6.light_cube.fs");
 	Shader skyboxShader("../OpenGLSample/shaderfiles/skybox.vs", "../OpenGLSample/shaderfiles/skybox.fs");
+	// Same vertex shaders as the scene shaders, so the pre-pass depth matches the lighting pass exactly
+	Shader depthShader("../OpenGLSample/shaderfiles/6.multiple_lights.vs", "../OpenGLSample/shaderfiles/depth_only.fs");
+	Shader depthInstancedShader("../OpenGLSample/shaderfiles/6.multiple_lights_instanced.vs", "../OpenGLSample/shaderfiles/depth_only.fs");
+
 
+	// Simulates the next frame on the cores the GL thread leaves idle, and decodes the texture files
+	JobSystem jobSystem(JobSystem::getDefaultWorkerCount());
 
 	// Meshes data
 	MeshCreator gMesh;
@@ -159,36 +363,165 @@ int main()
 	Textures gTexture;
 	// Create meshes
 	gMesh.createMeshes();
-	// Load textures
-	gTexture.createTextures();
-	unsigned int cubemapTexture = gTexture.loadSkyBox();
+	// Register textures; they show a placeholder until the scene near the camera needs them and textureLoader uploads them
+	TextureLoader textureLoader(jobSystem, stateCache);
+	ResourceManager resourceManager(textureLoader, vramBudget);
+	resourceManager.addPinnedBytes(gMesh.getBufferBytes());
+	gTexture.createTextures(resourceManager);
+	unsigned int cubemapTexture = gTexture.loadSkyBox(textureLoader);
+	// The instanced draws read the item textures from its layers instead of binding each texture set
+	TextureArray textureArray(stateCache);
+
 
+	// Shared by every scene object
+	ResourceRegistry resources(gMesh, gTexture, lightingShader);
 
+	// A scene file holds every item, so the built-in root table is only added to the built-in layout
 	Transform transformData;
-	Table* rootItem = new Table(glm::vec3(0.0f, 0.0f, 0.0f), transformData, gMesh, gTexture, lightingShader, camera);
-	SceneManagerBSP sceneManagerBSP(rootItem, gMesh, gTexture, lightCubeShader, lightingShader, camera, deltaTime);
-	sceneManagerBSP.initializeScene();
+	SceneManagerBSP sceneManagerBSP(nullptr, resources, lightCubeShader, lightingShader, instancedShader, fireflyShader, fireflyUpdateShader, depthShader, depthInstancedShader, camera, deltaTime, stateCache, jobSystem);
+	const double sceneStart = glfwGetTime();
+	if (sceneFile.empty() || !sceneManagerBSP.loadScene(sceneFile.c_str())) {
+		SceneScale sceneScale;
+		if (benchmark || !saveSceneFile.empty()) {
+			sceneScale.tableCopies = benchmarkSettings.tableCopies;
+			sceneScale.fireflyCount = benchmarkSettings.fireflyCount;
+			sceneScale.fireflySeed = benchmarkSettings.seed;
+		}
+		sceneManagerBSP.addObject(new Table(glm::vec3(0.0f, 0.0f, 0.0f), transformData, resources, camera));
+		sceneManagerBSP.initializeScene(sceneScale);
+	}
+	std::cout << "Scene created in " << (glfwGetTime() - sceneStart) * 1000.0 << " ms" << std::endl;
+	if (!saveSceneFile.empty()) {
+		bool saved = sceneManagerBSP.saveScene(saveSceneFile.c_str());
+		sceneManagerBSP.destroyBuffers();
+		gMesh.destroyMeshes();
+		textureLoader.destroy();
+		resourceManager.destroy();
+		textureArray.destroy();
+		gTexture.destroyTextures();
+		glDeleteTextures(1, &cubemapTexture);
+		ProgramCache::save();
+		glfwTerminate();
+		return saved ? 0 : -1;
+	}
+	sceneManagerBSP.setTextureArray(&textureArray);
+	sceneManagerBSP.setResourceManager(&resourceManager);
+
+	// The camera slides along the submeshes it walks into
+	camera.ResolveMove = [&sceneManagerBSP](const glm::vec3& position, const glm::vec3& motion) {
+		return cameraCollision ? sceneManagerBSP.slideSphere(position, CAMERA_RADIUS, motion) : position + motion;
+	};
+
+	// Times the passes of each frame; its summary is shown in the window title
+	Profiler profiler;
+	sceneManagerBSP.setProfiler(&profiler);
+	double lastTitleUpdate = 0.0;
+
+	// Camera moves recorded for --record-path
+	CameraPath recordedPath;
+	float recordStart = static_cast<float>(glfwGetTime());
 
 
 	// shader configuration
 	// --------------------
-	lightingShader.use();
-	lightingShader.setInt("material.diffuse", 0);
-	lightingShader.setInt("material.specular", 1);
-	lightingShader.setInt("textureOverlay", 2);
+	// Sampler units and uniform blocks of the scene shaders, also applied to each variant as it is compiled.
+	// The variants are compiled in the middle of a frame, so the program is bound through the state cache.
+	const std::function<void(Shader&)> configureSceneShader = [](Shader& shader) {
+		stateCache.useProgram(shader.ID);
+		shader.setInt("material.diffuse", 0);
+		shader.setInt("material.specular", 1);
+		shader.setInt("textureOverlay", 2);
+		shader.setInt("pointLightData", LightGrid::LIGHT_DATA_UNIT);
+		shader.setInt("lightClusters", LightGrid::CLUSTER_UNIT);
+		shader.setInt("lightIndices", LightGrid::LIGHT_INDEX_UNIT);
+		shader.setInt("cascadeShadowMap", ShadowMaps::CASCADE_UNIT);
+		shader.setInt("spotShadowMap", ShadowMaps::SPOT_UNIT);
+		shader.setInt("textureLayers", TextureArray::TEXTURE_UNIT);
+		shader.setInt("materialIndex", MaterialTable::NO_MATERIAL);
+		shader.bindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+		shader.bindUniformBlock("Lights", LIGHTS_BLOCK_BINDING);
+		shader.bindUniformBlock("Shadows", SHADOWS_BLOCK_BINDING);
+		shader.bindUniformBlock("Materials", MATERIALS_BLOCK_BINDING);
+	};
+	configureSceneShader(lightingShader);
+	configureSceneShader(instancedShader);
+	configureSceneShader(fireflyShader);
+
+	// Specialized lighting programs leave out the lights that are off and the overlay of the draws without one.
+	// The G-buffer shader has no such switches, so in deferred mode every draw keeps the full program.
+	const unsigned int variantFeatures = useShaderVariants && !useDeferred ? ShaderVariants::ALL_FEATURES : 0;
+	ShaderVariants lightingVariants(lightingShader, "../OpenGLSample/shaderfiles/6.multiple_lights.vs", sceneFragmentShader.c_str(), variantFeatures, configureSceneShader);
+	ShaderVariants instancedVariants(instancedShader, "../OpenGLSample/shaderfiles/6.multiple_lights_instanced.vs", sceneFragmentShader.c_str(), variantFeatures, configureSceneShader);
+	if (variantFeatures != 0) {
+		sceneManagerBSP.setShaderVariants(&lightingVariants, &instancedVariants);
+	}
+
+	// Camera and light uniforms are shared through uniform buffers
+	UniformBuffer cameraBuffer;
+	UniformBuffer lightsBuffer;
+	cameraBuffer.create(sizeof(CameraBlock), CAMERA_BLOCK_BINDING);
+	lightsBuffer.create(sizeof(LightsBlock), LIGHTS_BLOCK_BINDING);
+	lightCubeShader.bindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+	depthShader.bindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+	depthInstancedShader.bindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+
+	// The directional and spot lights cast shadows; static casters are cached between frames
+	ShadowMaps shadowMaps;
+
+	// Everything rewritten every frame goes through one fenced ring, so no upload waits on the GPU
+	StreamBuffer streamBuffer;
+	if (useStreamBuffer) {
+		streamBuffer.create(StreamBuffer::DEFAULT_FRAME_SIZE, (GLADloadproc)glfwGetProcAddress);
+		cameraBuffer.setStreamBuffer(&streamBuffer);
+		lightsBuffer.setStreamBuffer(&streamBuffer);
+		shadowMaps.setStreamBuffer(&streamBuffer);
+		sceneManagerBSP.setStreamBuffer(&streamBuffer);
+	}
+
+	// Scratch memory of the frame, taken back after the swap, and the allocation totals at the frame's start
+	FrameArena frameArena;
+	sceneManagerBSP.setFrameArena(&frameArena);
+	AllocationTracker::Totals frameStartAllocations = AllocationTracker::getTotals();
+
+	// Point lights are sorted into clusters every frame and read from buffer textures
+	LightGrid lightGrid;
+	lightGrid.create();
+	std::vector<PointLightBlock> pointLights;
+
+	std::unique_ptr<DeferredRenderer> deferredRenderer;
+	if (useDeferred) {
+		int framebufferWidth, framebufferHeight;
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		deferredRenderer.reset(new DeferredRenderer(framebufferWidth, framebufferHeight, stateCache));
+	}
+
+	// Below the full resolution the frame is drawn offscreen and upscaled to the window
+	int windowWidth, windowHeight;
+	glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
+	ScaledRenderTarget scaledTarget(windowWidth, windowHeight, stateCache);
+	size_t lastResolvedFrame = 0;
+	// A benchmark measures the scene at the window's resolution, so runs stay comparable
+	if (benchmark) {
+		dynamicResolution.setEnabled(false);
+	}
 
 	// light configuration
 	// --------------------
-	DirectLight* directLight = new DirectLight("../OpenGLSample/resources/lightsConfig.ini");
-	PointLight* pointLight1 = new PointLight("../OpenGLSample/resources/lightsConfig.ini", "PointLight1");
-	PointLight* pointLight2 = new PointLight("../OpenGLSample/resources/lightsConfig.ini", "PointLight2");
-	SpotLight* spotLight = new SpotLight("../OpenGLSample/resources/lightsConfig.ini", camera);
-
+	// The lights are owned by lightManager and reached through their handles; the file is parsed once into lightConfig
+	LightConfig lightConfig(LIGHT_CONFIG_PATH);
 	LightManager lightManager;
-	lightManager.addLight(directLight);
-	lightManager.addLight(pointLight1);
-	lightManager.addLight(pointLight2);
-	lightManager.addLight(spotLight);	
+	lightConfig.load();
+	lightManager.applyConfig(lightConfig, camera);
+	LightHandle<DirectLight> directLight = lightManager.findLight<DirectLight>("DirectLight");
+	LightHandle<SpotLight> spotLight = lightManager.findLight<SpotLight>("SpotLight");
+	pointLight1 = lightManager.findLight<PointLight>("PointLight1");
+	pointLight2 = lightManager.findLight<PointLight>("PointLight2");
+	if (!directLight.isValid() || !spotLight.isValid()) {
+		std::cout << "ERROR::LIGHTCONFIG::MISSING_LIGHT " << LIGHT_CONFIG_PATH << " needs a [DirectLight] and a [SpotLight]" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	double lastLightConfigCheck = glfwGetTime();
 
 
 	// render loop
@@ -200,127 +533,335 @@ int main()
 		float currentFrame = glfwGetTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
+		if (benchmark) {
+			// The fixed step makes the run the same whatever the frame rate
+			deltaTime = Benchmark::TIME_STEP;
+			if (!benchmark->beginFrame(camera, profiler, textureLoader.getPendingCount())) {
+				break;
+			}
+		}
+		lodBudget.update(deltaTime);
+		profiler.beginFrame();
+		// Each GPU time is fed once, when a frame has been resolved
+		if (profiler.getResolvedFrameCount() != lastResolvedFrame) {
+			lastResolvedFrame = profiler.getResolvedFrameCount();
+			dynamicResolution.update(profiler.getLastGpuFrameMs());
+		}
 
 		// input
 		// -----
-		processInput(window, lightManager);
+		if (!benchmark) {
+			processInput(window, lightManager);
+		}
+		// Edits to the light file show up while the program runs; benchmarks keep the lights they started with
+		if (!benchmark && currentFrame - lastLightConfigCheck >= LIGHT_CONFIG_CHECK_SECONDS) {
+			lastLightConfigCheck = currentFrame;
+			if (lightConfig.reloadIfChanged()) {
+				lightManager.applyConfig(lightConfig, camera);
+				pointLight1 = lightManager.findLight<PointLight>("PointLight1");
+				pointLight2 = lightManager.findLight<PointLight>("PointLight2");
+				std::cout << "Lights reloaded: " << lightConfig.getLights().size() << " lights" << std::endl;
+			}
+		}
+		if (!recordPathFile.empty()) {
+			recordedPath.addKey(currentFrame - recordStart, camera);
+		}
+		if (toggleCapture) {
+			if (profiler.isCapturing()) {
+				profiler.stopCapture(TRACE_PATH);
+			}
+			else {
+				profiler.startCapture();
+			}
+			toggleCapture = false;
+		}
+
+		// counters cover one frame
+		stateCache.resetStats();
+
+		// Replace the placeholders of the textures decoded since the last frame, then evict down to the budget
+		{
+			GpuProfileZone zone(&profiler, "Texture uploads");
+			textureLoader.update();
+			resourceManager.setArrayBytes(textureArray.getBytes());
+			resourceManager.update();
+			textureArray.update(textureLoader.getUploads(), resourceManager.getEvictions(), stateCache);
+		}
 
 		// render
 		// ------
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// Scene objects are drawn into the G-buffer, and lit after submitFrame
+		int viewportWidth, viewportHeight;
+		glfwGetFramebufferSize(window, &viewportWidth, &viewportHeight);
+		if (deferredRenderer) {
+			deferredRenderer->resize(viewportWidth, viewportHeight, stateCache);
+		}
+		const bool scaleResolution = dynamicResolution.getScale() < 1.0f;
+		scaledTarget.update(viewportWidth, viewportHeight, dynamicResolution.getScale(), stateCache);
+		const int renderWidth = scaleResolution ? scaledTarget.getRenderWidth() : viewportWidth;
+		const int renderHeight = scaleResolution ? scaledTarget.getRenderHeight() : viewportHeight;
+
+
+		// Scene objects use the instanced variant of the lighting shader when instancing is on
+		Shader& sceneShader = useInstancing ? instancedShader : lightingShader;
 
 		// be sure to activate shader when setting uniforms/drawing objects
-		lightingShader.use();
-		lightingShader.setVec3("viewPos", camera.Position);
+		stateCache.useProgram(sceneShader.ID);
 
 		// default shininess, rough materials
-		lightingShader.setFloat("material.shininess", 2.0f);
+		sceneShader.setFloat("material.shininess", 2.0f);
 
 		// set default texture scale
 		glm::vec2 gUVScale(1.0f, 1.0f);
-		lightingShader.setVec2("uvScale", gUVScale);
+		sceneShader.setVec2("uvScale", gUVScale);
 
 
 		// Update the spotLight position and direction based on the camera's current state
-		spotLight->updateWithCamera(camera);
+		lightManager.get(spotLight)->updateWithCamera(camera);
 		// Toggle the flashlight mode of the spotLight based on the value of showFlashlight
-		spotLight->toggleFlashlight(showFlashlight);
-		// Pass all the lights managed by lightManager to the lightingShader
-		lightManager.setLightsToShader(lightingShader);
+		lightManager.get(spotLight)->toggleFlashlight(showFlashlight);
 
 
 		// View/projection transformations
 		glm::mat4 projection;
 		if (showPerspective) {
-			projection = glm::perspective(glm::radians(60.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+			projection = glm::perspective(glm::radians(FIELD_OF_VIEW), (float)SCR_WIDTH / (float)SCR_HEIGHT, NEAR_PLANE, FAR_PLANE);
 		}
 		else {
-			projection = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 100.0f);
+			projection = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, NEAR_PLANE, FAR_PLANE);
 		}
 		glm::mat4 view = camera.GetViewMatrix();
-		lightingShader.setMat4("projection", projection);
-		lightingShader.setMat4("view", view);
+
+		// This frame's uploads go into the ring region the GPU finished reading
+		streamBuffer.beginFrame();
+
+		// Sort the point lights into the clusters of this view, then pass all the lights managed
+		// by lightManager to the Lights uniform buffer
+		{
+			ProfileZone zone(&profiler, "Light uploads");
+			pointLights.clear();
+			lightManager.writePointLights(pointLights);
+			lightGrid.build(pointLights, view, projection, NEAR_PLANE, FAR_PLANE, renderWidth, renderHeight);
+			lightGrid.upload(stateCache);
+			lightManager.setLightsToBuffer(lightsBuffer, lightGrid);
+			lightsBuffer.refresh();
+		}
+
+		// Culling, level of detail and firefly movement run on workers while this frame is drawn
+		FrameInput frameInput;
+		frameInput.viewProjection = projection * view;
+		frameInput.lodView.viewPosition = camera.Position;
+		frameInput.lodView.projectionScale = projection[1][1];
+		frameInput.lodView.perspective = showPerspective;
+		frameInput.lodView.bias = std::max(lodBudget.getBias(), dynamicResolution.getLodBias());
+		frameInput.deltaTime = deltaTime;
+		frameInput.checkFrustum = checkFrustum;
+		frameInput.useInstancing = useInstancing;
+		frameInput.useIndirect = useIndirect;
+		frameInput.gpuParticles = gpuParticles;
+		frameInput.depthPrepass = depthPrepass;
+		frameInput.useTextureArray = useTextureArray;
+		frameInput.occlusionCulling = occlusionCulling;
+		{
+			ProfileZone zone(&profiler, "Begin scene frame");
+			sceneManagerBSP.beginFrame(frameInput, pipelineFrames);
+		}
+
+		// Shadow views go through the Camera block, so they are drawn before its upload for the frame
+		{
+			GpuProfileZone zone(&profiler, "Shadows");
+			shadowMaps.update(camera, glm::radians(FIELD_OF_VIEW), (float)SCR_WIDTH / (float)SCR_HEIGHT, NEAR_PLANE, lightManager.get(directLight)->direction,
+				lightManager.get(spotLight)->position, lightManager.get(spotLight)->direction, lightManager.get(spotLight)->outerCutOff, showFlashlight, sceneManagerBSP.getStaticRevision());
+			sceneManagerBSP.renderShadows(shadowMaps, cameraBuffer);
+		}
+		if (scaleResolution) {
+			scaledTarget.bind();
+		}
+		if (deferredRenderer) {
+			deferredRenderer->beginGeometryPass(renderWidth, renderHeight);
+		}
+
+		// One upload serves every shader that declares the Camera block
+		CameraBlock cameraBlock = {};
+		cameraBlock.projection = projection;
+		cameraBlock.view = view;
+		cameraBlock.viewPos = camera.Position;
+		cameraBuffer.update(&cameraBlock);
 
 		// World transformation
 		glm::mat4 model = glm::mat4(1.0f);
-		lightingShader.setMat4("model", model);
+		sceneShader.setMat4("model", model);
+
 
 
+		// Draw scene objects and environment
+		stateCache.useProgram(sceneShader.ID);
+
+		// World transformation
+		model = glm::mat4(1.0f);
+		sceneShader.setMat4("model", model);
 
-		// Draw the lamp object(s)
-		lightCubeShader.use();
+		// Only the lights that add light this frame are computed; the overlay is chosen per draw
+		unsigned int shaderFeatures = ShaderVariants::OVERLAY;
+		if (lightManager.get(spotLight)->isLit()) {
+			shaderFeatures |= ShaderVariants::SPOT_LIGHT;
+		}
+		if (!pointLights.empty()) {
+			shaderFeatures |= ShaderVariants::POINT_LIGHTS;
+		}
+		sceneManagerBSP.submitFrame(shaderFeatures);
+
+		if (deferredRenderer) {
+			GpuProfileZone zone(&profiler, "Deferred lighting");
+			deferredRenderer->renderLighting(pointLights, gMesh.gSphereMesh, projection * view, camera.Position, NEAR_PLANE, stateCache,
+				scaleResolution ? scaledTarget.getFramebuffer() : 0);
+		}
+
+		// Draw the lamp object(s), after the scene so that in deferred mode they are drawn into the lit image
+		stateCache.useProgram(lightCubeShader.ID);
 		lightCubeShader.setVec4("lightColor", 1.0f, 1.0f, 1.0f, 1.0f);
 
-		lightCubeShader.setMat4("projection", projection);
-		lightCubeShader.setMat4("view", view);
 		// Draw as many light bulbs as we have point lights.
-		glBindVertexArray(gMesh.gCubeMesh.vao);
+		stateCache.bindVertexArray(gMesh.gCubeMesh.vao);
 
-		PointLight* pointLight;
-		for (unsigned int i = 0; i < 2; i++)
+		for (const PointLightBlock& pointLight : pointLights)
 		{
 			model = glm::mat4(1.0f);
-			pointLight = i ? pointLight1 : pointLight2;
-			model = glm::translate(model, pointLight->position);
+			model = glm::translate(model, pointLight.position);
 			model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller cube
 			lightCubeShader.setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
+			glDrawElementsBaseVertex(GL_TRIANGLES, gMesh.gCubeMesh.nIndices, GL_UNSIGNED_SHORT, gMesh.gCubeMesh.getIndexOffset(), gMesh.gCubeMesh.baseVertex);
 		}
 
-		// Deactivate the Vertex Array Object
-		glBindVertexArray(0);
-
-		// Draw scene objects and environment
-		lightingShader.use();
-		lightingShader.setMat4("projection", projection);
-		lightingShader.setMat4("view", view);
-
-		// World transformation
-		model = glm::mat4(1.0f);
-		lightingShader.setMat4("model", model);
-
-		sceneManagerBSP.renderScene(checkFrustum);
-
 		// Display skybox
 		if (showSkybox) {
+			GpuProfileZone zone(&profiler, "Skybox");
 			glDepthFunc(GL_LEQUAL);
-			skyboxShader.use();
+			stateCache.useProgram(skyboxShader.ID);
 
 			view = glm::mat4(glm::mat3(camera.GetViewMatrix()));
 			view = glm::rotate(view, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 			skyboxShader.setMat4("projection", projection);
 			skyboxShader.setMat4("view", view);
-			glBindVertexArray(gMesh.gSkyboxMesh.vao);
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+			stateCache.bindVertexArray(gMesh.gSkyboxMesh.vao);
+			stateCache.bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
 			model = glm::mat4(1.0f);
 			skyboxShader.setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, gMesh.gSkyboxMesh.nVertices);
+			glDrawElementsBaseVertex(GL_TRIANGLES, gMesh.gSkyboxMesh.nIndices, GL_UNSIGNED_SHORT, gMesh.gSkyboxMesh.getIndexOffset(), gMesh.gSkyboxMesh.baseVertex);
 			glDepthFunc(GL_LESS);
-			glBindVertexArray(0);
 		}
 
+		if (scaleResolution) {
+			GpuProfileZone zone(&profiler, "Upscale");
+			scaledTarget.resolve(stateCache);
+		}
+
+		// State changes are the binds the cache let through to the driver
+		const GLStateCache::Stats& bindStats = stateCache.getStats();
+		Profiler::Counters counters;
+		counters.drawCalls = sceneManagerBSP.getDrawCallCount();
+		counters.triangles = sceneManagerBSP.getTriangleCount();
+		counters.stateChanges = bindStats.programBinds + bindStats.vertexArrayBinds + bindStats.textureBinds;
+		counters.visibleItems = sceneManagerBSP.getVisibleItemCount();
+		if (currentFrame - lastTitleUpdate >= TITLE_INTERVAL) {
+			char title[256];
+			const int titleLength = std::snprintf(title, sizeof(title), "%s - ", WINDOW_TITLE);
+			profiler.getSummary(title + titleLength, sizeof(title) - titleLength);
+			glfwSetWindowTitle(window, title);
+			lastTitleUpdate = currentFrame;
+		}
+
+		if (printStats) {
+			profiler.printReport();
+			stateCache.printStats();
+			std::cout << "LOD bias: " << lodBudget.getBias() << (lodBudget.isEnabled() ? " (frame budget on)" : " (frame budget off)") << std::endl;
+			std::cout << "Render scale: " << dynamicResolution.getScale() << " (" << renderWidth << "x" << renderHeight << ", LOD bias "
+				<< dynamicResolution.getLodBias() << (dynamicResolution.isEnabled() ? ", dynamic resolution on)" : ", dynamic resolution off)") << std::endl;
+			sceneManagerBSP.printVisibilityStats();
+			resourceManager.printStats();
+			std::cout << "Textures: " << textureLoader.getPendingCount() << " still loading, " << textureArray.getLayerCount() << " array layers" << (useTextureArray ? "" : " (array off)") << std::endl;
+			if (useStreamBuffer) {
+				streamBuffer.printStats();
+			}
+			std::cout << "Lights block: " << lightManager.getUploadedBytes() << " of " << sizeof(LightsBlock) << " bytes uploaded" << std::endl;
+			std::cout << "Frame arena: " << frameArena.getPeakBytes() / 1024 << " of " << frameArena.getCapacity() / 1024 << " KB at the peak, "
+				<< frameArena.getOverflowCount() << " frames overflowed" << std::endl;
+			std::cout << "Light grid: " << pointLights.size() << " point lights, " << lightGrid.getIndexCount() << " cluster entries" << std::endl;
+			std::cout << "Shadow maps: " << shadowMaps.getStaticPassCount() << " of " << ShadowMaps::VIEW_COUNT << " static caches re-rendered" << std::endl;
+			if (deferredRenderer) {
+				std::cout << "Deferred: " << deferredRenderer->getVolumeCount() << " of " << pointLights.size() << " point lights drawn as volumes" << std::endl;
+			}
+			printStats = false;
+		}
+
+
+		// Every draw reading this frame's region has been issued
+		streamBuffer.endFrame();
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
-		glfwSwapBuffers(window);
+		{
+			ProfileZone zone(&profiler, "Swap buffers");
+			glfwSwapBuffers(window);
+		}
+		// A frame's allocations run from the last endFrame to this one, on every thread
+		const AllocationTracker::Totals allocations = AllocationTracker::getTotals();
+		counters.allocations = allocations.allocations - frameStartAllocations.allocations;
+		counters.allocatedBytes = allocations.bytes - frameStartAllocations.bytes;
+		frameStartAllocations = allocations;
+		profiler.endFrame(counters);
+		frameArena.reset();
 		glfwPollEvents();
 	}
 
 
+	if (benchmark) {
+		benchmark->finish(profiler, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	}
+	if (!recordPathFile.empty()) {
+		recordedPath.save(recordPathFile.c_str());
+	}
+
+
 	// De-allocate all resources once they've outlived their purpose:
 	// ------------------------------------------------------------------------
 	
 	// Release meshes data
+	camera.ResolveMove = nullptr;
 	gMesh.destroyMeshes();
+	sceneManagerBSP.destroyBuffers();
+	lightingVariants.destroy();
+	instancedVariants.destroy();
 
 	// Release textures
+	textureLoader.destroy();
+	resourceManager.destroy();
+	textureArray.destroy();
 	gTexture.destroyTextures();
 	glDeleteTextures(1, &cubemapTexture);
 
+	// Release uniform buffers
+	cameraBuffer.destroy();
+	lightsBuffer.destroy();
+	lightGrid.destroy();
+	shadowMaps.destroy();
+	streamBuffer.destroy();
+	scaledTarget.destroy();
+	if (deferredRenderer) {
+		deferredRenderer->destroy();
+	}
+
 	lightManager.clearLights();
+	if (profiler.isCapturing()) {
+		profiler.stopCapture(TRACE_PATH);
+	}
+	profiler.destroy();
+
+	// Keep the binaries of the programs compiled this run
+	ProgramCache::save();
 
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
@@ -331,7 +872,7 @@ int main()
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
-void processInput(GLFWwindow* window, LightManager lightManager)
+void processInput(GLFWwindow* window, LightManager& lightManager)
 {
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, true);
@@ -385,29 +926,69 @@ void toggleEvent(GLFWwindow* window, int key, int scancode, int action, int mods
 	if (key == GLFW_KEY_V && action == GLFW_PRESS) {
 		checkFrustum = !checkFrustum;
 	}
+	if (key == GLFW_KEY_N && action == GLFW_PRESS) {
+		useInstancing = !useInstancing;
+	}
+	if (key == GLFW_KEY_X && action == GLFW_PRESS) {
+		useIndirect = !useIndirect;
+	}
+	if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+		gpuParticles = !gpuParticles;
+	}
+	if (key == GLFW_KEY_T && action == GLFW_PRESS) {
+		lodBudget.setEnabled(!lodBudget.isEnabled());
+	}
+	if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+		pipelineFrames = !pipelineFrames;
+	}
+	if (key == GLFW_KEY_Z && action == GLFW_PRESS) {
+		depthPrepass = !depthPrepass;
+	}
+	if (key == GLFW_KEY_Y && action == GLFW_PRESS) {
+		useTextureArray = !useTextureArray;
+	}
+	if (key == GLFW_KEY_3 && action == GLFW_PRESS) {
+		occlusionCulling = !occlusionCulling;
+	}
+	if (key == GLFW_KEY_4 && action == GLFW_PRESS) {
+		cameraCollision = !cameraCollision;
+	}
+	if (key == GLFW_KEY_5 && action == GLFW_PRESS) {
+		dynamicResolution.setEnabled(!dynamicResolution.isEnabled());
+	}
+	if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+		printStats = true;
+	}
+	if (key == GLFW_KEY_H && action == GLFW_PRESS) {
+		toggleCapture = true;
+	}
 	if (key == GLFW_KEY_R && action == GLFW_PRESS) {
 		camera.InvertFront();
 	}
 }
 
 // Processes input received from any keyboard-like input system.
-void moveLight(string direction, float time, LightManager lightManager)
+void moveLight(string direction, float time, LightManager& lightManager)
 {
-	glm::vec3& light = (lightNumber == 1) ? dynamic_cast<PointLight*>(lightManager.lights[1])->position : dynamic_cast<PointLight*>(lightManager.lights[2])->position;
+	PointLight* light = lightManager.get(lightNumber == 1 ? pointLight1 : pointLight2);
+	if (light == nullptr)
+		return;
 
+	glm::vec3 offset(0.0f);
 	float speed = 1.0f * time;
 	if (direction == "forward")
-		light.z -= speed; // Move forward
+		offset.z -= speed; // Move forward
 	if (direction == "backward")
-		light.z += speed; // Move backward
+		offset.z += speed; // Move backward
 	if (direction == "left")
-		light.x -= speed; // Move left
+		offset.x -= speed; // Move left
 	if (direction == "right")
-		light.x += speed; // Move right
+		offset.x += speed; // Move right
 	if (direction == "down")
-		light.y -= speed; // Move down
+		offset.y -= speed; // Move down
 	if (direction == "up")
-		light.y += speed; // Move up
+		offset.y += speed; // Move up
+	light->translate(offset);
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
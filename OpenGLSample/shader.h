@@ -13,18 +13,26 @@
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <memory>
+#include <map>
+#include <vector>
+
+#include "ProgramCache.h"
 
 class Shader
 {
 public:
 	unsigned int ID;
-	// constructor generates the shader on the fly
+	// constructor generates the shader on the fly; defines are #define lines inserted after the
+	// #version line of every stage, to compile a specialized variant of the same files
 	// ------------------------------------------------------------------------
-	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, const std::string& defines = std::string())
 	{
 		// 1. retrieve the vertex/fragment source code from filePath
 		std::string vertexCode;
@@ -66,9 +74,24 @@ public:
 		{
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << e.what() << std::endl;
 		}
+		if (!defines.empty())
+		{
+			insertDefines(vertexCode, defines);
+			insertDefines(fragmentCode, defines);
+			if (geometryPath != nullptr)
+				insertDefines(geometryCode, defines);
+		}
+		// 2. link the program from its cached binary when the sources and driver are unchanged
+		ID = glCreateProgram();
+		const uint64_t cacheKey = ProgramCache::makeKey({ vertexCode, fragmentCode, geometryCode });
+		if (ProgramCache::load(cacheKey, ID))
+		{
+			cacheUniformLocations();
+			return;
+		}
 		const char* vShaderCode = vertexCode.c_str();
 		const char * fShaderCode = fragmentCode.c_str();
-		// 2. compile shaders
+		// 3. compile shaders
 		unsigned int vertex, fragment;
 		// vertex shader
 		vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -91,19 +114,72 @@ public:
 			checkCompileErrors(geometry, "GEOMETRY");
 		}
 		// shader Program
-		ID = glCreateProgram();
 		glAttachShader(ID, vertex);
 		glAttachShader(ID, fragment);
 		if (geometryPath != nullptr)
 			glAttachShader(ID, geometry);
+		ProgramCache::prepare(ID);
 		glLinkProgram(ID);
 		checkCompileErrors(ID, "PROGRAM");
+		ProgramCache::store(cacheKey, ID);
 		// delete the shaders as they're linked into our program now and no longer necessery
 		glDeleteShader(vertex);
 		glDeleteShader(fragment);
 		if (geometryPath != nullptr)
 			glDeleteShader(geometry);
+		// resolve every uniform location once, now that the program is linked
+		cacheUniformLocations();
 
+	}
+	// constructor for a vertex-only program whose outputs are captured with transform feedback
+	// ------------------------------------------------------------------------
+	Shader(const char* vertexPath, const std::vector<const char*>& feedbackVaryings)
+	{
+		std::string vertexCode;
+		std::ifstream vShaderFile;
+		vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+		try
+		{
+			vShaderFile.open(vertexPath);
+			std::stringstream vShaderStream;
+			vShaderStream << vShaderFile.rdbuf();
+			vShaderFile.close();
+			vertexCode = vShaderStream.str();
+		}
+		catch (std::ifstream::failure& e)
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << e.what() << std::endl;
+		}
+		// the captured outputs are part of the binary, so they are part of its key
+		std::vector<std::string> cacheSources(1, vertexCode);
+		for (const char* varying : feedbackVaryings)
+			cacheSources.push_back(varying);
+		ID = glCreateProgram();
+		const uint64_t cacheKey = ProgramCache::makeKey(cacheSources);
+		if (ProgramCache::load(cacheKey, ID))
+		{
+			cacheUniformLocations();
+			return;
+		}
+		const char* vShaderCode = vertexCode.c_str();
+		unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(vertex, 1, &vShaderCode, NULL);
+		glCompileShader(vertex);
+		checkCompileErrors(vertex, "VERTEX");
+		glAttachShader(ID, vertex);
+		// the captured outputs must be named before linking; they are written back to back into one buffer
+		glTransformFeedbackVaryings(ID, (GLsizei)feedbackVaryings.size(), feedbackVaryings.data(), GL_INTERLEAVED_ATTRIBS);
+		ProgramCache::prepare(ID);
+		glLinkProgram(ID);
+		checkCompileErrors(ID, "PROGRAM");
+		ProgramCache::store(cacheKey, ID);
+		glDeleteShader(vertex);
+		cacheUniformLocations();
+	}
+	// constructor for a placeholder without a program, for code that holds a shader but never draws
+	// ------------------------------------------------------------------------
+	Shader() : ID(0), uniformLocations(std::make_shared<UniformTable>())
+	{
 	}
 	// activate the shader
 	// ------------------------------------------------------------------------
@@ -111,66 +187,227 @@ public:
 	{
 		glUseProgram(ID);
 	}
+	// uniform locations
+	// ------------------------------------------------------------------------
+	// Returns the cached location of a uniform, or -1 if the program does not use it.
+	// Resolve handles for per-draw uniforms once and pass them to the setters below.
+	// The table is searched with the name as given, so a string literal costs no std::string.
+	GLint getUniformLocation(const char* name) const
+	{
+		UniformTable::const_iterator it = std::lower_bound(uniformLocations->begin(), uniformLocations->end(), name,
+			[](const UniformTable::value_type& entry, const char* key) { return std::strcmp(entry.first.c_str(), key) < 0; });
+		return it != uniformLocations->end() && it->first == name ? it->second : -1;
+	}
+	GLint getUniformLocation(const std::string &name) const
+	{
+		return getUniformLocation(name.c_str());
+	}
+	// ------------------------------------------------------------------------
+	// Connects a uniform block of the program to a binding point.
+	void bindUniformBlock(const char* blockName, GLuint binding) const
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(ID, blockName);
+		if (blockIndex != GL_INVALID_INDEX)
+			glUniformBlockBinding(ID, blockIndex, binding);
+	}
 	// utility uniform functions
 	// ------------------------------------------------------------------------
+	void setBool(const char* name, bool value) const
+	{
+		setBool(getUniformLocation(name), value);
+	}
 	void setBool(const std::string &name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		setBool(name.c_str(), value);
+	}
+	void setBool(GLint location, bool value) const
+	{
+		glUniform1i(location, (int)value);
 	}
 	// ------------------------------------------------------------------------
+	void setInt(const char* name, int value) const
+	{
+		setInt(getUniformLocation(name), value);
+	}
 	void setInt(const std::string &name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		setInt(name.c_str(), value);
+	}
+	void setInt(GLint location, int value) const
+	{
+		glUniform1i(location, value);
 	}
 	// ------------------------------------------------------------------------
+	void setFloat(const char* name, float value) const
+	{
+		setFloat(getUniformLocation(name), value);
+	}
 	void setFloat(const std::string &name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		setFloat(name.c_str(), value);
+	}
+	void setFloat(GLint location, float value) const
+	{
+		glUniform1f(location, value);
 	}
 	// ------------------------------------------------------------------------
+	void setVec2(const char* name, const glm::vec2 &value) const
+	{
+		setVec2(getUniformLocation(name), value);
+	}
 	void setVec2(const std::string &name, const glm::vec2 &value) const
 	{
-		glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		setVec2(name.c_str(), value);
+	}
+	void setVec2(GLint location, const glm::vec2 &value) const
+	{
+		glUniform2fv(location, 1, &value[0]);
+	}
+	void setVec2(const char* name, float x, float y) const
+	{
+		glUniform2f(getUniformLocation(name), x, y);
 	}
 	void setVec2(const std::string &name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+		setVec2(name.c_str(), x, y);
 	}
 	// ------------------------------------------------------------------------
+	void setVec3(const char* name, const glm::vec3 &value) const
+	{
+		setVec3(getUniformLocation(name), value);
+	}
 	void setVec3(const std::string &name, const glm::vec3 &value) const
 	{
-		glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		setVec3(name.c_str(), value);
+	}
+	void setVec3(GLint location, const glm::vec3 &value) const
+	{
+		glUniform3fv(location, 1, &value[0]);
+	}
+	void setVec3(const char* name, float x, float y, float z) const
+	{
+		glUniform3f(getUniformLocation(name), x, y, z);
 	}
 	void setVec3(const std::string &name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+		setVec3(name.c_str(), x, y, z);
 	}
 	// ------------------------------------------------------------------------
+	void setVec4(const char* name, const glm::vec4 &value) const
+	{
+		setVec4(getUniformLocation(name), value);
+	}
 	void setVec4(const std::string &name, const glm::vec4 &value) const
 	{
-		glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		setVec4(name.c_str(), value);
+	}
+	void setVec4(GLint location, const glm::vec4 &value) const
+	{
+		glUniform4fv(location, 1, &value[0]);
+	}
+	void setVec4(const char* name, float x, float y, float z, float w)
+	{
+		glUniform4f(getUniformLocation(name), x, y, z, w);
 	}
 	void setVec4(const std::string &name, float x, float y, float z, float w)
 	{
-		glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+		setVec4(name.c_str(), x, y, z, w);
 	}
 	// ------------------------------------------------------------------------
+	void setMat2(const char* name, const glm::mat2 &mat) const
+	{
+		glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
+	}
 	void setMat2(const std::string &name, const glm::mat2 &mat) const
 	{
-		glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		setMat2(name.c_str(), mat);
 	}
 	// ------------------------------------------------------------------------
+	void setMat3(const char* name, const glm::mat3 &mat) const
+	{
+		glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
+	}
 	void setMat3(const std::string &name, const glm::mat3 &mat) const
 	{
-		glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		setMat3(name.c_str(), mat);
 	}
 	// ------------------------------------------------------------------------
+	void setMat4(const char* name, const glm::mat4 &mat) const
+	{
+		setMat4(getUniformLocation(name), mat);
+	}
 	void setMat4(const std::string &name, const glm::mat4 &mat) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		setMat4(name.c_str(), mat);
+	}
+	void setMat4(GLint location, const glm::mat4 &mat) const
+	{
+		glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
 	}
 
 private:
+	// Uniform name to location, sorted by name and shared by every copy of this shader
+	typedef std::vector<std::pair<std::string, GLint>> UniformTable;
+	std::shared_ptr<UniformTable> uniformLocations;
+
+	// queries the locations of all active uniforms after linking
+	// ------------------------------------------------------------------------
+	void cacheUniformLocations()
+	{
+		std::map<std::string, GLint> locations;
+
+		GLint uniformCount = 0;
+		GLint maxNameLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+		std::vector<GLchar> nameBuffer(maxNameLength > 0 ? maxNameLength : 1);
+
+		for (GLint i = 0; i < uniformCount; i++)
+		{
+			GLint size = 0;
+			GLenum type = 0;
+			GLsizei length = 0;
+			glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, &nameBuffer[0]);
+			std::string name(&nameBuffer[0], length);
+
+			// members of uniform blocks have no location
+			GLint location = glGetUniformLocation(ID, name.c_str());
+			if (location < 0)
+				continue;
+			locations[name] = location;
+
+			// arrays of basic types are reported once as "name[0]"; register the base name and every element
+			const std::string arraySuffix = "[0]";
+			if (name.size() > arraySuffix.size() && name.compare(name.size() - arraySuffix.size(), arraySuffix.size(), arraySuffix) == 0)
+			{
+				std::string baseName = name.substr(0, name.size() - arraySuffix.size());
+				locations[baseName] = location;
+				for (GLint element = 1; element < size; element++)
+				{
+					std::string elementName = baseName + "[" + std::to_string(element) + "]";
+					locations[elementName] = glGetUniformLocation(ID, elementName.c_str());
+				}
+			}
+		}
+		uniformLocations = std::make_shared<UniformTable>(locations.begin(), locations.end());
+	}
+
+	// inserts #define lines after the #version line, which must stay the first statement of a GLSL source
+	// ------------------------------------------------------------------------
+	static void insertDefines(std::string& code, const std::string& defines)
+	{
+		size_t position = 0;
+		const size_t version = code.find("#version");
+		if (version != std::string::npos)
+		{
+			const size_t lineEnd = code.find('\n', version);
+			if (lineEnd == std::string::npos)
+				code += '\n';
+			position = lineEnd != std::string::npos ? lineEnd + 1 : code.size();
+		}
+		code.insert(position, defines);
+	}
+
 	// utility function for checking shader compilation/linking errors.
 	// ------------------------------------------------------------------------
 	void checkCompileErrors(GLuint shader, std::string type)
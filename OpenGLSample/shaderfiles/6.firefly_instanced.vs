@@ -0,0 +1,31 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in float aOffsetX; // per-instance position, one array per axis
+layout (location = 4) in float aOffsetY;
+layout (location = 5) in float aOffsetZ;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+flat out int MaterialIndex;       // Entry in the Materials block, or -1 for the material uniforms
+
+uniform float particleScale;
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+void main()
+{
+    FragPos = aPos * particleScale + vec3(aOffsetX, aOffsetY, aOffsetZ);
+    Normal = aNormal;
+    TexCoords = aTexCoords;
+    MaterialIndex = -1;
+    
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
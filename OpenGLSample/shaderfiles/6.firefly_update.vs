@@ -0,0 +1,54 @@
+#version 330 core
+// Moves one firefly per vertex; the outputs are captured with transform feedback
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec3 aSpawn;
+layout (location = 2) in vec2 aMotion; // speed, angle
+layout (location = 3) in uint aSeed;
+
+out vec3 outPosition;
+out vec3 outSpawn;
+out vec2 outMotion;
+flat out uint outSeed;
+
+uniform float deltaTime;
+
+const float PI = 3.14159265;
+const float LEASH_RADIUS = 3.0;
+
+uint seed;
+
+// xorshift32, uniform float in [0, 1)
+float nextRandom()
+{
+    seed ^= seed << 13u;
+    seed ^= seed >> 17u;
+    seed ^= seed << 5u;
+    return float(seed >> 8u) / 16777216.0;
+}
+
+void main()
+{
+    seed = aSeed;
+
+    // Add some randomness to the speed
+    float speed = aMotion.x + nextRandom() * 0.01 - 0.005;
+
+    // Reverse the direction of movement once the firefly strays from its spawn point
+    if (length(aSpawn - aPosition) > LEASH_RADIUS)
+        speed = -speed;
+
+    // Update the angle, with some randomness
+    float angle = aMotion.y + speed * deltaTime + nextRandom() * 0.1 - 0.05;
+    angle = mod(angle + PI, 2.0 * PI) - PI;
+
+    // Calculate the new position
+    float step = speed * deltaTime;
+    vec3 position = aPosition;
+    position.x += step * (sin(angle) + nextRandom() * 0.2 - 0.1);
+    position.y += step * (cos(angle) + nextRandom() * 0.2 - 0.1);
+
+    outPosition = position;
+    outSpawn = aSpawn;
+    outMotion = vec2(speed, angle);
+    outSeed = seed;
+}
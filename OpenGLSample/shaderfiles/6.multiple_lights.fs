@@ -1,12 +1,26 @@
 #version 330 core
 out vec4 FragColor;
 
+// Features of this program; ShaderVariants defines the ones a variant leaves out as 0
+#ifndef SPOT_LIGHT
+#define SPOT_LIGHT 1
+#endif
+#ifndef POINT_LIGHTS
+#define POINT_LIGHTS 1
+#endif
+#ifndef OVERLAY
+#define OVERLAY 1
+#endif
+
 struct Material {
     sampler2D diffuse;
     sampler2D specular;
     float shininess;
 }; 
 
+// Light structs are laid out for std140: every vec3 is followed by a float filling its 16-byte slot.
+// Keep them in sync with the blocks in UniformBuffer.h. Point lights are read from the buffer
+// textures of LightGrid, four texels per light in the same layout.
 struct DirLight {
     vec3 direction;
 	
@@ -17,52 +31,109 @@ struct DirLight {
 
 struct PointLight {
     vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;
-    float intensity;
-
-	
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
+    float intensity;
 };
 
 struct SpotLight {
     vec3 position;
-    vec3 direction;
     float cutOff;
+    vec3 direction;
     float outerCutOff;
-  
+    vec3 ambient;
     float constant;
+    vec3 diffuse;
     float linear;
+    vec3 specular;
     float quadratic;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;       
 };
 
-#define NR_POINT_LIGHTS 2
+// How a fragment finds its cluster in the light grid
+struct LightClusters {
+    uvec3 gridSize;
+    uint pointLightCount;
+    vec2 tileSize;
+    float sliceScale;
+    float sliceBias;
+};
 
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+flat in int MaterialIndex;       // Entry in the Materials block, or -1 for the material uniforms
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+layout (std140) uniform Lights
+{
+    DirLight dirLight;
+    LightClusters clusters;
+    SpotLight spotLight;
+};
+
+// Shadow maps rendered by ShadowMaps every frame; keep in sync with ShadowsBlock in UniformBuffer.h
+layout (std140) uniform Shadows
+{
+    mat4 cascadeViewProjection[3];
+    mat4 spotViewProjection;
+    vec4 cascadeSplits;     // Far view depth of each cascade
+    int spotShadows;        // 0 when the spot light has no shadow map
+};
+
+// Materials of the recorded draws, filled by MaterialTable; keep in sync with MaterialsBlock in UniformBuffer.h
+struct MaterialEntry {
+    vec2 uvScale;
+    float shininess;
+    ivec4 layers;   // Diffuse, specular and overlay layers in the texture array, then the mirrored slots
+};
+
+layout (std140) uniform Materials
+{
+    MaterialEntry materials[256];
+};
 
-uniform vec3 viewPos;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLight;
 uniform Material material;
 uniform vec2 uvScale;
 uniform sampler2D textureOverlay;
+// Material textures are read from their units, or from the layers of TextureArray for instanced draws
+uniform bool useTextureArray;
+uniform sampler2DArray textureLayers;
+
+// The draw's material, read in main from the Materials block or from the material uniforms
+vec2 materialUV;
+float materialShininess;
+ivec4 materialLayers;
+// Texture coordinate derivatives, taken in main because the light loops are not uniform control flow
+vec2 uvGradX;
+vec2 uvGradY;
+
+// Light grid built by LightGrid every frame
+uniform samplerBuffer pointLightData;   // Four texels per point light
+uniform usamplerBuffer lightClusters;   // Offset and count of each cluster's light indices
+uniform usamplerBuffer lightIndices;    // Point light indices of every cluster
+uniform sampler2DArrayShadow cascadeShadowMap; // One layer per cascade
+uniform sampler2DShadow spotShadowMap;
 
 
 // function prototypes
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float shadow);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow);
+PointLight FetchPointLight(int index);
+float CalcDirShadow(vec3 fragPos, vec3 normal);
+float CalcSpotShadow(vec3 fragPos, vec3 normal);
+void LoadMaterial();
+vec4 SampleMaterial(sampler2D map, int slot);
 
 void main()
 {    
@@ -70,7 +141,7 @@ void main()
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(viewPos - FragPos);
     
-    vec4 overlay = texture(textureOverlay, TexCoords * uvScale);
+    LoadMaterial();
 
     // == =====================================================
     // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
@@ -79,12 +150,24 @@ void main()
     // this fragment's final color.
     // == =====================================================
     // phase 1: directional lighting
-    vec3 result = CalcDirLight(dirLight, norm, viewDir);
-    // phase 2: point lights
-    for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+    vec3 result = CalcDirLight(dirLight, norm, viewDir, CalcDirShadow(FragPos, norm));
+#if POINT_LIGHTS
+    // phase 2: point lights, only those listed in this fragment's cluster
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusters.tileSize), clusters.gridSize.xy - 1u);
+    float depth = -(view * vec4(FragPos, 1.0)).z;
+    uint slice = uint(clamp(log(max(depth, 1e-4)) * clusters.sliceScale + clusters.sliceBias, 0.0, float(clusters.gridSize.z - 1u)));
+    int cluster = int(tile.x + clusters.gridSize.x * (tile.y + clusters.gridSize.y * slice));
+    uvec2 range = texelFetch(lightClusters, cluster).rg;
+    for(uint i = 0u; i < range.y; i++)
+        result += CalcPointLight(FetchPointLight(int(texelFetch(lightIndices, int(range.x + i)).r)), norm, FragPos, viewDir);
+#endif
+#if SPOT_LIGHT
     // phase 3: spot light
-    result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir, CalcSpotShadow(FragPos, norm));    
+#endif
+
+#if OVERLAY
+    vec4 overlay = SampleMaterial(textureOverlay, 2);
     vec4 defaultTexture = vec4(0.0, 0.0, 0.0, 1.0);
 
     if (overlay != defaultTexture) {
@@ -94,22 +177,45 @@ void main()
     else {
         FragColor = vec4(result, 1.0);
     }
+#else
+    FragColor = vec4(result, 1.0);
+#endif
 }
 
 // calculates the color when using a directional light.
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float shadow)
 {
     vec3 lightDir = normalize(-light.direction);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), materialShininess);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords * uvScale));
-    return (ambient + diffuse + specular);
+    vec3 ambient = light.ambient * vec3(SampleMaterial(material.diffuse, 0));
+    vec3 diffuse = light.diffuse * diff * vec3(SampleMaterial(material.diffuse, 0));
+    vec3 specular = light.specular * spec * vec3(SampleMaterial(material.specular, 1));
+    return (ambient + shadow * (diffuse + specular));
+}
+
+// reads a point light from the light buffer.
+PointLight FetchPointLight(int index)
+{
+    vec4 texel0 = texelFetch(pointLightData, index * 4);
+    vec4 texel1 = texelFetch(pointLightData, index * 4 + 1);
+    vec4 texel2 = texelFetch(pointLightData, index * 4 + 2);
+    vec4 texel3 = texelFetch(pointLightData, index * 4 + 3);
+
+    PointLight light;
+    light.position = texel0.xyz;
+    light.constant = texel0.w;
+    light.ambient = texel1.xyz;
+    light.linear = texel1.w;
+    light.diffuse = texel2.xyz;
+    light.quadratic = texel2.w;
+    light.specular = texel3.xyz;
+    light.intensity = texel3.w;
+    return light;
 }
 
 // calculates the color when using a point light.
@@ -120,14 +226,14 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), materialShininess);
     // attenuation
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
     // combine results
-    vec3 ambient = light.intensity * light.ambient * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 diffuse = light.intensity * light.diffuse * diff * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 specular = light.intensity * light.specular * spec * vec3(texture(material.specular, TexCoords * uvScale));
+    vec3 ambient = light.intensity * light.ambient * vec3(SampleMaterial(material.diffuse, 0));
+    vec3 diffuse = light.intensity * light.diffuse * diff * vec3(SampleMaterial(material.diffuse, 0));
+    vec3 specular = light.intensity * light.specular * spec * vec3(SampleMaterial(material.specular, 1));
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -135,14 +241,14 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 }
 
 // calculates the color when using a spot light.
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow)
 {
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), materialShininess);
     // attenuation
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
@@ -151,11 +257,67 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords * uvScale));
+    vec3 ambient = light.ambient * vec3(SampleMaterial(material.diffuse, 0));
+    vec3 diffuse = light.diffuse * diff * vec3(SampleMaterial(material.diffuse, 0));
+    vec3 specular = light.specular * spec * vec3(SampleMaterial(material.specular, 1));
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
-    return (ambient + diffuse + specular);
-}
\ No newline at end of file
+    return (ambient + shadow * (diffuse + specular));
+}
+
+// Moves the lookup off the surface along its normal, so that it does not shadow itself
+const float SHADOW_NORMAL_OFFSET = 0.02;
+
+// returns how much of the directional light reaches a fragment, from its cascade.
+float CalcDirShadow(vec3 fragPos, vec3 normal)
+{
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    if (depth > cascadeSplits[2])
+        return 1.0;
+    int cascade = depth > cascadeSplits[0] ? (depth > cascadeSplits[1] ? 2 : 1) : 0;
+    vec4 lightSpace = cascadeViewProjection[cascade] * vec4(fragPos + normal * SHADOW_NORMAL_OFFSET, 1.0);
+    vec3 coords = lightSpace.xyz * 0.5 + 0.5;
+    return texture(cascadeShadowMap, vec4(coords.xy, float(cascade), coords.z));
+}
+
+// returns how much of the spot light reaches a fragment.
+float CalcSpotShadow(vec3 fragPos, vec3 normal)
+{
+    if (spotShadows == 0)
+        return 1.0;
+    vec4 lightSpace = spotViewProjection * vec4(fragPos + normal * SHADOW_NORMAL_OFFSET, 1.0);
+    if (lightSpace.w <= 0.0)
+        return 1.0;
+    vec3 coords = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+    return texture(spotShadowMap, coords);
+}
+
+// Reads the draw's material; draws outside the material table set the material uniforms instead.
+void LoadMaterial()
+{
+    if (MaterialIndex >= 0) {
+        materialUV = TexCoords * materials[MaterialIndex].uvScale;
+        materialShininess = materials[MaterialIndex].shininess;
+        materialLayers = materials[MaterialIndex].layers;
+    }
+    else {
+        materialUV = TexCoords * uvScale;
+        materialShininess = material.shininess;
+        materialLayers = ivec4(0);
+    }
+    uvGradX = dFdx(materialUV);
+    uvGradY = dFdy(materialUV);
+}
+
+// Samples a material slot (0 diffuse, 1 specular, 2 overlay) from its unit or from its layer of the
+// texture array. The array repeats, so the layers of mirrored textures are mirrored here.
+vec4 SampleMaterial(sampler2D map, int slot)
+{
+    if (!useTextureArray)
+        return texture(map, materialUV);
+    vec2 uv = materialUV;
+    if ((materialLayers.w & (1 << slot)) != 0)
+        uv = 1.0 - abs(mod(uv, 2.0) - 1.0);
+    return textureGrad(textureLayers, vec3(uv, float(materialLayers[slot])), uvGradX, uvGradY);
+}
@@ -6,16 +6,26 @@ layout (location = 2) in vec2 aTexCoords;
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+flat out int MaterialIndex;       // Entry in the Materials block, or -1 for the material uniforms
+// The depth pre-pass and the lighting pass must compute the exact same depth for GL_EQUAL
+invariant gl_Position;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform int materialIndex;
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
 
 void main()
 {
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;  
     TexCoords = aTexCoords;
+    MaterialIndex = materialIndex;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aInstanceModel; // occupies locations 3 to 6
+layout (location = 7) in int aMaterial; // per-instance entry in the Materials block
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+flat out int MaterialIndex;       // Entry in the Materials block, or -1 for the material uniforms
+// The depth pre-pass and the lighting pass must compute the exact same depth for GL_EQUAL
+invariant gl_Position;
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+void main()
+{
+    FragPos = vec3(aInstanceModel * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(aInstanceModel))) * aNormal;  
+    TexCoords = aTexCoords;
+    MaterialIndex = aMaterial;
+    
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 330 core
+// Blends the premultiplied overlay textures over the lit scene, as 6.multiple_lights.fs does.
+out vec4 FragColor;
+
+uniform sampler2D gOverlay;
+
+void main()
+{
+    FragColor = texelFetch(gOverlay, ivec2(gl_FragCoord.xy), 0);
+}
@@ -0,0 +1,159 @@
+#version 330 core
+// Writes the directional light and the spot light of every pixel of the G-buffer the scene was drawn to.
+out vec4 FragColor;
+
+// Keep in sync with the blocks in UniformBuffer.h and 6.multiple_lights.fs
+struct DirLight {
+    vec3 direction;
+	
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct SpotLight {
+    vec3 position;
+    float cutOff;
+    vec3 direction;
+    float outerCutOff;
+    vec3 ambient;
+    float constant;
+    vec3 diffuse;
+    float linear;
+    vec3 specular;
+    float quadratic;
+};
+
+struct LightClusters {
+    uvec3 gridSize;
+    uint pointLightCount;
+    vec2 tileSize;
+    float sliceScale;
+    float sliceBias;
+};
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+layout (std140) uniform Lights
+{
+    DirLight dirLight;
+    LightClusters clusters;
+    SpotLight spotLight;
+};
+
+// Shadow maps rendered by ShadowMaps every frame; keep in sync with ShadowsBlock in UniformBuffer.h
+layout (std140) uniform Shadows
+{
+    mat4 cascadeViewProjection[3];
+    mat4 spotViewProjection;
+    vec4 cascadeSplits;     // Far view depth of each cascade
+    int spotShadows;        // 0 when the spot light has no shadow map
+};
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gSpecular;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform sampler2DArrayShadow cascadeShadowMap; // One layer per cascade
+uniform sampler2DShadow spotShadowMap;
+uniform mat4 inverseViewProjection;
+uniform vec2 screenSize;
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, vec3 specularColor, float shininess, float shadow);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, vec3 specularColor, float shininess, float shadow);
+float CalcDirShadow(vec3 fragPos, vec3 normal);
+float CalcSpotShadow(vec3 fragPos, vec3 normal);
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    // Nothing was drawn here
+    if (depth == 1.0)
+        discard;
+
+    vec4 world = inverseViewProjection * vec4(vec3(gl_FragCoord.xy / screenSize, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+    vec4 normalShininess = texelFetch(gNormal, pixel, 0);
+    vec3 albedo = texelFetch(gAlbedo, pixel, 0).rgb;
+    vec3 specularColor = texelFetch(gSpecular, pixel, 0).rgb;
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    vec3 result = CalcDirLight(dirLight, normalShininess.xyz, viewDir, albedo, specularColor, normalShininess.w, CalcDirShadow(fragPos, normalShininess.xyz));
+    result += CalcSpotLight(spotLight, normalShininess.xyz, fragPos, viewDir, albedo, specularColor, normalShininess.w, CalcSpotShadow(fragPos, normalShininess.xyz));
+    FragColor = vec4(result, 1.0);
+}
+
+// calculates the color when using a directional light.
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, vec3 specularColor, float shininess, float shadow)
+{
+    vec3 lightDir = normalize(-light.direction);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    // combine results
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specular * spec * specularColor;
+    return (ambient + shadow * (diffuse + specular));
+}
+
+// calculates the color when using a spot light.
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, vec3 specularColor, float shininess, float shadow)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    // attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    // spotlight intensity
+    float theta = dot(lightDir, normalize(-light.direction)); 
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    // combine results
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specular * spec * specularColor;
+    ambient *= attenuation * intensity;
+    diffuse *= attenuation * intensity;
+    specular *= attenuation * intensity;
+    return (ambient + shadow * (diffuse + specular));
+}
+
+// Moves the lookup off the surface along its normal, so that it does not shadow itself
+const float SHADOW_NORMAL_OFFSET = 0.02;
+
+// returns how much of the directional light reaches a fragment, from its cascade.
+float CalcDirShadow(vec3 fragPos, vec3 normal)
+{
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    if (depth > cascadeSplits[2])
+        return 1.0;
+    int cascade = depth > cascadeSplits[0] ? (depth > cascadeSplits[1] ? 2 : 1) : 0;
+    vec4 lightSpace = cascadeViewProjection[cascade] * vec4(fragPos + normal * SHADOW_NORMAL_OFFSET, 1.0);
+    vec3 coords = lightSpace.xyz * 0.5 + 0.5;
+    return texture(cascadeShadowMap, vec4(coords.xy, float(cascade), coords.z));
+}
+
+// returns how much of the spot light reaches a fragment.
+float CalcSpotShadow(vec3 fragPos, vec3 normal)
+{
+    if (spotShadows == 0)
+        return 1.0;
+    vec4 lightSpace = spotViewProjection * vec4(fragPos + normal * SHADOW_NORMAL_OFFSET, 1.0);
+    if (lightSpace.w <= 0.0)
+        return 1.0;
+    vec3 coords = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+    return texture(spotShadowMap, coords);
+}
@@ -0,0 +1,62 @@
+#version 330 core
+// Adds one point light to the G-buffer pixels covered by its sphere, or by a fullscreen triangle.
+out vec4 FragColor;
+
+struct PointLight {
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+    float intensity;
+};
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+uniform PointLight light;
+uniform sampler2D gAlbedo;
+uniform sampler2D gSpecular;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+uniform vec2 screenSize;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    // Nothing was drawn here
+    if (depth == 1.0)
+        discard;
+
+    vec4 world = inverseViewProjection * vec4(vec3(gl_FragCoord.xy / screenSize, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+    vec4 normalShininess = texelFetch(gNormal, pixel, 0);
+    vec3 normal = normalShininess.xyz;
+    vec3 albedo = texelFetch(gAlbedo, pixel, 0).rgb;
+    vec3 specularColor = texelFetch(gSpecular, pixel, 0).rgb;
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    // Same terms as CalcPointLight in 6.multiple_lights.fs
+    vec3 lightDir = normalize(light.position - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), normalShininess.w);
+    // attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    // combine results
+    vec3 ambient = light.intensity * light.ambient * albedo;
+    vec3 diffuse = light.intensity * light.diffuse * diff * albedo;
+    vec3 specular = light.intensity * light.specular * spec * specularColor;
+    FragColor = vec4((ambient + diffuse + specular) * attenuation, 1.0);
+}
@@ -0,0 +1,17 @@
+#version 330 core
+// A point light's sphere, scaled to the light's range by the model matrix.
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,5 @@
+#version 330 core
+// Depth pre-pass: paired with the scene vertex shaders, only the depth of each fragment is written.
+void main()
+{
+}
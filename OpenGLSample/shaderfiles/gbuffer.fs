@@ -0,0 +1,92 @@
+#version 330 core
+// Writes the material of each fragment for DeferredRenderer instead of lighting it.
+// Shares its inputs and uniforms with 6.multiple_lights.fs, so it pairs with the same vertex shaders.
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec4 gSpecular;
+layout (location = 2) out vec4 gNormal;
+layout (location = 3) out vec4 gOverlay;
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+flat in int MaterialIndex;       // Entry in the Materials block, or -1 for the material uniforms
+
+// Materials of the recorded draws, filled by MaterialTable; keep in sync with MaterialsBlock in UniformBuffer.h
+struct MaterialEntry {
+    vec2 uvScale;
+    float shininess;
+    ivec4 layers;   // Diffuse, specular and overlay layers in the texture array, then the mirrored slots
+};
+
+layout (std140) uniform Materials
+{
+    MaterialEntry materials[256];
+};
+
+uniform Material material;
+uniform vec2 uvScale;
+uniform sampler2D textureOverlay;
+// Material textures are read from their units, or from the layers of TextureArray for instanced draws
+uniform bool useTextureArray;
+uniform sampler2DArray textureLayers;
+
+// The draw's material, read in main from the Materials block or from the material uniforms
+vec2 materialUV;
+float materialShininess;
+ivec4 materialLayers;
+// Texture coordinate derivatives of the unmirrored coordinates, since mirroring folds them at the tile edges
+vec2 uvGradX;
+vec2 uvGradY;
+
+void LoadMaterial();
+vec4 SampleMaterial(sampler2D map, int slot);
+
+void main()
+{
+    LoadMaterial();
+    gAlbedo = vec4(SampleMaterial(material.diffuse, 0).rgb, 1.0);
+    gSpecular = vec4(SampleMaterial(material.specular, 1).rgb, 1.0);
+    gNormal = vec4(normalize(Normal), materialShininess);
+
+    // Opaque black is the "no overlay" texture; store the others premultiplied for the composite blend
+    vec4 overlay = SampleMaterial(textureOverlay, 2);
+    if (overlay != vec4(0.0, 0.0, 0.0, 1.0))
+        gOverlay = vec4(overlay.rgb * overlay.a, overlay.a);
+    else
+        gOverlay = vec4(0.0);
+}
+
+// Reads the draw's material; draws outside the material table set the material uniforms instead.
+void LoadMaterial()
+{
+    if (MaterialIndex >= 0) {
+        materialUV = TexCoords * materials[MaterialIndex].uvScale;
+        materialShininess = materials[MaterialIndex].shininess;
+        materialLayers = materials[MaterialIndex].layers;
+    }
+    else {
+        materialUV = TexCoords * uvScale;
+        materialShininess = material.shininess;
+        materialLayers = ivec4(0);
+    }
+    uvGradX = dFdx(materialUV);
+    uvGradY = dFdy(materialUV);
+}
+
+// Samples a material slot (0 diffuse, 1 specular, 2 overlay) from its unit or from its layer of the
+// texture array. The array repeats, so the layers of mirrored textures are mirrored here.
+vec4 SampleMaterial(sampler2D map, int slot)
+{
+    if (!useTextureArray)
+        return texture(map, materialUV);
+    vec2 uv = materialUV;
+    if ((materialLayers.w & (1 << slot)) != 0)
+        uv = 1.0 - abs(mod(uv, 2.0) - 1.0);
+    return textureGrad(textureLayers, vec3(uv, float(materialLayers[slot])), uvGradX, uvGradY);
+}
@@ -0,0 +1,12 @@
+#version 330 core
+// Resamples a texture into one layer of the texture array, drawn over the layer by deferred_fullscreen.vs.
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform float layerSize;
+uniform float lod;  // The source mip nearest the layer's size
+
+void main()
+{
+    FragColor = textureLod(source, gl_FragCoord.xy / layerSize, lod);
+}
@@ -0,0 +1,30 @@
+#version 330 core
+// Upscales the part of the scene texture the frame was rendered into to the window, drawn by
+// deferred_fullscreen.vs. A contrast-adaptive sharpen restores the edges the bilinear filter softens:
+// each pixel is pushed away from its four neighbors, less where they already differ a lot.
+out vec4 FragColor;
+
+uniform sampler2D sceneColor;
+uniform vec2 outputSize;    // Window size in pixels
+uniform vec2 renderScale;   // Rendered size over the texture size
+uniform float sharpness;    // 0 for the plain bilinear upscale, up to 1
+
+void main()
+{
+    vec2 texel = 1.0 / vec2(textureSize(sceneColor, 0));
+    // Samples stay inside the rendered part, whose border texels the filter would mix with stale ones
+    vec2 uv = clamp(gl_FragCoord.xy / outputSize * renderScale, texel * 0.5, renderScale - texel * 0.5);
+
+    vec3 center = texture(sceneColor, uv).rgb;
+    vec3 north = texture(sceneColor, uv + vec2(0.0, texel.y)).rgb;
+    vec3 south = texture(sceneColor, uv - vec2(0.0, texel.y)).rgb;
+    vec3 east = texture(sceneColor, uv + vec2(texel.x, 0.0)).rgb;
+    vec3 west = texture(sceneColor, uv - vec2(texel.x, 0.0)).rgb;
+
+    vec3 low = min(center, min(min(north, south), min(east, west)));
+    vec3 high = max(center, max(max(north, south), max(east, west)));
+    vec3 amount = sqrt(clamp(min(low, 1.0 - high) / max(high, 1.0e-4), 0.0, 1.0));
+    vec3 weight = -amount * 0.2 * sharpness;
+
+    FragColor = vec4((center + (north + south + east + west) * weight) / (1.0 + 4.0 * weight), 1.0);
+}